@@ -6,6 +6,7 @@ import android.content.Context;
 import android.content.DialogInterface;
 import android.content.Intent;
 import android.content.IntentFilter;
+import android.content.SharedPreferences;
 import android.hardware.usb.UsbDevice;
 import android.hardware.usb.UsbDeviceConnection;
 import android.hardware.usb.UsbManager;
@@ -13,32 +14,68 @@ import android.support.v7.app.AlertDialog;
 import android.support.v7.app.AppCompatActivity;
 import android.os.Bundle;
 import android.view.View;
+import android.widget.Button;
 import android.widget.TimePicker;
 
 import com.felhr.usbserial.UsbSerialDevice;
 import com.felhr.usbserial.UsbSerialInterface;
 
 import java.util.Calendar;
-import java.util.HashMap;
-import java.util.Map;
+import java.util.ArrayList;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
 
 public class MainActivity extends AppCompatActivity
 {
     /** The time picker user interface object. */
     private TimePicker _timePicker;
+    /** The set alarm button. */
+    private Button _buttonSetAlarm;
+    /** The set time and date button. */
+    private Button _buttonSetTimeAndDate;
 
-    /** The USB device corresponding to the USB cable. */
+    /** The USB device corresponding to the USB cable. It is only accessed by the serial executor. */
     private UsbDevice _usbDevice;
-    /** The serial cable USB device. */
+    /** The serial cable USB device, it is kept opened and configured while the cable is plugged so a command can be sent right away. It is only accessed by the serial executor. */
     private UsbSerialDevice _usbSerialDevice;
+    /** Access to the USB devices. */
+    private UsbManager _usbManager;
+    /** Remember the last working serial cable. */
+    private SharedPreferences _preferences;
+    /** Set to true while the user is asked to allow the access to a USB device. It is only accessed by the serial executor. */
+    private boolean _isPermissionRequestPending = false;
+    /** The command to send when the user allows the access to the serial cable. It is only accessed by the serial executor. */
+    private ClockCommand _pendingCommand = null;
 
-    /** The UART protocol magic number (a value that could hardly be randomly generated on the bus). */
-    private final byte _COMMUNICATION_PROTOCOL_MAGIC_NUMBER = (byte) 0xA5;
     /** An UART transmission or reception timeout in milliseconds. */
     private final int _COMMUNICATION_PROTOCOL_TIMEOUT = 5000;
 
+    /** Talk to the clock out of the user interface thread, one command at a time, so a missing or slow clock can't freeze the application. */
+    private final ExecutorService _serialExecutor = Executors.newSingleThreadExecutor();
+    /** The set alarm command frame : the command, the hour and the minutes. It is only accessed by the serial executor. */
+    private final byte _alarmFrame[] = new byte[3];
+    /** The set time and date command frame : the command, the field mask, then the seconds, minutes, hours, day of week, day, month and year. It is only accessed by the serial executor. */
+    private final byte _dateAndTimeFrame[] = new byte[9];
+    /** The configuration fields values the frames are encoded from. It is only accessed by the serial executor. */
+    private final int _configurationFields[] = new int[Protocol.FIELDS_COUNT];
+    /** Receive the clock acknowledge. It is only accessed by the serial executor. */
+    private final byte _receiveBuffer[] = new byte[1];
+
     /** The permission we are waiting for. */
     private final String _PERMISSION_USB_ACCESS = "com.android.example.USB_PERMISSION";
+    /** The preference holding the last working serial cable vendor ID. */
+    private final String _PREFERENCE_USB_VENDOR_ID = "usbVendorId";
+    /** The preference holding the last working serial cable product ID. */
+    private final String _PREFERENCE_USB_PRODUCT_ID = "usbProductId";
+
+    /** The serial cable is opened and configured. */
+    private final int _SERIAL_DEVICE_STATUS_READY = 0;
+    /** No compatible serial cable is plugged. */
+    private final int _SERIAL_DEVICE_STATUS_NOT_FOUND = -1;
+    /** The serial cable communication settings can't be set. */
+    private final int _SERIAL_DEVICE_STATUS_CONFIGURATION_FAILED = -2;
+    /** The user has not answered the USB access request yet. */
+    private final int _SERIAL_DEVICE_STATUS_WAITING_FOR_PERMISSION = -3;
 
     /** Display a simple dialog window waiting for the user to hit the "ok" button.
      * @param title The dialog title.
@@ -63,52 +100,118 @@ public class MainActivity extends AppCompatActivity
         dialog.show();
     }
 
-    /** Receive the USB permission access result. */
+    /** Receive the USB permission access result and the serial cable plug and unplug events. */
     private final BroadcastReceiver _usbDeviceBroadcastReceiver = new BroadcastReceiver()
     {
         public void onReceive(Context context, Intent intent)
         {
             String action = intent.getAction();
-            if (action.equals(_PERMISSION_USB_ACCESS)) {}
+            final UsbDevice usbDevice = intent.getParcelableExtra(UsbManager.EXTRA_DEVICE);
+
+            if (action.equals(_PERMISSION_USB_ACCESS))
+            {
+                final boolean isPermissionGranted = intent.getBooleanExtra(UsbManager.EXTRA_PERMISSION_GRANTED, false);
+                _serialExecutor.execute(new Runnable()
+                {
+                    public void run()
+                    {
+                        handlePermissionResult(isPermissionGranted);
+                    }
+                });
+            }
+            else if (action.equals(UsbManager.ACTION_USB_DEVICE_ATTACHED)) openSerialDeviceAhead();
+            else if (action.equals(UsbManager.ACTION_USB_DEVICE_DETACHED))
+            {
+                _serialExecutor.execute(new Runnable()
+                {
+                    public void run()
+                    {
+                        if ((_usbDevice != null) && (usbDevice != null) && _usbDevice.getDeviceName().equals(usbDevice.getDeviceName())) closeSerialDevice();
+                    }
+                });
+            }
         }
     };
 
-    /** Probe the USB bus to find a working serial cable.
-     * @return 0 if the serial device was successfully found,
-     * @return -1 if no compatible device was found.
+    /** Called by the serial executor when the user allowed or denied the access to a USB device. The pending command, if any, is sent.
+     * @param isPermissionGranted Set to true if the access was allowed.
      */
-    private int findSerialDevice()
+    private void handlePermissionResult(boolean isPermissionGranted)
     {
-        // Retrieve all connected USB devices
-        UsbManager usbManager = (UsbManager) getSystemService(Context.USB_SERVICE);
-        HashMap<String, UsbDevice> usbDevicesMap = usbManager.getDeviceList();
-        if (usbDevicesMap.isEmpty()) return -1;
+        _isPermissionRequestPending = false;
 
-        // Is one of this devices a compatible serial cable ?
-        UsbDeviceConnection usbDeviceConnection;
-        PendingIntent permissionPendingIntent = PendingIntent.getBroadcast(this, 0, new Intent(_PERMISSION_USB_ACCESS), 0);
-        for(Map.Entry<String, UsbDevice> usbDevicesMapEntry : usbDevicesMap.entrySet())
+        ClockCommand command = _pendingCommand;
+        _pendingCommand = null;
+
+        if (!isPermissionGranted)
         {
-            _usbDevice = usbDevicesMapEntry.getValue();
+            if (command != null) postMessage("Error", "The access to the serial cable was denied.");
+            return;
+        }
+
+        // Try the allowed device
+        if (command != null) command.run();
+        else openSerialDevice();
+    }
 
-            // Can the app access to the device ?
-            if (!usbManager.hasPermission(_usbDevice))
+    /** Open the serial cable from the serial executor, so it is ready when the user sends a command. */
+    private void openSerialDeviceAhead()
+    {
+        _serialExecutor.execute(new Runnable()
+        {
+            public void run()
             {
-                // Ask permission to access to the device
-                usbManager.requestPermission(_usbDevice, permissionPendingIntent);
-                if (!usbManager.hasPermission(_usbDevice)) continue;
+                openSerialDevice();
             }
+        });
+    }
 
-            // Connect to the device
-            usbDeviceConnection = usbManager.openDevice(_usbDevice);
+    /** Try to use a USB device as the serial cable. This is called from the serial executor.
+     * @param usbDevice The device to try.
+     * @return _SERIAL_DEVICE_STATUS_READY if the device is a working serial cable, it is opened and configured,
+     * @return _SERIAL_DEVICE_STATUS_WAITING_FOR_PERMISSION if the user is asked for the permission to access the device,
+     * @return another _SERIAL_DEVICE_STATUS_xxx value if the device can't be used.
+     */
+    private int tryUsbDevice(UsbDevice usbDevice)
+    {
+        // Ask the user permission without waiting for the answer, the broadcast receiver will try again when the user answers
+        if (!_usbManager.hasPermission(usbDevice))
+        {
+            if (!_isPermissionRequestPending)
+            {
+                PendingIntent permissionPendingIntent = PendingIntent.getBroadcast(this, 0, new Intent(_PERMISSION_USB_ACCESS), 0);
+                _usbManager.requestPermission(usbDevice, permissionPendingIntent);
+                _isPermissionRequestPending = true;
+            }
+            return _SERIAL_DEVICE_STATUS_WAITING_FOR_PERMISSION;
+        }
 
-            // Is it a compatible serial cable ?
-            _usbSerialDevice = UsbSerialDevice.createUsbSerialDevice(_usbDevice, usbDeviceConnection);
-            if (_usbSerialDevice != null) return 0;
+        // Is it a compatible serial cable ?
+        UsbDeviceConnection usbDeviceConnection = _usbManager.openDevice(usbDevice);
+        if (usbDeviceConnection == null) return _SERIAL_DEVICE_STATUS_NOT_FOUND;
+        _usbSerialDevice = UsbSerialDevice.createUsbSerialDevice(usbDevice, usbDeviceConnection);
+        if (_usbSerialDevice == null)
+        {
+            usbDeviceConnection.close();
+            return _SERIAL_DEVICE_STATUS_NOT_FOUND;
         }
 
-        // No compatible device was found
-        return -1;
+        // Set the serial communication settings
+        if (configureSerialDevice() != 0)
+        {
+            _usbSerialDevice = null;
+            usbDeviceConnection.close();
+            return _SERIAL_DEVICE_STATUS_CONFIGURATION_FAILED;
+        }
+        _usbDevice = usbDevice;
+
+        // Try this cable first next time
+        SharedPreferences.Editor preferencesEditor = _preferences.edit();
+        preferencesEditor.putInt(_PREFERENCE_USB_VENDOR_ID, usbDevice.getVendorId());
+        preferencesEditor.putInt(_PREFERENCE_USB_PRODUCT_ID, usbDevice.getProductId());
+        preferencesEditor.apply();
+
+        return _SERIAL_DEVICE_STATUS_READY;
     }
 
     /** Set the UART communication baud rate, stop bits amount...
@@ -130,47 +233,96 @@ public class MainActivity extends AppCompatActivity
         return 0;
     }
 
-    /** Write a byte of data on the UART.
-     * @param data The byte to send.
+    /** Display a message from the serial executor, then let the user send another command.
+     * @param title The dialog title.
+     * @param message The dialog message.
      */
-    private void sendByte(byte data)
+    private void postMessage(final CharSequence title, final CharSequence message)
     {
-        // Prepare the buffer to send
-        byte dataBuffer[] = new byte[1];
-        dataBuffer[0] = data;
+        runOnUiThread(new Runnable()
+        {
+            public void run()
+            {
+                // The user may have left the application while the clock was answering
+                if (isFinishing()) return;
 
-        // Try to send a byte
-        if (_usbSerialDevice.syncWrite(dataBuffer, _COMMUNICATION_PROTOCOL_TIMEOUT) != 1) displayMessage("Error", "Failed to send a byte of data.");
+                displayMessage(title, message);
+                setButtonsEnabled(true);
+            }
+        });
     }
 
-    /** Convert a byte to a couple of Binary Coded Decimal values and transmit it over the UART. The byte value must be in range 0 to 99.
-     * @param data The value to send.
+    /** Allow or forbid the user to send a command.
+     * @param isEnabled Set to true to enable the command buttons.
      */
-    private void sendBCDValue(int data)
+    private void setButtonsEnabled(boolean isEnabled)
+    {
+        _buttonSetAlarm.setEnabled(isEnabled);
+        _buttonSetTimeAndDate.setEnabled(isEnabled);
+    }
+
+    /** A command sent to the clock by the serial executor. The whole frame is sent in a single USB transfer, then the clock acknowledge is waited for and the result is displayed. */
+    private abstract class ClockCommand implements Runnable
     {
-        int tens, units;
-        byte bcdData;
+        /** The message to display when the clock acknowledged the command. */
+        private final CharSequence _successMessage;
+
+        /** Create a command.
+         * @param successMessage The message to display when the clock acknowledged the command.
+         */
+        ClockCommand(CharSequence successMessage)
+        {
+            _successMessage = successMessage;
+        }
+
+        /** Fill the command frame. This is called when the serial cable is ready, so the time sent to the clock is sampled as late as possible.
+         * @return The frame to send,
+         * @return null if the frame could not be encoded.
+         */
+        protected abstract byte[] buildFrame();
+
+        public void run()
+        {
+            switch (openSerialDevice())
+            {
+                case _SERIAL_DEVICE_STATUS_READY:
+                    break;
+
+                // Send the command as soon as the user allows the access to the cable
+                case _SERIAL_DEVICE_STATUS_WAITING_FOR_PERMISSION:
+                    _pendingCommand = this;
+                    return;
+
+                case _SERIAL_DEVICE_STATUS_CONFIGURATION_FAILED:
+                    postMessage("Error", "Failed to configure the serial communication settings.");
+                    return;
 
-        // Convert the binary data to Binary Coded Decimal
-        tens = data / 10;
-        units = data - (tens * 10);
-        bcdData = (byte) ((tens << 4) | units);
+                default:
+                    postMessage("Error", "No compatible serial cable was detected.");
+                    return;
+            }
 
-        // Transmit the converted data
-        sendByte(bcdData);
+            byte frame[] = buildFrame();
+            if (frame == null) postMessage("Error", "Failed to encode the command.");
+            else if (_usbSerialDevice.syncWrite(frame, _COMMUNICATION_PROTOCOL_TIMEOUT) != frame.length)
+            {
+                // The cable may have been unplugged, search it again next time
+                closeSerialDevice();
+                postMessage("Error", "Failed to send the command.");
+            }
+            else if (_usbSerialDevice.syncRead(_receiveBuffer, _COMMUNICATION_PROTOCOL_TIMEOUT) != 1) postMessage("Error", "The clock did not answer.");
+            else if (_receiveBuffer[0] != Protocol.MAGIC_NUMBER) postMessage("Error", "Clock configuration failed.");
+            else postMessage("Information", _successMessage);
+        }
     }
 
-    /** Wait for a byte to be received from the UART.
-     * @return The received byte (an error message is displayed if the timeout fired).
+    /** Send a command to the clock without blocking the user interface. The buttons are disabled until the command result is displayed.
+     * @param command The command to send.
      */
-    private byte receiveByte()
+    private void sendCommand(ClockCommand command)
     {
-        byte dataBuffer[] = new byte[1];
-
-        // Try to receive a byte
-        if (_usbSerialDevice.syncRead(dataBuffer, _COMMUNICATION_PROTOCOL_TIMEOUT) != 1) displayMessage("Error", "Failed to receive a byte of data.");
-
-        return dataBuffer[0];
+        setButtonsEnabled(false);
+        _serialExecutor.execute(command);
     }
 
     @Override
@@ -181,70 +333,129 @@ public class MainActivity extends AppCompatActivity
 
         // Get access to the user interface objects
         _timePicker = (TimePicker) findViewById(R.id.timePicker);
+        _buttonSetAlarm = (Button) findViewById(R.id.button);
+        _buttonSetTimeAndDate = (Button) findViewById(R.id.buttonSetTimeAndDate);
 
         // Force time picker to be in 24 hours mode
         _timePicker.setIs24HourView(true);
 
-        // Register the callback object called when the USB access permission has been granted or denied by the user
+        _usbManager = (UsbManager) getSystemService(Context.USB_SERVICE);
+        _preferences = getPreferences(Context.MODE_PRIVATE);
+
+        // Register the callback object called when the USB access permission has been granted or denied by the user, and when a USB device is plugged or unplugged
         IntentFilter filter = new IntentFilter(_PERMISSION_USB_ACCESS);
+        filter.addAction(UsbManager.ACTION_USB_DEVICE_ATTACHED);
+        filter.addAction(UsbManager.ACTION_USB_DEVICE_DETACHED);
         registerReceiver(_usbDeviceBroadcastReceiver, filter);
+
+        // The cable may already be plugged, or the application may have been started by plugging it
+        openSerialDeviceAhead();
+    }
+
+    @Override
+    protected void onNewIntent(Intent intent)
+    {
+        super.onNewIntent(intent);
+
+        // The application is already running and the cable has just been plugged
+        if (UsbManager.ACTION_USB_DEVICE_ATTACHED.equals(intent.getAction())) openSerialDeviceAhead();
     }
 
     @Override
     protected void onDestroy()
     {
         unregisterReceiver(_usbDeviceBroadcastReceiver);
+
+        // Release the serial cable once the command in progress, if any, is terminated
+        _serialExecutor.execute(new Runnable()
+        {
+            public void run()
+            {
+                closeSerialDevice();
+            }
+        });
+        _serialExecutor.shutdown();
+        super.onDestroy();
     }
 
-    /** Called when the button is pressed. */
-    public void buttonClick(View view)
+    /** Connect to the serial cable and configure it if it is not opened yet. The last working serial cable is tried first. This is called from the serial executor.
+     * @return A _SERIAL_DEVICE_STATUS_xxx value.
+     */
+    private int openSerialDevice()
     {
-        // Try to connect to the serial cable
-        if (findSerialDevice() != 0)
-        {
-            displayMessage("Error", "No compatible serial cable was detected.");
-            return;
-        }
+        if (_usbSerialDevice != null) return _SERIAL_DEVICE_STATUS_READY;
 
-        // Set the serial communication settings
-        if (configureSerialDevice() != 0)
+        // Sort the connected USB devices, the last working serial cable first
+        int preferredVendorId = _preferences.getInt(_PREFERENCE_USB_VENDOR_ID, -1);
+        int preferredProductId = _preferences.getInt(_PREFERENCE_USB_PRODUCT_ID, -1);
+        ArrayList<UsbDevice> usbDevices = new ArrayList<UsbDevice>();
+        for (UsbDevice usbDevice : _usbManager.getDeviceList().values())
         {
-            displayMessage("Error", "Failed to configure the serial communication settings.");
-            return;
+            if ((usbDevice.getVendorId() == preferredVendorId) && (usbDevice.getProductId() == preferredProductId)) usbDevices.add(0, usbDevice);
+            else usbDevices.add(usbDevice);
         }
 
-        // Connect to the clock
-        sendByte(_COMMUNICATION_PROTOCOL_MAGIC_NUMBER);
-        if (receiveByte() != _COMMUNICATION_PROTOCOL_MAGIC_NUMBER)
+        // Is one of this devices a compatible serial cable ?
+        int status = _SERIAL_DEVICE_STATUS_NOT_FOUND;
+        for (UsbDevice usbDevice : usbDevices)
         {
-            displayMessage("Error", "Failed to connect to the clock.");
-            _usbSerialDevice.syncClose();
-            return;
-        }
+            int deviceStatus = tryUsbDevice(usbDevice);
+            if (deviceStatus == _SERIAL_DEVICE_STATUS_READY) return _SERIAL_DEVICE_STATUS_READY;
 
-        // Send time and date now that all time consuming operations are done
-        Calendar calendar = Calendar.getInstance();
-        sendBCDValue(calendar.get(Calendar.SECOND));
-        sendBCDValue(calendar.get(Calendar.MINUTE));
-        sendBCDValue(calendar.get(Calendar.HOUR_OF_DAY));
-        sendBCDValue(calendar.get(Calendar.DAY_OF_WEEK));
-        sendBCDValue(calendar.get(Calendar.DAY_OF_MONTH));
-        sendBCDValue(calendar.get(Calendar.MONTH) + 1); // January starts from 0
-        sendBCDValue(calendar.get(Calendar.YEAR) - 2000); // RTC year starts from 2000
-
-        // Get alarm time
-        sendBCDValue(_timePicker.getCurrentHour());
-        sendBCDValue(_timePicker.getCurrentMinute());
-
-        // Wait for the clock answer
-        if (receiveByte() != _COMMUNICATION_PROTOCOL_MAGIC_NUMBER)
-        {
-            displayMessage("Error", "Clock configuration failed.");
-            _usbSerialDevice.syncClose();
-            return;
+            // Report the most relevant error if no cable can be used
+            if (status == _SERIAL_DEVICE_STATUS_NOT_FOUND) status = deviceStatus;
         }
+        return status;
+    }
+
+    /** Close the serial cable, it will be searched again for the next command. This is called from the serial executor. */
+    private void closeSerialDevice()
+    {
+        if (_usbSerialDevice == null) return;
 
-        displayMessage("Information", "Time, date and alarm were successfully set.");
         _usbSerialDevice.syncClose();
+        _usbSerialDevice = null;
+        _usbDevice = null;
+    }
+
+    /** Called when the set alarm button is pressed. Only the alarm is sent, so the clock time is not disturbed. */
+    public void buttonSetAlarmClick(View view)
+    {
+        // The time picker can only be read from the user interface thread
+        final int hour = _timePicker.getCurrentHour();
+        final int minute = _timePicker.getCurrentMinute();
+
+        sendCommand(new ClockCommand("The alarm was successfully set.")
+        {
+            protected byte[] buildFrame()
+            {
+                _configurationFields[Protocol.FIELD_ALARM_HOUR] = hour;
+                _configurationFields[Protocol.FIELD_ALARM_MINUTES] = minute;
+                if (Protocol.encodeConfigurationFrame(Protocol.COMMAND_SET_ALARM, (byte) 0, _configurationFields, _alarmFrame) != _alarmFrame.length) return null;
+                return _alarmFrame;
+            }
+        });
+    }
+
+    /** Called when the set time and date button is pressed. The alarm is not modified. */
+    public void buttonSetTimeAndDateClick(View view)
+    {
+        sendCommand(new ClockCommand("Time and date were successfully set.")
+        {
+            protected byte[] buildFrame()
+            {
+                // Sample time and date now that all time consuming operations are done
+                Calendar calendar = Calendar.getInstance();
+                _configurationFields[Protocol.FIELD_SECONDS] = calendar.get(Calendar.SECOND);
+                _configurationFields[Protocol.FIELD_MINUTES] = calendar.get(Calendar.MINUTE);
+                _configurationFields[Protocol.FIELD_HOURS] = calendar.get(Calendar.HOUR_OF_DAY);
+                _configurationFields[Protocol.FIELD_DAY_OF_WEEK] = calendar.get(Calendar.DAY_OF_WEEK);
+                _configurationFields[Protocol.FIELD_DAY] = calendar.get(Calendar.DAY_OF_MONTH);
+                _configurationFields[Protocol.FIELD_MONTH] = calendar.get(Calendar.MONTH) + 1; // January starts from 0
+                _configurationFields[Protocol.FIELD_YEAR] = calendar.get(Calendar.YEAR);
+                if (Protocol.encodeConfigurationFrame(Protocol.COMMAND_SET_FIELDS, (byte) (Protocol.FIELD_MASK_TIME | Protocol.FIELD_MASK_DATE), _configurationFields, _dateAndTimeFrame) != _dateAndTimeFrame.length) return null;
+                return _dateAndTimeFrame;
+            }
+        });
     }
 }
@@ -0,0 +1,47 @@
+package com.example.ar.clock;
+
+/** Build the frames sent to the clock with the same codec as the PC program (Software/Protocol), called through JNI. */
+public class Protocol
+{
+    static
+    {
+        System.loadLibrary("Protocol");
+    }
+
+    /** The UART protocol magic number, it acknowledges all commands. */
+    public static final byte MAGIC_NUMBER = (byte) 0xA5;
+    /** Set only the alarm, the clock keeps running. */
+    public static final byte COMMAND_SET_ALARM = (byte) 0xB4;
+    /** Set the configuration fields selected by a field mask. */
+    public static final byte COMMAND_SET_FIELDS = (byte) 0xB7;
+
+    /** The seconds, minutes and hours configuration fields. */
+    public static final byte FIELD_MASK_TIME = (byte) 0x07;
+    /** The day of week, day, month and year configuration fields. */
+    public static final byte FIELD_MASK_DATE = (byte) 0x78;
+    /** The alarm hour and minutes configuration fields. */
+    public static final byte FIELD_MASK_ALARM = (byte) 0x80;
+
+    /** The configuration fields indexes, they follow the RTC registers order. */
+    public static final int FIELD_SECONDS = 0;
+    public static final int FIELD_MINUTES = 1;
+    public static final int FIELD_HOURS = 2;
+    public static final int FIELD_DAY_OF_WEEK = 3;
+    public static final int FIELD_DAY = 4;
+    public static final int FIELD_MONTH = 5;
+    public static final int FIELD_YEAR = 6;
+    public static final int FIELD_ALARM_HOUR = 7;
+    public static final int FIELD_ALARM_MINUTES = 8;
+    /** How many configuration fields there are. */
+    public static final int FIELDS_COUNT = 9;
+
+    /** Encode a partial configuration frame for a clock alone on its line.
+     * @param command COMMAND_SET_ALARM or COMMAND_SET_FIELDS.
+     * @param fieldMask The fields to send with COMMAND_SET_FIELDS, it is ignored by COMMAND_SET_ALARM.
+     * @param fields The fields values indexed by the FIELD_xxx constants (the year is a full year like 2017), only the selected ones are read.
+     * @param frame On output, contain the frame. It is filled from its beginning.
+     * @return The frame size in bytes,
+     * @return -1 if a field is out of range or the frame array is too small.
+     */
+    public static native int encodeConfigurationFrame(byte command, byte fieldMask, int fields[], byte frame[]);
+}
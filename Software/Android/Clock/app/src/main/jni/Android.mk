@@ -0,0 +1,13 @@
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+# The codec sources are shared with the PC program
+PROTOCOL_PATH := $(LOCAL_PATH)/../../../../../../Protocol
+
+LOCAL_MODULE := Protocol
+LOCAL_SRC_FILES := Protocol_JNI.c $(PROTOCOL_PATH)/Protocol.c
+LOCAL_C_INCLUDES := $(PROTOCOL_PATH)
+LOCAL_CFLAGS := -W -Wall -O2
+
+include $(BUILD_SHARED_LIBRARY)
@@ -0,0 +1,31 @@
+/** @file Protocol_JNI.c
+ * Expose the clock protocol codec to the Android application.
+ * @author Adrien RICCIARDI
+ */
+#include <jni.h>
+#include "Protocol.h"
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+JNIEXPORT jint JNICALL Java_com_example_ar_clock_Protocol_encodeConfigurationFrame(JNIEnv *Pointer_Environment, jclass Class, jbyte Command, jbyte Field_Mask, jintArray Fields, jbyteArray Frame)
+{
+	TProtocolConfiguration Configuration;
+	unsigned char Buffer[PROTOCOL_MAXIMUM_FRAME_SIZE];
+	jint Fields_Count;
+	int Size;
+	
+	(void) Class;
+	
+	// Get the fields values
+	Fields_Count = (*Pointer_Environment)->GetArrayLength(Pointer_Environment, Fields);
+	if (Fields_Count < PROTOCOL_FIELDS_COUNT) return -1;
+	(*Pointer_Environment)->GetIntArrayRegion(Pointer_Environment, Fields, 0, PROTOCOL_FIELDS_COUNT, (jint *) Configuration.Fields);
+	
+	// Encode the frame on the stack, then copy it to the Java array in a single call
+	Size = ProtocolEncodeConfigurationFrame(PROTOCOL_NO_UNIT_ADDRESS, (unsigned char) Command, (unsigned char) Field_Mask, &Configuration, Buffer, sizeof(Buffer));
+	if ((Size < 0) || (Size > (*Pointer_Environment)->GetArrayLength(Pointer_Environment, Frame))) return -1;
+	(*Pointer_Environment)->SetByteArrayRegion(Pointer_Environment, Frame, 0, Size, (jbyte *) Buffer);
+	
+	return Size;
+}
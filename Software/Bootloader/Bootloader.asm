@@ -0,0 +1,533 @@
+; @file Bootloader.asm
+; A small resident serial bootloader allowing to update the clock firmware through the UART, without an ICSP programmer.
+; The bootloader lives in the last 512 program memory words. The reset vector always starts the bootloader. After a power-on reset it waits a short time for the host before starting the application, after a brown-out or a reset button press it starts the application right away so the clock restarts quickly.
+; The application is built without any special setting : its first 4 words are relocated by the bootloader to the bootloader area, and are executed from there to start the application.
+; The host protocol works on 32-word blocks (see the protocol description below). Words are transmitted most significant byte first.
+; Program this file once with an ICSP programmer. It also programs the configuration word, which enables the flash memory self-programming.
+; @author Adrien RICCIARDI
+
+	list p=16f876, r=dec
+	#include <p16f876.inc>
+	errorlevel -302 ; Do not warn about bank selection, banks are explicitly selected
+
+;--------------------------------------------------------------------------------------------------
+; Configuration
+;--------------------------------------------------------------------------------------------------
+; The core frequency in Hz, it must match the application one (use "-D CLOCK_FREQUENCY=20000000" to build for the 20MHz profile)
+#ifndef CLOCK_FREQUENCY
+	#define CLOCK_FREQUENCY 4000000
+#endif
+
+; Disable code protection, disable background debugger, enable flash memory writing, disable EEPROM write protection, disable the Low-Voltage Programming, enable the Brown-Out Reset, enable the Power-On Timer, disable the watchdog timer, use a crystal oscillator
+	if CLOCK_FREQUENCY > 4000000
+		__CONFIG _CP_OFF & _DEBUG_OFF & _WRT_ENABLE_ON & _CPD_OFF & _LVP_OFF & _BODEN_ON & _PWRTE_ON & _WDT_OFF & _HS_OSC
+	else
+		__CONFIG _CP_OFF & _DEBUG_OFF & _WRT_ENABLE_ON & _CPD_OFF & _LVP_OFF & _BODEN_ON & _PWRTE_ON & _WDT_OFF & _XT_OSC
+	endif
+
+;--------------------------------------------------------------------------------------------------
+; Protocol
+;--------------------------------------------------------------------------------------------------
+; Synchronize with the bootloader. The bootloader answers with the same byte.
+BOOTLOADER_COMMAND_SYNCHRONIZE equ 0xC0
+; Get the CRC of consecutive blocks. The command is followed by the first block index and the blocks count. The bootloader answers with the 16-bit CRC of each block.
+BOOTLOADER_COMMAND_GET_BLOCKS_CRC equ 0xC1
+; Write a block. The command is followed by the block index, the 32 block words and the 16-bit CRC of the block index and words. The bootloader answers with the same byte when the block is written and verified, or with an error code.
+BOOTLOADER_COMMAND_WRITE_BLOCK equ 0xC2
+; Start the application. The bootloader answers with the same byte before starting the application.
+BOOTLOADER_COMMAND_START_APPLICATION equ 0xC3
+
+; The received block CRC is wrong.
+BOOTLOADER_ERROR_BAD_CRC equ 0xE0
+; The block can't be written because it belongs to the bootloader.
+BOOTLOADER_ERROR_BAD_BLOCK equ 0xE1
+; A word read back after being written is different from the requested value.
+BOOTLOADER_ERROR_VERIFICATION_FAILED equ 0xE2
+
+; All CRCs are CRC-16-CCITT with 0xFFFF initial value (the same as the host program).
+
+;--------------------------------------------------------------------------------------------------
+; Constants
+;--------------------------------------------------------------------------------------------------
+; The bootloader start address in program memory.
+BOOTLOADER_BASE_ADDRESS equ 0x1E00
+
+; How many words are in a block.
+BOOTLOADER_BLOCK_SIZE_WORDS equ 32
+; How many bytes are in a block.
+BOOTLOADER_BLOCK_SIZE_BYTES equ BOOTLOADER_BLOCK_SIZE_WORDS * 2
+; How many blocks the application can use (the bootloader area is protected).
+BOOTLOADER_APPLICATION_BLOCKS_COUNT equ BOOTLOADER_BASE_ADDRESS / BOOTLOADER_BLOCK_SIZE_WORDS
+; How many application words are relocated to the bootloader area.
+BOOTLOADER_RELOCATED_WORDS_COUNT equ 4
+
+; The UART baud rate in bit/s.
+BOOTLOADER_UART_BAUD_RATE equ 19200
+; The baud rate generator value in high baud rate mode, rounded to the nearest integer.
+BOOTLOADER_UART_BAUD_RATE_GENERATOR_VALUE equ ((CLOCK_FREQUENCY + (8 * BOOTLOADER_UART_BAUD_RATE)) / (16 * BOOTLOADER_UART_BAUD_RATE)) - 1
+
+; How many 327680-cycle loops to wait for the host before starting the application (about 300ms).
+BOOTLOADER_SYNCHRONIZATION_WAIT_LOOPS equ (((CLOCK_FREQUENCY / 4) * 3 / 10) + 327679) / 327680
+
+;--------------------------------------------------------------------------------------------------
+; Variables
+;--------------------------------------------------------------------------------------------------
+; The received block, in bank 0.
+BOOTLOADER_BUFFER_ADDRESS equ 0x20
+
+; Variables only accessed from bank 0
+	cblock 0x60
+		Block ; The block index.
+		Blocks_Count ; How many blocks remain to process.
+		Counter ; A loop counter.
+		Shift_Counter ; The block address computation loop counter.
+		Difference ; Tell whether a word must be written.
+		Wait_Counter_Low ; The synchronization timeout counters.
+		Wait_Counter_Middle
+		Wait_Counter_High
+		CRC_High ; The CRC being computed.
+		CRC_Low
+		CRC_X ; CRC computation temporary values.
+		CRC_T
+		Logical_Address_High ; The application word address, before the first words relocation.
+		Logical_Address_Low
+	endc
+
+; Variables accessed from all banks (they are in the shared RAM area)
+	cblock 0x70
+		Address_High ; The flash memory word physical address.
+		Address_Low
+		Data_High ; The flash memory word value.
+		Data_Low
+	endc
+
+;--------------------------------------------------------------------------------------------------
+; Reset vector
+;--------------------------------------------------------------------------------------------------
+	org 0x0000
+	movlw high BootloaderStart
+	movwf PCLATH
+	goto BootloaderStart
+	nop
+
+;--------------------------------------------------------------------------------------------------
+; Application entry point
+;--------------------------------------------------------------------------------------------------
+	org BOOTLOADER_BASE_ADDRESS
+ApplicationEntry
+	clrf PCLATH ; The application code expects the reset value
+	; The application first words are programmed here
+ApplicationRelocatedWords
+	org ApplicationRelocatedWords + BOOTLOADER_RELOCATED_WORDS_COUNT
+	; Continue to the application code as after the reset vector if the relocated words did not jump
+	clrf PCLATH
+	goto 0x0004
+
+;--------------------------------------------------------------------------------------------------
+; Private functions
+;--------------------------------------------------------------------------------------------------
+; Wait for a byte to be received from the UART.
+; @return W contains the received byte.
+ReceiveByte
+	; Recover from an overrun error, which stops the reception
+	btfss RCSTA, OERR
+	goto ReceiveByteWait
+	bcf RCSTA, CREN
+	bsf RCSTA, CREN
+ReceiveByteWait
+	btfss PIR1, RCIF
+	goto ReceiveByteWait
+	movf RCREG, W
+	return
+
+; Send a byte through the UART.
+; @param W The byte to send.
+SendByte
+	btfss PIR1, TXIF
+	goto SendByte
+	movwf TXREG
+	return
+
+; Wait for the last byte to be fully transmitted.
+WaitTransmissionEnd
+	banksel TXSTA
+WaitTransmissionEndLoop
+	btfss TXSTA, TRMT
+	goto WaitTransmissionEndLoop
+	banksel RCSTA
+	return
+
+; Reset the CRC to its initial value.
+CRCInitialize
+	movlw 0xFF
+	movwf CRC_High
+	movwf CRC_Low
+	return
+
+; Add a byte to the CRC.
+; @param W The byte.
+CRCUpdate
+	; X = (CRC >> 8) ^ Byte
+	xorwf CRC_High, W
+	movwf CRC_X
+	; X ^= X >> 4
+	swapf CRC_X, W
+	andlw 0x0F
+	xorwf CRC_X, F
+	; CRC = (CRC << 8) ^ (X << 12) ^ (X << 5) ^ X, compute the most significant byte first as it needs the previous least significant byte
+	swapf CRC_X, W
+	andlw 0xF0
+	xorwf CRC_Low, W
+	movwf CRC_High
+	movf CRC_X, W
+	movwf CRC_T
+	rrf CRC_T, F
+	rrf CRC_T, F
+	rrf CRC_T, W
+	andlw 0x1F
+	xorwf CRC_High, F
+	swapf CRC_X, W
+	movwf CRC_T
+	rlf CRC_T, W
+	andlw 0xE0
+	xorwf CRC_X, W
+	movwf CRC_Low
+	return
+
+; Set the logical address to the first word of a block.
+; @param Block The block index.
+SetBlockAddress
+	clrf Logical_Address_High
+	movf Block, W
+	movwf Logical_Address_Low
+	movlw 5 ; Multiply by the block size (32 words)
+	movwf Shift_Counter
+SetBlockAddressLoop
+	bcf STATUS, C
+	rlf Logical_Address_Low, F
+	rlf Logical_Address_High, F
+	decfsz Shift_Counter, F
+	goto SetBlockAddressLoop
+	return
+
+; Convert the logical address to a physical address, then increment the logical address.
+; @return Address_High and Address_Low contain the physical address.
+LoadPhysicalAddress
+	movf Logical_Address_High, W
+	movwf Address_High
+	movf Logical_Address_Low, W
+	movwf Address_Low
+	incf Logical_Address_Low, F
+	btfsc STATUS, Z
+	incf Logical_Address_High, F
+	; The reset vector always starts the bootloader, so the application first words are stored in the bootloader area
+	movf Address_High, F
+	btfss STATUS, Z
+	return
+	movlw BOOTLOADER_RELOCATED_WORDS_COUNT
+	subwf Address_Low, W
+	btfsc STATUS, C
+	return
+	movlw low ApplicationRelocatedWords
+	addwf Address_Low, F
+	movlw high ApplicationRelocatedWords
+	movwf Address_High
+	return
+
+; Read a program memory word.
+; @param Address_High The word address most significant byte.
+; @param Address_Low The word address least significant byte.
+; @return Data_High and Data_Low contain the word value.
+ReadFlashWord
+	banksel EEADR
+	movf Address_Low, W
+	movwf EEADR
+	movf Address_High, W
+	movwf EEADRH
+	banksel EECON1
+	bsf EECON1, EEPGD
+	bsf EECON1, RD
+	nop ; The two instructions following the read are ignored
+	nop
+	banksel EEDATA
+	movf EEDATA, W
+	movwf Data_Low
+	movf EEDATH, W
+	movwf Data_High
+	banksel RCSTA
+	return
+
+; Write a program memory word. The processor is halted until the write is completed.
+; @param Address_High The word address most significant byte.
+; @param Address_Low The word address least significant byte.
+; @param Data_High The word value most significant byte.
+; @param Data_Low The word value least significant byte.
+WriteFlashWord
+	banksel EEADR
+	movf Address_Low, W
+	movwf EEADR
+	movf Address_High, W
+	movwf EEADRH
+	movf Data_Low, W
+	movwf EEDATA
+	movf Data_High, W
+	movwf EEDATH
+	banksel EECON1
+	bsf EECON1, EEPGD
+	bsf EECON1, WREN
+	movlw 0x55 ; Required write sequence
+	movwf EECON2
+	movlw 0xAA
+	movwf EECON2
+	bsf EECON1, WR
+	nop ; The two instructions following the write are ignored
+	nop
+	bcf EECON1, WREN
+	banksel RCSTA
+	return
+
+;--------------------------------------------------------------------------------------------------
+; Entry point
+;--------------------------------------------------------------------------------------------------
+BootloaderStart
+	; The POR bit is cleared by a power-on reset, the application sets it when it starts and clears it again when it starts the bootloader on purpose. So a set bit tells a warm reset, which does not wait for the host
+	clrf INTCON
+	banksel PCON
+	btfss PCON, NOT_POR
+	goto BootloaderColdStart
+	banksel RCSTA
+	goto StartApplication
+
+BootloaderColdStart
+	; The bootloader can be started by the application, so silence the buzzer (the interrupts were disabled above)
+	banksel CCP2CON
+	clrf CCP2CON
+	bcf STATUS, IRP ; The buffer is accessed through FSR
+	banksel PIE1
+	clrf PIE1
+	clrf PIE2
+
+	; Configure the UART at 19200 bit/s, 8 data bits, no parity, 1 stop bit
+	bsf TRISC, 6
+	bsf TRISC, 7
+	movlw BOOTLOADER_UART_BAUD_RATE_GENERATOR_VALUE
+	movwf SPBRG
+	movlw 0x26 ; Select 8-bit transmission, enable transmission, use asynchronous mode, select high baud rate mode
+	movwf TXSTA
+	banksel RCSTA
+	clrf RCSTA ; Clear a pending overrun error
+	movlw 0x90 ; Enable the serial port module and the reception
+	movwf RCSTA
+
+	; Wait forever for the host if there is no application to start
+	movlw high ApplicationRelocatedWords
+	movwf Address_High
+	movlw low ApplicationRelocatedWords
+	movwf Address_Low
+	call ReadFlashWord
+	incf Data_Low, W
+	btfss STATUS, Z
+	goto WaitSynchronization
+	movlw 0x3F
+	xorwf Data_High, W
+	btfsc STATUS, Z
+	goto WaitSynchronizationForever
+
+WaitSynchronization
+	movlw BOOTLOADER_SYNCHRONIZATION_WAIT_LOOPS
+	movwf Wait_Counter_High
+	clrf Wait_Counter_Middle
+	clrf Wait_Counter_Low
+WaitSynchronizationLoop
+	btfsc PIR1, RCIF
+	goto WaitSynchronizationByteReceived
+	decfsz Wait_Counter_Low, F
+	goto WaitSynchronizationLoop
+	decfsz Wait_Counter_Middle, F
+	goto WaitSynchronizationLoop
+	decfsz Wait_Counter_High, F
+	goto WaitSynchronizationLoop
+	goto StartApplication
+WaitSynchronizationByteReceived
+	call ReceiveByte
+	xorlw BOOTLOADER_COMMAND_SYNCHRONIZE
+	btfss STATUS, Z
+	goto WaitSynchronizationLoop ; Ignore anything else
+	goto CommandSynchronize
+
+WaitSynchronizationForever
+	call ReceiveByte
+	xorlw BOOTLOADER_COMMAND_SYNCHRONIZE
+	btfss STATUS, Z
+	goto WaitSynchronizationForever
+
+;--------------------------------------------------------------------------------------------------
+; Commands
+;--------------------------------------------------------------------------------------------------
+CommandSynchronize
+	movlw BOOTLOADER_COMMAND_SYNCHRONIZE
+	call SendByte
+
+CommandLoop
+	call ReceiveByte
+	xorlw BOOTLOADER_COMMAND_SYNCHRONIZE
+	btfsc STATUS, Z
+	goto CommandSynchronize
+	xorlw BOOTLOADER_COMMAND_SYNCHRONIZE ^ BOOTLOADER_COMMAND_GET_BLOCKS_CRC
+	btfsc STATUS, Z
+	goto CommandGetBlocksCRC
+	xorlw BOOTLOADER_COMMAND_GET_BLOCKS_CRC ^ BOOTLOADER_COMMAND_WRITE_BLOCK
+	btfsc STATUS, Z
+	goto CommandWriteBlock
+	xorlw BOOTLOADER_COMMAND_WRITE_BLOCK ^ BOOTLOADER_COMMAND_START_APPLICATION
+	btfss STATUS, Z
+	goto CommandLoop ; Ignore unknown commands
+
+	; Start the application
+	movlw BOOTLOADER_COMMAND_START_APPLICATION
+	call SendByte
+	call WaitTransmissionEnd
+StartApplication
+	; Give the UART back in its reset state
+	clrf RCSTA
+	banksel TXSTA
+	clrf TXSTA
+	banksel RCSTA
+	movlw high ApplicationEntry
+	movwf PCLATH
+	goto ApplicationEntry
+
+CommandGetBlocksCRC
+	call ReceiveByte
+	movwf Block
+	call ReceiveByte
+	movwf Blocks_Count
+	movf Blocks_Count, F
+	btfsc STATUS, Z
+	goto CommandLoop
+CommandGetBlocksCRCBlock
+	call SetBlockAddress
+	call CRCInitialize
+	movlw BOOTLOADER_BLOCK_SIZE_WORDS
+	movwf Counter
+CommandGetBlocksCRCWord
+	call LoadPhysicalAddress
+	call ReadFlashWord
+	movf Data_High, W
+	call CRCUpdate
+	movf Data_Low, W
+	call CRCUpdate
+	decfsz Counter, F
+	goto CommandGetBlocksCRCWord
+	movf CRC_High, W
+	call SendByte
+	movf CRC_Low, W
+	call SendByte
+	incf Block, F
+	decfsz Blocks_Count, F
+	goto CommandGetBlocksCRCBlock
+	goto CommandLoop
+
+CommandWriteBlock
+	; Receive the block index
+	call CRCInitialize
+	call ReceiveByte
+	movwf Block
+	call CRCUpdate
+
+	; Receive the block words
+	movlw BOOTLOADER_BUFFER_ADDRESS
+	movwf FSR
+	movlw BOOTLOADER_BLOCK_SIZE_BYTES
+	movwf Counter
+CommandWriteBlockReceive
+	call ReceiveByte
+	movwf INDF
+	call CRCUpdate
+	incf FSR, F
+	decfsz Counter, F
+	goto CommandWriteBlockReceive
+
+	; Check the CRC
+	call ReceiveByte
+	xorwf CRC_High, F
+	call ReceiveByte
+	xorwf CRC_Low, W
+	iorwf CRC_High, W
+	btfsc STATUS, Z
+	goto CommandWriteBlockCheckIndex
+	movlw BOOTLOADER_ERROR_BAD_CRC
+	call SendByte
+	goto CommandLoop
+
+	; Never overwrite the bootloader
+CommandWriteBlockCheckIndex
+	movlw BOOTLOADER_APPLICATION_BLOCKS_COUNT
+	subwf Block, W
+	btfss STATUS, C
+	goto CommandWriteBlockProgram
+	movlw BOOTLOADER_ERROR_BAD_BLOCK
+	call SendByte
+	goto CommandLoop
+
+	; Write only the words that changed, as each write halts the processor for some milliseconds
+CommandWriteBlockProgram
+	call SetBlockAddress
+	movlw BOOTLOADER_BUFFER_ADDRESS
+	movwf FSR
+	movlw BOOTLOADER_BLOCK_SIZE_WORDS
+	movwf Counter
+CommandWriteBlockWord
+	call LoadPhysicalAddress
+	call ReadFlashWord
+	movf INDF, W
+	xorwf Data_High, W
+	movwf Difference
+	incf FSR, F
+	movf INDF, W
+	xorwf Data_Low, W
+	iorwf Difference, W
+	btfsc STATUS, Z
+	goto CommandWriteBlockNextWord
+
+	; Program the word
+	movf INDF, W
+	movwf Data_Low
+	decf FSR, F
+	movf INDF, W
+	movwf Data_High
+	incf FSR, F
+	call WriteFlashWord
+
+	; Read it back to make sure it was correctly written
+	call ReadFlashWord
+	movf INDF, W
+	xorwf Data_Low, W
+	btfss STATUS, Z
+	goto CommandWriteBlockVerificationFailed
+	decf FSR, F
+	movf INDF, W
+	incf FSR, F
+	xorwf Data_High, W
+	btfss STATUS, Z
+	goto CommandWriteBlockVerificationFailed
+
+CommandWriteBlockNextWord
+	incf FSR, F
+	decfsz Counter, F
+	goto CommandWriteBlockWord
+	movlw BOOTLOADER_COMMAND_WRITE_BLOCK
+	call SendByte
+	goto CommandLoop
+
+CommandWriteBlockVerificationFailed
+	movlw BOOTLOADER_ERROR_VERIFICATION_FAILED
+	call SendByte
+	goto CommandLoop
+
+	; Make sure the bootloader fits in its area
+	if $ > 0x2000
+		error "The bootloader is too big."
+	endif
+
+	end
@@ -4,6 +4,70 @@
  */
 #include <system.h>
 #include "Button.h"
+#include "Scheduler.h"
+#include "System_Tick.h"
+#include "Timestamp.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** How many consecutive samples must read the new level for an input change to be accepted (the bounces of a contact last a few milliseconds, a sample is taken every system tick). */
+#define BUTTON_DEBOUNCE_SAMPLES_COUNT 3
+/** How many samples the snooze button must be held for to be long-pressed. */
+#define BUTTON_LONG_PRESS_SAMPLES_COUNT SYSTEM_TICK_MILLISECONDS_TO_TICKS(BUTTON_LONG_PRESS_DURATION)
+
+/** The snooze button bit in the inputs states, it is set when the button is pressed. */
+#define BUTTON_INPUT_SNOOZE 0x01
+/** The alarm switch bit in the inputs states, it is set when the alarm is enabled. */
+#define BUTTON_INPUT_ALARM_SWITCH 0x02
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The inputs debounced states (BUTTON_INPUT_xxx bits). */
+static unsigned char Button_Debounced_Inputs;
+/** How many consecutive samples of the snooze button differed from its debounced state. */
+static unsigned char Button_Snooze_Debounce_Counter;
+/** How many consecutive samples of the alarm switch differed from its debounced state. */
+static unsigned char Button_Alarm_Switch_Debounce_Counter;
+/** How many samples the snooze button has been held for, it stops counting when the button is long-pressed. */
+static unsigned char Button_Snooze_Held_Samples_Count;
+
+/** The events that the main loop has not retrieved yet. */
+static unsigned char Button_Events;
+/** How many bounces were filtered out, saturated to 255. */
+static unsigned char Button_Bounces_Count;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Update an input debounced state from a new sample.
+ * @param Input The input bit (BUTTON_INPUT_xxx value).
+ * @param Sampled_Inputs The sampled levels of all inputs.
+ * @param Pointer_Counter The input debounce counter.
+ * @return 1 if the input debounced state changed,
+ * @return 0 if the input debounced state did not change.
+ */
+static unsigned char ButtonDebounceInput(unsigned char Input, unsigned char Sampled_Inputs, unsigned char *Pointer_Counter)
+{
+	// The sample agrees with the debounced state, so a level change that did not last long enough was a bounce
+	if (((Sampled_Inputs ^ Button_Debounced_Inputs) & Input) == 0)
+	{
+		if (*Pointer_Counter != 0)
+		{
+			*Pointer_Counter = 0;
+			if (Button_Bounces_Count < 255) Button_Bounces_Count++;
+		}
+		return 0;
+	}
+	
+	// Accept the new level only when it is stable
+	(*Pointer_Counter)++;
+	if (*Pointer_Counter < BUTTON_DEBOUNCE_SAMPLES_COUNT) return 0;
+	*Pointer_Counter = 0;
+	Button_Debounced_Inputs ^= Input;
+	return 1;
+}
 
 //--------------------------------------------------------------------------------------------------
 // Public functions
@@ -14,7 +78,76 @@ void ButtonInitialize(void)
 	trisb.0 = 1;
 	trisc.2 = 1;
 	
-	// Enable the RB0 interrupt
-	option_reg.INTEDG = 1; // Trigger the interrupt on a rising edge
-	intcon.INTE = 1; // Enable the interrupt
-}
\ No newline at end of file
+	Button_Snooze_Debounce_Counter = 0;
+	Button_Alarm_Switch_Debounce_Counter = 0;
+	Button_Events = 0;
+	Button_Bounces_Count = 0;
+	
+	// Start from the current levels
+	Button_Debounced_Inputs = 0;
+	if (portb.0) Button_Debounced_Inputs |= BUTTON_INPUT_SNOOZE;
+	if (portc.2) Button_Debounced_Inputs |= BUTTON_INPUT_ALARM_SWITCH;
+	Button_Snooze_Held_Samples_Count = BUTTON_LONG_PRESS_SAMPLES_COUNT; // A button held during the boot is not long-pressed
+}
+
+void ButtonSampleInputs(void)
+{
+	unsigned char Sampled_Inputs = 0, Events = 0;
+	
+	if (portb.0) Sampled_Inputs |= BUTTON_INPUT_SNOOZE;
+	if (portc.2) Sampled_Inputs |= BUTTON_INPUT_ALARM_SWITCH;
+	
+	// Handle the snooze button
+	if (ButtonDebounceInput(BUTTON_INPUT_SNOOZE, Sampled_Inputs, &Button_Snooze_Debounce_Counter))
+	{
+		if (Button_Debounced_Inputs & BUTTON_INPUT_SNOOZE)
+		{
+			Events |= BUTTON_EVENT_SNOOZE_PRESSED;
+			TimestampCaptureEvent(TIMESTAMP_EVENT_BUTTON_PRESS);
+			Button_Snooze_Held_Samples_Count = 0;
+		}
+		else Events |= BUTTON_EVENT_SNOOZE_RELEASED;
+	}
+	// Tell only once that the button is held long enough
+	else if ((Button_Debounced_Inputs & BUTTON_INPUT_SNOOZE) && (Button_Snooze_Held_Samples_Count < BUTTON_LONG_PRESS_SAMPLES_COUNT))
+	{
+		Button_Snooze_Held_Samples_Count++;
+		if (Button_Snooze_Held_Samples_Count == BUTTON_LONG_PRESS_SAMPLES_COUNT) Events |= BUTTON_EVENT_SNOOZE_LONG_PRESSED;
+	}
+	
+	// Handle the alarm switch
+	if (ButtonDebounceInput(BUTTON_INPUT_ALARM_SWITCH, Sampled_Inputs, &Button_Alarm_Switch_Debounce_Counter))
+	{
+		if (Button_Debounced_Inputs & BUTTON_INPUT_ALARM_SWITCH) Events |= BUTTON_EVENT_ALARM_SWITCH_ENABLED;
+		else Events |= BUTTON_EVENT_ALARM_SWITCH_DISABLED;
+	}
+	
+	if (Events != 0)
+	{
+		Button_Events |= Events;
+		SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_BUTTON);
+	}
+}
+
+unsigned char ButtonGetEvents(void)
+{
+	unsigned char Events;
+	
+	intcon.GIE = 0;
+	Events = Button_Events;
+	Button_Events = 0;
+	intcon.GIE = 1;
+	
+	return Events;
+}
+
+unsigned char ButtonIsAlarmEnabled(void)
+{
+	if (Button_Debounced_Inputs & BUTTON_INPUT_ALARM_SWITCH) return 1;
+	return 0;
+}
+
+unsigned char ButtonGetBouncesCount(void)
+{
+	return Button_Bounces_Count;
+}
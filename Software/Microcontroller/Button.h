@@ -1,30 +1,50 @@
 /** @file Button.h
- * Ease access to Alarm and Snooze buttons.
+ * Debounce the snooze button and the alarm switch. Both inputs are sampled on each system tick instead of triggering interrupts, so a worn contact can't flood the interrupt handler, and a level change is accepted only when it is stable for several samples.
  * @author Adrien RICCIARDI
  */
 #ifndef H_BUTTON_H
 #define H_BUTTON_H
 
-#include <system.h>
-
 //--------------------------------------------------------------------------------------------------
 // Constants and macros
 //--------------------------------------------------------------------------------------------------
-/** Tell if the snooze button interrupt fired or not. */
-#define BUTTON_HAS_INTERRUPT_FIRED() intcon.INTF
-/** Clear the snooze button interrupt flag. */
-#define BUTTON_CLEAR_INTERRUPT_FLAG() intcon.INTF = 0
+/** How long the snooze button must be held to be long-pressed, in milliseconds. */
+#define BUTTON_LONG_PRESS_DURATION 1000
+
+/** The snooze button has been pressed. */
+#define BUTTON_EVENT_SNOOZE_PRESSED 0x01
+/** The snooze button has been held for BUTTON_LONG_PRESS_DURATION milliseconds, it is still pressed. */
+#define BUTTON_EVENT_SNOOZE_LONG_PRESSED 0x02
+/** The snooze button has been released. */
+#define BUTTON_EVENT_SNOOZE_RELEASED 0x04
+/** The alarm switch has been moved to the "enabled" position. */
+#define BUTTON_EVENT_ALARM_SWITCH_ENABLED 0x08
+/** The alarm switch has been moved to the "disabled" position. */
+#define BUTTON_EVENT_ALARM_SWITCH_DISABLED 0x10
 
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize the alarm and snooze buttons pins. */
+/** Initialize the alarm and snooze buttons pins. The current inputs levels are taken as the debounced states, so no event is generated on boot. */
 void ButtonInitialize(void);
 
-/** Test the alarm button to check whether the alarm is enabled or not
+/** Must be called on each system tick to sample the inputs. The SCHEDULER_EVENT_BUTTON event is posted when a debounced input changes or when the snooze button is long-pressed. */
+void ButtonSampleInputs(void);
+
+/** Get the inputs events that happened since the last call and clear them.
+ * @return The BUTTON_EVENT_xxx values OR'ed, 0 if nothing happened.
+ */
+unsigned char ButtonGetEvents(void);
+
+/** Test the alarm switch debounced position to check whether the alarm is enabled or not.
  * @return 0 if the alarm is disabled,
  * @return 1 if the alarm is enabled.
  */
-#define ButtonIsAlarmEnabled() portc.2
+unsigned char ButtonIsAlarmEnabled(void);
+
+/** Get how many bounces were filtered out, a high value tells that a contact is worn.
+ * @return The bounces count, saturated to 255.
+ */
+unsigned char ButtonGetBouncesCount(void);
 
-#endif
\ No newline at end of file
+#endif
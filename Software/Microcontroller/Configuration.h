@@ -0,0 +1,27 @@
+/** @file Configuration.h
+ * Select the build profile. All timing constants (baud rates, timers, delays...) are derived from the core frequency selected here.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_CONFIGURATION_H
+#define H_CONFIGURATION_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** Set to 1 to build the firmware for a 20MHz crystal, or to 0 to build it for the original 4MHz crystal. */
+#define CONFIGURATION_IS_20MHZ_PROFILE_ENABLED 0
+
+#if CONFIGURATION_IS_20MHZ_PROFILE_ENABLED
+	/** The core frequency in Hz. Main.c selects the matching "#pragma CLOCK_FREQ" value. */
+	#define CONFIGURATION_CLOCK_FREQUENCY 20000000
+	/** The oscillator fuse matching the crystal. */
+	#define CONFIGURATION_OSCILLATOR_MODE _HS_OSC
+#else
+	#define CONFIGURATION_CLOCK_FREQUENCY 4000000
+	#define CONFIGURATION_OSCILLATOR_MODE _XT_OSC
+#endif
+
+/** How many instruction cycles are executed in a second. */
+#define CONFIGURATION_INSTRUCTION_FREQUENCY (CONFIGURATION_CLOCK_FREQUENCY / 4)
+
+#endif
@@ -3,47 +3,13 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
+#include "Configuration.h"
 #include "Display.h"
+#include "System_Tick.h"
 
 //--------------------------------------------------------------------------------------------------
 // Private constants and macros
 //--------------------------------------------------------------------------------------------------
-/** Wait 64s. */
-// Can't use a scope or the preprocessor will fail
-#define DISPLAY_WAIT_64_MICROSECONDS() \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop \
-	asm nop
-
 /** The R/S signal. */
 #define DISPLAY_SIGNAL_RS portb.2
 /** The R/W signal. */
@@ -51,14 +17,16 @@
 /** The E signal. */
 #define DISPLAY_SIGNAL_E portb.3
 
-/** The timer reload value to get the requested 2Hz interrupt rate (called Finterrupt below). */
-#define DISPLAY_TIMER_RELOAD_VALUE 3036 // Reload_Value = 65536 - (((Fosc/4) / Prescaler)) / Finterrupt) with Prescaler = 8
+/** The E signal minimum high level duration in nanoseconds (the HD44780 PWEH parameter), the data must also be stable for 195ns before E falls. */
+#define DISPLAY_ENABLE_PULSE_WIDTH 450
 
-//--------------------------------------------------------------------------------------------------
-// Private variables
-//--------------------------------------------------------------------------------------------------
-/** Count how many half-seconds the backlight is being lighted. */
-static unsigned char Display_Backlight_Half_Seconds_Counter; // The timer counts at 2Hz
+// An instruction cycle lasts 1s at 4MHz, which is long enough, but a faster core must hold E high for longer
+#if CONFIGURATION_INSTRUCTION_FREQUENCY > 1000000000 / DISPLAY_ENABLE_PULSE_WIDTH
+	/** Keep the E signal high long enough for the display controller to latch the data. */
+	#define DISPLAY_WAIT_ENABLE_PULSE_WIDTH() delay_us(1)
+#else
+	#define DISPLAY_WAIT_ENABLE_PULSE_WIDTH()
+#endif
 
 //--------------------------------------------------------------------------------------------------
 // Private functions
@@ -77,12 +45,28 @@ inline void DisplayWrite(unsigned char Byte, unsigned char Is_Data)
 	portb &= 0x0F; // Clear bits 7 to 4
 	DISPLAY_SIGNAL_E = 1;
 	portb |= Byte & 0xF0;
+	DISPLAY_WAIT_ENABLE_PULSE_WIDTH();
 	DISPLAY_SIGNAL_E = 0;
 	
 	// Send the lower nibble
 	portb &= 0x0F; // Clear bits 7 to 4
 	DISPLAY_SIGNAL_E = 1;
 	portb |= (Byte << 4) & 0xF0;
+	DISPLAY_WAIT_ENABLE_PULSE_WIDTH();
+	DISPLAY_SIGNAL_E = 0;
+}
+
+/** Send a single nibble of command, which the controller takes as a whole command when it uses its 8-bit interface.
+ * @param Nibble The command upper nibble, in the 4 lower bits.
+ */
+static void DisplayWriteCommandNibble(unsigned char Nibble)
+{
+	DISPLAY_SIGNAL_RS = 0;
+	DISPLAY_SIGNAL_RW = 0;
+	portb &= 0x0F; // Clear bits 7 to 4
+	portb |= Nibble << 4;
+	DISPLAY_SIGNAL_E = 1;
+	DISPLAY_WAIT_ENABLE_PULSE_WIDTH();
 	DISPLAY_SIGNAL_E = 0;
 }
 
@@ -117,24 +101,35 @@ inline void DisplayWaitForOperationEnd(void)
 //--------------------------------------------------------------------------------------------------
 // Public functions
 //--------------------------------------------------------------------------------------------------
-void DisplayInitialize(void)
+void DisplayInitialize(unsigned char Is_Warm_Boot)
 {
 	// Configure pins
 	trisc.5 = 0; // Display backlight
 	trisb &= 0x01; // Set RB7 to RB1 as output
 	
+	// The display controller kept its configuration, but the reset may have happened between the two nibbles of a byte. Three 8-bit Function Set commands bring the controller back to the 8-bit interface whatever nibble it was waiting for, then the 4-bit interface is selected again
+	if (Is_Warm_Boot)
+	{
+		DisplayWriteCommandNibble(0x03);
+		delay_ms(2); // The nibble can complete a Return Home command, which lasts 1.52ms
+		DisplayWriteCommandNibble(0x03);
+		delay_us(100); // Wait at least 37s
+		DisplayWriteCommandNibble(0x03);
+		delay_us(100);
+		DisplayWriteCommandNibble(0x02);
+		delay_us(100);
+		
+		// The lower data lines are not connected, so the single-nibble Function Set selected one line
+		DisplayWrite(0x2C, 0); // Set the display interface to 4 bits, enable use of both lines and select 5x8 font
+		delay_us(100);
+		return;
+	}
+	
 	// Wait 40ms as requested and even more to be sure
 	delay_ms(50);
 	
 	// Send the initial Function Set command which is not in two parts
-	DISPLAY_SIGNAL_RS = 0;
-	DISPLAY_SIGNAL_RW = 0;
-	portb.7 = 0;
-	portb.6 = 0;
-	portb.5 = 1;
-	portb.4 = 1;
-	DISPLAY_SIGNAL_E = 1;
-	DISPLAY_SIGNAL_E = 0;
+	DisplayWriteCommandNibble(0x03);
 	delay_ms(1); // Wait at least 37s
 	
 	// Send Function Set command a second time
@@ -156,9 +151,6 @@ void DisplayInitialize(void)
 	// Send Entry Mode Set command
 	DisplayWrite(0x06, 0); // Set cursor moving direction to right, disable display shifting (i.e. scrolling)
 	delay_ms(1); // Wait at least 37s
-	
-	// Configure timer 1 to be used as the backlight timer
-	t1con = 0x30; // Select a 1:8 prescaler, disable the built-in oscillator circuit, use Fosc/4 as clock source, do not enable the timer
 }
 
 void DisplayBacklightOn(void)
@@ -166,51 +158,26 @@ void DisplayBacklightOn(void)
 	// Turn the backlight on
 	portc.5 = 1;
 	
-	// Preload the timer and start it
-	tmr1h = DISPLAY_TIMER_RELOAD_VALUE >> 8;
-	tmr1l = (unsigned char) DISPLAY_TIMER_RELOAD_VALUE;
-	t1con.TMR1ON = 1;
-	
-	// Enable the timer interrupt
-	pie1.TMR1IE = 1;
-	
-	// Start counting elapsed time
-	Display_Backlight_Half_Seconds_Counter = 0;
+	// Turn it off later
+	SYSTEM_TICK_MASK_INTERRUPT();
+	SystemTickStartTimer(SYSTEM_TICK_TIMER_DISPLAY_BACKLIGHT, DISPLAY_BACKLIGHT_ON_DELAY * SYSTEM_TICK_FREQUENCY);
+	SYSTEM_TICK_UNMASK_INTERRUPT();
 }
 
 void DisplayWriteCharacter(unsigned char Character)
 {
 	DisplayWrite(Character, 1);
-	DISPLAY_WAIT_64_MICROSECONDS(); // Wait at least 37s
+	delay_us(40); // Wait at least 37s, the delay is computed by the compiler from the core frequency
 }
 
 void DisplaySetCursorLocation(unsigned char Location)
 {
 	DisplayWrite(0x80 | Location, 0);
-	DISPLAY_WAIT_64_MICROSECONDS(); // Wait at least 37s
+	delay_us(40); // Wait at least 37s, the delay is computed by the compiler from the core frequency
 }
 
-void DisplayInterruptHandler(void)
+void DisplayBacklightTimerHandler(void)
 {
-	Display_Backlight_Half_Seconds_Counter++;
-	if (Display_Backlight_Half_Seconds_Counter >= DISPLAY_BACKLIGHT_ON_DELAY * 2)
-	{
-		// Turn off the display backlight
-		portc.5 = 0;
-		
-		// Stop the timer
-		t1con.TMR1ON = 0;
-		pie1.TMR1IE = 0; // Disable the timer interrupt
-	}
-	else
-	{
-		// Reload the timer value
-		t1con.TMR1ON = 0; // Stop the timer to avoid a glitch when reloading its value
-		tmr1h = DISPLAY_TIMER_RELOAD_VALUE >> 8;
-		tmr1l = (unsigned char) DISPLAY_TIMER_RELOAD_VALUE;
-		t1con.TMR1ON = 1; // Restart the timer
-	}
-	
-	// Clear interrupt flag
-	pir1.TMR1IF = 0;
+	// Turn off the display backlight
+	portc.5 = 0;
 }
\ No newline at end of file
@@ -13,14 +13,13 @@
 /** How many seconds the backlight will remain lighted. */
 #define DISPLAY_BACKLIGHT_ON_DELAY 6
 
-/** Tell whether the display timer interrupt fired or not. */
-#define DISPLAY_HAS_INTERRUPT_FIRED() (pie1.TMR1IE && pir1.TMR1IF)
-
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize the display subsystem. */
-void DisplayInitialize(void);
+/** Initialize the display subsystem.
+ * @param Is_Warm_Boot Set to 1 when the microcontroller was reset while the display stayed powered, so only the microcontroller pins are configured and the 4-bit interface is resynchronized (about 3ms), the display keeps showing its content. Set to 0 to run the whole display initialization sequence (about 55ms).
+ */
+void DisplayInitialize(unsigned char Is_Warm_Boot);
 
 /** Light the display backlight for DISPLAY_BACKLIGHT_ON_DELAY seconds. */
 void DisplayBacklightOn(void);
@@ -35,7 +34,7 @@ void DisplayWriteCharacter(unsigned char Character);
  */
 void DisplaySetCursorLocation(unsigned char Location);
 
-/** Handle the backlight timer. */
-void DisplayInterruptHandler(void);
+/** Must be called when the SYSTEM_TICK_TIMER_DISPLAY_BACKLIGHT timer expires. */
+void DisplayBacklightTimerHandler(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+/** @file Interrupt_Trace.c
+ * @see Interrupt_Trace.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Interrupt_Trace.h"
+#include "RTC.h"
+#include "System_Tick.h"
+#include "Temperature_Sensor.h"
+#include "UART.h"
+
+#if INTERRUPT_TRACE_IS_ENABLED
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** A trace entry, one per interrupt handler call. */
+typedef struct
+{
+	unsigned char Sources; //!< Bits 2..0 are the pending sources when the handler was entered, bits 4..3 are unused, bits 7..5 are how many sources were served.
+	unsigned short Served_Sources; //!< All served sources, in the order they were served in (3 bits per source, first served source is in bits 2..0).
+	unsigned short Entry_Time; //!< The time when the handler was entered.
+	unsigned short Duration; //!< How many cycles the handler lasted.
+} TInterruptTraceEntry;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The trace ring buffer. */
+static TInterruptTraceEntry Interrupt_Trace_Entries[INTERRUPT_TRACE_ENTRIES_COUNT];
+/** The entry being filled. */
+static unsigned char Interrupt_Trace_Current_Entry_Index;
+/** How many entries are valid (it is saturated to INTERRUPT_TRACE_ENTRIES_COUNT). */
+static unsigned char Interrupt_Trace_Entries_Count;
+/** Set to 1 to stop recording while the trace is sent. */
+static unsigned char Interrupt_Trace_Is_Frozen;
+
+/** The longest interrupt handler call. */
+static TInterruptTraceEntry Interrupt_Trace_Longest_Entry;
+/** The longest time elapsed between a system tick and the interrupt handler entry. */
+static unsigned short Interrupt_Trace_Worst_Latency;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Send a trace entry through the UART.
+ * @param Pointer_Entry The entry to send.
+ */
+static void InterruptTraceSendEntry(TInterruptTraceEntry *Pointer_Entry)
+{
+	UARTWriteByte(Pointer_Entry->Sources);
+	UARTWriteByte(Pointer_Entry->Served_Sources >> 8);
+	UARTWriteByte((unsigned char) Pointer_Entry->Served_Sources);
+	UARTWriteByte(Pointer_Entry->Entry_Time >> 8);
+	UARTWriteByte((unsigned char) Pointer_Entry->Entry_Time);
+	UARTWriteByte(Pointer_Entry->Duration >> 8);
+	UARTWriteByte((unsigned char) Pointer_Entry->Duration);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void InterruptTraceInitialize(void)
+{
+	Interrupt_Trace_Current_Entry_Index = 0;
+	Interrupt_Trace_Entries_Count = 0;
+	Interrupt_Trace_Is_Frozen = 0;
+	Interrupt_Trace_Longest_Entry.Duration = 0;
+	Interrupt_Trace_Worst_Latency = 0;
+}
+
+void InterruptTraceBegin(void)
+{
+	TInterruptTraceEntry *Pointer_Entry;
+	unsigned char Pending_Sources = 0, Timer_Value;
+	unsigned short Latency;
+	
+	if (Interrupt_Trace_Is_Frozen) return;
+	
+	Pointer_Entry = &Interrupt_Trace_Entries[Interrupt_Trace_Current_Entry_Index];
+	Pointer_Entry->Entry_Time = SystemTickGetTime();
+	
+	// Sample the pending sources as soon as possible
+	if (SYSTEM_TICK_HAS_INTERRUPT_FIRED())
+	{
+		Pending_Sources |= 1 << INTERRUPT_TRACE_SOURCE_SYSTEM_TICK;
+		
+		// Timer 1 has been reset to zero by the tick, so its value is the time elapsed since the interrupt request
+		Timer_Value = tmr1l;
+		Latency = ((unsigned short) tmr1h << 8) | Timer_Value;
+		if (Latency > Interrupt_Trace_Worst_Latency) Interrupt_Trace_Worst_Latency = Latency;
+	}
+	if (TEMPERATURE_SENSOR_HAS_INTERRUPT_FIRED()) Pending_Sources |= 1 << INTERRUPT_TRACE_SOURCE_TEMPERATURE_SENSOR;
+	if (UART_HAS_INTERRUPT_FIRED()) Pending_Sources |= 1 << INTERRUPT_TRACE_SOURCE_UART;
+	
+	Pointer_Entry->Sources = Pending_Sources;
+	Pointer_Entry->Served_Sources = 0;
+}
+
+void InterruptTraceSourceServed(TInterruptTraceSource Source)
+{
+	TInterruptTraceEntry *Pointer_Entry;
+	unsigned char Served_Sources_Count;
+	
+	if (Interrupt_Trace_Is_Frozen) return;
+	
+	Pointer_Entry = &Interrupt_Trace_Entries[Interrupt_Trace_Current_Entry_Index];
+	Served_Sources_Count = Pointer_Entry->Sources >> 5;
+	if (Served_Sources_Count >= 5) return; // Only 5 sources fit in the served sources word
+	
+	Pointer_Entry->Served_Sources |= (unsigned short) Source << (Served_Sources_Count * 3);
+	Pointer_Entry->Sources += 0x20;
+}
+
+void InterruptTraceEnd(void)
+{
+	TInterruptTraceEntry *Pointer_Entry;
+	
+	if (Interrupt_Trace_Is_Frozen) return;
+	
+	// The duration is not saturated, so the longest interrupt can still be told apart from the other long ones
+	Pointer_Entry = &Interrupt_Trace_Entries[Interrupt_Trace_Current_Entry_Index];
+	Pointer_Entry->Duration = SystemTickGetTime() - Pointer_Entry->Entry_Time;
+	
+	// Keep the longest interrupt
+	if (Pointer_Entry->Duration > Interrupt_Trace_Longest_Entry.Duration)
+	{
+		Interrupt_Trace_Longest_Entry.Sources = Pointer_Entry->Sources;
+		Interrupt_Trace_Longest_Entry.Served_Sources = Pointer_Entry->Served_Sources;
+		Interrupt_Trace_Longest_Entry.Entry_Time = Pointer_Entry->Entry_Time;
+		Interrupt_Trace_Longest_Entry.Duration = Pointer_Entry->Duration;
+	}
+	
+	// Go to next entry
+	Interrupt_Trace_Current_Entry_Index = (Interrupt_Trace_Current_Entry_Index + 1) & (INTERRUPT_TRACE_ENTRIES_COUNT - 1);
+	if (Interrupt_Trace_Entries_Count < INTERRUPT_TRACE_ENTRIES_COUNT) Interrupt_Trace_Entries_Count++;
+}
+
+void InterruptTraceSend(void)
+{
+	unsigned char i, Index;
+	
+	Interrupt_Trace_Is_Frozen = 1;
+	
+	// Start from the oldest entry
+	UARTWriteByte(Interrupt_Trace_Entries_Count);
+	Index = (Interrupt_Trace_Current_Entry_Index - Interrupt_Trace_Entries_Count) & (INTERRUPT_TRACE_ENTRIES_COUNT - 1);
+	for (i = 0; i < Interrupt_Trace_Entries_Count; i++)
+	{
+		InterruptTraceSendEntry(&Interrupt_Trace_Entries[Index]);
+		Index = (Index + 1) & (INTERRUPT_TRACE_ENTRIES_COUNT - 1);
+	}
+	
+	// Send worst cases
+	InterruptTraceSendEntry(&Interrupt_Trace_Longest_Entry);
+	UARTWriteByte(Interrupt_Trace_Worst_Latency >> 8);
+	UARTWriteByte((unsigned char) Interrupt_Trace_Worst_Latency);
+	
+	Interrupt_Trace_Is_Frozen = 0;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/** @file Interrupt_Trace.h
+ * Record which interrupt sources were pending each time the interrupt handler is entered, the order they were served in, when the handler was entered and how long it lasted.
+ * The system tick is used as time base, so all times are expressed in its increments (see SystemTickGetTime()).
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_INTERRUPT_TRACE_H
+#define H_INTERRUPT_TRACE_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** Set to 1 to build the interrupt trace in the firmware, set to 0 to make all trace macros expand to nothing. */
+#define INTERRUPT_TRACE_IS_ENABLED 0
+
+/** How many interrupts are kept in the trace. This must be a power of two. */
+#define INTERRUPT_TRACE_ENTRIES_COUNT 8
+
+#if INTERRUPT_TRACE_IS_ENABLED
+	/** Must be the first thing done by the interrupt handler. */
+	#define INTERRUPT_TRACE_BEGIN() InterruptTraceBegin()
+	/** Must be called each time an interrupt source has been served.
+	 * @param Source The served source.
+	 */
+	#define INTERRUPT_TRACE_SOURCE_SERVED(Source) InterruptTraceSourceServed(Source)
+	/** Must be the last thing done by the interrupt handler. */
+	#define INTERRUPT_TRACE_END() InterruptTraceEnd()
+#else
+	#define INTERRUPT_TRACE_BEGIN()
+	#define INTERRUPT_TRACE_SOURCE_SERVED(Source)
+	#define INTERRUPT_TRACE_END()
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All traced interrupt sources. */
+typedef enum
+{
+	INTERRUPT_TRACE_SOURCE_SYSTEM_TICK, //!< The system tick (timer 1 reset by CCP1).
+	INTERRUPT_TRACE_SOURCE_TEMPERATURE_SENSOR, //!< The ADC conversion end.
+	INTERRUPT_TRACE_SOURCE_UART //!< The UART reception or the transmission of an answer sent from the interrupt.
+} TInterruptTraceSource;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+#if INTERRUPT_TRACE_IS_ENABLED
+	/** Clear the trace. */
+	void InterruptTraceInitialize(void);
+
+	/** Start a new trace entry. */
+	void InterruptTraceBegin(void);
+
+	/** Append a source to the served sources list of the current entry.
+	 * @param Source The source that has just been served.
+	 */
+	void InterruptTraceSourceServed(TInterruptTraceSource Source);
+
+	/** Terminate the current trace entry and update the worst case values. */
+	void InterruptTraceEnd(void);
+
+	/** Send the trace through the UART, from the oldest entry to the newest one. The trace is frozen while it is sent. Each 16-bit value is sent most significant byte first.
+	 * Frame format : entries count, the entries, the entry of the longest interrupt, the worst system tick entry latency.
+	 * Entry format : pending sources bit mask (bits 2..0, a bit is set when the source of the same number was pending) and served sources count (bits 7..5), served sources numbers (16 bits, 3 bits per source, the first served in bits 2..0), entry time (16 bits, in the system tick time base), duration (16 bits).
+	 */
+	void InterruptTraceSend(void);
+#endif
+
+#endif
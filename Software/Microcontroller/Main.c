@@ -4,66 +4,125 @@
  */
 #include <system.h>
 #include "Button.h"
+#include "Configuration.h"
 #include "Display.h"
+#include "Interrupt_Trace.h"
+#include "Profiler.h"
 #include "Ring.h"
 #include "RTC.h"
+#include "Scheduler.h"
+#include "Status.h"
+#include "System_Tick.h"
+#include "Tables.h"
 #include "Temperature_Sensor.h"
+#include "Time_Compensation.h"
+#include "Timestamp.h"
 #include "UART.h"
 
 //--------------------------------------------------------------------------------------------------
 // Microcontroller configuration
 //--------------------------------------------------------------------------------------------------
 // Microcontroller fuses
-#pragma DATA _CONFIG, _CP_OFF & _DEBUG_OFF & _WRT_ENABLE_OFF & _CPD_OFF & _LVP_OFF & _BODEN_ON & _PWRTE_ON & _WDT_OFF & _XT_OSC // Disable code protection, disable background debugger, disable flash memory writing, disable EEPROM write protection, disable the Low-Voltage Programming, enable the Brown-Out Reset, enable the Power-On Timer, disable the watchdog timer, use a crystal oscillator
+#pragma DATA _CONFIG, _CP_OFF & _DEBUG_OFF & _WRT_ENABLE_ON & _CPD_OFF & _LVP_OFF & _BODEN_ON & _PWRTE_ON & _WDT_OFF & CONFIGURATION_OSCILLATOR_MODE // Disable code protection, disable background debugger, enable flash memory writing (needed by the bootloader), disable EEPROM write protection, disable the Low-Voltage Programming, enable the Brown-Out Reset, enable the Power-On Timer, disable the watchdog timer, use a crystal oscillator
 
-// Core frequency
-#pragma CLOCK_FREQ 4000000
+// Core frequency (the pragma needs a literal value)
+#if CONFIGURATION_CLOCK_FREQUENCY == 20000000
+	#pragma CLOCK_FREQ 20000000
+#elif CONFIGURATION_CLOCK_FREQUENCY == 4000000
+	#pragma CLOCK_FREQ 4000000
+#else
+	#error "Unsupported core frequency."
+#endif
 
 //--------------------------------------------------------------------------------------------------
 // Private constants
 //--------------------------------------------------------------------------------------------------
 /** The alarm base address in RTC RAM. */
 #define MAIN_ALARM_BASE_ADDRESS 0x08
+/** The ringtone address in RTC RAM. */
+#define MAIN_RINGTONE_ADDRESS 0x0A
+/** The unit address base address in RTC RAM, the address is followed by its complement. */
+#define MAIN_UNIT_ADDRESS_BASE_ADDRESS 0x0B
+
+/** How many seconds between two temperature samples. */
+#define MAIN_TEMPERATURE_SAMPLING_PERIOD 10
+
+/** The filtered temperature value telling that no temperature has been sampled yet. */
+#define MAIN_FILTERED_TEMPERATURE_NONE 0xFFFF
+
+/** How many characters the alarm label contains. */
+#define MAIN_ALARM_LABEL_LENGTH 9
+
+/** Tell that the configuration kept in RAM is valid (a value that could hardly be randomly found in RAM after a power on). */
+#define MAIN_WARM_BOOT_SIGNATURE 0x5A
 
 //--------------------------------------------------------------------------------------------------
 // Private variables
 //--------------------------------------------------------------------------------------------------
-/** The string corresponding to each day index. */
-static unsigned char *String_Day_Names[] =
-{
-	NULL, // Index 0 does not exist
-	"DIM",
-	"LUN",
-	"MAR",
-	"MER",
-	"JEU",
-	"VEN",
-	"SAM"
-};	
+/** The current date and time. */
+static TRTCClockData Main_Clock_Data;
+/** The alarm hour in BCD format. */
+static unsigned char Main_Alarm_Hour;
+/** The alarm minutes in BCD format. */
+static unsigned char Main_Alarm_Minutes;
+/** The selected ringtone. */
+static unsigned char Main_Ringtone;
+/** The unit address, UART_UNIT_ADDRESS_NONE when the clock is alone on its line. */
+static unsigned char Main_Unit_Address;
+
+/** Set to MAIN_WARM_BOOT_SIGNATURE when the alarm, ringtone and unit address variables hold the saved configuration. Like them, it has no initializer so the C startup code leaves it untouched on a reset. */
+static unsigned char Main_Warm_Boot_Signature;
+/** The checksum of the configuration kept in RAM, it detects a RAM corruption during a brown-out. */
+static unsigned char Main_Warm_Boot_Checksum;
+
+/** The day of the month the date line has been displayed for. Set to an invalid day to force the date line to be displayed on next tick. */
+static unsigned char Main_Displayed_Day;
+/** The temperature smoothed by a first-order low-pass filter, in 1/16 centigrade degrees. */
+static unsigned short Main_Filtered_Temperature = MAIN_FILTERED_TEMPERATURE_NONE;
+/** Set to 1 while the alarm time is displayed instead of the date. */
+static unsigned char Main_Is_Alarm_Displayed = 0;
+/** The text displayed before the alarm time. */
+static rom char *Main_String_Alarm_Label = "REVEIL   ";
+
+/** How many ticks elapsed since the last temperature sample. */
+static unsigned char Main_Temperature_Sampling_Ticks_Counter = 0;
 
 //--------------------------------------------------------------------------------------------------
 // Interrupts handler
 //--------------------------------------------------------------------------------------------------
 void interrupt(void)
 {
-	// Handle the ring interrupt
-	if (RING_HAS_INTERRUPT_FIRED()) RingInterruptHandler();
+	unsigned char Expired_Timers;
+	
+	INTERRUPT_TRACE_BEGIN();
 	
-	// Handle the snooze button interrupt
-	if (BUTTON_HAS_INTERRUPT_FIRED())
+	// Handle the system tick and dispatch the expired software timers
+	if (SYSTEM_TICK_HAS_INTERRUPT_FIRED())
 	{
-		RingStop(); // Stop the alarm in case it was ringing
-		DisplayBacklightOn();
+		Expired_Timers = SystemTickInterruptHandler();
+		if (Expired_Timers & SYSTEM_TICK_TIMER_MASK(SYSTEM_TICK_TIMER_RING)) RingTimerHandler();
+		if (Expired_Timers & SYSTEM_TICK_TIMER_MASK(SYSTEM_TICK_TIMER_DISPLAY_BACKLIGHT)) DisplayBacklightTimerHandler();
 		
-		// Clear the interrupt flag
-		BUTTON_CLEAR_INTERRUPT_FLAG();
+		// Sample the buttons at a fixed rate, so the interrupt load does not depend on how much they bounce
+		ButtonSampleInputs();
+		INTERRUPT_TRACE_SOURCE_SERVED(INTERRUPT_TRACE_SOURCE_SYSTEM_TICK);
 	}
 	
-	// Handle the display backlight timer
-	if (DISPLAY_HAS_INTERRUPT_FIRED()) DisplayInterruptHandler();
+	// Handle the temperature sensor conversion end
+	if (TEMPERATURE_SENSOR_HAS_INTERRUPT_FIRED())
+	{
+		TemperatureSensorInterruptHandler();
+		INTERRUPT_TRACE_SOURCE_SERVED(INTERRUPT_TRACE_SOURCE_TEMPERATURE_SENSOR);
+	}
 	
 	// Handle the serial port used to configure the clock
-	if (UART_HAS_INTERRUPT_FIRED()) UARTInterruptHandler();
+	if (UART_HAS_INTERRUPT_FIRED())
+	{
+		UARTInterruptHandler();
+		INTERRUPT_TRACE_SOURCE_SERVED(INTERRUPT_TRACE_SOURCE_UART);
+	}
+	
+	INTERRUPT_TRACE_END();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -80,110 +139,423 @@ inline void MainConvertBCDToASCII(unsigned char BCD_Number, unsigned char *Point
 	*Pointer_Units_Character = (BCD_Number & 0x0F) + '0';
 }
 
+/** Fill a 16-bit status field.
+ * @param Pointer_Word The field.
+ * @param Value The field value.
+ */
+inline void MainSetStatusWord(TStatusWord *Pointer_Word, unsigned short Value)
+{
+	Pointer_Word->High_Byte = Value >> 8;
+	Pointer_Word->Low_Byte = (unsigned char) Value;
+}
+
+/** Compute the checksum of the configuration kept in RAM.
+ * @return The checksum.
+ */
+static unsigned char MainComputeWarmBootChecksum(void)
+{
+	return MAIN_WARM_BOOT_SIGNATURE + Main_Alarm_Hour + Main_Alarm_Minutes + Main_Ringtone + Main_Unit_Address;
+}
+
+/** Must be called each time the configuration kept in RAM changes, so the next warm boot can use it. */
+static void MainUpdateWarmBootChecksum(void)
+{
+	Main_Warm_Boot_Checksum = MainComputeWarmBootChecksum();
+	Main_Warm_Boot_Signature = MAIN_WARM_BOOT_SIGNATURE;
+}
+
+/** Tell whether the microcontroller was reset while the board stayed powered (brown-out or MCLR reset), so the display, the RTC and the configuration kept in RAM did not lose their state.
+ * @return 1 if the peripherals and the RAM content can be reused,
+ * @return 0 if the board has just been powered on (or the RAM content is corrupted) and everything must be initialized.
+ */
+static unsigned char MainIsWarmBoot(void)
+{
+	unsigned char Is_Warm_Boot = 0;
+	
+	// The POR bit is cleared by a power-on reset only, and the RAM content is random after a power on
+	if (pcon.NOT_POR && (Main_Warm_Boot_Signature == MAIN_WARM_BOOT_SIGNATURE) && (Main_Warm_Boot_Checksum == MainComputeWarmBootChecksum())) Is_Warm_Boot = 1;
+	
+	// The status bits must be set by software to tell the next reset cause
+	pcon.NOT_POR = 1;
+	pcon.NOT_BOR = 1;
+	
+	return Is_Warm_Boot;
+}
+
+/** Load the configuration stored in the RTC RAM, so it can survive a power loss. */
+static void MainLoadConfiguration(void)
+{
+	Main_Alarm_Hour = RTCReadRAMByte(MAIN_ALARM_BASE_ADDRESS);
+	Main_Alarm_Minutes = RTCReadRAMByte(MAIN_ALARM_BASE_ADDRESS + 1);
+	Main_Ringtone = RTCReadRAMByte(MAIN_RINGTONE_ADDRESS);
+	
+	// The unit address is stored with its complement so a clock whose RTC RAM was never initialized stays alone on its line
+	Main_Unit_Address = RTCReadRAMByte(MAIN_UNIT_ADDRESS_BASE_ADDRESS);
+	if (RTCReadRAMByte(MAIN_UNIT_ADDRESS_BASE_ADDRESS + 1) != (unsigned char) ~Main_Unit_Address) Main_Unit_Address = UART_UNIT_ADDRESS_NONE;
+	
+	MainUpdateWarmBootChecksum();
+}
+
+/** Apply the configuration received from the UART. */
+static void MainApplyConfiguration(void)
+{
+	unsigned char Field_Mask;
+	
+	PROFILER_BEGIN_PHASE();
+	Field_Mask = UARTAreConfigurationDataAvailable(&Main_Clock_Data, &Main_Alarm_Hour, &Main_Alarm_Minutes);
+	
+	// Set the new RTC date and time fields only, so an alarm change does not touch the running clock
+	if (Field_Mask & (UART_CONFIGURATION_FIELD_MASK_TIME | UART_CONFIGURATION_FIELD_MASK_DATE))
+	{
+		RTCSetDateAndTime(&Main_Clock_Data, Field_Mask & (UART_CONFIGURATION_FIELD_MASK_TIME | UART_CONFIGURATION_FIELD_MASK_DATE));
+		if (Field_Mask & UART_CONFIGURATION_FIELD_MASK_TIME) TimeCompensationClearError(); // The new time is accurate
+		
+		// The date may have changed
+		Main_Displayed_Day = 0xFF;
+	}
+	
+	// Save the alarm to the RTC RAM right now, missing it after a power loss would be the worst failure of an alarm clock
+	if (Field_Mask & UART_CONFIGURATION_FIELD_MASK_ALARM)
+	{
+		RTCWriteRAMByte(MAIN_ALARM_BASE_ADDRESS, Main_Alarm_Hour);
+		RTCWriteRAMByte(MAIN_ALARM_BASE_ADDRESS + 1, Main_Alarm_Minutes);
+		RTCFlushRAMCache();
+		MainUpdateWarmBootChecksum();
+	}
+	PROFILER_END_PHASE(PROFILER_PHASE_UART_CONFIGURATION);
+}
+
+/** Display the date line. */
+static void MainDisplayDate(void)
+{
+	unsigned char Tens_Character, Units_Character, i;
+	
+	// Display the day of the week
+	DisplaySetCursorLocation(0x41); // Second line
+	for (i = 0; i < TABLES_DAY_NAME_LENGTH; i++) DisplayWriteCharacter(TablesGetDayNameCharacter(Main_Clock_Data.Register_Name.Day_Of_Week, i));
+	DisplayWriteCharacter(' ');
+	
+	// Display the day
+	MainConvertBCDToASCII(Main_Clock_Data.Register_Name.Day, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	DisplayWriteCharacter('/');
+	
+	// Display the month
+	MainConvertBCDToASCII(Main_Clock_Data.Register_Name.Month, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	DisplayWriteCharacter('/');
+	
+	// Display the year
+	MainConvertBCDToASCII(Main_Clock_Data.Register_Name.Year, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter('2');
+	DisplayWriteCharacter('0');
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+}
+
+/** Read the date and time from the RTC, then display the time and the date when the day changed.
+ * @param Is_Tick_Beginning Set to 1 when called right after a tick began, so the crystal drift can be corrected. Set to 0 when called at any other time.
+ */
+static void MainDisplayDateAndTime(unsigned char Is_Tick_Beginning)
+{
+	unsigned char Tens_Character, Units_Character;
+	
+	// Get the date and time to display
+	PROFILER_BEGIN_PHASE();
+	RTCGetDateAndTime(&Main_Clock_Data);
+	if (Is_Tick_Beginning) TimeCompensationCorrectTime(&Main_Clock_Data); // Correct the crystal drift before the time is used, the correction relies on the RTC being in the middle of a second
+	PROFILER_END_PHASE(PROFILER_PHASE_RTC_READ);
+	
+	// Display hours
+	PROFILER_BEGIN_PHASE();
+	MainConvertBCDToASCII(Main_Clock_Data.Register_Name.Hours, &Tens_Character, &Units_Character);
+	if (Tens_Character == '0') Tens_Character = ' '; // Do not display the leading zero
+	DisplaySetCursorLocation(0);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	DisplayWriteCharacter(':');
+	
+	// Display minutes
+	MainConvertBCDToASCII(Main_Clock_Data.Register_Name.Minutes, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	DisplayWriteCharacter(':');
+	
+	// Display seconds
+	MainConvertBCDToASCII(Main_Clock_Data.Register_Name.Seconds, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	
+	// The date line needs to be displayed only once a day
+	if ((Main_Clock_Data.Register_Name.Day != Main_Displayed_Day) && !Main_Is_Alarm_Displayed) // Do not overwrite the alarm time, the date is displayed when the button is released
+	{
+		MainDisplayDate();
+		Main_Displayed_Day = Main_Clock_Data.Register_Name.Day;
+	}
+	PROFILER_END_PHASE(PROFILER_PHASE_DISPLAY);
+}
+
+/** Display the alarm time on the date line. */
+static void MainDisplayAlarm(void)
+{
+	unsigned char Tens_Character, Units_Character, i;
+	
+	DisplaySetCursorLocation(0x41); // Second line
+	for (i = 0; i < MAIN_ALARM_LABEL_LENGTH; i++) DisplayWriteCharacter(Main_String_Alarm_Label[i]);
+	
+	MainConvertBCDToASCII(Main_Alarm_Hour, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	DisplayWriteCharacter(':');
+	MainConvertBCDToASCII(Main_Alarm_Minutes, &Tens_Character, &Units_Character);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+}
+
+/** Serve the snooze button and the alarm switch events. */
+static void MainHandleButton(void)
+{
+	unsigned char Events;
+	
+	Events = ButtonGetEvents();
+	
+	// A press stops the alarm in case it was ringing and lights the display
+	if (Events & BUTTON_EVENT_SNOOZE_PRESSED)
+	{
+		RingStop();
+		DisplayBacklightOn();
+	}
+	
+	// Show the alarm time as long as the button is held
+	if (Events & BUTTON_EVENT_SNOOZE_LONG_PRESSED)
+	{
+		MainDisplayAlarm();
+		Main_Is_Alarm_Displayed = 1;
+	}
+	if ((Events & BUTTON_EVENT_SNOOZE_RELEASED) && Main_Is_Alarm_Displayed)
+	{
+		MainDisplayDate();
+		Main_Is_Alarm_Displayed = 0;
+	}
+	
+	// The alarm can't ring anymore once it is disabled
+	if (Events & BUTTON_EVENT_ALARM_SWITCH_DISABLED) RingStop();
+}
+
+/** Publish the data read on this tick, so the UART interrupt can answer the PC without waiting for the main loop. */
+static void MainPublishStatus(void)
+{
+	TStatus *Pointer_Status;
+	unsigned char i, Flags = 0;
+	
+	Pointer_Status = StatusGetUnpublishedSnapshot();
+	for (i = 0; i < sizeof(TRTCClockData); i++) Pointer_Status->Field_Name.Clock_Data.Array[i] = Main_Clock_Data.Array[i];
+	
+	// Round the filtered temperature to the nearest degree
+	if (Main_Filtered_Temperature == MAIN_FILTERED_TEMPERATURE_NONE) Pointer_Status->Field_Name.Temperature = 0;
+	else Pointer_Status->Field_Name.Temperature = (Main_Filtered_Temperature + 8) >> 4;
+	
+	Pointer_Status->Field_Name.Alarm_Hour = Main_Alarm_Hour;
+	Pointer_Status->Field_Name.Alarm_Minutes = Main_Alarm_Minutes;
+	if (ButtonIsAlarmEnabled()) Flags |= STATUS_FLAG_ALARM_ENABLED;
+	if (RingIsRinging()) Flags |= STATUS_FLAG_RINGING;
+	Pointer_Status->Field_Name.Flags = Flags;
+	
+	Pointer_Status->Field_Name.UART_Overrun_Errors_Count = UARTGetOverrunErrorsCount();
+	Pointer_Status->Field_Name.UART_Framing_Errors_Count = UARTGetFramingErrorsCount();
+	Pointer_Status->Field_Name.Button_Bounces_Count = ButtonGetBouncesCount();
+	
+	MainSetStatusWord(&Pointer_Status->Field_Name.Tick_Period, TimestampGetTickPeriod());
+	MainSetStatusWord(&Pointer_Status->Field_Name.UART_Frame_Time, TimestampGetEventTime(TIMESTAMP_EVENT_UART_FRAME));
+	MainSetStatusWord(&Pointer_Status->Field_Name.Button_Press_Time, TimestampGetEventTime(TIMESTAMP_EVENT_BUTTON_PRESS));
+	MainSetStatusWord(&Pointer_Status->Field_Name.Temperature_Sample_Time, TimestampGetEventTime(TIMESTAMP_EVENT_TEMPERATURE_SAMPLE));
+	
+	// Publish the edge along with the snapshot, so the UART interrupt always dates the requests relative to the second the snapshot reports
+	intcon.GIE = 0;
+	TimestampPublish();
+	StatusPublish();
+	intcon.GIE = 1;
+}
+
+/** Display the time, the date when the day changed, check the alarm and start a temperature sample when needed. */
+static void MainHandleTick(void)
+{
+	MainDisplayDateAndTime(1);
+	
+	// Is it time to ring ?
+	PROFILER_BEGIN_PHASE();
+	if (ButtonIsAlarmEnabled() && (Main_Clock_Data.Register_Name.Hours == Main_Alarm_Hour) && (Main_Clock_Data.Register_Name.Minutes == Main_Alarm_Minutes) && (Main_Clock_Data.Register_Name.Seconds == 0x00)) RingStart();
+	PROFILER_END_PHASE(PROFILER_PHASE_ALARM);
+	
+	MainPublishStatus();
+	
+	// Is it time to sample the temperature ?
+	Main_Temperature_Sampling_Ticks_Counter++;
+	if (Main_Temperature_Sampling_Ticks_Counter >= MAIN_TEMPERATURE_SAMPLING_PERIOD)
+	{
+		TemperatureSensorStartConversion();
+		Main_Temperature_Sampling_Ticks_Counter = 0;
+	}
+	
+	// The tick work is done, save the configuration changes of the previous second in a single transaction
+	PROFILER_BEGIN_PHASE();
+	RTCFlushRAMCache();
+	PROFILER_END_PHASE(PROFILER_PHASE_RTC_WRITE);
+}
+
+/** Display the last sampled temperature, filter it for the status and accumulate the crystal drift it causes. */
+static void MainDisplayTemperature(void)
+{
+	unsigned char Temperature, Tens_Character, Units_Character;
+	
+	// Get the sample converted to centigrade
+	PROFILER_BEGIN_PHASE();
+	Temperature = TemperatureSensorGetTemperature();
+	
+	// Smooth the sensor noise for the status with Filtered = 3/4 * Filtered + 1/4 * Sample, the first sample directly initializes the filter
+	if (Main_Filtered_Temperature == MAIN_FILTERED_TEMPERATURE_NONE) Main_Filtered_Temperature = (unsigned short) Temperature << 4;
+	else Main_Filtered_Temperature = Main_Filtered_Temperature - (Main_Filtered_Temperature >> 2) + ((unsigned short) Temperature << 2);
+	
+	// The crystal stayed at this temperature since the previous sample
+	TimeCompensationAccumulateError(Temperature, MAIN_TEMPERATURE_SAMPLING_PERIOD);
+	
+	// Convert the binary value to digits, the display shows the raw sample
+	MainConvertBCDToASCII(TablesConvertBinaryToBCD(Temperature), &Tens_Character, &Units_Character);
+	PROFILER_END_PHASE(PROFILER_PHASE_TEMPERATURE);
+	
+	// Display the value
+	PROFILER_BEGIN_PHASE();
+	DisplaySetCursorLocation(0x0C);
+	DisplayWriteCharacter(Tens_Character);
+	DisplayWriteCharacter(Units_Character);
+	DisplayWriteCharacter(0xDF); // An equivalent of the "degree" character with the japanese character map version
+	DisplayWriteCharacter('C');
+	PROFILER_END_PHASE(PROFILER_PHASE_DISPLAY);
+}
+
+/** Stop the clock and start the bootloader, so the firmware can be updated. */
+static void MainStartBootloader(void)
+{
+	intcon.GIE = 0;
+	
+	// The new firmware may use the RAM in another way, so it must not trust the configuration kept in RAM. Save the configuration that was not written to the RTC yet
+	Main_Warm_Boot_Signature = 0;
+	RTCFlushRAMCache();
+	
+	// Let the acknowledge be fully transmitted, as the bootloader configures the UART again
+	while (!txsta.TRMT);
+	
+	// The reset vector always starts the bootloader, which waits for the host only when the POR bit tells a power-on reset
+	pcon.NOT_POR = 0;
+	pclath = 0;
+	pcl = 0;
+}
+
+/** Serve the requests that are too long to be handled by the UART interrupt. */
+static void MainServeUARTRequest(void)
+{
+	TTimeCompensationCurve Crystal_Curve;
+	unsigned char Requests;
+	
+	// Several requests can be received before the main loop serves them
+	Requests = UARTGetRequests();
+	
+	if (Requests & UART_REQUEST_SET_RINGTONE)
+	{
+		Main_Ringtone = UARTGetRingtone();
+		RingSetMelody(Main_Ringtone);
+		RTCWriteRAMByte(MAIN_RINGTONE_ADDRESS, Main_Ringtone); // Save it to the RTC RAM, so it can survive a power loss
+		MainUpdateWarmBootChecksum();
+	}
+	
+	if (Requests & UART_REQUEST_SET_CRYSTAL_CURVE)
+	{
+		UARTGetCrystalCurve(&Crystal_Curve);
+		TimeCompensationSetCurve(&Crystal_Curve);
+	}
+	
+	if (Requests & UART_REQUEST_SET_UNIT_ADDRESS)
+	{
+		Main_Unit_Address = UARTGetUnitAddress();
+		RTCWriteRAMByte(MAIN_UNIT_ADDRESS_BASE_ADDRESS, Main_Unit_Address);
+		RTCWriteRAMByte(MAIN_UNIT_ADDRESS_BASE_ADDRESS + 1, ~Main_Unit_Address);
+		MainUpdateWarmBootChecksum();
+	}
+	
+	#if PROFILER_IS_ENABLED
+		if (Requests & UART_REQUEST_SEND_PROFILER_STATISTICS) ProfilerSendStatistics();
+	#endif
+	
+	#if INTERRUPT_TRACE_IS_ENABLED
+		if (Requests & UART_REQUEST_SEND_INTERRUPT_TRACE) InterruptTraceSend();
+	#endif
+	
+	// The bootloader never returns, so serve the other requests first
+	if (Requests & UART_REQUEST_ENTER_BOOTLOADER) MainStartBootloader();
+}
+
 //--------------------------------------------------------------------------------------------------
 // Entry point
 //--------------------------------------------------------------------------------------------------
 void main(void)
 {
-	TRTCClockData Clock_Data;
-	unsigned char i, Tens_Character, Units_Character, Temperature, Alarm_Hour, Alarm_Minutes;
-
+	unsigned char Events, Is_Warm_Boot;
+	
+	// A brown-out or a reset button press do not need the display and the RTC to be initialized again, which is much faster
+	Is_Warm_Boot = MainIsWarmBoot();
+	
 	// Initialize the modules
+	SchedulerInitialize(); // Must be called before any module that can post an event
+	SystemTickInitialize(); // Must be called before any module that uses a software timer
+	TimestampInitialize(); // Must be called before any module that can capture an event
+	StatusInitialize(); // Must be called before UARTInitialize() as the UART interrupt sends the published snapshot
 	TemperatureSensorInitialize(); // Must be called before RTCInitialize() as TemperatureSensorInitialize() initializes the port A used by the RTC code too
-	RTCInitialize();
+	RTCInitialize(Is_Warm_Boot);
 	UARTInitialize();
 	RingInitialize();
-	DisplayInitialize();
+	DisplayInitialize(Is_Warm_Boot);
 	ButtonInitialize();
+	TimeCompensationInitialize(Is_Warm_Boot); // Must be called after RTCInitialize() as the crystal curve is loaded from the RTC RAM cache
+	#if PROFILER_IS_ENABLED
+		ProfilerInitialize();
+	#endif
+	#if INTERRUPT_TRACE_IS_ENABLED
+		InterruptTraceInitialize();
+	#endif
 	
 	// Enable interrupts
 	intcon.PEIE = 1; // Enable peripherals interrupts
 	intcon.GIE = 1; // Enable all interrupts
 	
-	// Load the alarm stored in the RTC RAM, so it can survive a power loss
-	RTCSetReadAddress(MAIN_ALARM_BASE_ADDRESS);
-	Alarm_Hour = RTCReadByte();
-	Alarm_Minutes = RTCReadByte();
+	// The configuration kept in RAM is still valid after a warm boot
+	if (!Is_Warm_Boot) MainLoadConfiguration();
+	RingSetMelody(Main_Ringtone);
+	UARTSetUnitAddress(Main_Unit_Address);
+	
+	// Display the time and the date right now instead of waiting for the next RTC tick
+	Main_Displayed_Day = 0xFF;
+	MainDisplayDateAndTime(0);
+	MainPublishStatus();
+	
+	// Display the temperature as soon as possible
+	TemperatureSensorStartConversion();
 	
 	while (1)
 	{
-		RTC_WAIT_TICK_BEGINNING();
-		
-		// Were new configuration data received from the UART ?
-		if (UARTAreConfigurationDataAvailable(&Clock_Data, &Alarm_Hour, &Alarm_Minutes))
-		{
-			// Set the new RTC date and time
-			RTCSetDateAndTime(&Clock_Data);
-			
-			// Save the alarm to the RTC RAM
-			RTCWriteByte(MAIN_ALARM_BASE_ADDRESS, Alarm_Hour);
-			RTCWriteByte(MAIN_ALARM_BASE_ADDRESS + 1, Alarm_Minutes);
-		}
-		
-		// Get the date and time to display
-		RTCGetDateAndTime(&Clock_Data);
+		Events = SchedulerWaitForEvents();
+		PROFILER_BEGIN_ITERATION();
 		
-		// Display hours
-		MainConvertBCDToASCII(Clock_Data.Register_Name.Hours, &Tens_Character, &Units_Character);
-		if (Tens_Character == '0') Tens_Character = ' '; // Do not display the leading zero
-		DisplaySetCursorLocation(0);
-		DisplayWriteCharacter(Tens_Character);
-		DisplayWriteCharacter(Units_Character);
-		DisplayWriteCharacter(':');
+		// Serve the button first to make it responsive
+		if (Events & SCHEDULER_EVENT_BUTTON) MainHandleButton();
+		// Apply a new configuration before the tick is handled, so the new time is immediately displayed
+		if (Events & SCHEDULER_EVENT_UART_FRAME) MainApplyConfiguration();
+		if (Events & SCHEDULER_EVENT_TICK) MainHandleTick();
+		if (Events & SCHEDULER_EVENT_ADC_READY) MainDisplayTemperature();
+		if (Events & SCHEDULER_EVENT_UART_REQUEST) MainServeUARTRequest();
 		
-		// Display minutes
-		MainConvertBCDToASCII(Clock_Data.Register_Name.Minutes, &Tens_Character, &Units_Character);
-		DisplayWriteCharacter(Tens_Character);
-		DisplayWriteCharacter(Units_Character);
-		DisplayWriteCharacter(':');
-		
-		// Display seconds
-		MainConvertBCDToASCII(Clock_Data.Register_Name.Seconds, &Tens_Character, &Units_Character);
-		DisplayWriteCharacter(Tens_Character);
-		DisplayWriteCharacter(Units_Character);
-		
-		// Display temperature
-		// Sample the temperature
-		Temperature = TemperatureSensorGetTemperature();
-		// Convert the binary value to digits
-		Tens_Character = Temperature / 10;
-		Units_Character = Temperature - ((Tens_Character << 3) + (Tens_Character << 1)); // Units = Temperature - Integer_Division(Temperature, 10)
-		// Display the value
-		DisplaySetCursorLocation(0x0C);
-		DisplayWriteCharacter(Tens_Character + '0');
-		DisplayWriteCharacter(Units_Character + '0');
-		DisplayWriteCharacter(0xDF); // An equivalent of the "degree" character with the japanese character map version
-		DisplayWriteCharacter('C');
-		
-		// Display the day of the week
-		DisplaySetCursorLocation(0x41); // Second line
-		DisplayWriteCharacter(String_Day_Names[Clock_Data.Register_Name.Day_Of_Week][0]);
-		DisplayWriteCharacter(String_Day_Names[Clock_Data.Register_Name.Day_Of_Week][1]);
-		DisplayWriteCharacter(String_Day_Names[Clock_Data.Register_Name.Day_Of_Week][2]);
-		DisplayWriteCharacter(' ');
-		
-		// Display the day
-		MainConvertBCDToASCII(Clock_Data.Register_Name.Day, &Tens_Character, &Units_Character);
-		DisplayWriteCharacter(Tens_Character);
-		DisplayWriteCharacter(Units_Character);
-		DisplayWriteCharacter('/');
-		
-		// Display the month
-		MainConvertBCDToASCII(Clock_Data.Register_Name.Month, &Tens_Character, &Units_Character);
-		DisplayWriteCharacter(Tens_Character);
-		DisplayWriteCharacter(Units_Character);
-		DisplayWriteCharacter('/');
-		
-		// Display the year
-		MainConvertBCDToASCII(Clock_Data.Register_Name.Year, &Tens_Character, &Units_Character);
-		DisplayWriteCharacter('2');
-		DisplayWriteCharacter('0');
-		DisplayWriteCharacter(Tens_Character);
-		DisplayWriteCharacter(Units_Character);
-		
-		// Is it time to ring ?
-		if (ButtonIsAlarmEnabled() && (Clock_Data.Register_Name.Hours == Alarm_Hour) && (Clock_Data.Register_Name.Minutes == Alarm_Minutes) && (Clock_Data.Register_Name.Seconds == 0x00)) RingStart();
-		
-		RTC_WAIT_TICK_END();
+		// Fold the phases durations of all served events
+		PROFILER_END_ITERATION();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,271 @@
+#!/bin/sh
+# Display the RAM and ROM usage found in a BoostC build log, the difference with a reference build log if provided, the RAM and ROM used by each module and the worst-case hardware stack depth.
+# Usage : ./Memory_Report.sh Build_Log [Reference_Build_Log]
+# The build log is the linker output saved from the SourceBoost IDE output window or from the command line tools. The per-module usage and the call tree are read from the linker assembly output (Clock.asm, next to this script).
+# The script exits with an error when a budget is exceeded, so it can be chained after the build. Budgets can be overridden with the RAM_BUDGET, ROM_BUDGET and STACK_BUDGET environment variables.
+
+# The whole PIC16F876 RAM
+RAM_Budget=${RAM_BUDGET:-368}
+# The program memory located below the bootloader (which starts at 0x1E00)
+ROM_Budget=${ROM_BUDGET:-7680}
+# The PIC16F876 hardware stack levels
+Stack_Budget=${STACK_BUDGET:-8}
+
+# All modules, the longest names must come first so a function or a variable is attributed to the module with the longest matching prefix
+Modules="Temperature_Sensor Time_Compensation Interrupt_Trace System_Tick Scheduler Timestamp Profiler Display Button Status Tables Main Ring UART RTC"
+
+# Extract a memory usage value from a build log
+# $1 : the build log file
+# $2 : the memory type ("RAM" or "ROM")
+GetUsedMemory()
+{
+	sed -n "s/^$2 available:[0-9]* [a-z]*, used:\([0-9]*\) .*/\1/p" "$1" | tail -n 1
+}
+
+# Display a memory report line
+# $1 : the memory type
+# $2 : the memory unit
+# $3 : the memory budget
+DisplayMemoryReport()
+{
+	Used=$(GetUsedMemory "$Build_Log" $1)
+	if [ -z "$Used" ]
+	then
+		echo "Error : no $1 usage found in $Build_Log."
+		exit 1
+	fi
+	if [ $Used -gt $3 ]
+	then
+		Exceeded_Budgets="$Exceeded_Budgets $1"
+	fi
+	
+	if [ -z "$Reference_Build_Log" ]
+	then
+		echo "$1 used : $Used $2 (budget : $3 $2)."
+		return
+	fi
+	
+	Reference_Used=$(GetUsedMemory "$Reference_Build_Log" $1)
+	if [ -z "$Reference_Used" ]
+	then
+		echo "Error : no $1 usage found in $Reference_Build_Log."
+		exit 1
+	fi
+	echo "$1 used : $Used $2 (budget : $3 $2, reference : $Reference_Used $2, difference : $(($Used - $Reference_Used)) $2)."
+}
+
+# Parse the linker assembly output to display the hardware stack depth and the RAM and ROM used by each module
+# BoostC surrounds each function code with "; { Name ; function begin" and "; } Name function end" comments, the function label is the line preceding the begin comment.
+# Variables are declared as "Name EQU Address ; bytes:Size", global variables are prefixed with "gbl_" and local variables with their function label.
+# The stack depth of a function is the number of levels its deepest call chain pushes. An interrupt can fire at the main loop deepest point, and pushes one level more than its handler calls.
+# $1 : the assembly file
+DisplayAssemblyReport()
+{
+	awk -v Modules="$Modules" -v Stack_Budget=$Stack_Budget '
+	# Find the module a function or a global variable belongs to
+	function GetModule(Name, i, Prefix)
+	{
+		if ((Name == "main") || (Name == "interrupt")) return "Main";
+		for (i = 1; i <= Modules_Count; i++)
+		{
+			# Functions are named ModuleAction, global variables Module_Name
+			Prefix = Module_Names[i];
+			if (index(Name, Prefix "_") == 1) return Prefix;
+			gsub("_", "", Prefix);
+			if ((index(Name, Prefix) == 1) && (substr(Name, length(Prefix) + 1, 1) ~ /[A-Z]/)) return Module_Names[i];
+		}
+		return "Libraries";
+	}
+	
+	# Compute the stack levels pushed by a function and all the functions it calls
+	function ComputeDepth(Function, i, Callee, Depth)
+	{
+		if (Function in Depths) return Depths[Function];
+		if (Function in Visited_Functions)
+		{
+			printf("Error : %s is recursive, its stack depth can not be bounded.\n", Function);
+			Is_Recursion_Found = 1;
+			return 0;
+		}
+		Visited_Functions[Function] = 1;
+		
+		Depths[Function] = 0;
+		for (i = 1; i <= Callees_Count[Function]; i++)
+		{
+			Callee = Callees[Function, i];
+			if (Callee in Label_Functions) Callee = Label_Functions[Callee];
+			Depth = ComputeDepth(Callee) + 1;
+			if (Depth > Depths[Function])
+			{
+				Depths[Function] = Depth;
+				Deepest_Callees[Function] = Callee;
+			}
+		}
+		return Depths[Function];
+	}
+	
+	# Build the deepest call chain of a function
+	function GetDeepestChain(Function, Chain)
+	{
+		Chain = Function;
+		while (Function in Deepest_Callees)
+		{
+			Function = Deepest_Callees[Function];
+			Chain = Chain " -> " Function;
+		}
+		return Chain;
+	}
+	
+	BEGIN \
+	{
+		Modules_Count = split(Modules, Module_Names, " ");
+		split("ADDWF ANDWF CLRF CLRW COMF DECF DECFSZ INCF INCFSZ IORWF MOVF MOVWF NOP RLF RRF SUBWF SWAPF XORWF BCF BSF BTFSC BTFSS ADDLW ANDLW CALL CLRWDT GOTO IORLW MOVLW RETFIE RETLW RETURN SLEEP SUBLW XORLW", Mnemonics_List, " ");
+		for (i in Mnemonics_List) Mnemonics[Mnemonics_List[i]] = 1;
+	}
+	
+	{ sub(/\r$/, ""); }
+	
+	# Function begin
+	/^;[ \t]*\{[ \t]*[A-Za-z_][A-Za-z0-9_]*[ \t]*;[ \t]*function begin/ \
+	{
+		Current_Function = $0;
+		sub(/^;[ \t]*\{[ \t]*/, "", Current_Function);
+		sub(/[ \t;].*$/, "", Current_Function);
+		if (Last_Label == "") Last_Label = Current_Function;
+		Label_Functions[Last_Label] = Current_Function;
+		Functions[Current_Function] = 1;
+		Last_Label = "";
+		next;
+	}
+	
+	# Function end
+	/^;[ \t]*\}.*function end/ \
+	{
+		Current_Function = "";
+		next;
+	}
+	
+	# Variable declaration
+	/^[A-Za-z_][A-Za-z0-9_]*[ \t]+EQU[ \t]+.*;[ \t]*bytes:[0-9]+/ \
+	{
+		Address = $3;
+		sub(/^0[xX]/, "", Address);
+		Address = tolower(Address);
+		Value = 0;
+		for (i = 1; i <= length(Address); i++) Value = (Value * 16) + index("0123456789abcdef", substr(Address, i, 1)) - 1;
+		if ((Value % 128) < 32) next; # Special function registers
+		
+		Size = $0;
+		sub(/.*bytes:/, "", Size);
+		Size += 0;
+		
+		Name = $1;
+		if (Name ~ /^gbl_/) Variable_Modules[Name] = GetModule(substr(Name, 5));
+		else if (match(Name, /_[0-9][0-9][0-9][0-9][0-9]_/)) Variable_Owners[Name] = substr(Name, 1, RSTART + 5); # Local variables belong to a function label, which is known only when the whole file is parsed
+		else Variable_Modules[Name] = "Libraries"; # Compiler temporary variables
+		Variable_Sizes[Name] = Size;
+		next;
+	}
+	
+	# Label
+	/^[A-Za-z_][A-Za-z0-9_]*[ \t]*$/ \
+	{
+		Last_Label = $1;
+		next;
+	}
+	
+	# Instruction
+	/^[ \t]/ \
+	{
+		if (!($1 in Mnemonics)) next;
+		
+		if (Current_Function == "") Module = "Libraries";
+		else Module = GetModule(Current_Function);
+		Module_ROM[Module]++;
+		Modules_Seen[Module] = 1;
+		
+		if (($1 == "CALL") && (Current_Function != ""))
+		{
+			Callees_Count[Current_Function]++;
+			Callees[Current_Function, Callees_Count[Current_Function]] = $2;
+		}
+	}
+	
+	END \
+	{
+		# Make sure the file really contains BoostC function markers
+		if (!("main" in Functions))
+		{
+			print "Error : no main function found in the assembly file.";
+			exit 1;
+		}
+		
+		# Attribute the RAM to the modules
+		for (Name in Variable_Owners)
+		{
+			Owner = Variable_Owners[Name];
+			if (Owner in Label_Functions) Variable_Modules[Name] = GetModule(Label_Functions[Owner]);
+			else Variable_Modules[Name] = "Libraries";
+		}
+		for (Name in Variable_Modules)
+		{
+			Module_RAM[Variable_Modules[Name]] += Variable_Sizes[Name];
+			Modules_Seen[Variable_Modules[Name]] = 1;
+		}
+		
+		# Compute the worst-case stack depth
+		Main_Depth = ComputeDepth("main");
+		if ("interrupt" in Functions) Interrupt_Depth = ComputeDepth("interrupt") + 1;
+		else Interrupt_Depth = 0;
+		Stack_Depth = Main_Depth + Interrupt_Depth;
+		printf("Hardware stack used : %d levels (budget : %d levels).\n", Stack_Depth, Stack_Budget);
+		printf("  Main loop : %d levels (%s).\n", Main_Depth, GetDeepestChain("main"));
+		if (Interrupt_Depth > 0) printf("  Interrupt : %d levels (%s).\n", Interrupt_Depth, GetDeepestChain("interrupt"));
+		
+		# Display the modules usage
+		printf("\n%-20s %11s %11s\n", "Module", "RAM (bytes)", "ROM (words)");
+		for (i = 1; i <= Modules_Count; i++)
+		{
+			if (Module_Names[i] in Modules_Seen) printf("%-20s %11d %11d\n", Module_Names[i], Module_RAM[Module_Names[i]], Module_ROM[Module_Names[i]]);
+		}
+		if ("Libraries" in Modules_Seen) printf("%-20s %11d %11d\n", "Libraries", Module_RAM["Libraries"], Module_ROM["Libraries"]);
+		print "The local variables of functions that can not run at the same time share the same RAM, so the modules RAM can sum to more than the RAM used.";
+		
+		if (Is_Recursion_Found || (Stack_Depth > Stack_Budget)) exit 2;
+	}' "$1"
+}
+
+if [ $# -lt 1 ] || [ $# -gt 2 ]
+then
+	echo "Usage : $0 Build_Log [Reference_Build_Log]"
+	exit 1
+fi
+Build_Log="$1"
+Reference_Build_Log="$2"
+Assembly_File="$(dirname "$0")/Clock.asm"
+Exceeded_Budgets=""
+
+DisplayMemoryReport RAM bytes $RAM_Budget
+DisplayMemoryReport ROM words $ROM_Budget
+
+if [ ! -f "$Assembly_File" ]
+then
+	echo "Error : $Assembly_File not found, build the project first."
+	exit 1
+fi
+DisplayAssemblyReport "$Assembly_File"
+Result=$?
+if [ $Result -eq 1 ]
+then
+	exit 1
+fi
+if [ $Result -eq 2 ]
+then
+	Exceeded_Budgets="$Exceeded_Budgets stack"
+fi
+
+if [ -n "$Exceeded_Budgets" ]
+then
+	echo "Error : budget exceeded for :$Exceeded_Budgets."
+	exit 1
+fi
@@ -0,0 +1,146 @@
+/** @file Profiler.c
+ * @see Profiler.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Profiler.h"
+#include "System_Tick.h"
+#include "UART.h"
+
+#if PROFILER_IS_ENABLED
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** A main loop iteration lasting longer than the RTC 1Hz signal low level (half a second) can miss a tick beginning, in system tick time base increments. */
+#define PROFILER_MAXIMUM_ITERATION_DURATION ((unsigned long) SYSTEM_TICK_PERIOD * SYSTEM_TICK_FREQUENCY / 2)
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** A phase duration statistics, in system tick time base increments. */
+typedef struct
+{
+	unsigned short Last; //!< The duration measured the last time the phase ran.
+	unsigned short Minimum; //!< The shortest measured duration.
+	unsigned short Maximum; //!< The longest measured duration.
+} TProfilerPhaseStatistics;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** All phases statistics. */
+static TProfilerPhaseStatistics Profiler_Phases_Statistics[PROFILER_PHASES_COUNT];
+/** The phases durations summed during the current main loop iteration. */
+static unsigned short Profiler_Phases_Durations[PROFILER_PHASES_COUNT];
+/** A bit set to 1 tells that the phase of the same number ran during the current main loop iteration. */
+static unsigned char Profiler_Ran_Phases;
+
+/** The timer value when the current phase began. */
+static unsigned short Profiler_Phase_Beginning_Time;
+/** The timer value when the current main loop iteration began. */
+static unsigned long Profiler_Iteration_Beginning_Time;
+
+/** How many main loop iterations lasted too long. */
+static unsigned short Profiler_Overrun_Iterations_Count;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Read the time base from the main loop.
+ * @return The current time.
+ */
+static unsigned long ProfilerGetTime(void)
+{
+	unsigned long Time;
+	
+	// The interrupt handlers read the time base too, and the time base reading code is not reentrant
+	intcon.GIE = 0;
+	Time = SystemTickGetLongTime();
+	intcon.GIE = 1;
+	
+	return Time;
+}
+
+/** Send a 16-bit value through the UART, most significant byte first.
+ * @param Word The value to send.
+ */
+static void ProfilerSendWord(unsigned short Word)
+{
+	UARTWriteByte(Word >> 8);
+	UARTWriteByte((unsigned char) Word);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void ProfilerInitialize(void)
+{
+	unsigned char i;
+	
+	for (i = 0; i < PROFILER_PHASES_COUNT; i++)
+	{
+		Profiler_Phases_Statistics[i].Last = 0;
+		Profiler_Phases_Statistics[i].Minimum = 0xFFFF;
+		Profiler_Phases_Statistics[i].Maximum = 0;
+		Profiler_Phases_Durations[i] = 0;
+	}
+	Profiler_Ran_Phases = 0;
+	Profiler_Overrun_Iterations_Count = 0;
+}
+
+void ProfilerBeginPhase(void)
+{
+	Profiler_Phase_Beginning_Time = (unsigned short) ProfilerGetTime();
+}
+
+void ProfilerEndPhase(TProfilerPhase Phase)
+{
+	// Unsigned arithmetic handles the time wrap around as long as the phase lasts less than 65536 cycles
+	Profiler_Phases_Durations[Phase] += (unsigned short) ProfilerGetTime() - Profiler_Phase_Beginning_Time;
+	Profiler_Ran_Phases |= 1 << Phase;
+}
+
+void ProfilerBeginIteration(void)
+{
+	Profiler_Iteration_Beginning_Time = ProfilerGetTime();
+}
+
+void ProfilerEndIteration(void)
+{
+	unsigned char i, Phase_Mask = 1;
+	unsigned short Duration;
+	
+	// A phase that did not run during this iteration did not last 0
+	for (i = 0; i < PROFILER_PHASES_COUNT; i++)
+	{
+		if (Profiler_Ran_Phases & Phase_Mask)
+		{
+			Duration = Profiler_Phases_Durations[i];
+			Profiler_Phases_Statistics[i].Last = Duration;
+			if (Duration < Profiler_Phases_Statistics[i].Minimum) Profiler_Phases_Statistics[i].Minimum = Duration;
+			if (Duration > Profiler_Phases_Statistics[i].Maximum) Profiler_Phases_Statistics[i].Maximum = Duration;
+			Profiler_Phases_Durations[i] = 0;
+		}
+		Phase_Mask <<= 1;
+	}
+	Profiler_Ran_Phases = 0;
+	
+	if (ProfilerGetTime() - Profiler_Iteration_Beginning_Time > PROFILER_MAXIMUM_ITERATION_DURATION) Profiler_Overrun_Iterations_Count++;
+}
+
+void ProfilerSendStatistics(void)
+{
+	unsigned char i;
+	
+	UARTWriteByte(PROFILER_PHASES_COUNT);
+	for (i = 0; i < PROFILER_PHASES_COUNT; i++)
+	{
+		ProfilerSendWord(Profiler_Phases_Statistics[i].Last);
+		ProfilerSendWord(Profiler_Phases_Statistics[i].Minimum);
+		ProfilerSendWord(Profiler_Phases_Statistics[i].Maximum);
+	}
+	ProfilerSendWord(Profiler_Overrun_Iterations_Count);
+}
+
+#endif
@@ -0,0 +1,73 @@
+/** @file Profiler.h
+ * Measure how long each main loop phase lasts. The system tick is used as time base, so all durations are expressed in its increments (see SystemTickGetTime()).
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_PROFILER_H
+#define H_PROFILER_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** Set to 1 to build the profiler in the firmware, set to 0 to make all profiler macros expand to nothing. */
+#define PROFILER_IS_ENABLED 0
+
+#if PROFILER_IS_ENABLED
+	/** Start timing a phase. */
+	#define PROFILER_BEGIN_PHASE() ProfilerBeginPhase()
+	/** Stop timing the current phase and add its duration to the provided phase. */
+	#define PROFILER_END_PHASE(Phase) ProfilerEndPhase(Phase)
+	/** Start timing a main loop iteration, when the scheduler returns the events to serve. */
+	#define PROFILER_BEGIN_ITERATION() ProfilerBeginIteration()
+	/** Update the statistics when all of the events of the main loop iteration have been served. */
+	#define PROFILER_END_ITERATION() ProfilerEndIteration()
+#else
+	#define PROFILER_BEGIN_PHASE()
+	#define PROFILER_END_PHASE(Phase)
+	#define PROFILER_BEGIN_ITERATION()
+	#define PROFILER_END_ITERATION()
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All measured main loop phases. A phase can be timed several times during the same main loop iteration, the durations are summed. */
+typedef enum
+{
+	PROFILER_PHASE_UART_CONFIGURATION, //!< Apply the configuration received from the UART.
+	PROFILER_PHASE_RTC_READ, //!< Read the date and time from the RTC.
+	PROFILER_PHASE_DISPLAY, //!< Write all characters to the display.
+	PROFILER_PHASE_TEMPERATURE, //!< Sample the temperature sensor and convert the value.
+	PROFILER_PHASE_ALARM, //!< Check whether the alarm must ring.
+	PROFILER_PHASE_RTC_WRITE, //!< Write the modified RTC RAM bytes.
+	PROFILER_PHASES_COUNT
+} TProfilerPhase;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+#if PROFILER_IS_ENABLED
+	/** Reset all statistics. */
+	void ProfilerInitialize(void);
+
+	/** Remember the current time as the beginning of a phase. */
+	void ProfilerBeginPhase(void);
+
+	/** Add the time elapsed since the last ProfilerBeginPhase() call to the phase duration.
+	 * @param Phase The phase that has just been executed.
+	 */
+	void ProfilerEndPhase(TProfilerPhase Phase);
+
+	/** Remember the current time as the beginning of a main loop iteration. */
+	void ProfilerBeginIteration(void);
+
+	/** Update the last, minimum and maximum duration of the phases that ran during this main loop iteration, the other phases statistics are left untouched. The iteration is counted as an overrun if it lasted longer than the RTC 1Hz signal low level, as the scheduler could have missed a tick beginning.
+	 */
+	void ProfilerEndIteration(void);
+
+	/** Send all statistics through the UART. Each 16-bit value is sent most significant byte first.
+	 * Frame format : phases count, for each phase : last duration, minimum duration, maximum duration, then the overrun iterations count.
+	 */
+	void ProfilerSendStatistics(void);
+#endif
+
+#endif
@@ -3,7 +3,9 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
+#include "Configuration.h"
 #include "RTC.h"
+#include "Timestamp.h"
 
 //--------------------------------------------------------------------------------------------------
 // Private constants and macros
@@ -16,6 +18,16 @@
 /** The R/#W bit Write value in the I2C protocol. */
 #define RTC_I2C_ADDRESS_READ_WRITE_BIT_WRITE 0
 
+/** The I2C bus bit rate in bit/s. */
+#define RTC_I2C_BIT_RATE 100000
+/** The I2C baud rate generator value, rounded up so the bit rate never exceeds the DS1307 maximum speed. */
+#define RTC_I2C_BAUD_RATE_GENERATOR_VALUE (((CONFIGURATION_CLOCK_FREQUENCY + (4 * RTC_I2C_BIT_RATE) - 1) / (4 * RTC_I2C_BIT_RATE)) - 1) // Baud_Rate = Fosc / (4 * (SSPADD + 1)) => SSPADD = (Fosc / (4 * Baud_Rate)) - 1
+
+// Only 7 bits of SSPADD are used by the baud rate generator, and 0 is not allowed
+#if (RTC_I2C_BAUD_RATE_GENERATOR_VALUE < 1) || (RTC_I2C_BAUD_RATE_GENERATOR_VALUE > 127)
+	#error "The I2C bit rate can't be generated at this core frequency."
+#endif
+
 /** Send a Start condition over the I2C bus. */
 #define RTC_I2C_SEND_START() \
 { \
@@ -33,8 +45,8 @@
 	pir1.SSPIF = 0; \
 }
 
-/** The RTC RAM starting address. */
-#define RTC_RAM_BASE_ADDRESS 0x08
+/** Tell that no cache byte was modified since the last flush. */
+#define RTC_RAM_CACHE_NO_DIRTY_BYTE 0xFF
 
 //--------------------------------------------------------------------------------------------------
 // Private types
@@ -52,10 +64,60 @@ typedef enum
 	RTC_REGISTER_CONTROL
 } TRTCRegister;
 
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The battery-backed RAM bytes used by the firmware, so reading them does not need any bus access. */
+static unsigned char RTC_RAM_Cache[RTC_RAM_CACHE_SIZE];
+/** The first modified cache byte index, or RTC_RAM_CACHE_NO_DIRTY_BYTE when the cache matches the RTC RAM. */
+static unsigned char RTC_RAM_Cache_First_Dirty_Index;
+/** The last modified cache byte index, it is meaningful only when a byte was modified. */
+static unsigned char RTC_RAM_Cache_Last_Dirty_Index;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Fill the RAM cache with a single read transaction. */
+static void RTCLoadRAMCache(void)
+{
+	unsigned char i;
+	
+	// Set the register index to the first cached byte doing a fake write
+	RTC_I2C_SEND_START();
+	RTC_I2C_WAIT_OPERATION_END();
+	sspbuf = RTC_I2C_ADDRESS | RTC_I2C_ADDRESS_READ_WRITE_BIT_WRITE;
+	RTC_I2C_WAIT_OPERATION_END();
+	sspbuf = RTC_RAM_CACHE_BASE_ADDRESS;
+	RTC_I2C_WAIT_OPERATION_END();
+	RTC_I2C_SEND_STOP();
+	RTC_I2C_WAIT_OPERATION_END();
+	
+	// Read all cached bytes, the RTC increments its register index after each byte
+	RTC_I2C_SEND_START();
+	RTC_I2C_WAIT_OPERATION_END();
+	sspbuf = RTC_I2C_ADDRESS | RTC_I2C_ADDRESS_READ_WRITE_BIT_READ;
+	RTC_I2C_WAIT_OPERATION_END();
+	sspcon2.ACKDT = 0; // Send an I2C ACK when a value is read
+	for (i = 0; i < RTC_RAM_CACHE_SIZE; i++)
+	{
+		sspcon2.RCEN = 1;
+		RTC_I2C_WAIT_OPERATION_END();
+		RTC_RAM_Cache[i] = sspbuf;
+		
+		if (i == RTC_RAM_CACHE_SIZE - 1) sspcon2.ACKDT = 1; // Send a NACK on the last read
+		sspcon2.ACKEN = 1;
+		RTC_I2C_WAIT_OPERATION_END();
+	}
+	RTC_I2C_SEND_STOP();
+	RTC_I2C_WAIT_OPERATION_END();
+	
+	RTC_RAM_Cache_First_Dirty_Index = RTC_RAM_CACHE_NO_DIRTY_BYTE;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Public functions
 //--------------------------------------------------------------------------------------------------
-void RTCInitialize(void)
+void RTCInitialize(unsigned char Is_Warm_Boot)
 {
 	TRTCClockData Clock_Data;
 	
@@ -69,9 +131,15 @@ void RTCInitialize(void)
 	// Initialize the I2C module at 100KHz
 	sspstat = 0x80; // Disable the slew rate control as requested for 100KHz speed mode, input levels conform to I2C
 	sspcon2 = 0x00; // Reset communication flags
-	sspadd = 9; // Baud_Rate = Fosc / (4 * (SSPADD + 1)) => SSPADD = (Fosc / (4 * Baud_Rate)) - 1
+	sspadd = RTC_I2C_BAUD_RATE_GENERATOR_VALUE;
 	sspcon = 0x28; // Enable I2C module in Master mode
 	
+	// The RAM cache content is not covered by the warm boot checks, so it is always loaded again
+	RTCLoadRAMCache();
+	
+	// The RTC is battery-backed, a microcontroller reset can't change its configuration
+	if (Is_Warm_Boot) return;
+	
 	// On the first RTC boot, the Clock Halt bit will be set and will prevent the clock from running, so clear this bit if needed
 	RTCGetDateAndTime(&Clock_Data);
 	if (Clock_Data.Register_Name.Seconds & 0x80) RTCWriteByte(RTC_REGISTER_SECONDS, 0); // No need to set a valid seconds count as the RTC time and date are not configured
@@ -80,12 +148,11 @@ void RTCInitialize(void)
 	RTCWriteByte(RTC_REGISTER_CONTROL, 0x90);
 }
 
-void RTCSetReadAddress(unsigned char Address)
+void RTCWriteByte(unsigned char Address, unsigned char Byte)
 {
 	// Do nothing if the address is bad
 	if (Address >= RTC_MEMORY_SIZE) return;
 	
-	// Set the byte address to read doing a fake write
 	// Send an I2C START
 	RTC_I2C_SEND_START();
 	RTC_I2C_WAIT_OPERATION_END();
@@ -98,66 +165,68 @@ void RTCSetReadAddress(unsigned char Address)
 	sspbuf = Address;
 	RTC_I2C_WAIT_OPERATION_END();
 	
+	// Send the byte value
+	sspbuf = Byte;
+	RTC_I2C_WAIT_OPERATION_END();
+	
 	// Send an I2C STOP
 	RTC_I2C_SEND_STOP();
 	RTC_I2C_WAIT_OPERATION_END();
+	
+	// The minimum bus free time between a STOP and a START must be at least 4.7s, but the microcontroller is so slow that there is no need to take that into account
 }
 
-unsigned char RTCReadByte(void)
+unsigned char RTCReadRAMByte(unsigned char Address)
 {
-	unsigned char Byte;
-	
-	// Send an I2C START
-	RTC_I2C_SEND_START();
-	RTC_I2C_WAIT_OPERATION_END();
-	
-	// Send the RTC I2C address
-	sspbuf = RTC_I2C_ADDRESS | RTC_I2C_ADDRESS_READ_WRITE_BIT_READ;
-	RTC_I2C_WAIT_OPERATION_END();
-	
-	// Receive the byte from the device
-	sspcon2.RCEN = 1;
-	RTC_I2C_WAIT_OPERATION_END();
-	Byte = sspbuf;
+	Address -= RTC_RAM_CACHE_BASE_ADDRESS;
+	if (Address >= RTC_RAM_CACHE_SIZE) return 0; // Lower addresses wrap to high values
 	
-	// Send an I2C NACK to the device
-	sspcon2.ACKDT = 1; // Send an I2C NACK indicating that no more byte will be read
-	sspcon2.ACKEN = 1;
-	RTC_I2C_WAIT_OPERATION_END();
+	return RTC_RAM_Cache[Address];
+}
+
+void RTCWriteRAMByte(unsigned char Address, unsigned char Byte)
+{
+	Address -= RTC_RAM_CACHE_BASE_ADDRESS;
+	if (Address >= RTC_RAM_CACHE_SIZE) return;
 	
-	// Send an I2C STOP
-	RTC_I2C_SEND_STOP();
-	RTC_I2C_WAIT_OPERATION_END();
+	// There is no need to write a byte that does not change
+	if (RTC_RAM_Cache[Address] == Byte) return;
+	RTC_RAM_Cache[Address] = Byte;
 	
-	return Byte;
+	// Grow the dirty range, the bytes in between are written again with their cached value, which costs less than a transaction per range
+	if (RTC_RAM_Cache_First_Dirty_Index == RTC_RAM_CACHE_NO_DIRTY_BYTE)
+	{
+		RTC_RAM_Cache_First_Dirty_Index = Address;
+		RTC_RAM_Cache_Last_Dirty_Index = Address;
+	}
+	else if (Address < RTC_RAM_Cache_First_Dirty_Index) RTC_RAM_Cache_First_Dirty_Index = Address;
+	else if (Address > RTC_RAM_Cache_Last_Dirty_Index) RTC_RAM_Cache_Last_Dirty_Index = Address;
 }
 
-void RTCWriteByte(unsigned char Address, unsigned char Byte)
+void RTCFlushRAMCache(void)
 {
-	// Do nothing if the address is bad
-	if (Address >= RTC_MEMORY_SIZE) return;
-
-	// Send an I2C START
+	unsigned char i;
+	
+	if (RTC_RAM_Cache_First_Dirty_Index == RTC_RAM_CACHE_NO_DIRTY_BYTE) return;
+	
+	// Send the first modified byte address
 	RTC_I2C_SEND_START();
 	RTC_I2C_WAIT_OPERATION_END();
-	
-	// Send the RTC I2C address
 	sspbuf = RTC_I2C_ADDRESS | RTC_I2C_ADDRESS_READ_WRITE_BIT_WRITE;
 	RTC_I2C_WAIT_OPERATION_END();
-	
-	// Send the byte address
-	sspbuf = Address;
-	RTC_I2C_WAIT_OPERATION_END();
-	
-	// Send the byte value
-	sspbuf = Byte;
+	sspbuf = RTC_RAM_CACHE_BASE_ADDRESS + RTC_RAM_Cache_First_Dirty_Index;
 	RTC_I2C_WAIT_OPERATION_END();
 	
-	// Send an I2C STOP
+	// Write the whole range in the same transaction, the RTC increments its register index after each byte
+	for (i = RTC_RAM_Cache_First_Dirty_Index; i <= RTC_RAM_Cache_Last_Dirty_Index; i++)
+	{
+		sspbuf = RTC_RAM_Cache[i];
+		RTC_I2C_WAIT_OPERATION_END();
+	}
 	RTC_I2C_SEND_STOP();
 	RTC_I2C_WAIT_OPERATION_END();
 	
-	// The minimum bus free time between a STOP and a START must be at least 4.7s, but the microcontroller is so slow that there is no need to take that into account
+	RTC_RAM_Cache_First_Dirty_Index = RTC_RAM_CACHE_NO_DIRTY_BYTE;
 }
 
 // This function does not use the utility functions to access the RTC in order to be as fast as possible
@@ -199,7 +268,7 @@ void RTCGetDateAndTime(TRTCClockData *Pointer_Clock_Data)
 		sspcon2.RCEN = 1;
 		RTC_I2C_WAIT_OPERATION_END();
 		Pointer_Clock_Data->Array[i] = sspbuf; // It is possible to store all field in the same way because bits CH and 12/24 are both 0)
-	
+		
 		// Send an I2C ACK or NACK to the device
 		if (i == sizeof(TRTCClockData) - 1) sspcon2.ACKDT = 1; // Send a NACK on the last read
 		sspcon2.ACKEN = 1;
@@ -211,19 +280,47 @@ void RTCGetDateAndTime(TRTCClockData *Pointer_Clock_Data)
 	RTC_I2C_WAIT_OPERATION_END();
 }
 
-void RTCSetDateAndTime(TRTCClockData *Pointer_Clock_Data)
+void RTCSetDateAndTime(TRTCClockData *Pointer_Clock_Data, unsigned char Registers_Mask)
 {
-	// Stop the clock to prevent it updating the time and date in the same time they are set
-	RTCWriteByte(RTC_REGISTER_SECONDS, 0x80);
-	
-	// Configure all registers
-	RTCWriteByte(RTC_REGISTER_MINUTES, Pointer_Clock_Data->Register_Name.Minutes);
-	RTCWriteByte(RTC_REGISTER_HOURS, Pointer_Clock_Data->Register_Name.Hours);
-	RTCWriteByte(RTC_REGISTER_DAY, Pointer_Clock_Data->Register_Name.Day_Of_Week);
-	RTCWriteByte(RTC_REGISTER_DATE, Pointer_Clock_Data->Register_Name.Day);
-	RTCWriteByte(RTC_REGISTER_MONTH, Pointer_Clock_Data->Register_Name.Month);
-	RTCWriteByte(RTC_REGISTER_YEAR, Pointer_Clock_Data->Register_Name.Year);
-	
-	// Set the SECONDS register and re-enable the clock in the same time
-	RTCWriteByte(RTC_REGISTER_SECONDS, Pointer_Clock_Data->Register_Name.Seconds);
-}
+	TRTCClockData Current_Clock_Data;
+	unsigned char i, First_Register = 0xFF, Last_Register = 0, Register_Mask = 0x01;
+	
+	// Find the range of registers to write
+	for (i = 0; i < sizeof(TRTCClockData); i++)
+	{
+		if (Registers_Mask & Register_Mask)
+		{
+			if (First_Register == 0xFF) First_Register = i;
+			Last_Register = i;
+		}
+		Register_Mask <<= 1;
+	}
+	if (First_Register == 0xFF) return;
+	
+	// The registers in between that are not selected are written again with their current value, so the whole range fits in a single transaction
+	Register_Mask = Registers_Mask >> First_Register;
+	if (Register_Mask & (Register_Mask + 1)) RTCGetDateAndTime(&Current_Clock_Data); // The selected bits are not contiguous
+	
+	// The last RTC 1Hz signal edge does not match the new seconds
+	if (Registers_Mask & 0x01) TimestampResynchronize();
+	
+	// Send the first register address
+	RTC_I2C_SEND_START();
+	RTC_I2C_WAIT_OPERATION_END();
+	sspbuf = RTC_I2C_ADDRESS | RTC_I2C_ADDRESS_READ_WRITE_BIT_WRITE;
+	RTC_I2C_WAIT_OPERATION_END();
+	sspbuf = RTC_REGISTER_SECONDS + First_Register; // The clock data are in the RTC registers order
+	RTC_I2C_WAIT_OPERATION_END();
+	
+	// Write the whole range in a burst, so a rollover can't happen between two registers writes. There is no need to halt the clock : writing the seconds first resets the RTC divider chain, which leaves a whole second to write the other registers, and without the seconds the burst is far shorter than a second
+	Register_Mask = 1 << First_Register;
+	for (i = First_Register; i <= Last_Register; i++)
+	{
+		if (Registers_Mask & Register_Mask) sspbuf = Pointer_Clock_Data->Array[i];
+		else sspbuf = Current_Clock_Data.Array[i];
+		RTC_I2C_WAIT_OPERATION_END();
+		Register_Mask <<= 1;
+	}
+	RTC_I2C_SEND_STOP();
+	RTC_I2C_WAIT_OPERATION_END();
+}
\ No newline at end of file
@@ -12,10 +12,17 @@
 #define RTC_WAIT_TICK_BEGINNING() while (!porta.1)
 /** Poll until the current RTC 1Hz tick ends. */
 #define RTC_WAIT_TICK_END() while (porta.1)
+/** Tell whether the RTC 1Hz signal is still high, i.e. the current tick has not ended yet. */
+#define RTC_IS_TICK_IN_PROGRESS() porta.1
 
 /** The RTC whole memory size in bytes. */
 #define RTC_MEMORY_SIZE 64
 
+/** The first battery-backed RAM address mirrored in the microcontroller RAM. */
+#define RTC_RAM_CACHE_BASE_ADDRESS 0x08
+/** How many battery-backed RAM bytes are mirrored, only the bytes used by the firmware are (the alarm, the ringtone, the unit address and the crystal curve). */
+#define RTC_RAM_CACHE_SIZE 10
+
 //--------------------------------------------------------------------------------------------------
 // Types
 //--------------------------------------------------------------------------------------------------
@@ -41,18 +48,10 @@ typedef union
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize the I2C module used to communicate with the RTC and configure the RTC to trigger an interrupt each second. */
-void RTCInitialize(void);
-
-/** Set the RTC internal address counter to allow reading from that address.
- * @param Address The address to set, in range [0; RTC_MEMORY_SIZE - 1]. Nothing is done if the provided address is bad.
- */
-void RTCSetReadAddress(unsigned char Address);
-
-/** Read a byte at the current address from the RTC memory. The address will automatically wrap around if it reaches RTC_MEMORY_SIZE.
- * @return The byte value.
+/** Initialize the I2C module used to communicate with the RTC, load the RAM cache with a single burst read and configure the RTC to trigger an interrupt each second.
+ * @param Is_Warm_Boot Set to 1 when the microcontroller was reset while the RTC kept running, so only the I2C module and the RAM cache are initialized. Set to 0 to also start the RTC oscillator and configure its 1Hz output.
  */
-unsigned char RTCReadByte(void);
+void RTCInitialize(unsigned char Is_Warm_Boot);
 
 /** Write a byte of data to the RTC memory.
  * @param Address The byte address, in range [0; RTC_MEMORY_SIZE - 1]. No byte is written if the provided address is out of range.
@@ -60,14 +59,32 @@ unsigned char RTCReadByte(void);
  */
 void RTCWriteByte(unsigned char Address, unsigned char Byte);
 
+/** Read a battery-backed RAM byte from the cache, without any bus access.
+ * @param Address The byte address, in range [RTC_RAM_CACHE_BASE_ADDRESS; RTC_RAM_CACHE_BASE_ADDRESS + RTC_RAM_CACHE_SIZE - 1].
+ * @return The byte value, 0 if the address is not cached.
+ */
+unsigned char RTCReadRAMByte(unsigned char Address);
+
+/** Write a battery-backed RAM byte to the cache. The byte is written to the RTC on the next RTCFlushRAMCache() call, together with the other modified bytes.
+ * @param Address The byte address, in range [RTC_RAM_CACHE_BASE_ADDRESS; RTC_RAM_CACHE_BASE_ADDRESS + RTC_RAM_CACHE_SIZE - 1]. Nothing is done if the address is not cached.
+ * @param Byte The byte to write.
+ */
+void RTCWriteRAMByte(unsigned char Address, unsigned char Byte);
+
+/** Write all modified cache bytes to the RTC in a single burst, covering the range from the first to the last modified byte. Nothing is sent if no byte was modified.
+ * @note The main loop calls it once per tick when the tick work is done. Call it right after modifying data that must not be lost if the power fails before the next tick.
+ */
+void RTCFlushRAMCache(void);
+
 /** Get the current date and time values.
  * @param Pointer_Clock_Data On output, will contain the current date and time in BCD format.
  */
 void RTCGetDateAndTime(TRTCClockData *Pointer_Clock_Data);
 
-/** Set the RTC date and time. Setting an invalid parameter will abort the RTC configuration and do nothing.
+/** Set some of the RTC date and time registers without stopping the clock, in a single transaction. Writing the seconds resets the RTC sub-second divider, the other registers keep the current second phase.
  * @param Pointer_Clock_Data The clock data to set, all parameters must be in BCD format.
+ * @param Registers_Mask The registers to write, bit 0 selects the seconds, bit 1 the minutes and so on in the TRTCClockRegisters order.
  */
-void RTCSetDateAndTime(TRTCClockData *Pointer_Clock_Data);
+void RTCSetDateAndTime(TRTCClockData *Pointer_Clock_Data, unsigned char Registers_Mask);
 
 #endif
\ No newline at end of file
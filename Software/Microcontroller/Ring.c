@@ -3,33 +3,175 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
-#include "Button.h"
+#include "Configuration.h"
 #include "Ring.h"
+#include "System_Tick.h"
 
 //--------------------------------------------------------------------------------------------------
-// Private constants
+// Private constants and macros
 //--------------------------------------------------------------------------------------------------
-/** The timer reload value to get the requested 50Hz interrupt rate (called Finterrupt below). */
-#define RING_TIMER_RELOAD_VALUE 60 // Reload_Value = 255 - ((Fosc/4) / (256 * Finterrupt))
+/** The lowest note frequency in Hz (C6), it needs the biggest PR2 value. */
+#define RING_LOWEST_NOTE_FREQUENCY 1047
+
+/** Compute the PR2 register value giving a PWM frequency.
+ * @param Frequency The PWM frequency in Hz.
+ * @param Prescaler The timer 2 prescaler value.
+ */
+#define RING_PWM_PERIOD(Frequency, Prescaler) ((CONFIGURATION_INSTRUCTION_FREQUENCY / ((Prescaler) * (Frequency))) - 1) // PR2 = ((Fosc/4) / (Prescaler * Fpwm)) - 1
+
+// Select the smallest timer 2 prescaler allowing the lowest note to fit in the 8-bit PR2 register, for the best frequency resolution. If there is none, play all notes one octave higher
+#if RING_PWM_PERIOD(RING_LOWEST_NOTE_FREQUENCY, 1) <= 255
+	/** The timer 2 prescaler value used for the PWM time base. */
+	#define RING_PWM_PRESCALER 1
+	/** The T2CON prescaler select bits. */
+	#define RING_PWM_PRESCALER_SELECT 0x00
+	/** How many octaves the notes are raised by. */
+	#define RING_OCTAVE_SHIFT 0
+#elif RING_PWM_PERIOD(RING_LOWEST_NOTE_FREQUENCY, 4) <= 255
+	#define RING_PWM_PRESCALER 4
+	#define RING_PWM_PRESCALER_SELECT 0x01
+	#define RING_OCTAVE_SHIFT 0
+#elif RING_PWM_PERIOD(RING_LOWEST_NOTE_FREQUENCY, 16) <= 255
+	#define RING_PWM_PRESCALER 16
+	#define RING_PWM_PRESCALER_SELECT 0x02
+	#define RING_OCTAVE_SHIFT 0
+#elif RING_PWM_PERIOD(RING_LOWEST_NOTE_FREQUENCY << 1, 16) <= 255
+	#define RING_PWM_PRESCALER 16
+	#define RING_PWM_PRESCALER_SELECT 0x02
+	#define RING_OCTAVE_SHIFT 1
+#else
+	#error "The ring notes can't be generated at this core frequency."
+#endif
+
+/** Compute the PR2 register value giving the requested note frequency.
+ * @param Frequency The note frequency in Hz.
+ */
+#define RING_NOTE_PERIOD(Frequency) RING_PWM_PERIOD((Frequency) << RING_OCTAVE_SHIFT, RING_PWM_PRESCALER)
+
+/** A rest (the buzzer is silent). */
+#define RING_NOTE_REST 0
+// All available notes, they index the Ring_Notes_Periods table starting from 1
+#define RING_NOTE_C6 1
+#define RING_NOTE_D6 2
+#define RING_NOTE_E6 3
+#define RING_NOTE_F6 4
+#define RING_NOTE_G6 5
+#define RING_NOTE_A6 6
+#define RING_NOTE_B6 7
+#define RING_NOTE_C7 8
+#define RING_NOTE_D7 9
+#define RING_NOTE_E7 10
+#define RING_NOTE_F7 11
+#define RING_NOTE_G7 12
+#define RING_NOTE_A7 13
+#define RING_NOTE_B7 14
+#define RING_NOTE_C8 15
+
+/** Encode a melody note on a single byte.
+ * @param Note The note to play (RING_NOTE_xxx).
+ * @param Duration How many system ticks the note lasts, in range [1; 15].
+ */
+#define RING_MELODY_NOTE(Note, Duration) (((Note) << 4) | (Duration))
+/** Mark the end of a melody (a null duration is not a valid note). */
+#define RING_MELODY_END 0
+
+/** How many times the melody will be played before being automatically shut off if the user did not stop it. */
+#define RING_MELODY_LOOPS_COUNT 60
 
 //--------------------------------------------------------------------------------------------------
 // Private variables
 //--------------------------------------------------------------------------------------------------
-/** The ring "melody". */
-static unsigned char Ring_Tone[] =
+/** The PR2 value of each note, stored in program memory. The first entry is unused as it corresponds to a rest. */
+static rom unsigned char *Ring_Notes_Periods =
+{
+	0,
+	RING_NOTE_PERIOD(1047), // C6
+	RING_NOTE_PERIOD(1175), // D6
+	RING_NOTE_PERIOD(1319), // E6
+	RING_NOTE_PERIOD(1397), // F6
+	RING_NOTE_PERIOD(1568), // G6
+	RING_NOTE_PERIOD(1760), // A6
+	RING_NOTE_PERIOD(1976), // B6
+	RING_NOTE_PERIOD(2093), // C7
+	RING_NOTE_PERIOD(2349), // D7
+	RING_NOTE_PERIOD(2637), // E7
+	RING_NOTE_PERIOD(2794), // F7
+	RING_NOTE_PERIOD(3136), // G7
+	RING_NOTE_PERIOD(3520), // A7
+	RING_NOTE_PERIOD(3951), // B7
+	RING_NOTE_PERIOD(4186) // C8
+};
+
+/** All melodies, stored one after the other in program memory. Each melody is terminated by RING_MELODY_END. */
+static rom unsigned char *Ring_Melodies =
 {
-	1, 1, 1,
-	0, 0, 0,
-	1, 1, 1,
-	0, 0, 0, 0, 0, 0, 0, 0, 0
+	// Melody 0 : the original double beep
+	RING_MELODY_NOTE(RING_NOTE_E7, 3), RING_MELODY_NOTE(RING_NOTE_REST, 3), RING_MELODY_NOTE(RING_NOTE_E7, 3), RING_MELODY_NOTE(RING_NOTE_REST, 9),
+	RING_MELODY_END,
+	// Melody 1 : ascending arpeggio
+	RING_MELODY_NOTE(RING_NOTE_C7, 5), RING_MELODY_NOTE(RING_NOTE_E7, 5), RING_MELODY_NOTE(RING_NOTE_G7, 5), RING_MELODY_NOTE(RING_NOTE_C8, 10), RING_MELODY_NOTE(RING_NOTE_REST, 15),
+	RING_MELODY_END,
+	// Melody 2 : Westminster chimes first quarter
+	RING_MELODY_NOTE(RING_NOTE_E7, 12), RING_MELODY_NOTE(RING_NOTE_C7, 12), RING_MELODY_NOTE(RING_NOTE_D7, 12), RING_MELODY_NOTE(RING_NOTE_G6, 15), RING_MELODY_NOTE(RING_NOTE_G6, 9), RING_MELODY_NOTE(RING_NOTE_REST, 12),
+	RING_MELODY_NOTE(RING_NOTE_G6, 12), RING_MELODY_NOTE(RING_NOTE_D7, 12), RING_MELODY_NOTE(RING_NOTE_E7, 12), RING_MELODY_NOTE(RING_NOTE_C7, 15), RING_MELODY_NOTE(RING_NOTE_C7, 9), RING_MELODY_NOTE(RING_NOTE_REST, 15), RING_MELODY_NOTE(RING_NOTE_REST, 15),
+	RING_MELODY_END
 };
 
-/** The ring "note" index. */
-static unsigned char Ring_Tone_Index;
+/** The offset in Ring_Melodies of each melody first note. */
+static rom unsigned char *Ring_Melodies_Offsets = { 0, 5, 11 };
+
+/** The selected melody first note offset. */
+static unsigned char Ring_Melody_Offset = 0;
+
+/** The offset of the note being played. */
+static unsigned char Ring_Note_Offset;
 
 /** How many times the melody will be played before being automatically shut off. */
 static unsigned char Ring_Melody_Loops_Count;
 
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Play the note at the current offset and wait for its end. When the melody end is reached, start from the melody beginning again. */
+static void RingPlayNote(void)
+{
+	unsigned char Note, Period;
+	
+	// Loop the melody
+	Note = Ring_Melodies[Ring_Note_Offset];
+	if (Note == RING_MELODY_END)
+	{
+		Ring_Melody_Loops_Count--;
+		Ring_Note_Offset = Ring_Melody_Offset;
+		Note = Ring_Melodies[Ring_Note_Offset];
+	}
+	
+	// Configure the PWM module
+	if ((Note >> 4) == RING_NOTE_REST) ccp2con = 0; // Disable the PWM module, the pin takes back the port latch value, which is zero
+	else
+	{
+		Period = Ring_Notes_Periods[Note >> 4];
+		pr2 = Period;
+		ccpr2l = (Period + 1) >> 1; // Set a 50% duty cycle (the duty cycle two least significant bits are left to zero)
+		ccp2con = 0x0C; // Enable the PWM mode
+	}
+	
+	// Wait for the note end
+	SystemTickStartTimer(SYSTEM_TICK_TIMER_RING, Note & 0x0F);
+	Ring_Note_Offset++;
+}
+
+/** Stop the buzzer and the note timer. */
+static void RingStopPlaying(void)
+{
+	SystemTickStopTimer(SYSTEM_TICK_TIMER_RING);
+	
+	// Stop ringing
+	ccp2con = 0;
+	portc.1 = 0;
+	t2con.TMR2ON = 0;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Public functions
 //--------------------------------------------------------------------------------------------------
@@ -37,59 +179,45 @@ void RingInitialize(void)
 {
 	// Configure the buzzer pin as output
 	portc.1 = 0; // Avoid ringing the buzzer due to an undefined value in the port register
-	trisc.1 = 0; // Use this pin as it can be configured as PWM if needed
+	trisc.1 = 0; // The CCP2 module PWM output is multiplexed on this pin
 	
-	// Configure the timer 0 module to trigger an interrupt at 20Hz
-	option_reg.T0CS = 0; // Use Fosc/4 as clock source
-	option_reg.PSA = 0; // Assign the prescaler to the timer 0 module
-	option_reg |= 0x07; // Set a 1:256 prescaler
+	// Configure timer 2 as the PWM time base, it will be started only when ringing
+	t2con = RING_PWM_PRESCALER_SELECT; // Select a 1:1 postscaler, do not enable the timer
+}
+
+void RingSetMelody(unsigned char Melody)
+{
+	if (Melody >= RING_MELODIES_COUNT) Melody = 0;
+	Ring_Melody_Offset = Ring_Melodies_Offsets[Melody];
 }
 
 void RingStart(void)
 {
-	// Preload the timer to get the requested interrupt rate
-	tmr0 = RING_TIMER_RELOAD_VALUE;
-	
-	// Enable the timer interrupt
-	intcon.T0IF = 0; // Clear the interrupt flag to avoid triggering a spurious interrupt
-	intcon.T0IE = 1;
+	// The tick interrupt plays the next notes with the same code, which is not reentrant
+	SYSTEM_TICK_MASK_INTERRUPT();
 	
 	// Start from the melody first note
-	portc.1 = Ring_Tone[0];
-	Ring_Tone_Index = 0;
+	Ring_Note_Offset = Ring_Melody_Offset;
+	Ring_Melody_Loops_Count = RING_MELODY_LOOPS_COUNT;
+	
+	// Start the PWM time base
+	tmr2 = 0;
+	t2con.TMR2ON = 1;
 	
-	// Melody will be played this amount of time then will be shut down if the user did not 
-	Ring_Melody_Loops_Count = 60;
+	RingPlayNote();
+	SYSTEM_TICK_UNMASK_INTERRUPT();
 }
 
 void RingStop(void)
 {
-	// Stop ringing
-	portc.1 = 0;
-	
-	// Disable the timer interrupt
-	intcon.T0IE = 0;
+	SYSTEM_TICK_MASK_INTERRUPT();
+	RingStopPlaying();
+	SYSTEM_TICK_UNMASK_INTERRUPT();
 }
 
-void RingInterruptHandler(void)
+void RingTimerHandler(void)
 {
-	// Stop the alarm if the alarm button is switched to "disabled", or if the alarm rang too long
-	if ((!ButtonIsAlarmEnabled()) || (Ring_Melody_Loops_Count == 0)) RingStop();
-	else
-	{
-		// Reload the timer
-		tmr0 = RING_TIMER_RELOAD_VALUE;
-		
-		// Play next tone
-		Ring_Tone_Index++;
-		if (Ring_Tone_Index >= sizeof(Ring_Tone))
-		{
-			Ring_Tone_Index = 0;
-			Ring_Melody_Loops_Count--; // Melody is restarting from the begining
-		}
-		portc.1 = Ring_Tone[Ring_Tone_Index];
-	}
-	
-	// Clear interrupt flag
-	intcon.T0IF = 0;
-}
\ No newline at end of file
+	// Stop the alarm if it rang too long (the main loop stops it when the alarm switch is moved to "disabled")
+	if (Ring_Melody_Loops_Count == 0) RingStopPlaying();
+	else RingPlayNote();
+}
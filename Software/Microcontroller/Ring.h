@@ -1,5 +1,5 @@
 /** @file Ring.h
- * Make the buzzer ring and stop.
+ * Make the buzzer play melodies stored in program memory, using the CCP2 module PWM mode to generate the notes.
  * @author Adrien RICCIARDI
  */
 #ifndef H_RING_H
@@ -8,24 +8,39 @@
 #include <system.h>
 
 //--------------------------------------------------------------------------------------------------
-// Constants and macros
+// Constants
 //--------------------------------------------------------------------------------------------------
-/** Tell if the ring interrupt fired or not. */
-#define RING_HAS_INTERRUPT_FIRED() (intcon.T0IE && intcon.T0IF)
+/** How many melodies can be selected. */
+#define RING_MELODIES_COUNT 3
 
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize the timer used to make the buzzer ring. */
+/** Initialize the buzzer pin and the PWM module time base. */
 void RingInitialize(void);
 
-/** Make the buzzer ring. */
+/** Select the melody to play when ringing.
+ * @param Melody The melody index, in range [0; RING_MELODIES_COUNT - 1]. The first melody is selected if the index is bad.
+ */
+void RingSetMelody(unsigned char Melody);
+
+/** Make the buzzer ring.
+ * @note This function must be called from the main loop only.
+ */
 void RingStart(void);
 
-/** Stop ringing. */
+/** Stop ringing.
+ * @note This function must be called from the main loop only.
+ */
 void RingStop(void);
 
-/** Must be called everytime the timer 0 interrupt fires. */
-void RingInterruptHandler(void);
+/** Tell whether the alarm is ringing.
+ * @return 0 if the buzzer is stopped,
+ * @return 1 if the alarm is ringing.
+ */
+#define RingIsRinging() t2con.TMR2ON
+
+/** Must be called everytime the SYSTEM_TICK_TIMER_RING timer expires, from the system tick interrupt. */
+void RingTimerHandler(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+/** @file Scheduler.c
+ * @see Scheduler.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "RTC.h"
+#include "Scheduler.h"
+#include "Timestamp.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** All posted events that have not been retrieved by the main loop yet. */
+static unsigned char Scheduler_Pending_Events;
+
+/** The RTC 1Hz signal level on the previous poll, used to detect the rising edge. */
+static unsigned char Scheduler_Previous_Tick_Level;
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void SchedulerInitialize(void)
+{
+	Scheduler_Pending_Events = 0;
+	Scheduler_Previous_Tick_Level = 0; // Consider that a tick begins if the signal is already high, so the display is updated right after boot
+}
+
+void SchedulerPostEventsFromInterrupt(unsigned char Events)
+{
+	Scheduler_Pending_Events |= Events;
+}
+
+void SchedulerPostEvents(unsigned char Events)
+{
+	intcon.GIE = 0;
+	Scheduler_Pending_Events |= Events;
+	intcon.GIE = 1;
+}
+
+unsigned char SchedulerWaitForEvents(void)
+{
+	unsigned char Events, Tick_Level;
+	
+	while (1)
+	{
+		// Detect the beginning of a new tick
+		Tick_Level = RTC_IS_TICK_IN_PROGRESS();
+		if (Tick_Level && !Scheduler_Previous_Tick_Level)
+		{
+			TimestampCaptureTick(); // Capture the edge before posting the event, as close as possible to the edge
+			SchedulerPostEvents(SCHEDULER_EVENT_TICK);
+		}
+		Scheduler_Previous_Tick_Level = Tick_Level;
+		
+		// Atomically retrieve and clear the pending events
+		intcon.GIE = 0;
+		Events = Scheduler_Pending_Events;
+		Scheduler_Pending_Events = 0;
+		intcon.GIE = 1;
+		
+		if (Events != 0) return Events;
+	}
+}
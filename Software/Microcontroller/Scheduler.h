@@ -0,0 +1,43 @@
+/** @file Scheduler.h
+ * A tiny run-to-completion scheduler. Interrupt handlers post events, the main loop waits for events and runs only the tasks that have work to do.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SCHEDULER_H
+#define H_SCHEDULER_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** A new RTC 1Hz tick began. */
+#define SCHEDULER_EVENT_TICK 0x01
+/** A button or switch event is available, get it with ButtonGetEvents(). */
+#define SCHEDULER_EVENT_BUTTON 0x02
+/** A whole configuration frame has been received from the UART. */
+#define SCHEDULER_EVENT_UART_FRAME 0x04
+/** A request that can't be served from the interrupt context has been received from the UART. */
+#define SCHEDULER_EVENT_UART_REQUEST 0x08
+/** A temperature sensor conversion has finished. */
+#define SCHEDULER_EVENT_ADC_READY 0x10
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Clear all pending events. */
+void SchedulerInitialize(void);
+
+/** Post one or more events from an interrupt handler.
+ * @param Events The events to post (SCHEDULER_EVENT_xxx values can be OR'ed).
+ */
+void SchedulerPostEventsFromInterrupt(unsigned char Events);
+
+/** Post one or more events from the main loop.
+ * @param Events The events to post (SCHEDULER_EVENT_xxx values can be OR'ed).
+ */
+void SchedulerPostEvents(unsigned char Events);
+
+/** Wait until at least one event is pending. The RTC 1Hz signal is polled while waiting, as it can't trigger an interrupt.
+ * @return All pending events, they are cleared from the pending events.
+ */
+unsigned char SchedulerWaitForEvents(void);
+
+#endif
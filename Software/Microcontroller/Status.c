@@ -0,0 +1,44 @@
+/** @file Status.c
+ * @see Status.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Status.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** Both snapshots, one is published while the other is filled. */
+static TStatus Status_Snapshots[2];
+/** The published snapshot index. It is a single byte, so the UART interrupt always sees a whole snapshot. */
+static unsigned char Status_Published_Snapshot_Index;
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void StatusInitialize(void)
+{
+	unsigned char i;
+	
+	Status_Published_Snapshot_Index = 0;
+	for (i = 0; i < sizeof(TStatus); i++) Status_Snapshots[0].Array[i] = 0;
+}
+
+TStatus *StatusGetUnpublishedSnapshot(void)
+{
+	return &Status_Snapshots[Status_Published_Snapshot_Index ^ 1];
+}
+
+void StatusPublish(void)
+{
+	unsigned char Index;
+	
+	Index = Status_Published_Snapshot_Index ^ 1;
+	Status_Snapshots[Index].Field_Name.Sequence_Number = Status_Snapshots[Status_Published_Snapshot_Index].Field_Name.Sequence_Number + 1;
+	Status_Published_Snapshot_Index = Index;
+}
+
+TStatus *StatusGetPublishedSnapshot(void)
+{
+	return &Status_Snapshots[Status_Published_Snapshot_Index];
+}
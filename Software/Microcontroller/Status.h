@@ -0,0 +1,76 @@
+/** @file Status.h
+ * A double-buffered snapshot of the clock status. The main loop fills the unpublished snapshot once per tick and publishes it in one step, while the UART interrupt sends the published snapshot without waiting for the main loop.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_STATUS_H
+#define H_STATUS_H
+
+#include "RTC.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** The status flag telling that the alarm switch is on. */
+#define STATUS_FLAG_ALARM_ENABLED 0x01
+/** The status flag telling that the alarm is ringing. */
+#define STATUS_FLAG_RINGING 0x02
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** A 16-bit field, sent most significant byte first. */
+typedef struct
+{
+	unsigned char High_Byte; //!< The most significant byte.
+	unsigned char Low_Byte; //!< The least significant byte.
+} TStatusWord;
+
+/** All status fields, in the order they are sent to the PC. */
+typedef struct
+{
+	unsigned char Sequence_Number; //!< Incremented on each publication, it tells the PC whether the snapshot has been updated since its last request.
+	TRTCClockData Clock_Data; //!< The date and time read on the last tick, in the RTC registers order.
+	unsigned char Temperature; //!< The filtered temperature in centigrade degrees.
+	unsigned char Alarm_Hour; //!< The alarm hour in BCD format.
+	unsigned char Alarm_Minutes; //!< The alarm minutes in BCD format.
+	unsigned char Flags; //!< The STATUS_FLAG_xxx values OR'ed.
+	unsigned char UART_Overrun_Errors_Count; //!< How many UART overruns happened since the clock started, saturated to 255.
+	unsigned char UART_Framing_Errors_Count; //!< How many bytes were received with a framing error since the clock started, saturated to 255.
+	unsigned char Button_Bounces_Count; //!< How many buttons bounces were filtered out since the clock started, saturated to 255.
+	TStatusWord Tick_Period; //!< The measured RTC 1Hz signal period in timestamp units, all following timestamps are relative to the tick the date and time were read on (see Timestamp.h).
+	TStatusWord Request_Time; //!< The timestamp of the telemetry request, filled by the UART interrupt right before sending the snapshot.
+	TStatusWord UART_Frame_Time; //!< The timestamp of the last configuration frame received.
+	TStatusWord Button_Press_Time; //!< The timestamp of the last snooze button press.
+	TStatusWord Temperature_Sample_Time; //!< The timestamp of the last temperature sample.
+} TStatusFields;
+
+/** A status snapshot. It can be accessed as a raw array to be sent or by field name. */
+typedef union
+{
+	unsigned char Array[sizeof(TStatusFields)]; //!< Raw access to the snapshot bytes.
+	TStatusFields Field_Name; //!< Named access to the fields.
+} TStatus;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Clear the published snapshot, so the PC gets a zero sequence number until the first publication. */
+void StatusInitialize(void);
+
+/** Get the snapshot the main loop can fill. The UART interrupt never reads it until it is published.
+ * @return The unpublished snapshot, all fields but the sequence number must be filled.
+ */
+TStatus *StatusGetUnpublishedSnapshot(void);
+
+/** Publish the filled snapshot, giving it the next sequence number. The previously published snapshot becomes the unpublished one : it is filled again one tick later, which is much longer than its transmission.
+ * @note This function must be called from the main loop only.
+ */
+void StatusPublish(void);
+
+/** Get the last published snapshot.
+ * @return The published snapshot.
+ * @note This function must be called from the UART interrupt only.
+ */
+TStatus *StatusGetPublishedSnapshot(void);
+
+#endif
@@ -0,0 +1,103 @@
+/** @file System_Tick.c
+ * @see System_Tick.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "System_Tick.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The remaining ticks of each software timer, 0 means that the timer is stopped. */
+static unsigned short System_Tick_Timers_Counters[SYSTEM_TICK_TIMERS_COUNT];
+
+/** The time when the current tick began, in timer 1 increments. */
+static unsigned long System_Tick_Time_Base;
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void SystemTickInitialize(void)
+{
+	unsigned char i;
+	
+	for (i = 0; i < SYSTEM_TICK_TIMERS_COUNT; i++) System_Tick_Timers_Counters[i] = 0;
+	System_Tick_Time_Base = 0;
+	
+	// Configure the CCP1 module to reset timer 1 when the tick period is reached
+	ccpr1h = (SYSTEM_TICK_PERIOD - 1) >> 8; // Timer 1 counts from 0 to the compare value
+	ccpr1l = (unsigned char) (SYSTEM_TICK_PERIOD - 1);
+	ccp1con = 0x0B; // Compare mode, trigger special event (the CCP1 pin is not driven, so RC2 can still be used as alarm button input)
+	
+	// Configure timer 1
+	tmr1h = 0;
+	tmr1l = 0;
+	t1con = SYSTEM_TICK_TIMER_PRESCALER_SELECT | 0x01; // Disable the built-in oscillator circuit, use Fosc/4 as clock source, enable the timer
+	
+	// Enable the tick interrupt
+	pir1.CCP1IF = 0;
+	pie1.CCP1IE = 1;
+}
+
+void SystemTickStartTimer(TSystemTickTimer Timer, unsigned short Ticks_Count)
+{
+	System_Tick_Timers_Counters[Timer] = Ticks_Count;
+}
+
+void SystemTickStopTimer(TSystemTickTimer Timer)
+{
+	SystemTickStartTimer(Timer, 0);
+}
+
+unsigned long SystemTickGetLongTime(void)
+{
+	unsigned long Time_Base;
+	unsigned short Timer_Value;
+	unsigned char High_Byte, Low_Byte;
+	
+	do
+	{
+		Time_Base = System_Tick_Time_Base;
+		
+		// Read the timer without being fooled by a low byte overflow happening between the two bytes read
+		do
+		{
+			High_Byte = tmr1h;
+			Low_Byte = tmr1l;
+		} while (High_Byte != tmr1h);
+		Timer_Value = ((unsigned short) High_Byte << 8) | Low_Byte;
+		
+		// The timer has been reset but the interrupt handler did not update the time base yet (this always happens when called from the interrupt context)
+		if (pir1.CCP1IF && (Timer_Value < SYSTEM_TICK_PERIOD / 2)) Timer_Value += SYSTEM_TICK_PERIOD;
+	} while (Time_Base != System_Tick_Time_Base); // Start again if the tick interrupt fired meanwhile
+	
+	return Time_Base + Timer_Value;
+}
+
+unsigned short SystemTickGetTime(void)
+{
+	return (unsigned short) SystemTickGetLongTime();
+}
+
+unsigned char SystemTickInterruptHandler(void)
+{
+	unsigned char i, Timer_Mask = 1, Expired_Timers = 0;
+	
+	System_Tick_Time_Base += SYSTEM_TICK_PERIOD;
+	
+	// Update the software timers
+	for (i = 0; i < SYSTEM_TICK_TIMERS_COUNT; i++)
+	{
+		if (System_Tick_Timers_Counters[i] != 0)
+		{
+			System_Tick_Timers_Counters[i]--;
+			if (System_Tick_Timers_Counters[i] == 0) Expired_Timers |= Timer_Mask;
+		}
+		Timer_Mask <<= 1;
+	}
+	
+	// Clear the interrupt flag
+	pir1.CCP1IF = 0;
+	
+	return Expired_Timers;
+}
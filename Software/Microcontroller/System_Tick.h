@@ -0,0 +1,107 @@
+/** @file System_Tick.h
+ * A periodic system tick shared by all modules, with software timers multiplexed on it. Timer 1 is automatically reset by the CCP1 module special event trigger, so there is no reload jitter.
+ * The timer 1 value is also combined with the elapsed ticks to provide a time base counting in timer 1 increments (one instruction cycle at 4MHz, two instruction cycles at 20MHz).
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SYSTEM_TICK_H
+#define H_SYSTEM_TICK_H
+
+#include <system.h>
+#include "Configuration.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** The system tick frequency in Hz. */
+#define SYSTEM_TICK_FREQUENCY 50
+/** How many instruction cycles are in a system tick period. */
+#define SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK (CONFIGURATION_INSTRUCTION_FREQUENCY / SYSTEM_TICK_FREQUENCY)
+
+// Select the smallest timer 1 prescaler allowing the tick period to fit in the 16-bit CCPR1 register, for the best time base resolution
+#if SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK <= 65536
+	/** The timer 1 prescaler value. */
+	#define SYSTEM_TICK_TIMER_PRESCALER 1
+	/** The T1CON prescaler select bits. */
+	#define SYSTEM_TICK_TIMER_PRESCALER_SELECT 0x00
+#elif SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK <= 131072
+	#define SYSTEM_TICK_TIMER_PRESCALER 2
+	#define SYSTEM_TICK_TIMER_PRESCALER_SELECT 0x10
+#elif SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK <= 262144
+	#define SYSTEM_TICK_TIMER_PRESCALER 4
+	#define SYSTEM_TICK_TIMER_PRESCALER_SELECT 0x20
+#elif SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK <= 524288
+	#define SYSTEM_TICK_TIMER_PRESCALER 8
+	#define SYSTEM_TICK_TIMER_PRESCALER_SELECT 0x30
+#else
+	#error "The system tick frequency is too low for this core frequency."
+#endif
+
+#if SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK % SYSTEM_TICK_TIMER_PRESCALER != 0
+	#error "The system tick frequency can't be exactly generated at this core frequency."
+#endif
+
+/** How many timer 1 increments are in a system tick period. */
+#define SYSTEM_TICK_PERIOD (SYSTEM_TICK_INSTRUCTION_CYCLES_PER_TICK / SYSTEM_TICK_TIMER_PRESCALER) // Period = (Fosc/4) / (Prescaler * Ftick)
+
+/** Convert a duration in milliseconds to system ticks. */
+#define SYSTEM_TICK_MILLISECONDS_TO_TICKS(Milliseconds) (((Milliseconds) * SYSTEM_TICK_FREQUENCY) / 1000)
+
+/** Get the expired timers bit mask value corresponding to a timer.
+ * @param Timer The timer.
+ */
+#define SYSTEM_TICK_TIMER_MASK(Timer) (1 << (Timer))
+
+/** Tell whether the system tick interrupt fired or not. */
+#define SYSTEM_TICK_HAS_INTERRUPT_FIRED() pir1.CCP1IF
+
+/** Mask the system tick interrupt only, so the main loop can call the functions that the tick interrupt calls too. A tick happening meanwhile is served as soon as the interrupt is unmasked. */
+#define SYSTEM_TICK_MASK_INTERRUPT() pie1.CCP1IE = 0
+/** Unmask the system tick interrupt. */
+#define SYSTEM_TICK_UNMASK_INTERRUPT() pie1.CCP1IE = 1
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All software timers. */
+typedef enum
+{
+	SYSTEM_TICK_TIMER_RING, //!< Play the ring melody.
+	SYSTEM_TICK_TIMER_DISPLAY_BACKLIGHT, //!< Turn off the display backlight.
+	SYSTEM_TICK_TIMERS_COUNT
+} TSystemTickTimer;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Configure timer 1 and the CCP1 module to generate the system tick, stop all software timers. */
+void SystemTickInitialize(void);
+
+/** Start or restart a one-shot software timer.
+ * @note The compiler does not support reentrancy (the parameters and local variables are static), so this function must be called from the system tick interrupt, or from the main loop with the tick interrupt masked (see SYSTEM_TICK_MASK_INTERRUPT()).
+ * @param Timer The timer to start.
+ * @param Ticks_Count How many system ticks to wait before the timer expires. 0 stops the timer.
+ */
+void SystemTickStartTimer(TSystemTickTimer Timer, unsigned short Ticks_Count);
+
+/** Stop a software timer.
+ * @param Timer The timer to stop.
+ * @note Like SystemTickStartTimer(), this function must be called from the system tick interrupt, or from the main loop with the tick interrupt masked.
+ */
+void SystemTickStopTimer(TSystemTickTimer Timer);
+
+/** Get the current time in timer 1 increments (SYSTEM_TICK_TIMER_PRESCALER instruction cycles each). The value wraps around, so only use it to compute durations shorter than 65536 increments.
+ * @return The current time.
+ */
+unsigned short SystemTickGetTime(void);
+
+/** Get the current time in timer 1 increments, like SystemTickGetTime(), on 32 bits so durations longer than a second can be measured. The value wraps around too, after 71 minutes at 4MHz.
+ * @return The current time.
+ */
+unsigned long SystemTickGetLongTime(void);
+
+/** Must be called each time the system tick interrupt fires.
+ * @return The expired timers, a bit set to 1 means that the timer of the same number expired (use SYSTEM_TICK_TIMER_MASK() to test a timer).
+ */
+unsigned char SystemTickInterruptHandler(void);
+
+#endif
@@ -0,0 +1,44 @@
+/** @file Tables.c
+ * @see Tables.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Tables.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** All day names, one after the other. The first name is used for invalid days. */
+static rom char *Tables_String_Day_Names = "???DIMLUNMARMERJEUVENSAM";
+
+/** The BCD value of each number in range [0; 99]. */
+static rom unsigned char *Tables_BCD_Values =
+{
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99
+};
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+unsigned char TablesGetDayNameCharacter(unsigned char Day_Of_Week, unsigned char Character_Index)
+{
+	// Use the invalid day name if the RTC contains garbage
+	if (Day_Of_Week > 7) Day_Of_Week = 0;
+	
+	return Tables_String_Day_Names[Day_Of_Week * TABLES_DAY_NAME_LENGTH + Character_Index];
+}
+
+unsigned char TablesConvertBinaryToBCD(unsigned char Number)
+{
+	if (Number > 99) Number = 99;
+	return Tables_BCD_Values[Number];
+}
@@ -0,0 +1,30 @@
+/** @file Tables.h
+ * Gather all constant tables. They are stored in program memory as "retlw" tables, so they do not use RAM nor startup initialization time.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TABLES_H
+#define H_TABLES_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** How many characters are in a day name. */
+#define TABLES_DAY_NAME_LENGTH 3
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Get a character of a day name.
+ * @param Day_Of_Week The day of the week in range [1; 7], 1 stands for sunday. An out of range day is displayed as "???".
+ * @param Character_Index The character index in range [0; TABLES_DAY_NAME_LENGTH - 1].
+ * @return The requested character.
+ */
+unsigned char TablesGetDayNameCharacter(unsigned char Day_Of_Week, unsigned char Character_Index);
+
+/** Convert a binary number to one-byte Binary Coded Decimal using a lookup table, which is faster than dividing.
+ * @param Number The number to convert. Numbers greater than 99 are converted as 99.
+ * @return The BCD value.
+ */
+unsigned char TablesConvertBinaryToBCD(unsigned char Number);
+
+#endif
@@ -3,7 +3,25 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
+#include "Configuration.h"
+#include "Scheduler.h"
 #include "Temperature_Sensor.h"
+#include "Timestamp.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+// Select the fastest ADC conversion clock giving a TAD of at least 1.6s
+#if CONFIGURATION_CLOCK_FREQUENCY <= 1250000
+	/** The ADCON0 conversion clock select bits. */
+	#define TEMPERATURE_SENSOR_ADC_CLOCK_SELECT 0x00 // Fosc / 2
+#elif CONFIGURATION_CLOCK_FREQUENCY <= 5000000
+	#define TEMPERATURE_SENSOR_ADC_CLOCK_SELECT 0x40 // Fosc / 8
+#elif CONFIGURATION_CLOCK_FREQUENCY <= 20000000
+	#define TEMPERATURE_SENSOR_ADC_CLOCK_SELECT 0x80 // Fosc / 32
+#else
+	#error "No ADC conversion clock can provide a TAD of at least 1.6s at this core frequency."
+#endif
 
 //--------------------------------------------------------------------------------------------------
 // Public functions
@@ -12,24 +30,40 @@ void TemperatureSensorInitialize(void)
 {
 	// Set only RA0 as analog
 	trisa.0 = 1; // Configure pin as input
-
+	
 	// Configure the ADC module
 	adcon1 = 0x8E; // Result of conversion is right justified, configure only RA0 as analog
-	adcon0 = 0x41; // Conversion clock at Fosc / 8 (TAD = 2s), select channel 0 (RA0), enable the ADC module
+	adcon0 = TEMPERATURE_SENSOR_ADC_CLOCK_SELECT | 0x01; // Select channel 0 (RA0), enable the ADC module
+	
+	// Enable the conversion end interrupt
+	pir1.ADIF = 0;
+	pie1.ADIE = 1;
+}
+
+void TemperatureSensorStartConversion(void)
+{
+	adcon0.GO = 1;
 }
 
 unsigned char TemperatureSensorGetTemperature(void)
 {
 	unsigned long Double_Word;
-
-	// Start conversion
-	adcon0.GO = 1;
-	while (adcon0.GO); // Wait for the conversion to finish
 	
 	// Convert the raw voltage to a centigrade temperature
 	Double_Word = (adresh << 8) | adresl; // Get the raw ADC value
 	Double_Word *= 100; // Multiply by 100 to perform fixed point calculations (use 100 because the sensor conversion is 10mv/C, so 1C = 0.01V
-	Double_Word = (500 * Double_Word) / 102300; // Convert the raw ADC value to volts*100 using the following formula : Voltage * 100 = 500 * (Raw_ADC_Value * 100) / 102300
+	Double_Word = ((500 * Double_Word) + (102300 / 2)) / 102300; // Convert the raw ADC value to volts*100 using the following formula : Voltage * 100 = 500 * (Raw_ADC_Value * 100) / 102300, rounded to the nearest value
 	
 	return (unsigned char) Double_Word;
-}
\ No newline at end of file
+}
+
+void TemperatureSensorInterruptHandler(void)
+{
+	TimestampCaptureEvent(TIMESTAMP_EVENT_TEMPERATURE_SAMPLE);
+	
+	// Let the main loop convert the sample, as this is a long computation
+	SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_ADC_READY);
+	
+	// Clear the interrupt flag
+	pir1.ADIF = 0;
+}
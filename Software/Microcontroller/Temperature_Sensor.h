@@ -5,15 +5,29 @@
 #ifndef H_TEMPERATURE_SENSOR_H
 #define H_TEMPERATURE_SENSOR_H
 
+#include <system.h>
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** Tell whether the ADC conversion end interrupt fired or not. */
+#define TEMPERATURE_SENSOR_HAS_INTERRUPT_FIRED() (pie1.ADIE && pir1.ADIF)
+
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
 /** Initialize the ADC module and the pin RA0 as analog. All other port A pins are digital. */
 void TemperatureSensorInitialize(void);
 
-/** Get the current temperature converted to centigrade.
- * @return The current temperature converted to centigrade. The temperature will always be positive.
+/** Start sampling the temperature. The SCHEDULER_EVENT_ADC_READY event is posted when the conversion is finished. */
+void TemperatureSensorStartConversion(void);
+
+/** Get the last sampled temperature converted to centigrade. Call this function only when the SCHEDULER_EVENT_ADC_READY event has been received.
+ * @return The last sampled temperature converted to centigrade. The temperature will always be positive.
  */
 unsigned char TemperatureSensorGetTemperature(void);
 
+/** Must be called when the ADC conversion end interrupt fires. */
+void TemperatureSensorInterruptHandler(void);
+
 #endif
\ No newline at end of file
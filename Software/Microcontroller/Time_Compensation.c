@@ -0,0 +1,147 @@
+/** @file Time_Compensation.c
+ * @see Time_Compensation.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "RTC.h"
+#include "Time_Compensation.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The crystal curve base address in RTC RAM : turnover temperature, curvature, offset most significant byte, offset least significant byte and the checksum of the previous bytes. */
+#define TIME_COMPENSATION_CURVE_BASE_ADDRESS 0x0D
+/** How many bytes a curve takes in RTC RAM, without its checksum. The checksum is the complement of the bytes sum, so a RTC RAM that was never initialized (full of zeros or of ones) does not hold a valid curve. */
+#define TIME_COMPENSATION_CURVE_SIZE 4
+
+/** The error corrected at once in nanoseconds (the error is accumulated in ppb multiplied by seconds). Writing the seconds register restarts a whole second, while the tick begins in the middle of a second, so each write delays the RTC by half a second. */
+#define TIME_COMPENSATION_CORRECTION_STEP 500000000
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The crystal curve. */
+static TTimeCompensationCurve Time_Compensation_Curve;
+/** The accumulated time error in nanoseconds, it is positive when the RTC is ahead of the real time. It has no initializer so the C startup code leaves it untouched on a warm boot. */
+static signed long Time_Compensation_Error;
+/** The accumulated error complement, so a warm boot can tell whether the error survived the reset. */
+static signed long Time_Compensation_Error_Complement;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Change the accumulated error and its complement.
+ * @param Error The new error in nanoseconds.
+ */
+static void TimeCompensationSetError(signed long Error)
+{
+	Time_Compensation_Error = Error;
+	Time_Compensation_Error_Complement = ~Error;
+}
+
+/** Convert the curve to the bytes stored in RTC RAM.
+ * @param Pointer_Bytes On output, contain the TIME_COMPENSATION_CURVE_SIZE curve bytes.
+ * @return The checksum of the bytes.
+ */
+static unsigned char TimeCompensationConvertCurveToBytes(unsigned char *Pointer_Bytes)
+{
+	unsigned char i, Checksum = 0;
+	
+	Pointer_Bytes[0] = Time_Compensation_Curve.Turnover_Temperature;
+	Pointer_Bytes[1] = Time_Compensation_Curve.Curvature;
+	Pointer_Bytes[2] = Time_Compensation_Curve.Offset >> 8;
+	Pointer_Bytes[3] = (unsigned char) Time_Compensation_Curve.Offset;
+	for (i = 0; i < TIME_COMPENSATION_CURVE_SIZE; i++) Checksum += Pointer_Bytes[i];
+	
+	return ~Checksum;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void TimeCompensationInitialize(unsigned char Is_Warm_Boot)
+{
+	unsigned char Bytes[TIME_COMPENSATION_CURVE_SIZE], i, Checksum = 0;
+	
+	// The error can't be recovered from anywhere else, so it is kept on a warm boot unless the RAM content is corrupted
+	if (!Is_Warm_Boot || (Time_Compensation_Error_Complement != ~Time_Compensation_Error)) TimeCompensationSetError(0);
+	
+	// The curve is always loaded again from the RTC RAM cache, which is loaded again on every boot too, so a corrupted curve is never kept
+	for (i = 0; i < TIME_COMPENSATION_CURVE_SIZE; i++)
+	{
+		Bytes[i] = RTCReadRAMByte(TIME_COMPENSATION_CURVE_BASE_ADDRESS + i);
+		Checksum += Bytes[i];
+	}
+	
+	// Use the typical crystal curve if none was saved
+	if (RTCReadRAMByte(TIME_COMPENSATION_CURVE_BASE_ADDRESS + TIME_COMPENSATION_CURVE_SIZE) != (unsigned char) ~Checksum)
+	{
+		Time_Compensation_Curve.Turnover_Temperature = TIME_COMPENSATION_DEFAULT_TURNOVER_TEMPERATURE;
+		Time_Compensation_Curve.Curvature = TIME_COMPENSATION_DEFAULT_CURVATURE;
+		Time_Compensation_Curve.Offset = 0;
+		return;
+	}
+	
+	Time_Compensation_Curve.Turnover_Temperature = Bytes[0];
+	Time_Compensation_Curve.Curvature = Bytes[1];
+	Time_Compensation_Curve.Offset = ((signed short) Bytes[2] << 8) | Bytes[3];
+}
+
+void TimeCompensationSetCurve(TTimeCompensationCurve *Pointer_Curve)
+{
+	unsigned char Bytes[TIME_COMPENSATION_CURVE_SIZE], i, Checksum;
+	
+	Time_Compensation_Curve.Turnover_Temperature = Pointer_Curve->Turnover_Temperature;
+	Time_Compensation_Curve.Curvature = Pointer_Curve->Curvature;
+	Time_Compensation_Curve.Offset = Pointer_Curve->Offset;
+	
+	// Save it to the RTC RAM, it is written on the next tick
+	Checksum = TimeCompensationConvertCurveToBytes(Bytes);
+	for (i = 0; i < TIME_COMPENSATION_CURVE_SIZE; i++) RTCWriteRAMByte(TIME_COMPENSATION_CURVE_BASE_ADDRESS + i, Bytes[i]);
+	RTCWriteRAMByte(TIME_COMPENSATION_CURVE_BASE_ADDRESS + TIME_COMPENSATION_CURVE_SIZE, Checksum);
+}
+
+void TimeCompensationClearError(void)
+{
+	TimeCompensationSetError(0);
+}
+
+void TimeCompensationAccumulateError(unsigned char Temperature, unsigned char Duration)
+{
+	signed short Difference;
+	signed long Frequency_Error;
+	
+	// Compute the crystal frequency error in ppb at this temperature
+	Difference = (signed short) Temperature - Time_Compensation_Curve.Turnover_Temperature;
+	Frequency_Error = Time_Compensation_Curve.Offset - ((signed long) Time_Compensation_Curve.Curvature * (Difference * Difference));
+	
+	// A frequency error of 1ppb makes the RTC drift of 1ns each second
+	TimeCompensationSetError(Time_Compensation_Error + Frequency_Error * Duration);
+}
+
+unsigned char TimeCompensationCorrectTime(TRTCClockData *Pointer_Clock_Data)
+{
+	unsigned char Seconds;
+	
+	Seconds = Pointer_Clock_Data->Register_Name.Seconds;
+	
+	// The RTC is late, write the next second : it is reached half a second earlier than without the write. Only the seconds register is written, so the correction is delayed to the next tick when it would carry to the minutes
+	if (Time_Compensation_Error <= -TIME_COMPENSATION_CORRECTION_STEP)
+	{
+		if (Seconds >= 0x59) return 0;
+		if ((Seconds & 0x0F) == 0x09) Seconds += 7; // Add one in BCD
+		else Seconds++;
+		TimeCompensationSetError(Time_Compensation_Error + TIME_COMPENSATION_CORRECTION_STEP);
+	}
+	// The RTC is ahead, write the same second again, so it lasts half a second longer. The alarm is checked on each tick, so the second 00 must not last for two ticks
+	else if (Time_Compensation_Error >= TIME_COMPENSATION_CORRECTION_STEP)
+	{
+		if (Seconds == 0x00) return 0;
+		TimeCompensationSetError(Time_Compensation_Error - TIME_COMPENSATION_CORRECTION_STEP);
+	}
+	else return 0;
+	
+	Pointer_Clock_Data->Register_Name.Seconds = Seconds;
+	RTCSetDateAndTime(Pointer_Clock_Data, 0x01); // Write the seconds only
+	return 1;
+}
@@ -0,0 +1,59 @@
+/** @file Time_Compensation.h
+ * Compensate the RTC crystal frequency error caused by the temperature. A 32.768KHz tuning fork crystal runs at its nominal frequency at its turnover temperature, and slower when its temperature moves away, following a parabola : the frequency error in ppb is Offset - Curvature * (Temperature - Turnover_Temperature).
+ * The time error is accumulated from the measured temperatures, and the RTC time is moved half a second forward or backward each time the error reaches half a second.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TIME_COMPENSATION_H
+#define H_TIME_COMPENSATION_H
+
+#include "RTC.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** The turnover temperature of a typical 32.768KHz crystal, used when no curve has been configured. */
+#define TIME_COMPENSATION_DEFAULT_TURNOVER_TEMPERATURE 25
+/** The parabola coefficient of a typical 32.768KHz crystal (0.034ppm/C), used when no curve has been configured. */
+#define TIME_COMPENSATION_DEFAULT_CURVATURE 34
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** The crystal frequency curve. */
+typedef struct
+{
+	signed char Turnover_Temperature; //!< The temperature the frequency is the highest at, in centigrade degrees.
+	unsigned char Curvature; //!< How fast the frequency decreases away from the turnover temperature, in ppb per squared centigrade degree.
+	signed short Offset; //!< The frequency error at the turnover temperature in ppb, it is positive when the crystal runs fast.
+} TTimeCompensationCurve;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Load the crystal curve saved in the RTC RAM, or use the typical curve if none was saved. The curve is loaded on every boot, so it must be called after the RTC RAM cache is loaded.
+ * @param Is_Warm_Boot Set to 1 when the RAM content survived a reset, so the accumulated error is kept if it is not corrupted. Set to 0 to clear the error.
+ */
+void TimeCompensationInitialize(unsigned char Is_Warm_Boot);
+
+/** Use a new crystal curve and save it to the RTC RAM, so it can survive a power loss.
+ * @param Pointer_Curve The curve.
+ */
+void TimeCompensationSetCurve(TTimeCompensationCurve *Pointer_Curve);
+
+/** Forget the accumulated error, must be called when the time is set from an accurate source. */
+void TimeCompensationClearError(void);
+
+/** Accumulate the time error of a period spent at a temperature.
+ * @param Temperature The measured temperature in centigrade degrees.
+ * @param Duration The period duration in seconds.
+ */
+void TimeCompensationAccumulateError(unsigned char Temperature, unsigned char Duration);
+
+/** Move the RTC time half a second forward or backward if the accumulated error reached half a second. Must be called right after a tick began, as the correction relies on the RTC divider chain being in the middle of a second.
+ * @param Pointer_Clock_Data The date and time read on this tick. On output, the seconds are corrected.
+ * @return 1 if the time was corrected,
+ * @return 0 if the time did not need to be corrected (or could not be corrected on this tick).
+ */
+unsigned char TimeCompensationCorrectTime(TRTCClockData *Pointer_Clock_Data);
+
+#endif
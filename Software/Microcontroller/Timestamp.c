@@ -0,0 +1,171 @@
+/** @file Timestamp.c
+ * @see Timestamp.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "System_Tick.h"
+#include "Timestamp.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+// Select the smallest time base division keeping a second below 16384 units, so the timestamps of the two seconds around an edge fit in a signed 16-bit value
+#if SYSTEM_TICK_PERIOD * SYSTEM_TICK_FREQUENCY < 1048576
+	/** How many bits the time base is shifted right by to get timestamp units. */
+	#define TIMESTAMP_UNIT_SHIFT 6
+#elif SYSTEM_TICK_PERIOD * SYSTEM_TICK_FREQUENCY < 2097152
+	#define TIMESTAMP_UNIT_SHIFT 7
+#elif SYSTEM_TICK_PERIOD * SYSTEM_TICK_FREQUENCY < 4194304
+	#define TIMESTAMP_UNIT_SHIFT 8
+#else
+	#error "The system tick time base is too fast for the timestamps."
+#endif
+
+/** How many time base increments are in a second when both crystals run at their nominal frequency. */
+#define TIMESTAMP_NOMINAL_SECOND ((unsigned long) SYSTEM_TICK_PERIOD * SYSTEM_TICK_FREQUENCY)
+/** The RTC 1Hz signal period in timestamp units when both crystals run at their nominal frequency. */
+#define TIMESTAMP_NOMINAL_TICK_PERIOD ((unsigned short) (TIMESTAMP_NOMINAL_SECOND >> TIMESTAMP_UNIT_SHIFT))
+/** The measured periods farther than this from the nominal period are discarded. Both crystals are much more accurate than 0.4%, so such a period comes from an edge detected late by a busy main loop, or from a RTC write. */
+#define TIMESTAMP_TICK_PERIOD_TOLERANCE (TIMESTAMP_NOMINAL_TICK_PERIOD >> 8)
+/** The weight of a new period in the filtered period is 1/2^TIMESTAMP_TICK_PERIOD_FILTER_SHIFT, this smoothes the edges detection jitter. */
+#define TIMESTAMP_TICK_PERIOD_FILTER_SHIFT 3
+
+/** The events older than this are forgotten, in time base increments. */
+#define TIMESTAMP_MAXIMUM_EVENT_AGE (2 * TIMESTAMP_NOMINAL_SECOND)
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The time base value on the last edge. */
+static unsigned long Timestamp_Edge_Time;
+/** Tell whether the last edge can be related to the RTC seconds. */
+static unsigned char Timestamp_Is_Edge_Trusted;
+/** Tell whether the next edge will be a real one. The first edge seen after the boot can be the boot itself, when the signal is already high. */
+static unsigned char Timestamp_Is_Next_Edge_Trusted;
+/** The filtered period, with TIMESTAMP_TICK_PERIOD_FILTER_SHIFT fractional bits. */
+static unsigned long Timestamp_Filtered_Tick_Period;
+
+/** The reference of the timestamps computed from the interrupt context. */
+static unsigned long Timestamp_Published_Edge_Time;
+/** Tell whether the published edge can be related to the RTC seconds. */
+static unsigned char Timestamp_Is_Published_Edge_Trusted;
+
+/** The time base value of each event. */
+static unsigned long Timestamp_Events_Times[TIMESTAMP_EVENTS_COUNT];
+/** A bit set to 1 tells that the event of the same number happened. */
+static unsigned char Timestamp_Captured_Events;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Convert a time base value to a timestamp.
+ * @param Time The time base value.
+ * @param Reference The time base value of the edge.
+ * @return The timestamp,
+ * @return TIMESTAMP_NONE if the time is too far from the edge.
+ */
+static signed short TimestampConvert(unsigned long Time, unsigned long Reference)
+{
+	unsigned long Difference;
+	
+	// Shift the difference magnitude, as shifting a negative value does not divide it on all compilers
+	Difference = Time - Reference;
+	if (Difference & 0x80000000)
+	{
+		Difference = (Reference - Time) >> TIMESTAMP_UNIT_SHIFT;
+		if (Difference > 32767) return TIMESTAMP_NONE;
+		return -(signed short) Difference;
+	}
+	
+	Difference >>= TIMESTAMP_UNIT_SHIFT;
+	if (Difference > 32767) return TIMESTAMP_NONE;
+	return (signed short) Difference;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void TimestampInitialize(void)
+{
+	Timestamp_Is_Edge_Trusted = 0;
+	Timestamp_Is_Next_Edge_Trusted = 0;
+	Timestamp_Filtered_Tick_Period = (unsigned long) TIMESTAMP_NOMINAL_TICK_PERIOD << TIMESTAMP_TICK_PERIOD_FILTER_SHIFT;
+	Timestamp_Is_Published_Edge_Trusted = 0;
+	Timestamp_Captured_Events = 0;
+}
+
+void TimestampCaptureTick(void)
+{
+	unsigned long Time;
+	unsigned short Period;
+	unsigned char i, Event_Mask = 1;
+	
+	// The interrupt handlers read the time base too, and the time base reading code is not reentrant
+	intcon.GIE = 0;
+	Time = SystemTickGetLongTime();
+	
+	// Forget the events that are too old to be related to the new edge, before the time base wraps around
+	for (i = 0; i < TIMESTAMP_EVENTS_COUNT; i++)
+	{
+		if ((Timestamp_Captured_Events & Event_Mask) && (Time - Timestamp_Events_Times[i] > TIMESTAMP_MAXIMUM_EVENT_AGE)) Timestamp_Captured_Events &= ~Event_Mask;
+		Event_Mask <<= 1;
+	}
+	intcon.GIE = 1;
+	
+	// Calibrate the time base against the RTC crystal
+	if (Timestamp_Is_Edge_Trusted)
+	{
+		Period = (unsigned short) ((Time - Timestamp_Edge_Time) >> TIMESTAMP_UNIT_SHIFT);
+		if ((Period > TIMESTAMP_NOMINAL_TICK_PERIOD - TIMESTAMP_TICK_PERIOD_TOLERANCE) && (Period < TIMESTAMP_NOMINAL_TICK_PERIOD + TIMESTAMP_TICK_PERIOD_TOLERANCE)) Timestamp_Filtered_Tick_Period = Timestamp_Filtered_Tick_Period - (Timestamp_Filtered_Tick_Period >> TIMESTAMP_TICK_PERIOD_FILTER_SHIFT) + Period;
+	}
+	
+	Timestamp_Edge_Time = Time;
+	Timestamp_Is_Edge_Trusted = Timestamp_Is_Next_Edge_Trusted;
+	Timestamp_Is_Next_Edge_Trusted = 1;
+}
+
+void TimestampResynchronize(void)
+{
+	intcon.GIE = 0;
+	Timestamp_Is_Published_Edge_Trusted = 0;
+	Timestamp_Captured_Events = 0; // They were dated with the previous seconds
+	intcon.GIE = 1;
+	
+	Timestamp_Is_Edge_Trusted = 0;
+	Timestamp_Is_Next_Edge_Trusted = 1; // The RTC 1Hz signal went low when the divider chain was restarted
+}
+
+void TimestampCaptureEvent(TTimestampEvent Event)
+{
+	Timestamp_Events_Times[Event] = SystemTickGetLongTime();
+	Timestamp_Captured_Events |= 1 << Event;
+}
+
+signed short TimestampGetEventTime(TTimestampEvent Event)
+{
+	signed short Time = TIMESTAMP_NONE;
+	
+	// The conversion is shared with the UART interrupt, so it can't be interrupted
+	intcon.GIE = 0;
+	if (Timestamp_Is_Edge_Trusted && (Timestamp_Captured_Events & (1 << Event))) Time = TimestampConvert(Timestamp_Events_Times[Event], Timestamp_Edge_Time);
+	intcon.GIE = 1;
+	
+	return Time;
+}
+
+unsigned short TimestampGetTickPeriod(void)
+{
+	return (unsigned short) ((Timestamp_Filtered_Tick_Period + (1 << (TIMESTAMP_TICK_PERIOD_FILTER_SHIFT - 1))) >> TIMESTAMP_TICK_PERIOD_FILTER_SHIFT);
+}
+
+void TimestampPublish(void)
+{
+	Timestamp_Published_Edge_Time = Timestamp_Edge_Time;
+	Timestamp_Is_Published_Edge_Trusted = Timestamp_Is_Edge_Trusted;
+}
+
+signed short TimestampGetTime(void)
+{
+	if (!Timestamp_Is_Published_Edge_Trusted) return TIMESTAMP_NONE;
+	return TimestampConvert(SystemTickGetLongTime(), Timestamp_Published_Edge_Time);
+}
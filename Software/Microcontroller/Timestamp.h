@@ -0,0 +1,74 @@
+/** @file Timestamp.h
+ * Date events with a sub-second resolution. The RTC only tells the time to the second, so the system tick time base is captured on each RTC 1Hz signal rising edge, which happens in the middle of a second, and the edge-to-edge period is measured to calibrate the time base against the RTC crystal.
+ * An event timestamp is the time elapsed from the last edge to the event, in timestamp units (the time base increments divided by a power of two, so a whole second fits in 16 bits). Dividing it by the measured period gives the fraction of second, which is left to the PC to keep the divisions out of the interrupt handlers.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TIMESTAMP_H
+#define H_TIMESTAMP_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants and macros
+//--------------------------------------------------------------------------------------------------
+/** The timestamp of an event that did not happen, or that can't be related to the current second. */
+#define TIMESTAMP_NONE -32768
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All timestamped events. */
+typedef enum
+{
+	TIMESTAMP_EVENT_UART_FRAME, //!< A whole configuration frame was received from the UART.
+	TIMESTAMP_EVENT_BUTTON_PRESS, //!< The snooze button was pressed.
+	TIMESTAMP_EVENT_TEMPERATURE_SAMPLE, //!< A temperature sensor conversion finished.
+	TIMESTAMP_EVENTS_COUNT
+} TTimestampEvent;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Forget all edges and events, use the nominal period until a period is measured. */
+void TimestampInitialize(void);
+
+/** Capture the time base on a RTC 1Hz signal rising edge, and update the measured period.
+ * @note This function must be called from the main loop, as soon as the edge is detected.
+ */
+void TimestampCaptureTick(void);
+
+/** Forget the last edge, must be called when the RTC seconds are written because this restarts the RTC divider chain. The next edge comes half a second after the write.
+ * @note This function must be called from the main loop only.
+ */
+void TimestampResynchronize(void);
+
+/** Remember when an event happened.
+ * @param Event The event.
+ * @note This function must be called from the interrupt context only.
+ */
+void TimestampCaptureEvent(TTimestampEvent Event);
+
+/** Get when an event happened, relative to the last edge.
+ * @param Event The event.
+ * @return The event timestamp, negative if the event happened before the edge,
+ * @return TIMESTAMP_NONE if the event did not happen in the last two seconds.
+ * @note This function must be called from the main loop only.
+ */
+signed short TimestampGetEventTime(TTimestampEvent Event);
+
+/** Get the measured RTC 1Hz signal period.
+ * @return The period in timestamp units.
+ */
+unsigned short TimestampGetTickPeriod(void);
+
+/** Make the last edge the reference of TimestampGetTime(). Call it with the interrupts disabled, along with the publication of the status snapshot reporting the second of this edge.
+ * @note This function must be called from the main loop only.
+ */
+void TimestampPublish(void);
+
+/** Get the current time relative to the published edge.
+ * @return The current timestamp,
+ * @return TIMESTAMP_NONE if no edge was published yet or if the published edge is too old.
+ * @note This function must be called from the interrupt context only.
+ */
+signed short TimestampGetTime(void);
+
+#endif
@@ -3,15 +3,89 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
+#include "Configuration.h"
+#include "Interrupt_Trace.h"
+#include "Profiler.h"
 #include "RTC.h"
+#include "Scheduler.h"
+#include "Status.h"
+#include "Timestamp.h"
 #include "UART.h"
 
 //--------------------------------------------------------------------------------------------------
 // Private constants
 //--------------------------------------------------------------------------------------------------
+/** The UART baud rate in bit/s. */
+#define UART_BAUD_RATE 19200
+/** The baud rate generator value in high baud rate mode, rounded to the nearest integer. */
+#define UART_BAUD_RATE_GENERATOR_VALUE (((CONFIGURATION_CLOCK_FREQUENCY + (8 * UART_BAUD_RATE)) / (16 * UART_BAUD_RATE)) - 1) // SPBRG = (Fosc / (16 * Baud_Rate)) - 1
+/** The baud rate really generated by the hardware. */
+#define UART_REAL_BAUD_RATE (CONFIGURATION_CLOCK_FREQUENCY / (16 * (UART_BAUD_RATE_GENERATOR_VALUE + 1)))
+
+// The receiver tolerates a 2% baud rate error
+#if (UART_BAUD_RATE_GENERATOR_VALUE > 255) || (UART_REAL_BAUD_RATE * 50 > UART_BAUD_RATE * 51) || (UART_REAL_BAUD_RATE * 50 < UART_BAUD_RATE * 49)
+	#error "The UART baud rate can't be generated with less than 2% error at this core frequency."
+#endif
+
 /** The UART protocol magic number. */
 #define UART_PROTOCOL_MAGIC_NUMBER 0xA5 // This value can't be represented in BCD format, so it can't be mistaken with data value
 
+/** Ask the clock to send the profiler statistics. */
+#define UART_PROTOCOL_COMMAND_GET_PROFILER_STATISTICS 0xB0 // Commands values can't be represented in BCD format too
+/** Ask the clock to send the interrupt trace. */
+#define UART_PROTOCOL_COMMAND_GET_INTERRUPT_TRACE 0xB1
+/** Select the alarm melody. The command is followed by the melody index. */
+#define UART_PROTOCOL_COMMAND_SET_RINGTONE 0xB2
+/** Start the bootloader to update the firmware. The command is acknowledged with the magic number. */
+#define UART_PROTOCOL_COMMAND_ENTER_BOOTLOADER 0xB3
+/** Set only the alarm. The command is followed by the alarm hour and minutes, and is acknowledged with the magic number once they are received. */
+#define UART_PROTOCOL_COMMAND_SET_ALARM 0xB4
+/** Set only the time. The command is followed by the seconds, minutes and hours, and is acknowledged with the magic number once they are received. */
+#define UART_PROTOCOL_COMMAND_SET_TIME 0xB5
+/** Set only the date. The command is followed by the day of week, day, month and year, and is acknowledged with the magic number once they are received. */
+#define UART_PROTOCOL_COMMAND_SET_DATE 0xB6
+/** Set any configuration fields. The command is followed by a field mask (UART_CONFIGURATION_FIELD_MASK_xxx values OR'ed), then by the selected fields in the full configuration frame order. It is acknowledged with the magic number once all fields are received. */
+#define UART_PROTOCOL_COMMAND_SET_FIELDS 0xB7
+/** Send the following command to a single clock of a shared line. The prefix is followed by the destination unit address, then by any other command. */
+#define UART_PROTOCOL_COMMAND_ADDRESSED_FRAME 0xB8
+/** Ask the clock its unit address, the answer is the address. */
+#define UART_PROTOCOL_COMMAND_GET_UNIT_ADDRESS 0xB9
+/** Set the clock unit address. The command is followed by the new address, and is acknowledged with the magic number. */
+#define UART_PROTOCOL_COMMAND_SET_UNIT_ADDRESS 0xBA
+/** Ask the clock its telemetry, the answer is the status snapshot published on the last tick (see TStatusFields for its content). */
+#define UART_PROTOCOL_COMMAND_GET_TELEMETRY 0xBB
+/** Set the RTC crystal frequency curve. The command is followed by the turnover temperature, the curvature, the offset most significant byte and the offset least significant byte, and is acknowledged with the magic number. */
+#define UART_PROTOCOL_COMMAND_SET_CRYSTAL_CURVE 0xBC
+
+/** The destination address of a frame that all clocks of the line must execute. Broadcast frames are never answered, so the clocks can't talk at the same time. */
+#define UART_PROTOCOL_BROADCAST_ADDRESS 0xFF
+
+/** All fields of a full configuration frame. */
+#define UART_CONFIGURATION_FIELD_MASK_ALL (UART_CONFIGURATION_FIELD_MASK_TIME | UART_CONFIGURATION_FIELD_MASK_DATE | UART_CONFIGURATION_FIELD_MASK_ALARM)
+/** The alarm hour index in the configuration fields, the date and time fields come first in the RTC registers order and the alarm minutes come last. */
+#define UART_CONFIGURATION_FIELD_INDEX_ALARM_HOUR 7
+/** How many fields a full configuration frame contains. */
+#define UART_CONFIGURATION_FIELDS_COUNT 9
+/** How many bytes follow the crystal curve command. */
+#define UART_CRYSTAL_CURVE_SIZE 4
+
+/** Tell whether the frame being received must be executed by this clock. */
+#define UART_IS_FRAME_EXECUTED() (UART_Frame_Destination != UART_FRAME_DESTINATION_OTHER_UNIT)
+/** Tell whether the frame being received must be answered by this clock, which is the case only when no other clock can answer it. */
+#define UART_IS_FRAME_ANSWERED() (UART_Frame_Destination == UART_FRAME_DESTINATION_THIS_UNIT)
+
+/** Answer the frame being received if it was sent to this clock alone, taking the line over. There is no need for a specific state to wait for the byte to be sent because the PC waits for the answer to send the next byte.
+ * @param Byte The byte to send.
+ */
+#define UART_SEND_ANSWER(Byte) \
+{ \
+	if (UART_IS_FRAME_ANSWERED()) \
+	{ \
+		txsta.TXEN = 1; \
+		txreg = Byte; \
+	} \
+}
+
 //--------------------------------------------------------------------------------------------------
 // Private types
 //--------------------------------------------------------------------------------------------------
@@ -19,17 +93,24 @@
 typedef enum
 {
 	UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER,
-	UART_PROTOCOL_STATE_RECEIVE_SECONDS,
-	UART_PROTOCOL_STATE_RECEIVE_MINUTES,
-	UART_PROTOCOL_STATE_RECEIVE_HOURS,
-	UART_PROTOCOL_STATE_RECEIVE_DAY_OF_WEEK,
-	UART_PROTOCOL_STATE_RECEIVE_DAY,
-	UART_PROTOCOL_STATE_RECEIVE_MONTH,
-	UART_PROTOCOL_STATE_RECEIVE_YEAR,
-	UART_PROTOCOL_STATE_RECEIVE_ALARM_HOUR,
-	UART_PROTOCOL_STATE_RECEIVE_ALARM_MINUTES
+	UART_PROTOCOL_STATE_RECEIVE_DESTINATION_ADDRESS,
+	UART_PROTOCOL_STATE_RECEIVE_COMMAND,
+	UART_PROTOCOL_STATE_RECEIVE_FIELD_MASK,
+	UART_PROTOCOL_STATE_SELECT_NEXT_FIELD,
+	UART_PROTOCOL_STATE_RECEIVE_FIELD,
+	UART_PROTOCOL_STATE_RECEIVE_RINGTONE,
+	UART_PROTOCOL_STATE_RECEIVE_UNIT_ADDRESS,
+	UART_PROTOCOL_STATE_RECEIVE_CRYSTAL_CURVE
 } TUARTProtocolState;
 
+/** Which clocks a frame is sent to. */
+typedef enum
+{
+	UART_FRAME_DESTINATION_THIS_UNIT, //!< The frame is addressed to this clock, or is unaddressed and this clock has no address, it is executed and answered.
+	UART_FRAME_DESTINATION_ALL_UNITS, //!< The frame is broadcast, it is executed but not answered.
+	UART_FRAME_DESTINATION_OTHER_UNIT //!< The frame is addressed to another clock, or is unaddressed and this clock has an address, it is received to stay synchronized with the protocol but it is ignored.
+} TUARTFrameDestination;
+
 //--------------------------------------------------------------------------------------------------
 // Private variables
 //--------------------------------------------------------------------------------------------------
@@ -40,8 +121,38 @@ static unsigned char UART_Configuration_Alarm_Hour;
 /** Keep the lastest received alarm minutes. */
 static unsigned char UART_Configuration_Alarm_Minutes;
 
-/** Tell whether new configuration data have been received. */
-static unsigned char UART_Are_Configuration_Data_Available = 0;
+/** Keep the lastest received ringtone. */
+static unsigned char UART_Configuration_Ringtone;
+
+/** Keep the lastest received crystal curve bytes, in the command order. */
+static unsigned char UART_Configuration_Crystal_Curve[UART_CRYSTAL_CURVE_SIZE];
+/** The crystal curve byte the next received byte will be stored to. */
+static unsigned char UART_Configuration_Crystal_Curve_Index;
+
+/** The configuration fields selected by the command being received. */
+static unsigned char UART_Configuration_Field_Mask;
+/** The configuration field the next received byte will be stored to. */
+static unsigned char UART_Configuration_Field_Index;
+/** All configuration fields received since the main loop last applied the configuration, 0 when there is nothing new to apply. */
+static unsigned char UART_Configuration_Received_Field_Mask = 0;
+
+/** The received requests that the main loop must serve (UART_REQUEST_xxx values OR'ed). */
+static unsigned char UART_Requests = 0;
+
+/** The next byte of the answer sent from the interrupt. */
+static unsigned char *UART_Pointer_Interrupt_Answer;
+/** How many bytes of the answer sent from the interrupt remain to be sent. */
+static unsigned char UART_Interrupt_Answer_Remaining_Size;
+
+/** How many UART overruns happened, saturated to 255. */
+static unsigned char UART_Overrun_Errors_Count = 0;
+/** How many bytes were received with a framing error, saturated to 255. */
+static unsigned char UART_Framing_Errors_Count = 0;
+
+/** The clock address on a shared line. */
+static unsigned char UART_Unit_Address = UART_UNIT_ADDRESS_NONE;
+/** Which clocks the frame being received is sent to. */
+static TUARTFrameDestination UART_Frame_Destination;
 
 //--------------------------------------------------------------------------------------------------
 // Public functions
@@ -51,9 +162,9 @@ void UARTInitialize(void)
 	// Configure UART pins as inputs
 	trisc.6 = 1;
 	trisc.7 = 1;
-
+	
 	// Configure the UART module
-	spbrg = 12; // 19200 bit/s baud rate
+	spbrg = UART_BAUD_RATE_GENERATOR_VALUE;
 	txsta = 0x26; // Select 8-bit transmission, enable transmission, use asynchronous mode, select high baud rate mode
 	rcsta = 0x90; // Enable the serial port module and the reception
 	
@@ -61,97 +172,325 @@ void UARTInitialize(void)
 	pie1.RCIE = 1;
 }
 
+void UARTWriteByte(unsigned char Byte)
+{
+	// Drive the line, the main loop only sends data requested by an answered frame
+	txsta.TXEN = 1;
+	
+	// Wait for the transmission register to be empty
+	while (!pir1.TXIF);
+	txreg = Byte;
+}
+
 void UARTInterruptHandler(void)
 {
 	static TUARTProtocolState UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
-
+	unsigned char Byte, Field_Bit;
+	TStatus *Pointer_Status;
+	signed short Request_Time;
+	
+	// Send the next byte of the answer being sent from the interrupt, the transmission interrupt is enabled only while such an answer is sent
+	if (pie1.TXIE && pir1.TXIF)
+	{
+		txreg = *UART_Pointer_Interrupt_Answer; // Writing the register clears the interrupt flag
+		UART_Pointer_Interrupt_Answer++;
+		UART_Interrupt_Answer_Remaining_Size--;
+		if (UART_Interrupt_Answer_Remaining_Size == 0) pie1.TXIE = 0;
+	}
+	if (!pir1.RCIF) return;
+	
+	// The reception stops on an overrun, restart it. The bytes still in the FIFO are received as usual, the protocol resynchronizes on the next frame
+	if (rcsta.OERR)
+	{
+		rcsta.CREN = 0;
+		rcsta.CREN = 1;
+		if (UART_Overrun_Errors_Count < 255) UART_Overrun_Errors_Count++;
+	}
+	
+	// A byte received with a framing error is corrupted, drop it and wait for the next frame
+	if (rcsta.FERR)
+	{
+		Byte = rcreg; // Reading the register clears the error
+		if (UART_Framing_Errors_Count < 255) UART_Framing_Errors_Count++;
+		UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+		return;
+	}
+	
 	switch (UART_Protocol_State)
 	{
-		// Wait for the PC to send the magic number
+		// Receive the destination of an addressed frame
+		case UART_PROTOCOL_STATE_RECEIVE_DESTINATION_ADDRESS:
+			Byte = rcreg;
+			if (Byte == UART_PROTOCOL_BROADCAST_ADDRESS) UART_Frame_Destination = UART_FRAME_DESTINATION_ALL_UNITS;
+			else if ((Byte == UART_Unit_Address) && (Byte != UART_UNIT_ADDRESS_NONE)) UART_Frame_Destination = UART_FRAME_DESTINATION_THIS_UNIT; // A clock without address only serves unaddressed and broadcast frames
+			else UART_Frame_Destination = UART_FRAME_DESTINATION_OTHER_UNIT;
+			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_COMMAND;
+			break;
+		
+		// Wait for the PC to send the magic number or a command
 		case UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER:
-			if (rcreg == UART_PROTOCOL_MAGIC_NUMBER)
+		case UART_PROTOCOL_STATE_RECEIVE_COMMAND:
+			Byte = rcreg; // Reading the register pops the byte from the reception FIFO, so read it only once
+			if (UART_Protocol_State == UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER)
 			{
-				// Send the acknowledge code
-				txreg = UART_PROTOCOL_MAGIC_NUMBER; // There is no need for a specific state to wait for the byte to be sent because the PC will wait for this answer to sent the next byte
-				
-				UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_SECONDS;
-			}
-			break;
+				// A new frame begins, so the previous answer has been received by the PC. Release the line for the other clocks if this one is on a shared line
+				if ((UART_Unit_Address != UART_UNIT_ADDRESS_NONE) && txsta.TRMT) txsta.TXEN = 0;
 			
-		// Receive seconds
-		case UART_PROTOCOL_STATE_RECEIVE_SECONDS:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Seconds = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MINUTES;
-			break;
-			
-		// Receive minutes
-		case UART_PROTOCOL_STATE_RECEIVE_MINUTES:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Minutes = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_HOURS;
-			break;
+				if (Byte == UART_PROTOCOL_COMMAND_ADDRESSED_FRAME)
+				{
+					UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_DESTINATION_ADDRESS;
+					break;
+				}
+				// Unaddressed frames are meant for a clock alone on its line, so a clock having an address ignores them instead of answering at the same time as another clock
+				if (UART_Unit_Address == UART_UNIT_ADDRESS_NONE) UART_Frame_Destination = UART_FRAME_DESTINATION_THIS_UNIT;
+				else UART_Frame_Destination = UART_FRAME_DESTINATION_OTHER_UNIT;
+			}
+			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+		
+			UART_Configuration_Field_Mask = 0;
+			if (Byte == UART_PROTOCOL_MAGIC_NUMBER)
+			{
+				// Send the acknowledge code
+				UART_SEND_ANSWER(UART_PROTOCOL_MAGIC_NUMBER);
 			
-		// Receive hours
-		case UART_PROTOCOL_STATE_RECEIVE_HOURS:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Hours = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_DAY_OF_WEEK;
-			break;
+				UART_Configuration_Field_Mask = UART_CONFIGURATION_FIELD_MASK_ALL; // A full configuration frame follows
+			}
+			// Partial updates do not touch the other fields, so an alarm change does not disturb the RTC time base
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_ALARM) UART_Configuration_Field_Mask = UART_CONFIGURATION_FIELD_MASK_ALARM;
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_TIME) UART_Configuration_Field_Mask = UART_CONFIGURATION_FIELD_MASK_TIME;
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_DATE) UART_Configuration_Field_Mask = UART_CONFIGURATION_FIELD_MASK_DATE;
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_FIELDS) UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_FIELD_MASK;
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_RINGTONE) UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_RINGTONE;
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_UNIT_ADDRESS) UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_UNIT_ADDRESS;
+			else if (Byte == UART_PROTOCOL_COMMAND_SET_CRYSTAL_CURVE)
+			{
+				UART_Configuration_Crystal_Curve_Index = 0;
+				UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_CRYSTAL_CURVE;
+			}
+			else if (Byte == UART_PROTOCOL_COMMAND_GET_UNIT_ADDRESS)
+			{
+				UART_SEND_ANSWER(UART_Unit_Address);
+			}
+			// The following requests send data or take the line over, so they are only served when this clock is the only one to answer
+			else if ((Byte == UART_PROTOCOL_COMMAND_ENTER_BOOTLOADER) && UART_IS_FRAME_ANSWERED())
+			{
+				UART_SEND_ANSWER(UART_PROTOCOL_MAGIC_NUMBER);
+				UART_Requests |= UART_REQUEST_ENTER_BOOTLOADER;
+				SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_REQUEST);
+			}
+			else if ((Byte == UART_PROTOCOL_COMMAND_GET_TELEMETRY) && UART_IS_FRAME_ANSWERED())
+			{
+				// Date the request relative to the second the snapshot reports, so the PC knows the clock time to the millisecond
+				Request_Time = TimestampGetTime();
+				Pointer_Status = StatusGetPublishedSnapshot();
+				Pointer_Status->Field_Name.Request_Time.High_Byte = Request_Time >> 8;
+				Pointer_Status->Field_Name.Request_Time.Low_Byte = (unsigned char) Request_Time;
 			
-		// Receive day of week
-		case UART_PROTOCOL_STATE_RECEIVE_DAY_OF_WEEK:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Day_Of_Week = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_DAY;
+				// Send the snapshot published by the main loop right now, the transmission interrupt fires as soon as the transmission register is empty
+				UART_Pointer_Interrupt_Answer = Pointer_Status->Array;
+				UART_Interrupt_Answer_Remaining_Size = sizeof(TStatus);
+				txsta.TXEN = 1;
+				pie1.TXIE = 1;
+			}
+			#if PROFILER_IS_ENABLED
+				else if ((Byte == UART_PROTOCOL_COMMAND_GET_PROFILER_STATISTICS) && UART_IS_FRAME_ANSWERED())
+				{
+					UART_Requests |= UART_REQUEST_SEND_PROFILER_STATISTICS; // Statistics are sent by the main loop as it takes too long to be done here
+					SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_REQUEST);
+				}
+			#endif
+			#if INTERRUPT_TRACE_IS_ENABLED
+				else if ((Byte == UART_PROTOCOL_COMMAND_GET_INTERRUPT_TRACE) && UART_IS_FRAME_ANSWERED())
+				{
+					UART_Requests |= UART_REQUEST_SEND_INTERRUPT_TRACE;
+					SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_REQUEST);
+				}
+			#endif
+		
+			// Receive the fields selected by a configuration command
+			if (UART_Configuration_Field_Mask != 0)
+			{
+				UART_Configuration_Field_Index = 0xFF; // The next field index will wrap to 0
+				UART_Protocol_State = UART_PROTOCOL_STATE_SELECT_NEXT_FIELD;
+			}
 			break;
-			
-		// Receive day
-		case UART_PROTOCOL_STATE_RECEIVE_DAY:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Day = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MONTH;
+		
+		// Receive the mask selecting the fields to update
+		case UART_PROTOCOL_STATE_RECEIVE_FIELD_MASK:
+			UART_Configuration_Field_Mask = rcreg;
+			UART_Configuration_Field_Index = 0xFF;
+			UART_Protocol_State = UART_PROTOCOL_STATE_SELECT_NEXT_FIELD; // An empty mask is immediately acknowledged
 			break;
 		
-		// Receive month
-		case UART_PROTOCOL_STATE_RECEIVE_MONTH:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Month = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_YEAR;
+		// Store a field value
+		case UART_PROTOCOL_STATE_RECEIVE_FIELD:
+			Byte = rcreg;
+			UART_Protocol_State = UART_PROTOCOL_STATE_SELECT_NEXT_FIELD;
+			if (!UART_IS_FRAME_EXECUTED()) break; // Do not overwrite the fields of a previous frame that the main loop has not applied yet
+		
+			if (UART_Configuration_Field_Index < sizeof(TRTCClockData)) UART_Configuration_RTC_Clock_Data.Array[UART_Configuration_Field_Index] = Byte;
+			else if (UART_Configuration_Field_Index == UART_CONFIGURATION_FIELD_INDEX_ALARM_HOUR) UART_Configuration_Alarm_Hour = Byte;
+			else UART_Configuration_Alarm_Minutes = Byte;
 			break;
-			
-		// Receive year
-		case UART_PROTOCOL_STATE_RECEIVE_YEAR:
-			UART_Configuration_RTC_Clock_Data.Register_Name.Year = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_ALARM_HOUR;
+		
+		// Receive the ringtone index
+		case UART_PROTOCOL_STATE_RECEIVE_RINGTONE:
+			Byte = rcreg;
+			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+			if (!UART_IS_FRAME_EXECUTED()) break;
+			UART_Configuration_Ringtone = Byte;
+		
+			// Let the main loop apply and save the ringtone
+			UART_Requests |= UART_REQUEST_SET_RINGTONE;
+			SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_REQUEST);
+		
+			// Tell the PC that the command was received
+			UART_SEND_ANSWER(UART_PROTOCOL_MAGIC_NUMBER);
 			break;
-			
-		// Receive alarm hour
-		case UART_PROTOCOL_STATE_RECEIVE_ALARM_HOUR:
-			UART_Configuration_Alarm_Hour = rcreg;
-			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_ALARM_MINUTES;
+		
+		// Receive the new unit address
+		case UART_PROTOCOL_STATE_RECEIVE_UNIT_ADDRESS:
+			Byte = rcreg;
+			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+			if (!UART_IS_FRAME_EXECUTED() || (Byte == UART_PROTOCOL_BROADCAST_ADDRESS)) break; // The broadcast address can't be a clock address, the command is not acknowledged
+		
+			// The new address is immediately used, so the PC can address the clock as soon as it is acknowledged. The main loop saves it
+			UART_Unit_Address = Byte;
+			UART_Requests |= UART_REQUEST_SET_UNIT_ADDRESS;
+			SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_REQUEST);
+		
+			UART_SEND_ANSWER(UART_PROTOCOL_MAGIC_NUMBER);
 			break;
-			
-		// Receive alarm minutes
-		case UART_PROTOCOL_STATE_RECEIVE_ALARM_MINUTES:
-			UART_Configuration_Alarm_Minutes = rcreg;
-			
-			// Send an acknowledge to the PC telling that everything was successfully received
-			txreg = UART_PROTOCOL_MAGIC_NUMBER;
-			
-			UART_Are_Configuration_Data_Available = 1;
-			
+		
+		// Receive the crystal curve bytes
+		case UART_PROTOCOL_STATE_RECEIVE_CRYSTAL_CURVE:
+			Byte = rcreg;
+			if (UART_IS_FRAME_EXECUTED()) UART_Configuration_Crystal_Curve[UART_Configuration_Crystal_Curve_Index] = Byte;
+			UART_Configuration_Crystal_Curve_Index++;
+			if (UART_Configuration_Crystal_Curve_Index < UART_CRYSTAL_CURVE_SIZE) break;
 			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+			if (!UART_IS_FRAME_EXECUTED()) break;
+		
+			// Let the main loop apply and save the curve
+			UART_Requests |= UART_REQUEST_SET_CRYSTAL_CURVE;
+			SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_REQUEST);
+		
+			UART_SEND_ANSWER(UART_PROTOCOL_MAGIC_NUMBER);
+			break;
+		
+		default:
 			break;
 	}
+	
+	// Find the next configuration field to receive, this is done in a single place for all configuration commands
+	if (UART_Protocol_State != UART_PROTOCOL_STATE_SELECT_NEXT_FIELD) return;
+	while (1)
+	{
+		UART_Configuration_Field_Index++;
+		if (UART_Configuration_Field_Index >= UART_CONFIGURATION_FIELDS_COUNT) break;
+		
+		// The alarm hour and minutes are selected by the same bit, the date and time field bits follow the fields order
+		if (UART_Configuration_Field_Index >= UART_CONFIGURATION_FIELD_INDEX_ALARM_HOUR) Field_Bit = UART_CONFIGURATION_FIELD_MASK_ALARM;
+		else Field_Bit = 1 << UART_Configuration_Field_Index;
+		if (UART_Configuration_Field_Mask & Field_Bit)
+		{
+			UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_FIELD;
+			return;
+		}
+	}
+	
+	// All selected fields have been received, let the main loop apply them
+	if ((UART_Configuration_Field_Mask != 0) && UART_IS_FRAME_EXECUTED())
+	{
+		UART_Configuration_Received_Field_Mask |= UART_Configuration_Field_Mask; // Keep the fields of a previous command that the main loop has not applied yet
+		TimestampCaptureEvent(TIMESTAMP_EVENT_UART_FRAME);
+		SchedulerPostEventsFromInterrupt(SCHEDULER_EVENT_UART_FRAME);
+	}
+	
+	// Send an acknowledge to the PC telling that everything was successfully received
+	UART_SEND_ANSWER(UART_PROTOCOL_MAGIC_NUMBER);
+	
+	UART_Protocol_State = UART_PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
 }
 
 unsigned char UARTAreConfigurationDataAvailable(TRTCClockData *Pointer_Clock_Data, unsigned char *Pointer_Alarm_Hour, unsigned char *Pointer_Alarm_Minutes)
 {
-	unsigned char i;
-
-	if (!UART_Are_Configuration_Data_Available) return 0;
+	unsigned char i, Field_Mask, Field_Bit = 1;
+	
+	// The interrupt handler can receive a new frame at any time, so the fields are copied and the mask is cleared at once
+	intcon.GIE = 0;
+	Field_Mask = UART_Configuration_Received_Field_Mask;
+	if (Field_Mask == 0)
+	{
+		intcon.GIE = 1;
+		return 0;
+	}
 	
-	// Fill configuration data
-	for (i = 0; i < sizeof(TRTCClockData); i++) Pointer_Clock_Data->Array[i] = UART_Configuration_RTC_Clock_Data.Array[i];
-	*Pointer_Alarm_Hour = UART_Configuration_Alarm_Hour;
-	*Pointer_Alarm_Minutes = UART_Configuration_Alarm_Minutes;
+	// Fill the received configuration data only
+	for (i = 0; i < sizeof(TRTCClockData); i++)
+	{
+		if (Field_Mask & Field_Bit) Pointer_Clock_Data->Array[i] = UART_Configuration_RTC_Clock_Data.Array[i];
+		Field_Bit <<= 1;
+	}
+	if (Field_Mask & UART_CONFIGURATION_FIELD_MASK_ALARM)
+	{
+		*Pointer_Alarm_Hour = UART_Configuration_Alarm_Hour;
+		*Pointer_Alarm_Minutes = UART_Configuration_Alarm_Minutes;
+	}
 	
 	// Configuration has been applied
-	UART_Are_Configuration_Data_Available = 0;
-	return 1;
+	UART_Configuration_Received_Field_Mask = 0;
+	intcon.GIE = 1;
+	
+	return Field_Mask;
+}
+
+unsigned char UARTGetRequests(void)
+{
+	unsigned char Requests;
+	
+	intcon.GIE = 0;
+	Requests = UART_Requests;
+	UART_Requests = 0;
+	intcon.GIE = 1;
+	
+	return Requests;
+}
+
+unsigned char UARTGetRingtone(void)
+{
+	return UART_Configuration_Ringtone;
+}
+
+void UARTGetCrystalCurve(TTimeCompensationCurve *Pointer_Curve)
+{
+	// Do not mix the bytes of two curves
+	intcon.GIE = 0;
+	Pointer_Curve->Turnover_Temperature = UART_Configuration_Crystal_Curve[0];
+	Pointer_Curve->Curvature = UART_Configuration_Crystal_Curve[1];
+	Pointer_Curve->Offset = ((signed short) UART_Configuration_Crystal_Curve[2] << 8) | UART_Configuration_Crystal_Curve[3];
+	intcon.GIE = 1;
+}
+
+void UARTSetUnitAddress(unsigned char Address)
+{
+	UART_Unit_Address = Address;
+	
+	// A clock on a shared line only drives it when it answers
+	if (Address != UART_UNIT_ADDRESS_NONE) txsta.TXEN = 0;
+}
+
+unsigned char UARTGetUnitAddress(void)
+{
+	return UART_Unit_Address;
+}
+
+unsigned char UARTGetOverrunErrorsCount(void)
+{
+	return UART_Overrun_Errors_Count;
+}
+
+unsigned char UARTGetFramingErrorsCount(void)
+{
+	return UART_Framing_Errors_Count;
 }
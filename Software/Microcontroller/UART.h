@@ -5,11 +5,36 @@
 #ifndef H_UART_H
 #define H_UART_H
 
+#include "Time_Compensation.h"
+
 //--------------------------------------------------------------------------------------------------
 // Constants
 //--------------------------------------------------------------------------------------------------
-/** Tell whether the UART reception interrupt fired or not. */
-#define UART_HAS_INTERRUPT_FIRED() pir1.RCIF
+/** Tell whether the UART reception interrupt or the transmission interrupt (enabled only while an answer is sent from the interrupt) fired or not. */
+#define UART_HAS_INTERRUPT_FIRED() (pir1.RCIF || (pie1.TXIE && pir1.TXIF))
+
+/** The seconds, minutes and hours configuration fields. The date and time fields bits follow the RTC registers order. */
+#define UART_CONFIGURATION_FIELD_MASK_TIME 0x07
+/** The day of week, day, month and year configuration fields. */
+#define UART_CONFIGURATION_FIELD_MASK_DATE 0x78
+/** The alarm hour and minutes configuration fields. */
+#define UART_CONFIGURATION_FIELD_MASK_ALARM 0x80
+
+/** The unit address of a clock that is alone on its line. Such a clock only serves unaddressed and broadcast frames, and always drives the line. A clock having an address ignores the unaddressed frames. */
+#define UART_UNIT_ADDRESS_NONE 0
+
+/** The profiler statistics must be sent. */
+#define UART_REQUEST_SEND_PROFILER_STATISTICS 0x01
+/** The interrupt trace must be sent. */
+#define UART_REQUEST_SEND_INTERRUPT_TRACE 0x02
+/** A new ringtone must be applied, get it with UARTGetRingtone(). */
+#define UART_REQUEST_SET_RINGTONE 0x04
+/** The bootloader must be started. */
+#define UART_REQUEST_ENTER_BOOTLOADER 0x08
+/** A new unit address is used, get it with UARTGetUnitAddress() to save it. */
+#define UART_REQUEST_SET_UNIT_ADDRESS 0x10
+/** A new crystal curve must be applied, get it with UARTGetCrystalCurve(). */
+#define UART_REQUEST_SET_CRYSTAL_CURVE 0x20
 
 //--------------------------------------------------------------------------------------------------
 // Functions
@@ -33,18 +58,55 @@ void UARTWriteByte(unsigned char Byte);
  */
 unsigned char UARTIsByteReceived(void);
 
-/** Handle the configuration protocol. */
+/** Handle the configuration protocol. The SCHEDULER_EVENT_UART_FRAME event is posted when a whole configuration frame has been received, the SCHEDULER_EVENT_UART_REQUEST event is posted when a request must be served by the main loop. The telemetry is answered from the interrupt with the published status snapshot, so its latency does not depend on the main loop load.
+ * Several clocks can share the same line : the PC transmission reaches all clocks, and the clocks transmissions are merged on the PC reception. A frame prefixed by an address is only executed by the clock having this address, a frame sent to the broadcast address is executed by all clocks, and a frame without address is only executed by the clocks having no address. Only the clock a frame is addressed to answers it, so two clocks never talk at the same time, and a clock having an address releases the line when it is not answering.
+ */
 void UARTInterruptHandler(void);
 
 /** Tell whether new configuration data have been received through the UART.
- * @param Pointer_Clock_Data On output, filled with new clock date and time values.
- * @param Pointer_Alarm_Hour On output, filled with new alarm hour value.
- * @param Pointer_Alarm_Minutes On output, filled with new alarm minutes value.
+ * @param Pointer_Clock_Data On output, the received clock date and time fields are updated.
+ * @param Pointer_Alarm_Hour On output, filled with new alarm hour value if it was received.
+ * @param Pointer_Alarm_Minutes On output, filled with new alarm minutes value if it was received.
  * @note This function must be called when the provided variables are not accessed.
- * @note All provided variables are modified ONLY if new data are available, they are left unmodified if there is no new configuration to apply. This way you can safely call the function with the target variables (no need for temporary ones).
+ * @note Only the received fields are modified, the others are left unmodified. This way you can safely call the function with the target variables (no need for temporary ones).
  * @return 0 if no new configuration data were received,
- * @return 1 when new configuration data are available and have been copied to the provided variables.
+ * @return the received fields mask (UART_CONFIGURATION_FIELD_MASK_xxx bits) when new configuration data are available and have been copied to the provided variables.
  */
 unsigned char UARTAreConfigurationDataAvailable(TRTCClockData *Pointer_Clock_Data, unsigned char *Pointer_Alarm_Hour, unsigned char *Pointer_Alarm_Minutes);
 
+/** Get the requests received from the UART since the last call and clear them.
+ * @return The UART_REQUEST_xxx values OR'ed, 0 if there is nothing to do.
+ */
+unsigned char UARTGetRequests(void);
+
+/** Get the last received ringtone.
+ * @return The ringtone index (it has not been checked).
+ */
+unsigned char UARTGetRingtone(void);
+
+/** Get the last received crystal curve.
+ * @param Pointer_Curve On output, contain the curve (it has not been checked).
+ */
+void UARTGetCrystalCurve(TTimeCompensationCurve *Pointer_Curve);
+
+/** Set the address the clock answers to on a shared line.
+ * @param Address The unit address, use UART_UNIT_ADDRESS_NONE for a clock alone on its line. The broadcast address 0xFF is not allowed.
+ */
+void UARTSetUnitAddress(unsigned char Address);
+
+/** Get the clock unit address.
+ * @return The unit address, UART_UNIT_ADDRESS_NONE if the clock has no address.
+ */
+unsigned char UARTGetUnitAddress(void);
+
+/** Get how many UART overruns happened since the clock started.
+ * @return The overruns count, saturated to 255.
+ */
+unsigned char UARTGetOverrunErrorsCount(void);
+
+/** Get how many bytes were received with a framing error since the clock started.
+ * @return The framing errors count, saturated to 255.
+ */
+unsigned char UARTGetFramingErrorsCount(void);
+
 #endif
@@ -0,0 +1,525 @@
+/** @file Clock_Bench.c
+ * Measure the exchanges with a real clock end to end : round-trip latency, throughput, errors and the time offset really achieved when the time is set. Run it with the same clock through different serial adapters or with different firmware builds to compare them.
+ * The clock can be reached through a serial port or a daemon socket, like with the Clock program.
+ * @author Adrien RICCIARDI
+ */
+#include "Daemon.h"
+#include "Protocol.h"
+#include <Serial_Port.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How long to wait for each answer byte before the attempt is considered failed, in milliseconds. */
+#define CLOCK_BENCH_ANSWER_TIMEOUT 200
+/** How many times a failed exchange is attempted again before it is counted as a failure. */
+#define CLOCK_BENCH_MAXIMUM_RETRIES_COUNT 3
+/** How long the clock must stay silent after a failed attempt, so a late answer is not taken for the next one, in milliseconds. */
+#define CLOCK_BENCH_RESYNCHRONIZATION_DELAY 50
+
+/** How many times the time-set offset is measured. */
+#define CLOCK_BENCH_TIME_SET_MEASURES_COUNT 5
+/** How long to wait for the clock to publish its status after the time is set, in milliseconds. */
+#define CLOCK_BENCH_PUBLICATION_TIMEOUT 3000
+
+/** Give the line back to the daemon after owning it for this long, in milliseconds, so the daemon does not consider the program stuck. */
+#define CLOCK_BENCH_LINE_OWNERSHIP_DURATION 30000
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** All benchmarked exchanges. */
+typedef enum
+{
+	CLOCK_BENCH_EXCHANGE_GET_UNIT_ADDRESS, //!< The shortest exchange : a command byte and a single answer byte.
+	CLOCK_BENCH_EXCHANGE_GET_TELEMETRY, //!< A command byte and a multiple-byte answer.
+	CLOCK_BENCH_EXCHANGE_SET_TIME, //!< A configuration frame and its acknowledge, the main loop applies the configuration right after. The time-set offset measures are accounted here too.
+	CLOCK_BENCH_EXCHANGE_TIME_SET_POLL, //!< A telemetry query done while measuring the time-set offset, accounted apart as the queries are sent back to back for a varying duration.
+	CLOCK_BENCH_EXCHANGES_COUNT
+} TClockBenchExchange;
+
+/** The results of an exchange type. */
+typedef struct
+{
+	char *String_Name; //!< The exchange name in the results.
+	int Successes_Count; //!< How many exchanges eventually succeeded.
+	int Failures_Count; //!< How many exchanges failed after all retries.
+	int Errors_Count; //!< How many attempts failed (timeout or bad answer).
+	int Retries_Count; //!< How many attempts were made again.
+	long long Bytes_Count; //!< How many bytes were sent and received by the successful attempts.
+	double Duration; //!< The cumulated duration of the successful attempts, in seconds.
+	double *Pointer_Latencies; //!< The round-trip latency of each successful exchange, in milliseconds.
+	int Latencies_Capacity; //!< How many latencies the buffer can hold.
+} TClockBenchResult;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The serial port identifier. */
+static TSerialPortID Clock_Bench_Serial_Port_ID;
+/** The daemon socket, NULL when the serial port is directly opened. */
+static char *Clock_Bench_String_Socket_Path = NULL;
+/** When the line was last acquired from the daemon, in milliseconds. */
+static double Clock_Bench_Line_Acquisition_Time;
+
+/** The address of the benchmarked clock, or PROTOCOL_NO_UNIT_ADDRESS when the clock is alone on its line. */
+static int Clock_Bench_Unit_Address = PROTOCOL_NO_UNIT_ADDRESS;
+
+/** The results of each exchange type. */
+static TClockBenchResult Clock_Bench_Results[CLOCK_BENCH_EXCHANGES_COUNT] =
+{
+	{"get_unit_address", 0, 0, 0, 0, 0, 0, NULL, 0},
+	{"get_telemetry", 0, 0, 0, 0, 0, 0, NULL, 0},
+	{"set_time", 0, 0, 0, 0, 0, 0, NULL, 0},
+	{"time_set_poll", 0, 0, 0, 0, 0, 0, NULL, 0}
+};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the monotonic time in milliseconds.
+ * @return The time.
+ */
+static double ClockBenchGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (Time.tv_sec * 1000.0) + (Time.tv_nsec / 1e6);
+}
+
+/** Get the computer wall clock time in milliseconds.
+ * @return The time since the Unix epoch.
+ */
+static double ClockBenchGetWallClockTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_REALTIME, &Time);
+	return (Time.tv_sec * 1000.0) + (Time.tv_nsec / 1e6);
+}
+
+/** Close the serial port or the daemon connection on program termination. */
+static void ClockBenchExitClose(void)
+{
+	if (Clock_Bench_String_Socket_Path != NULL) DaemonDisconnect();
+	else SerialPortClose(Clock_Bench_Serial_Port_ID);
+}
+
+/** Open the serial port, or connect to the daemon serving it. The program exits on failure.
+ * @param String_Serial_Port The serial port device or the daemon socket.
+ */
+static void ClockBenchOpenSerialPort(char *String_Serial_Port)
+{
+	if (DaemonIsSocket(String_Serial_Port))
+	{
+		if (DaemonConnect(String_Serial_Port, 0) != 0) exit(EXIT_FAILURE);
+		Clock_Bench_String_Socket_Path = String_Serial_Port;
+		Clock_Bench_Line_Acquisition_Time = ClockBenchGetTime();
+	}
+	else if (SerialPortOpen(String_Serial_Port, 19200, &Clock_Bench_Serial_Port_ID) != 0)
+	{
+		printf("Error : failed to open the serial port '%s'.\n", String_Serial_Port);
+		exit(EXIT_FAILURE);
+	}
+	atexit(ClockBenchExitClose);
+}
+
+/** Give the line back to the other daemon clients from time to time. This must be called between two exchanges, so the time taken by the other clients is not measured. */
+static void ClockBenchShareLine(void)
+{
+	if ((Clock_Bench_String_Socket_Path == NULL) || (ClockBenchGetTime() - Clock_Bench_Line_Acquisition_Time < CLOCK_BENCH_LINE_OWNERSHIP_DURATION)) return;
+	
+	DaemonDisconnect();
+	if (DaemonConnect(Clock_Bench_String_Socket_Path, 0) != 0) exit(EXIT_FAILURE);
+	Clock_Bench_Line_Acquisition_Time = ClockBenchGetTime();
+}
+
+/** Send bytes to the clock.
+ * @param Pointer_Buffer The bytes.
+ * @param Size How many bytes to send.
+ */
+static void ClockBenchTransmit(unsigned char *Pointer_Buffer, int Size)
+{
+	int i;
+	
+	for (i = 0; i < Size; i++)
+	{
+		if (Clock_Bench_String_Socket_Path != NULL) DaemonWriteByte(Pointer_Buffer[i]);
+		else SerialPortWriteByte(Clock_Bench_Serial_Port_ID, Pointer_Buffer[i]);
+	}
+}
+
+/** Tell if a byte has been received from the clock or not.
+ * @return 1 if a byte is available to read,
+ * @return 0 if no byte was received.
+ */
+static int ClockBenchIsByteAvailable(void)
+{
+	if (Clock_Bench_String_Socket_Path != NULL) return DaemonIsByteAvailable();
+	return SerialPortIsByteAvailable(Clock_Bench_Serial_Port_ID);
+}
+
+/** Receive bytes from the clock. The serial port is polled without sleeping, so the measured latency does not depend on the scheduler.
+ * @param Pointer_Buffer On output, contain the received bytes.
+ * @param Size How many bytes to receive.
+ * @return 0 if all bytes were received,
+ * @return -1 if the clock stopped answering.
+ */
+static int ClockBenchReceive(unsigned char *Pointer_Buffer, int Size)
+{
+	int i;
+	double Deadline;
+	
+	for (i = 0; i < Size; i++)
+	{
+		Deadline = ClockBenchGetTime() + CLOCK_BENCH_ANSWER_TIMEOUT;
+		while (!ClockBenchIsByteAvailable())
+		{
+			if (ClockBenchGetTime() >= Deadline) return -1;
+		}
+		
+		if (Clock_Bench_String_Socket_Path != NULL) Pointer_Buffer[i] = DaemonReadByte();
+		else Pointer_Buffer[i] = SerialPortReadByte(Clock_Bench_Serial_Port_ID);
+	}
+	return 0;
+}
+
+/** Wait for the clock to stay silent, dropping the bytes of a late answer. */
+static void ClockBenchResynchronize(void)
+{
+	double Deadline;
+	unsigned char Byte;
+	
+	Deadline = ClockBenchGetTime() + CLOCK_BENCH_RESYNCHRONIZATION_DELAY;
+	while (ClockBenchGetTime() < Deadline)
+	{
+		if (ClockBenchIsByteAvailable())
+		{
+			ClockBenchReceive(&Byte, 1);
+			Deadline = ClockBenchGetTime() + CLOCK_BENCH_RESYNCHRONIZATION_DELAY;
+		}
+		else usleep(1000);
+	}
+}
+
+/** Fill the configuration with the computer local time.
+ * @param Wall_Clock_Time The time to convert, in milliseconds since the Unix epoch.
+ * @param Pointer_Configuration On output, contain the date and time fields.
+ */
+static void ClockBenchGetConfiguration(double Wall_Clock_Time, TProtocolConfiguration *Pointer_Configuration)
+{
+	time_t Seconds;
+	struct tm *Pointer_Time;
+	
+	Seconds = (time_t) (Wall_Clock_Time / 1000);
+	Pointer_Time = localtime(&Seconds);
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_SECONDS] = Pointer_Time->tm_sec;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_MINUTES] = Pointer_Time->tm_min;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_HOURS] = Pointer_Time->tm_hour;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_DAY_OF_WEEK] = Pointer_Time->tm_wday + 1;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_DAY] = Pointer_Time->tm_mday;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_MONTH] = Pointer_Time->tm_mon + 1;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_YEAR] = Pointer_Time->tm_year + 1900;
+}
+
+/** Convert the date and time reported by the clock to a computer time.
+ * @param Pointer_Configuration The clock date and time fields, they are the computer local time.
+ * @return The time in seconds since the Unix epoch.
+ */
+static time_t ClockBenchConvertClockTime(TProtocolConfiguration *Pointer_Configuration)
+{
+	struct tm Time;
+	
+	memset(&Time, 0, sizeof(Time));
+	Time.tm_sec = Pointer_Configuration->Fields[PROTOCOL_FIELD_SECONDS];
+	Time.tm_min = Pointer_Configuration->Fields[PROTOCOL_FIELD_MINUTES];
+	Time.tm_hour = Pointer_Configuration->Fields[PROTOCOL_FIELD_HOURS];
+	Time.tm_mday = Pointer_Configuration->Fields[PROTOCOL_FIELD_DAY];
+	Time.tm_mon = Pointer_Configuration->Fields[PROTOCOL_FIELD_MONTH] - 1;
+	Time.tm_year = Pointer_Configuration->Fields[PROTOCOL_FIELD_YEAR] - 1900;
+	Time.tm_isdst = -1;
+	return mktime(&Time);
+}
+
+/** Do an exchange with the clock, attempting it again when it fails, and account it in the results.
+ * @param Exchange The exchange to do.
+ * @param Pointer_Telemetry On output, contain the clock telemetry for a telemetry exchange. It can be NULL.
+ * @return 0 if the exchange succeeded,
+ * @return -1 if it failed after all retries.
+ */
+static int ClockBenchDoExchange(TClockBenchExchange Exchange, TProtocolTelemetry *Pointer_Telemetry)
+{
+	TClockBenchResult *Pointer_Result = &Clock_Bench_Results[Exchange];
+	unsigned char Frame[PROTOCOL_MAXIMUM_FRAME_SIZE], Answer[PROTOCOL_TELEMETRY_SIZE];
+	int Frame_Size, Answer_Size, Attempt, Is_Answer_Valid;
+	TProtocolConfiguration Configuration;
+	TProtocolTelemetry Telemetry;
+	double Start_Time, Latency;
+	
+	for (Attempt = 0; Attempt <= CLOCK_BENCH_MAXIMUM_RETRIES_COUNT; Attempt++)
+	{
+		if (Attempt > 0)
+		{
+			Pointer_Result->Retries_Count++;
+			ClockBenchResynchronize();
+		}
+		ClockBenchShareLine();
+		
+		// Build the frame right before sending it, so the time to set is accurate
+		switch (Exchange)
+		{
+			case CLOCK_BENCH_EXCHANGE_GET_UNIT_ADDRESS:
+				Frame_Size = ProtocolEncodeCommand(Clock_Bench_Unit_Address, PROTOCOL_COMMAND_GET_UNIT_ADDRESS, Frame, sizeof(Frame));
+				Answer_Size = 1;
+				break;
+			
+			case CLOCK_BENCH_EXCHANGE_GET_TELEMETRY:
+			case CLOCK_BENCH_EXCHANGE_TIME_SET_POLL:
+				Frame_Size = ProtocolEncodeCommand(Clock_Bench_Unit_Address, PROTOCOL_COMMAND_GET_TELEMETRY, Frame, sizeof(Frame));
+				Answer_Size = PROTOCOL_TELEMETRY_SIZE;
+				break;
+			
+			case CLOCK_BENCH_EXCHANGE_SET_TIME:
+				ClockBenchGetConfiguration(ClockBenchGetWallClockTime(), &Configuration);
+				Frame_Size = ProtocolEncodeConfigurationFrame(Clock_Bench_Unit_Address, PROTOCOL_COMMAND_SET_TIME, 0, &Configuration, Frame, sizeof(Frame));
+				Answer_Size = 1;
+				break;
+			
+			default:
+				return -1;
+		}
+		if (Frame_Size < 0)
+		{
+			printf("Error : failed to encode the frame.\n");
+			exit(EXIT_FAILURE);
+		}
+		
+		// Measure from the first byte sent to the last byte received
+		Start_Time = ClockBenchGetTime();
+		ClockBenchTransmit(Frame, Frame_Size);
+		if (ClockBenchReceive(Answer, Answer_Size) != 0)
+		{
+			Pointer_Result->Errors_Count++;
+			continue;
+		}
+		Latency = ClockBenchGetTime() - Start_Time;
+		
+		// Check the answer
+		if (Exchange == CLOCK_BENCH_EXCHANGE_GET_UNIT_ADDRESS) Is_Answer_Valid = (Clock_Bench_Unit_Address == PROTOCOL_NO_UNIT_ADDRESS) || (Answer[0] == Clock_Bench_Unit_Address);
+		else if (Exchange != CLOCK_BENCH_EXCHANGE_SET_TIME) Is_Answer_Valid = ProtocolDecodeTelemetry(Answer, Answer_Size, &Telemetry) == PROTOCOL_TELEMETRY_SIZE;
+		else Is_Answer_Valid = Answer[0] == PROTOCOL_MAGIC_NUMBER;
+		if (!Is_Answer_Valid)
+		{
+			Pointer_Result->Errors_Count++;
+			continue;
+		}
+		
+		// The offset measures do an unknown amount of exchanges, so the latencies buffer grows as needed
+		if (Pointer_Result->Successes_Count >= Pointer_Result->Latencies_Capacity)
+		{
+			Pointer_Result->Latencies_Capacity = (Pointer_Result->Latencies_Capacity * 2) + 1024;
+			Pointer_Result->Pointer_Latencies = realloc(Pointer_Result->Pointer_Latencies, Pointer_Result->Latencies_Capacity * sizeof(double));
+			if (Pointer_Result->Pointer_Latencies == NULL)
+			{
+				printf("Error : not enough memory.\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		Pointer_Result->Pointer_Latencies[Pointer_Result->Successes_Count] = Latency;
+		Pointer_Result->Successes_Count++;
+		Pointer_Result->Bytes_Count += Frame_Size + Answer_Size;
+		Pointer_Result->Duration += Latency / 1000;
+		if ((Exchange != CLOCK_BENCH_EXCHANGE_SET_TIME) && (Pointer_Telemetry != NULL)) *Pointer_Telemetry = Telemetry;
+		return 0;
+	}
+	
+	Pointer_Result->Failures_Count++;
+	return -1;
+}
+
+/** Set the clock time, then ask the clock when it received a telemetry request to compute how far the clock time is from the computer one. The clock dates the request to the millisecond, relative to the second reported in the same answer.
+ * @param Pointer_Offset On output, contain the clock time minus the computer time, in milliseconds.
+ * @param Pointer_Resolution On output, contain the measure uncertainty, in milliseconds.
+ * @return 0 if the offset was measured,
+ * @return -1 if the clock did not answer.
+ */
+static int ClockBenchMeasureTimeSetOffset(double *Pointer_Offset, double *Pointer_Resolution)
+{
+	TProtocolTelemetry Telemetry;
+	int First_Sequence_Number = -1;
+	double Deadline, Request_Time, Answer_Time;
+	
+	if (ClockBenchDoExchange(CLOCK_BENCH_EXCHANGE_SET_TIME, NULL) != 0) return -1;
+	
+	// The status answered right after the time is set can have been published before, so wait for the next publication
+	Deadline = ClockBenchGetTime() + CLOCK_BENCH_PUBLICATION_TIMEOUT;
+	while (ClockBenchGetTime() < Deadline)
+	{
+		Request_Time = ClockBenchGetWallClockTime();
+		if (ClockBenchDoExchange(CLOCK_BENCH_EXCHANGE_TIME_SET_POLL, &Telemetry) != 0) return -1;
+		Answer_Time = ClockBenchGetWallClockTime();
+		
+		if (First_Sequence_Number == -1) First_Sequence_Number = Telemetry.Sequence_Number;
+		else if ((Telemetry.Sequence_Number != First_Sequence_Number) && (Telemetry.Request_Timestamp != PROTOCOL_NO_TIMESTAMP))
+		{
+			// The clock received the request somewhere between the request beginning and the answer end
+			*Pointer_Offset = (ClockBenchConvertClockTime(&Telemetry.Clock) * 1000.0) + Telemetry.Request_Timestamp - ((Request_Time + Answer_Time) / 2);
+			*Pointer_Resolution = (Answer_Time - Request_Time) / 2;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/** Compare two latencies for qsort().
+ * @param Pointer_A The first latency.
+ * @param Pointer_B The second latency.
+ * @return A negative value if the first latency is smaller, a positive value if it is bigger, 0 if they are equal.
+ */
+static int ClockBenchCompareLatencies(const void *Pointer_A, const void *Pointer_B)
+{
+	double A = *(const double *) Pointer_A, B = *(const double *) Pointer_B;
+	
+	if (A < B) return -1;
+	if (A > B) return 1;
+	return 0;
+}
+
+/** Get a latency percentile using the nearest-rank method. The latencies must be sorted.
+ * @param Pointer_Result The exchange results, with at least one success.
+ * @param Percentile The percentile in range ]0;100].
+ * @return The latency in milliseconds.
+ */
+static double ClockBenchGetPercentile(TClockBenchResult *Pointer_Result, int Percentile)
+{
+	int Rank;
+	
+	Rank = ((Pointer_Result->Successes_Count * Percentile) + 99) / 100;
+	if (Rank < 1) Rank = 1;
+	return Pointer_Result->Pointer_Latencies[Rank - 1];
+}
+
+/** Display the results in a human-readable table.
+ * @param Pointer_Offsets The time-set offsets.
+ * @param Pointer_Resolutions The offsets uncertainties.
+ * @param Offsets_Count How many offsets were measured.
+ */
+static void ClockBenchDisplayResults(double *Pointer_Offsets, double *Pointer_Resolutions, int Offsets_Count)
+{
+	TClockBenchResult *Pointer_Result;
+	int i;
+	
+	printf("%-17s %9s %8s %7s %7s %8s %8s %8s %8s %8s %8s\n", "Exchange", "Successes", "Failures", "Errors", "Retries", "Min (ms)", "P50", "P90", "P99", "Max", "Bytes/s");
+	for (i = 0; i < CLOCK_BENCH_EXCHANGES_COUNT; i++)
+	{
+		Pointer_Result = &Clock_Bench_Results[i];
+		printf("%-17s %9d %8d %7d %7d ", Pointer_Result->String_Name, Pointer_Result->Successes_Count, Pointer_Result->Failures_Count, Pointer_Result->Errors_Count, Pointer_Result->Retries_Count);
+		if (Pointer_Result->Successes_Count == 0) printf("%8s %8s %8s %8s %8s %8s\n", "-", "-", "-", "-", "-", "-");
+		else printf("%8.2f %8.2f %8.2f %8.2f %8.2f %8.0f\n", Pointer_Result->Pointer_Latencies[0], ClockBenchGetPercentile(Pointer_Result, 50), ClockBenchGetPercentile(Pointer_Result, 90), ClockBenchGetPercentile(Pointer_Result, 99),
+			Pointer_Result->Pointer_Latencies[Pointer_Result->Successes_Count - 1], Pointer_Result->Bytes_Count / Pointer_Result->Duration);
+	}
+	
+	printf("Time-set offset (clock minus computer) :");
+	if (Offsets_Count == 0) printf(" not measured");
+	for (i = 0; i < Offsets_Count; i++) printf(" %+.0f ms (+/- %.0f)", Pointer_Offsets[i], Pointer_Resolutions[i]);
+	putchar('\n');
+}
+
+/** Display the results as a JSON object.
+ * @param String_Serial_Port The serial port or daemon socket the clock was reached through.
+ * @param Exchanges_Count How many exchanges of each type were requested.
+ * @param Pointer_Offsets The time-set offsets.
+ * @param Pointer_Resolutions The offsets uncertainties.
+ * @param Offsets_Count How many offsets were measured.
+ */
+static void ClockBenchDisplayJSONResults(char *String_Serial_Port, int Exchanges_Count, double *Pointer_Offsets, double *Pointer_Resolutions, int Offsets_Count)
+{
+	TClockBenchResult *Pointer_Result;
+	int i;
+	
+	printf("{\n  \"serial_port\": \"%s\",\n  \"through_daemon\": %s,\n  \"unit_address\": %d,\n  \"exchanges_count\": %d,\n  \"exchanges\": [\n", String_Serial_Port, (Clock_Bench_String_Socket_Path != NULL) ? "true" : "false", Clock_Bench_Unit_Address,
+		Exchanges_Count);
+	for (i = 0; i < CLOCK_BENCH_EXCHANGES_COUNT; i++)
+	{
+		Pointer_Result = &Clock_Bench_Results[i];
+		printf("    {\"name\": \"%s\", \"successes\": %d, \"failures\": %d, \"errors\": %d, \"retries\": %d", Pointer_Result->String_Name, Pointer_Result->Successes_Count, Pointer_Result->Failures_Count, Pointer_Result->Errors_Count,
+			Pointer_Result->Retries_Count);
+		if (Pointer_Result->Successes_Count > 0) printf(", \"latency_ms\": {\"minimum\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"maximum\": %.3f}, \"bytes_per_second\": %.1f", Pointer_Result->Pointer_Latencies[0],
+			ClockBenchGetPercentile(Pointer_Result, 50), ClockBenchGetPercentile(Pointer_Result, 90), ClockBenchGetPercentile(Pointer_Result, 99), Pointer_Result->Pointer_Latencies[Pointer_Result->Successes_Count - 1],
+			Pointer_Result->Bytes_Count / Pointer_Result->Duration);
+		printf("}%s\n", (i < CLOCK_BENCH_EXCHANGES_COUNT - 1) ? "," : "");
+	}
+	
+	printf("  ],\n  \"time_set_offsets\": [");
+	for (i = 0; i < Offsets_Count; i++) printf("%s{\"offset_ms\": %.1f, \"resolution_ms\": %.1f}", (i > 0) ? ", " : "", Pointer_Offsets[i], Pointer_Resolutions[i]);
+	printf("]\n}\n");
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	char *String_Serial_Port;
+	int Exchanges_Count, Is_JSON_Output = 0, Offsets_Count = 0, Exchange, i;
+	double Offsets[CLOCK_BENCH_TIME_SET_MEASURES_COUNT], Resolutions[CLOCK_BENCH_TIME_SET_MEASURES_COUNT];
+	
+	// Check parameters
+	if ((argc >= 5) && (strcmp(argv[2], "unit") == 0))
+	{
+		if ((sscanf(argv[3], "%d", &Clock_Bench_Unit_Address) != 1) || (Clock_Bench_Unit_Address < 1) || (Clock_Bench_Unit_Address > PROTOCOL_MAXIMUM_UNIT_ADDRESS))
+		{
+			printf("Error : the unit address must be in range [1;%d].\n", PROTOCOL_MAXIMUM_UNIT_ADDRESS);
+			return EXIT_FAILURE;
+		}
+		argv[3] = argv[1];
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+	if ((argc == 4) && (strcmp(argv[3], "json") == 0))
+	{
+		Is_JSON_Output = 1;
+		argc--;
+	}
+	if ((argc != 3) || (sscanf(argv[2], "%d", &Exchanges_Count) != 1) || (Exchanges_Count < 1))
+	{
+		printf("Usage : %s Serial_Port [unit Unit_Address] Exchanges_Count [json]\n"
+			"Do Exchanges_Count exchanges of each type with the clock (unit address query, telemetry query and time setting), then measure %d times the offset between the clock and the computer time right after the time is set.\n"
+			"The results are displayed as a table, or as a JSON object when 'json' is provided.\n", argv[0], CLOCK_BENCH_TIME_SET_MEASURES_COUNT);
+		return EXIT_FAILURE;
+	}
+	String_Serial_Port = argv[1];
+	
+	ClockBenchOpenSerialPort(String_Serial_Port);
+	ClockBenchResynchronize();
+	
+	// Benchmark each exchange type in turn
+	for (Exchange = 0; Exchange < CLOCK_BENCH_EXCHANGE_TIME_SET_POLL; Exchange++)
+	{
+		for (i = 0; i < Exchanges_Count; i++) ClockBenchDoExchange(Exchange, NULL);
+	}
+	
+	// The offset measures are the last ones, so the clock is left with the most accurate time
+	for (i = 0; i < CLOCK_BENCH_TIME_SET_MEASURES_COUNT; i++)
+	{
+		if (ClockBenchMeasureTimeSetOffset(&Offsets[Offsets_Count], &Resolutions[Offsets_Count]) == 0) Offsets_Count++;
+	}
+	
+	for (i = 0; i < CLOCK_BENCH_EXCHANGES_COUNT; i++) qsort(Clock_Bench_Results[i].Pointer_Latencies, Clock_Bench_Results[i].Successes_Count, sizeof(double), ClockBenchCompareLatencies);
+	if (Is_JSON_Output) ClockBenchDisplayJSONResults(String_Serial_Port, Exchanges_Count, Offsets, Resolutions, Offsets_Count);
+	else ClockBenchDisplayResults(Offsets, Resolutions, Offsets_Count);
+	
+	// Tell a script that the clock did not always answer
+	for (i = 0; i < CLOCK_BENCH_EXCHANGES_COUNT; i++)
+	{
+		if (Clock_Bench_Results[i].Failures_Count > 0) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,755 @@
+/** @file Daemon.c
+ * @see Daemon.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "Daemon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <Serial_Port.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Client request : queue for the line ownership, the daemon answers with DAEMON_MESSAGE_TYPE_LINE_GRANTED when the client owns the line. */
+#define DAEMON_MESSAGE_TYPE_ACQUIRE_LINE 0x01
+/** Client request : give the line back so the next client can use it. */
+#define DAEMON_MESSAGE_TYPE_RELEASE_LINE 0x02
+/** Client request : send the payload bytes to the clock, the client must own the line. */
+#define DAEMON_MESSAGE_TYPE_WRITE_BYTES 0x03
+/** Client request : receive all bytes sent by the clock. */
+#define DAEMON_MESSAGE_TYPE_MONITOR 0x04
+/** Daemon answer : the client owns the line, the following received bytes answer its commands. */
+#define DAEMON_MESSAGE_TYPE_LINE_GRANTED 0x81
+/** Daemon message : the payload contains bytes sent by the clock. */
+#define DAEMON_MESSAGE_TYPE_RECEIVED_BYTES 0x82
+
+/** A message type and payload length size in bytes. */
+#define DAEMON_MESSAGE_HEADER_SIZE 2
+/** The biggest message payload size in bytes. */
+#define DAEMON_MESSAGE_MAXIMUM_PAYLOAD_SIZE 255
+/** The biggest message size in bytes. */
+#define DAEMON_MESSAGE_MAXIMUM_SIZE (DAEMON_MESSAGE_HEADER_SIZE + DAEMON_MESSAGE_MAXIMUM_PAYLOAD_SIZE)
+
+/** How many bytes sent by the clock are kept for the clients, a client lagging by more than this is disconnected. The clock can't send more than 1920 bytes per second. */
+#define DAEMON_RECEIVED_BYTES_BUFFER_SIZE 16384
+/** How many clients a serial port can serve at the same time. */
+#define DAEMON_MAXIMUM_CLIENTS_COUNT 32
+/** How long a client can own the line, in milliseconds. A client owning the line for longer is considered stuck and is disconnected. */
+#define DAEMON_LINE_OWNERSHIP_TIMEOUT 60000
+/** How long to wait for a client event before checking the line ownership timeout, in milliseconds. */
+#define DAEMON_POLL_PERIOD 1000
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A client connected to a daemon socket. */
+typedef struct
+{
+	int Socket; //!< The client socket, -1 when this client slot is free.
+	int Is_Monitoring; //!< Set to 1 when the client receives all bytes sent by the clock.
+	int Is_Line_Grant_Pending; //!< Set to 1 when the DAEMON_MESSAGE_TYPE_LINE_GRANTED message must be sent.
+	unsigned long long Stream_Position; //!< The index of the next byte sent by the clock to transmit to the client.
+	unsigned char Output_Header[DAEMON_MESSAGE_HEADER_SIZE]; //!< The header of the message being transmitted.
+	int Output_Header_Remaining_Size; //!< How many header bytes are still to transmit.
+	int Output_Payload_Remaining_Size; //!< How many payload bytes are still to transmit, they are directly taken from the line received bytes.
+	unsigned char Input_Buffer[DAEMON_MESSAGE_MAXIMUM_SIZE]; //!< Hold an incompletely received message.
+	int Input_Size; //!< How many bytes are stored in the input buffer.
+} TDaemonClient;
+
+/** A served serial port. */
+typedef struct
+{
+	char *String_Serial_Port; //!< The serial port the clock is connected to.
+	char *String_Socket_Path; //!< The socket the clients connect to.
+	TSerialPortID Serial_Port_ID; //!< The opened serial port.
+	int Listening_Socket; //!< Accept the clients connections.
+	int Wake_Up_Pipe[2]; //!< The serial port reception thread writes to this pipe to wake up the clients thread.
+	pthread_t Server_Thread_ID; //!< The thread serving the clients.
+	pthread_t Reader_Thread_ID; //!< The thread receiving the bytes sent by the clock.
+	pthread_mutex_t Mutex; //!< Protect the received bytes.
+	unsigned char Received_Bytes[DAEMON_RECEIVED_BYTES_BUFFER_SIZE]; //!< The last bytes sent by the clock, shared by all clients.
+	unsigned long long Received_Bytes_Count; //!< How many bytes the clock sent since the daemon started.
+	TDaemonClient Clients[DAEMON_MAXIMUM_CLIENTS_COUNT]; //!< All client slots.
+	int Queued_Clients[DAEMON_MAXIMUM_CLIENTS_COUNT]; //!< The indexes of the clients waiting for the line, the first one owns the line.
+	int Queued_Clients_Count; //!< How many clients own or wait for the line.
+	long Line_Grant_Time; //!< When the line was granted to its current owner.
+	int Is_Started; //!< Set to 1 when the server thread is running.
+} TDaemonLine;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The daemon connection of a client program. */
+static int Daemon_Client_Socket = -1;
+/** How many bytes of the received message payload are still to read. */
+static int Daemon_Client_Remaining_Payload_Size = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the current time in milliseconds.
+ * @return The time.
+ */
+static long DaemonGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (Time.tv_sec * 1000) + (Time.tv_nsec / 1000000);
+}
+
+/** Send the line to the first queued client if it does not own it yet.
+ * @param Pointer_Line The line.
+ */
+static void DaemonGrantLine(TDaemonLine *Pointer_Line)
+{
+	TDaemonClient *Pointer_Client;
+	
+	if (Pointer_Line->Queued_Clients_Count == 0) return;
+	Pointer_Client = &Pointer_Line->Clients[Pointer_Line->Queued_Clients[0]];
+	
+	// The client must only receive the clock answers to its own commands
+	Pointer_Client->Is_Line_Grant_Pending = 1;
+	if (!Pointer_Client->Is_Monitoring)
+	{
+		pthread_mutex_lock(&Pointer_Line->Mutex);
+		Pointer_Client->Stream_Position = Pointer_Line->Received_Bytes_Count;
+		pthread_mutex_unlock(&Pointer_Line->Mutex);
+	}
+	Pointer_Line->Line_Grant_Time = DaemonGetTime();
+}
+
+/** Remove a client from the line queue, granting the line to the next client if the removed client owned it.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client to remove.
+ */
+static void DaemonUnqueueClient(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	int i;
+	
+	for (i = 0; i < Pointer_Line->Queued_Clients_Count; i++)
+	{
+		if (Pointer_Line->Queued_Clients[i] == Client_Index) break;
+	}
+	if (i == Pointer_Line->Queued_Clients_Count) return;
+	
+	memmove(&Pointer_Line->Queued_Clients[i], &Pointer_Line->Queued_Clients[i + 1], (Pointer_Line->Queued_Clients_Count - i - 1) * sizeof(Pointer_Line->Queued_Clients[0]));
+	Pointer_Line->Queued_Clients_Count--;
+	if (i == 0) DaemonGrantLine(Pointer_Line);
+}
+
+/** Close a client connection, releasing the line if the client owned it.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client to disconnect.
+ */
+static void DaemonCloseClient(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	close(Pointer_Line->Clients[Client_Index].Socket);
+	Pointer_Line->Clients[Client_Index].Socket = -1;
+	DaemonUnqueueClient(Pointer_Line, Client_Index);
+}
+
+/** Tell whether a client owns the line.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client.
+ * @return 1 if the client owns the line,
+ * @return 0 otherwise.
+ */
+static int DaemonIsLineOwner(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	return (Pointer_Line->Queued_Clients_Count > 0) && (Pointer_Line->Queued_Clients[0] == Client_Index);
+}
+
+/** Execute a message received from a client.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client that sent the message.
+ * @param Pointer_Message The message.
+ * @return 0 on success,
+ * @return -1 if the message is not allowed, the client must be disconnected.
+ */
+static int DaemonExecuteClientMessage(TDaemonLine *Pointer_Line, int Client_Index, unsigned char *Pointer_Message)
+{
+	int i;
+	
+	switch (Pointer_Message[0])
+	{
+		case DAEMON_MESSAGE_TYPE_ACQUIRE_LINE:
+			for (i = 0; i < Pointer_Line->Queued_Clients_Count; i++)
+			{
+				if (Pointer_Line->Queued_Clients[i] == Client_Index) return 0; // The client is already queued
+			}
+			Pointer_Line->Queued_Clients[Pointer_Line->Queued_Clients_Count] = Client_Index;
+			Pointer_Line->Queued_Clients_Count++;
+			if (Pointer_Line->Queued_Clients_Count == 1) DaemonGrantLine(Pointer_Line);
+			return 0;
+		
+		case DAEMON_MESSAGE_TYPE_RELEASE_LINE:
+			DaemonUnqueueClient(Pointer_Line, Client_Index);
+			return 0;
+		
+		case DAEMON_MESSAGE_TYPE_WRITE_BYTES:
+			if (!DaemonIsLineOwner(Pointer_Line, Client_Index)) return -1;
+			for (i = 0; i < Pointer_Message[1]; i++) SerialPortWriteByte(Pointer_Line->Serial_Port_ID, Pointer_Message[DAEMON_MESSAGE_HEADER_SIZE + i]);
+			return 0;
+		
+		case DAEMON_MESSAGE_TYPE_MONITOR:
+			Pointer_Line->Clients[Client_Index].Is_Monitoring = 1;
+			return 0;
+		
+		default:
+			return -1;
+	}
+}
+
+/** Receive the messages sent by a client and execute them.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client.
+ * @return 0 on success,
+ * @return -1 if the client is disconnected or sent a bad message, the client must be disconnected.
+ */
+static int DaemonReceiveClientMessages(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	TDaemonClient *Pointer_Client;
+	ssize_t Size;
+	int Message_Size;
+	
+	Pointer_Client = &Pointer_Line->Clients[Client_Index];
+	Size = read(Pointer_Client->Socket, &Pointer_Client->Input_Buffer[Pointer_Client->Input_Size], sizeof(Pointer_Client->Input_Buffer) - Pointer_Client->Input_Size);
+	if (Size < 0)
+	{
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) return 0;
+		return -1;
+	}
+	if (Size == 0) return -1; // The client closed the connection
+	Pointer_Client->Input_Size += Size;
+	
+	// Execute all complete messages
+	while (Pointer_Client->Input_Size >= DAEMON_MESSAGE_HEADER_SIZE)
+	{
+		Message_Size = DAEMON_MESSAGE_HEADER_SIZE + Pointer_Client->Input_Buffer[1];
+		if (Pointer_Client->Input_Size < Message_Size) break;
+		
+		if (DaemonExecuteClientMessage(Pointer_Line, Client_Index, Pointer_Client->Input_Buffer) != 0) return -1;
+		
+		Pointer_Client->Input_Size -= Message_Size;
+		memmove(Pointer_Client->Input_Buffer, &Pointer_Client->Input_Buffer[Message_Size], Pointer_Client->Input_Size);
+	}
+	return 0;
+}
+
+/** Tell whether a client must receive the bytes sent by the clock.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client.
+ * @return 1 if the client receives the clock bytes,
+ * @return 0 otherwise.
+ */
+static int DaemonIsClientReceiving(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	return Pointer_Line->Clients[Client_Index].Is_Monitoring || DaemonIsLineOwner(Pointer_Line, Client_Index);
+}
+
+/** Transmit as many pending messages as possible to a client without blocking. The payloads are directly sent from the line received bytes, which are shared by all clients.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client.
+ * @return 0 on success,
+ * @return -1 if the client can't keep up with the clock or if the connection is lost, the client must be disconnected.
+ */
+static int DaemonTransmitClientMessages(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	TDaemonClient *Pointer_Client;
+	struct iovec Vectors[3];
+	int Vectors_Count, Offset, Size, Result = 0, Is_Receiving;
+	unsigned long long Available_Bytes_Count;
+	ssize_t Transmitted_Size;
+	
+	Pointer_Client = &Pointer_Line->Clients[Client_Index];
+	Is_Receiving = DaemonIsClientReceiving(Pointer_Line, Client_Index);
+	
+	// The reception thread can't overwrite the bytes being transmitted
+	pthread_mutex_lock(&Pointer_Line->Mutex);
+	
+	// The client does not need the bytes received while it was not listening
+	if (!Is_Receiving && (Pointer_Client->Output_Payload_Remaining_Size == 0)) Pointer_Client->Stream_Position = Pointer_Line->Received_Bytes_Count;
+	
+	while (1)
+	{
+		// Start a new message when the previous one is fully transmitted
+		if ((Pointer_Client->Output_Header_Remaining_Size == 0) && (Pointer_Client->Output_Payload_Remaining_Size == 0))
+		{
+			Available_Bytes_Count = Pointer_Line->Received_Bytes_Count - Pointer_Client->Stream_Position;
+			
+			// The line grant must be transmitted before the answers to the client commands
+			if (Pointer_Client->Is_Line_Grant_Pending)
+			{
+				Pointer_Client->Output_Header[0] = DAEMON_MESSAGE_TYPE_LINE_GRANTED;
+				Pointer_Client->Output_Header[1] = 0;
+				Pointer_Client->Is_Line_Grant_Pending = 0;
+			}
+			else if (Is_Receiving && (Available_Bytes_Count > 0))
+			{
+				if (Available_Bytes_Count > DAEMON_RECEIVED_BYTES_BUFFER_SIZE)
+				{
+					printf("[%s] Error : a client can't keep up with the clock, disconnecting it.\n", Pointer_Line->String_Serial_Port);
+					Result = -1;
+					break;
+				}
+				
+				Pointer_Client->Output_Header[0] = DAEMON_MESSAGE_TYPE_RECEIVED_BYTES;
+				if (Available_Bytes_Count > DAEMON_MESSAGE_MAXIMUM_PAYLOAD_SIZE) Pointer_Client->Output_Header[1] = DAEMON_MESSAGE_MAXIMUM_PAYLOAD_SIZE;
+				else Pointer_Client->Output_Header[1] = (unsigned char) Available_Bytes_Count;
+				Pointer_Client->Output_Payload_Remaining_Size = Pointer_Client->Output_Header[1];
+			}
+			else break; // Nothing to transmit
+			Pointer_Client->Output_Header_Remaining_Size = DAEMON_MESSAGE_HEADER_SIZE;
+		}
+		
+		// Transmit the remaining header bytes, then the payload which can wrap around the end of the received bytes buffer
+		Vectors_Count = 0;
+		if (Pointer_Client->Output_Header_Remaining_Size > 0)
+		{
+			Vectors[Vectors_Count].iov_base = &Pointer_Client->Output_Header[DAEMON_MESSAGE_HEADER_SIZE - Pointer_Client->Output_Header_Remaining_Size];
+			Vectors[Vectors_Count].iov_len = Pointer_Client->Output_Header_Remaining_Size;
+			Vectors_Count++;
+		}
+		if (Pointer_Client->Output_Payload_Remaining_Size > 0)
+		{
+			Offset = Pointer_Client->Stream_Position % DAEMON_RECEIVED_BYTES_BUFFER_SIZE;
+			Size = Pointer_Client->Output_Payload_Remaining_Size;
+			if (Offset + Size > DAEMON_RECEIVED_BYTES_BUFFER_SIZE) Size = DAEMON_RECEIVED_BYTES_BUFFER_SIZE - Offset;
+			Vectors[Vectors_Count].iov_base = &Pointer_Line->Received_Bytes[Offset];
+			Vectors[Vectors_Count].iov_len = Size;
+			Vectors_Count++;
+			if (Size < Pointer_Client->Output_Payload_Remaining_Size)
+			{
+				Vectors[Vectors_Count].iov_base = Pointer_Line->Received_Bytes;
+				Vectors[Vectors_Count].iov_len = Pointer_Client->Output_Payload_Remaining_Size - Size;
+				Vectors_Count++;
+			}
+		}
+		
+		Transmitted_Size = writev(Pointer_Client->Socket, Vectors, Vectors_Count);
+		if (Transmitted_Size < 0)
+		{
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) Result = -1;
+			break;
+		}
+		
+		// Account for the transmitted bytes
+		Size = Transmitted_Size;
+		if (Size > Pointer_Client->Output_Header_Remaining_Size) Size = Pointer_Client->Output_Header_Remaining_Size;
+		Pointer_Client->Output_Header_Remaining_Size -= Size;
+		Transmitted_Size -= Size;
+		Pointer_Client->Output_Payload_Remaining_Size -= Transmitted_Size;
+		Pointer_Client->Stream_Position += Transmitted_Size;
+		
+		// Wait for the client to read the data if its socket is full
+		if ((Pointer_Client->Output_Header_Remaining_Size > 0) || (Pointer_Client->Output_Payload_Remaining_Size > 0)) break;
+	}
+	
+	pthread_mutex_unlock(&Pointer_Line->Mutex);
+	return Result;
+}
+
+/** Tell whether there are messages to transmit to a client.
+ * @param Pointer_Line The line.
+ * @param Client_Index The client.
+ * @return 1 if messages are waiting for transmission,
+ * @return 0 otherwise.
+ */
+static int DaemonIsClientTransmissionPending(TDaemonLine *Pointer_Line, int Client_Index)
+{
+	TDaemonClient *Pointer_Client;
+	int Is_Pending;
+	
+	Pointer_Client = &Pointer_Line->Clients[Client_Index];
+	if ((Pointer_Client->Output_Header_Remaining_Size > 0) || (Pointer_Client->Output_Payload_Remaining_Size > 0) || Pointer_Client->Is_Line_Grant_Pending) return 1;
+	if (!DaemonIsClientReceiving(Pointer_Line, Client_Index)) return 0;
+	
+	pthread_mutex_lock(&Pointer_Line->Mutex);
+	Is_Pending = Pointer_Client->Stream_Position != Pointer_Line->Received_Bytes_Count;
+	pthread_mutex_unlock(&Pointer_Line->Mutex);
+	return Is_Pending;
+}
+
+/** Accept a new client connection.
+ * @param Pointer_Line The line.
+ */
+static void DaemonAcceptClient(TDaemonLine *Pointer_Line)
+{
+	int Socket, i;
+	
+	Socket = accept(Pointer_Line->Listening_Socket, NULL, NULL);
+	if (Socket < 0) return;
+	
+	// Find a free client slot
+	for (i = 0; i < DAEMON_MAXIMUM_CLIENTS_COUNT; i++)
+	{
+		if (Pointer_Line->Clients[i].Socket == -1) break;
+	}
+	if (i == DAEMON_MAXIMUM_CLIENTS_COUNT)
+	{
+		printf("[%s] Error : too many clients, refusing a new connection.\n", Pointer_Line->String_Serial_Port);
+		close(Socket);
+		return;
+	}
+	
+	// A slow client must never block the other ones
+	fcntl(Socket, F_SETFL, fcntl(Socket, F_GETFL) | O_NONBLOCK);
+	
+	memset(&Pointer_Line->Clients[i], 0, sizeof(Pointer_Line->Clients[i]));
+	Pointer_Line->Clients[i].Socket = Socket;
+}
+
+/** Receive the bytes sent by the clock and store them for the clients.
+ * @param Pointer_Line The line.
+ * @return NULL, the thread never exits.
+ */
+static void *DaemonThreadReceiveBytes(void *Pointer_Line)
+{
+	TDaemonLine *Pointer_Served_Line = Pointer_Line;
+	unsigned char Byte;
+	
+	while (1)
+	{
+		Byte = SerialPortReadByte(Pointer_Served_Line->Serial_Port_ID);
+		
+		pthread_mutex_lock(&Pointer_Served_Line->Mutex);
+		Pointer_Served_Line->Received_Bytes[Pointer_Served_Line->Received_Bytes_Count % DAEMON_RECEIVED_BYTES_BUFFER_SIZE] = Byte;
+		Pointer_Served_Line->Received_Bytes_Count++;
+		pthread_mutex_unlock(&Pointer_Served_Line->Mutex);
+		
+		// The pipe is non-blocking, a full pipe already wakes up the server
+		if (write(Pointer_Served_Line->Wake_Up_Pipe[1], &Byte, 1) < 0) continue;
+	}
+	
+	return NULL;
+}
+
+/** Serve the clients of a line.
+ * @param Pointer_Line The line.
+ * @return NULL when the line can't be served anymore.
+ */
+static void *DaemonThreadServeClients(void *Pointer_Line)
+{
+	TDaemonLine *Pointer_Served_Line = Pointer_Line;
+	struct pollfd Poll_Descriptors[2 + DAEMON_MAXIMUM_CLIENTS_COUNT];
+	int Poll_Client_Indexes[DAEMON_MAXIMUM_CLIENTS_COUNT], Descriptors_Count, i;
+	unsigned char Buffer[64];
+	
+	while (1)
+	{
+		// Wait for new clients, bytes from the clock or client messages
+		Poll_Descriptors[0].fd = Pointer_Served_Line->Listening_Socket;
+		Poll_Descriptors[0].events = POLLIN;
+		Poll_Descriptors[1].fd = Pointer_Served_Line->Wake_Up_Pipe[0];
+		Poll_Descriptors[1].events = POLLIN;
+		Descriptors_Count = 2;
+		for (i = 0; i < DAEMON_MAXIMUM_CLIENTS_COUNT; i++)
+		{
+			if (Pointer_Served_Line->Clients[i].Socket == -1) continue;
+			Poll_Descriptors[Descriptors_Count].fd = Pointer_Served_Line->Clients[i].Socket;
+			Poll_Descriptors[Descriptors_Count].events = POLLIN;
+			if (DaemonIsClientTransmissionPending(Pointer_Served_Line, i)) Poll_Descriptors[Descriptors_Count].events |= POLLOUT;
+			Poll_Client_Indexes[Descriptors_Count - 2] = i;
+			Descriptors_Count++;
+		}
+		if (poll(Poll_Descriptors, Descriptors_Count, DAEMON_POLL_PERIOD) < 0)
+		{
+			if (errno == EINTR) continue;
+			printf("[%s] Error : failed to wait for clients (%s).\n", Pointer_Served_Line->String_Serial_Port, strerror(errno));
+			return NULL;
+		}
+		
+		if (Poll_Descriptors[1].revents & POLLIN)
+		{
+			if (read(Pointer_Served_Line->Wake_Up_Pipe[0], Buffer, sizeof(Buffer)) < 0) continue;
+		}
+		if (Poll_Descriptors[0].revents & POLLIN) DaemonAcceptClient(Pointer_Served_Line);
+		
+		// Execute the clients messages in arrival order, a client owning the line sends its whole command before the next client can send anything
+		for (i = 2; i < Descriptors_Count; i++)
+		{
+			if (Pointer_Served_Line->Clients[Poll_Client_Indexes[i - 2]].Socket == -1) continue;
+			if (Poll_Descriptors[i].revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				if (DaemonReceiveClientMessages(Pointer_Served_Line, Poll_Client_Indexes[i - 2]) != 0) DaemonCloseClient(Pointer_Served_Line, Poll_Client_Indexes[i - 2]);
+			}
+		}
+		
+		// Disconnect a client that owns the line for too long, so it can't block the other clients forever
+		if ((Pointer_Served_Line->Queued_Clients_Count > 0) && (DaemonGetTime() - Pointer_Served_Line->Line_Grant_Time > DAEMON_LINE_OWNERSHIP_TIMEOUT))
+		{
+			printf("[%s] Error : a client owns the line for too long, disconnecting it.\n", Pointer_Served_Line->String_Serial_Port);
+			DaemonCloseClient(Pointer_Served_Line, Pointer_Served_Line->Queued_Clients[0]);
+		}
+		
+		// Transmit the bytes sent by the clock and the line grants
+		for (i = 0; i < DAEMON_MAXIMUM_CLIENTS_COUNT; i++)
+		{
+			if (Pointer_Served_Line->Clients[i].Socket == -1) continue;
+			if (DaemonTransmitClientMessages(Pointer_Served_Line, i) != 0) DaemonCloseClient(Pointer_Served_Line, i);
+		}
+	}
+	
+	return NULL;
+}
+
+/** Open the serial port and create the socket of a line, then start serving it.
+ * @param Pointer_Line The line.
+ * @return 0 if the line is served,
+ * @return -1 if an error occurred (an error message is displayed).
+ */
+static int DaemonStartLine(TDaemonLine *Pointer_Line)
+{
+	struct sockaddr_un Address;
+	int i;
+	
+	for (i = 0; i < DAEMON_MAXIMUM_CLIENTS_COUNT; i++) Pointer_Line->Clients[i].Socket = -1;
+	pthread_mutex_init(&Pointer_Line->Mutex, NULL);
+	
+	if (strlen(Pointer_Line->String_Socket_Path) >= sizeof(Address.sun_path))
+	{
+		printf("[%s] Error : the socket path '%s' is too long.\n", Pointer_Line->String_Serial_Port, Pointer_Line->String_Socket_Path);
+		return -1;
+	}
+	
+	if (SerialPortOpen(Pointer_Line->String_Serial_Port, 19200, &Pointer_Line->Serial_Port_ID) != 0)
+	{
+		printf("[%s] Error : failed to open the serial port.\n", Pointer_Line->String_Serial_Port);
+		return -1;
+	}
+	
+	// Replace the socket left by a previous daemon instance
+	if (DaemonIsSocket(Pointer_Line->String_Socket_Path)) unlink(Pointer_Line->String_Socket_Path);
+	
+	Pointer_Line->Listening_Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (Pointer_Line->Listening_Socket < 0)
+	{
+		printf("[%s] Error : failed to create the socket (%s).\n", Pointer_Line->String_Serial_Port, strerror(errno));
+		goto Exit_Close_Serial_Port;
+	}
+	memset(&Address, 0, sizeof(Address));
+	Address.sun_family = AF_UNIX;
+	strcpy(Address.sun_path, Pointer_Line->String_Socket_Path);
+	if ((bind(Pointer_Line->Listening_Socket, (struct sockaddr *) &Address, sizeof(Address)) != 0) || (listen(Pointer_Line->Listening_Socket, DAEMON_MAXIMUM_CLIENTS_COUNT) != 0))
+	{
+		printf("[%s] Error : failed to listen on the socket '%s' (%s).\n", Pointer_Line->String_Serial_Port, Pointer_Line->String_Socket_Path, strerror(errno));
+		goto Exit_Close_Socket;
+	}
+	
+	if (pipe(Pointer_Line->Wake_Up_Pipe) != 0)
+	{
+		printf("[%s] Error : failed to create the wake-up pipe.\n", Pointer_Line->String_Serial_Port);
+		goto Exit_Close_Socket;
+	}
+	fcntl(Pointer_Line->Wake_Up_Pipe[1], F_SETFL, fcntl(Pointer_Line->Wake_Up_Pipe[1], F_GETFL) | O_NONBLOCK);
+	
+	if ((pthread_create(&Pointer_Line->Reader_Thread_ID, NULL, DaemonThreadReceiveBytes, Pointer_Line) != 0) || (pthread_create(&Pointer_Line->Server_Thread_ID, NULL, DaemonThreadServeClients, Pointer_Line) != 0))
+	{
+		printf("[%s] Error : failed to create the daemon threads.\n", Pointer_Line->String_Serial_Port);
+		exit(EXIT_FAILURE); // The reception thread can't be stopped while it is reading the serial port
+	}
+	
+	printf("[%s] Serving the clock on '%s'.\n", Pointer_Line->String_Serial_Port, Pointer_Line->String_Socket_Path);
+	return 0;
+	
+Exit_Close_Socket:
+	close(Pointer_Line->Listening_Socket);
+	
+Exit_Close_Serial_Port:
+	SerialPortClose(Pointer_Line->Serial_Port_ID);
+	return -1;
+}
+
+/** Send a message to the daemon. The program exits if the daemon connection is lost.
+ * @param Type The message type.
+ * @param Pointer_Payload The message payload.
+ * @param Payload_Size The payload size in bytes.
+ */
+static void DaemonSendMessage(unsigned char Type, unsigned char *Pointer_Payload, unsigned char Payload_Size)
+{
+	unsigned char Message[DAEMON_MESSAGE_MAXIMUM_SIZE];
+	
+	Message[0] = Type;
+	Message[1] = Payload_Size;
+	if (Payload_Size > 0) memcpy(&Message[DAEMON_MESSAGE_HEADER_SIZE], Pointer_Payload, Payload_Size);
+	if (write(Daemon_Client_Socket, Message, DAEMON_MESSAGE_HEADER_SIZE + Payload_Size) != DAEMON_MESSAGE_HEADER_SIZE + Payload_Size)
+	{
+		printf("Error : the daemon connection is lost.\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** Receive bytes from the daemon. The program exits if the daemon connection is lost.
+ * @param Pointer_Buffer On output, contain the received bytes.
+ * @param Size How many bytes to receive.
+ */
+static void DaemonReceive(unsigned char *Pointer_Buffer, int Size)
+{
+	ssize_t Received_Size;
+	
+	while (Size > 0)
+	{
+		Received_Size = read(Daemon_Client_Socket, Pointer_Buffer, Size);
+		if (Received_Size <= 0)
+		{
+			if ((Received_Size < 0) && (errno == EINTR)) continue;
+			printf("Error : the daemon connection is lost.\n");
+			exit(EXIT_FAILURE);
+		}
+		Pointer_Buffer += Received_Size;
+		Size -= Received_Size;
+	}
+}
+
+/** Receive a message header from the daemon.
+ * @return The message type.
+ */
+static unsigned char DaemonReceiveMessageHeader(void)
+{
+	unsigned char Header[DAEMON_MESSAGE_HEADER_SIZE];
+	
+	DaemonReceive(Header, sizeof(Header));
+	Daemon_Client_Remaining_Payload_Size = Header[1];
+	return Header[0];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int DaemonServe(char *String_Serial_Ports[], char *String_Socket_Paths[], int Lines_Count)
+{
+	TDaemonLine *Pointer_Lines;
+	int i;
+	
+	Pointer_Lines = calloc(Lines_Count, sizeof(TDaemonLine));
+	if (Pointer_Lines == NULL)
+	{
+		printf("Error : not enough memory.\n");
+		return -1;
+	}
+	
+	// A client closing its connection must not terminate the daemon
+	signal(SIGPIPE, SIG_IGN);
+	
+	// The daemon messages are usually redirected to a log file, make sure they are written as soon as they are displayed
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	
+	// Each line is served by its own threads, so a slow serial port never delays the other clocks
+	for (i = 0; i < Lines_Count; i++)
+	{
+		Pointer_Lines[i].String_Serial_Port = String_Serial_Ports[i];
+		Pointer_Lines[i].String_Socket_Path = String_Socket_Paths[i];
+		if (DaemonStartLine(&Pointer_Lines[i]) == 0) Pointer_Lines[i].Is_Started = 1;
+	}
+	
+	for (i = 0; i < Lines_Count; i++)
+	{
+		if (Pointer_Lines[i].Is_Started) pthread_join(Pointer_Lines[i].Server_Thread_ID, NULL);
+	}
+	
+	// The reception threads may still be using the lines
+	return -1;
+}
+
+int DaemonIsSocket(char *String_Path)
+{
+	struct stat Status;
+	
+	if (stat(String_Path, &Status) != 0) return 0;
+	return S_ISSOCK(Status.st_mode);
+}
+
+int DaemonConnect(char *String_Socket_Path, int Is_Monitoring)
+{
+	struct sockaddr_un Address;
+	
+	if (strlen(String_Socket_Path) >= sizeof(Address.sun_path))
+	{
+		printf("Error : the socket path '%s' is too long.\n", String_Socket_Path);
+		return -1;
+	}
+	
+	Daemon_Client_Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (Daemon_Client_Socket < 0)
+	{
+		printf("Error : failed to create the socket (%s).\n", strerror(errno));
+		return -1;
+	}
+	memset(&Address, 0, sizeof(Address));
+	Address.sun_family = AF_UNIX;
+	strcpy(Address.sun_path, String_Socket_Path);
+	if (connect(Daemon_Client_Socket, (struct sockaddr *) &Address, sizeof(Address)) != 0)
+	{
+		printf("Error : failed to connect to the daemon socket '%s' (%s).\n", String_Socket_Path, strerror(errno));
+		close(Daemon_Client_Socket);
+		Daemon_Client_Socket = -1;
+		return -1;
+	}
+	
+	if (Is_Monitoring)
+	{
+		DaemonSendMessage(DAEMON_MESSAGE_TYPE_MONITOR, NULL, 0);
+		return 0;
+	}
+	
+	// Wait for the other clients commands to terminate
+	DaemonSendMessage(DAEMON_MESSAGE_TYPE_ACQUIRE_LINE, NULL, 0);
+	while (DaemonReceiveMessageHeader() != DAEMON_MESSAGE_TYPE_LINE_GRANTED);
+	return 0;
+}
+
+void DaemonDisconnect(void)
+{
+	if (Daemon_Client_Socket == -1) return;
+	
+	// Closing the connection also releases the line, but let the next client start as soon as possible
+	DaemonSendMessage(DAEMON_MESSAGE_TYPE_RELEASE_LINE, NULL, 0);
+	close(Daemon_Client_Socket);
+	Daemon_Client_Socket = -1;
+}
+
+unsigned char DaemonReadByte(void)
+{
+	unsigned char Byte;
+	
+	// Skip the messages that do not contain clock bytes
+	while (Daemon_Client_Remaining_Payload_Size == 0)
+	{
+		if (DaemonReceiveMessageHeader() == DAEMON_MESSAGE_TYPE_RECEIVED_BYTES) continue;
+		for (; Daemon_Client_Remaining_Payload_Size > 0; Daemon_Client_Remaining_Payload_Size--) DaemonReceive(&Byte, 1);
+	}
+	
+	DaemonReceive(&Byte, 1);
+	Daemon_Client_Remaining_Payload_Size--;
+	return Byte;
+}
+
+void DaemonWriteByte(unsigned char Byte)
+{
+	DaemonSendMessage(DAEMON_MESSAGE_TYPE_WRITE_BYTES, &Byte, 1);
+}
+
+int DaemonIsByteAvailable(void)
+{
+	struct pollfd Poll_Descriptor;
+	
+	if (Daemon_Client_Remaining_Payload_Size > 0) return 1;
+	
+	Poll_Descriptor.fd = Daemon_Client_Socket;
+	Poll_Descriptor.events = POLLIN;
+	if (poll(&Poll_Descriptor, 1, 0) <= 0) return 0;
+	return 1;
+}
@@ -0,0 +1,55 @@
+/** @file Daemon.h
+ * Share the clocks serial ports between several programs. The daemon owns the serial ports and serves local clients through a Unix domain socket per serial port.
+ * A client must own the line to send bytes to the clock, the line is granted to the clients in request order and each client receives the clock bytes while it owns the line, so whole commands from different clients are never mixed. Monitoring clients receive all bytes sent by the clock.
+ * All messages exchanged with the daemon are made of a type byte, a payload length byte and the payload.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_DAEMON_H
+#define H_DAEMON_H
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Serve one or more serial ports, each one through its own socket. This function returns only on failure.
+ * @param String_Serial_Ports The serial ports the clocks are connected to.
+ * @param String_Socket_Paths The socket to create for each serial port. An existing socket with the same name is replaced.
+ * @param Lines_Count How many serial ports are provided.
+ * @return -1 as the function returns only when all serial ports can't be served anymore (an error message is displayed).
+ */
+int DaemonServe(char *String_Serial_Ports[], char *String_Socket_Paths[], int Lines_Count);
+
+/** Tell whether a file is a daemon socket rather than a serial port.
+ * @param String_Path The file to check.
+ * @return 1 if the file is a socket,
+ * @return 0 otherwise.
+ */
+int DaemonIsSocket(char *String_Path);
+
+/** Connect to a daemon.
+ * @param String_Socket_Path The daemon socket serving the clock serial port.
+ * @param Is_Monitoring Set to 0 to wait until the line is owned by this program, so bytes can be sent to the clock. Set to 1 to receive all bytes sent by the clock without sending anything.
+ * @return 0 if the connection succeeded,
+ * @return -1 if an error occurred (an error message is displayed).
+ */
+int DaemonConnect(char *String_Socket_Path, int Is_Monitoring);
+
+/** Close the daemon connection, releasing the line. */
+void DaemonDisconnect(void);
+
+/** Block until a byte sent by the clock is received from the daemon. The program exits if the daemon connection is lost.
+ * @return The received byte.
+ */
+unsigned char DaemonReadByte(void);
+
+/** Send a byte to the clock through the daemon. The program exits if the daemon connection is lost.
+ * @param Byte The byte to send.
+ */
+void DaemonWriteByte(unsigned char Byte);
+
+/** Tell if a byte sent by the clock has been received or not.
+ * @return 1 if a byte is available to read,
+ * @return 0 if no byte was received.
+ */
+int DaemonIsByteAvailable(void);
+
+#endif
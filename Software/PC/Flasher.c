@@ -0,0 +1,492 @@
+/** @file Flasher.c
+ * @see Flasher.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "Flasher.h"
+#include <pthread.h>
+#include "Protocol.h"
+#include <Serial_Port.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Synchronize with the bootloader. */
+#define FLASHER_BOOTLOADER_COMMAND_SYNCHRONIZE 0xC0
+/** Get the CRC of consecutive blocks. */
+#define FLASHER_BOOTLOADER_COMMAND_GET_BLOCKS_CRC 0xC1
+/** Write a block. */
+#define FLASHER_BOOTLOADER_COMMAND_WRITE_BLOCK 0xC2
+/** Start the application. */
+#define FLASHER_BOOTLOADER_COMMAND_START_APPLICATION 0xC3
+
+/** The bootloader received a corrupted block. */
+#define FLASHER_BOOTLOADER_ERROR_BAD_CRC 0xE0
+
+/** How many words are in a block. */
+#define FLASHER_BLOCK_SIZE_WORDS 32
+/** How many program memory words the application can use, the remaining ones belong to the bootloader. */
+#define FLASHER_APPLICATION_SIZE_WORDS 0x1E00
+/** How many blocks the application can use. */
+#define FLASHER_APPLICATION_BLOCKS_COUNT (FLASHER_APPLICATION_SIZE_WORDS / FLASHER_BLOCK_SIZE_WORDS)
+/** The configuration word address, it can't be written by the bootloader. */
+#define FLASHER_CONFIGURATION_WORD_ADDRESS 0x2007
+/** How many application words are relocated by the bootloader. Erasing them makes the bootloader wait for the host on next boot. */
+#define FLASHER_RELOCATED_WORDS_COUNT 4
+/** An erased program memory word value. */
+#define FLASHER_ERASED_WORD 0x3FFF
+
+/** How many times a block is sent before giving up. */
+#define FLASHER_BLOCK_WRITE_ATTEMPTS_COUNT 3
+/** How long to wait for the bootloader to answer, in milliseconds. */
+#define FLASHER_BOOTLOADER_ANSWER_TIMEOUT 1000
+/** How long to wait for the bootloader to start, in milliseconds. */
+#define FLASHER_BOOTLOADER_SYNCHRONIZATION_TIMEOUT 10000
+/** How long to wait between two synchronization attempts, in milliseconds. */
+#define FLASHER_BOOTLOADER_SYNCHRONIZATION_PERIOD 100
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A clock to update. */
+typedef struct
+{
+	char *String_Serial_Port; //!< The serial port the clock is connected to.
+	pthread_t Thread_ID; //!< The thread updating the clock.
+	int Is_Update_Successful; //!< Set to 1 if the clock was successfully updated.
+} TFlasherClock;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The firmware words, unused words are left erased. */
+static unsigned short Flasher_Firmware_Words[FLASHER_APPLICATION_SIZE_WORDS];
+/** Tell which blocks contain firmware words. */
+static int Flasher_Is_Block_Used[FLASHER_APPLICATION_BLOCKS_COUNT];
+/** The CRC of each firmware block. */
+static unsigned short Flasher_Blocks_CRC[FLASHER_APPLICATION_BLOCKS_COUNT];
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Add a byte to a CRC-16-CCITT computation.
+ * @param CRC The current CRC value (start with 0xFFFF).
+ * @param Byte The byte to add.
+ * @return The new CRC value.
+ */
+static unsigned short FlasherUpdateCRC(unsigned short CRC, unsigned char Byte)
+{
+	int i;
+	
+	CRC ^= Byte << 8;
+	for (i = 0; i < 8; i++)
+	{
+		if (CRC & 0x8000) CRC = (CRC << 1) ^ 0x1021;
+		else CRC <<= 1;
+	}
+	return CRC;
+}
+
+/** Convert the hexadecimal digits of an Intel HEX record.
+ * @param String_Digits The digits to convert.
+ * @param Digits_Count How many digits to convert.
+ * @return The converted value,
+ * @return -1 if a character is not an hexadecimal digit.
+ */
+static int FlasherConvertHexadecimalDigits(char *String_Digits, int Digits_Count)
+{
+	int Value = 0, i;
+	char Character;
+	
+	for (i = 0; i < Digits_Count; i++)
+	{
+		Character = String_Digits[i];
+		if ((Character >= '0') && (Character <= '9')) Character -= '0';
+		else if ((Character >= 'A') && (Character <= 'F')) Character -= 'A' - 10;
+		else if ((Character >= 'a') && (Character <= 'f')) Character -= 'a' - 10;
+		else return -1;
+		Value = (Value << 4) | Character;
+	}
+	return Value;
+}
+
+/** Get the current time in milliseconds.
+ * @return The time.
+ */
+static long FlasherGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (Time.tv_sec * 1000) + (Time.tv_nsec / 1000000);
+}
+
+/** Wait for a byte from the serial port.
+ * @param Serial_Port_ID The serial port.
+ * @param Timeout How many milliseconds to wait for the byte.
+ * @param Pointer_Byte On output, contain the received byte.
+ * @return 0 if a byte was received,
+ * @return -1 if the timeout expired.
+ */
+static int FlasherReadByte(TSerialPortID Serial_Port_ID, int Timeout, unsigned char *Pointer_Byte)
+{
+	long Deadline;
+	
+	Deadline = FlasherGetTime() + Timeout;
+	while (!SerialPortIsByteAvailable(Serial_Port_ID))
+	{
+		if (FlasherGetTime() >= Deadline) return -1;
+		usleep(1000);
+	}
+	*Pointer_Byte = SerialPortReadByte(Serial_Port_ID);
+	return 0;
+}
+
+/** Discard all bytes received until the serial port stays silent for some time.
+ * @param Serial_Port_ID The serial port.
+ */
+static void FlasherDiscardReceivedBytes(TSerialPortID Serial_Port_ID)
+{
+	unsigned char Byte;
+	
+	while (FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_SYNCHRONIZATION_PERIOD, &Byte) == 0);
+}
+
+/** Ask the clock firmware to start the bootloader, then wait for the bootloader to answer. The bootloader also waits for the host for a short time on power-on, so a clock with a broken firmware can be recovered by power-cycling it.
+ * @param String_Serial_Port The clock serial port, used to display messages.
+ * @param Serial_Port_ID The serial port.
+ * @return 0 if the bootloader answered,
+ * @return -1 if the bootloader did not answer.
+ */
+static int FlasherStartBootloader(char *String_Serial_Port, TSerialPortID Serial_Port_ID)
+{
+	unsigned char Byte;
+	long Deadline;
+	
+	// The firmware acknowledges the command, there is no answer if the bootloader is already running
+	SerialPortWriteByte(Serial_Port_ID, PROTOCOL_COMMAND_ENTER_BOOTLOADER);
+	FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_ANSWER_TIMEOUT, &Byte);
+	
+	// Send synchronization bytes until the bootloader answers
+	Deadline = FlasherGetTime() + FLASHER_BOOTLOADER_SYNCHRONIZATION_TIMEOUT;
+	do
+	{
+		SerialPortWriteByte(Serial_Port_ID, FLASHER_BOOTLOADER_COMMAND_SYNCHRONIZE);
+		while (FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_SYNCHRONIZATION_PERIOD, &Byte) == 0)
+		{
+			if (Byte == FLASHER_BOOTLOADER_COMMAND_SYNCHRONIZE)
+			{
+				// Do not mistake an answer to a previous synchronization byte for a command answer
+				FlasherDiscardReceivedBytes(Serial_Port_ID);
+				return 0;
+			}
+		}
+	} while (FlasherGetTime() < Deadline);
+	
+	printf("[%s] Error : the bootloader did not answer. Power-cycle the clock while flashing if its firmware is broken.\n", String_Serial_Port);
+	return -1;
+}
+
+/** Get the CRC of all application blocks programmed in the clock. The bootloader streams all CRCs in a single answer.
+ * @param Serial_Port_ID The serial port.
+ * @param Pointer_Blocks_CRC On output, contain the CRC of each block.
+ * @return 0 on success,
+ * @return -1 if the bootloader did not answer.
+ */
+static int FlasherGetBlocksCRC(TSerialPortID Serial_Port_ID, unsigned short *Pointer_Blocks_CRC)
+{
+	int i;
+	unsigned char Byte;
+	
+	SerialPortWriteByte(Serial_Port_ID, FLASHER_BOOTLOADER_COMMAND_GET_BLOCKS_CRC);
+	SerialPortWriteByte(Serial_Port_ID, 0);
+	SerialPortWriteByte(Serial_Port_ID, FLASHER_APPLICATION_BLOCKS_COUNT);
+	
+	for (i = 0; i < FLASHER_APPLICATION_BLOCKS_COUNT; i++)
+	{
+		if (FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_ANSWER_TIMEOUT, &Byte) != 0) return -1;
+		Pointer_Blocks_CRC[i] = Byte << 8;
+		if (FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_ANSWER_TIMEOUT, &Byte) != 0) return -1;
+		Pointer_Blocks_CRC[i] |= Byte;
+	}
+	return 0;
+}
+
+/** Write a block to the clock program memory. The block is sent again if it was corrupted during the transfer.
+ * @param String_Serial_Port The clock serial port, used to display messages.
+ * @param Serial_Port_ID The serial port.
+ * @param Block The block index.
+ * @param Pointer_Words The block words.
+ * @return 0 if the block was written and verified,
+ * @return -1 if the block could not be written.
+ */
+static int FlasherWriteBlock(char *String_Serial_Port, TSerialPortID Serial_Port_ID, int Block, unsigned short *Pointer_Words)
+{
+	unsigned char Frame[1 + 1 + (FLASHER_BLOCK_SIZE_WORDS * 2) + 2], Byte;
+	unsigned short CRC;
+	int Size = 0, i, Attempt;
+	
+	// Build the whole frame first, so it is sent without interruption
+	Frame[Size++] = FLASHER_BOOTLOADER_COMMAND_WRITE_BLOCK;
+	Frame[Size++] = (unsigned char) Block;
+	for (i = 0; i < FLASHER_BLOCK_SIZE_WORDS; i++)
+	{
+		Frame[Size++] = (unsigned char) (Pointer_Words[i] >> 8);
+		Frame[Size++] = (unsigned char) Pointer_Words[i];
+	}
+	// The CRC covers the block index and the words
+	CRC = 0xFFFF;
+	for (i = 1; i < Size; i++) CRC = FlasherUpdateCRC(CRC, Frame[i]);
+	Frame[Size++] = (unsigned char) (CRC >> 8);
+	Frame[Size++] = (unsigned char) CRC;
+	
+	for (Attempt = 0; Attempt < FLASHER_BLOCK_WRITE_ATTEMPTS_COUNT; Attempt++)
+	{
+		for (i = 0; i < Size; i++) SerialPortWriteByte(Serial_Port_ID, Frame[i]);
+		
+		if (FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_ANSWER_TIMEOUT, &Byte) != 0)
+		{
+			// The bootloader may be waiting for the missing bytes of a truncated frame, synchronize again
+			if (FlasherStartBootloader(String_Serial_Port, Serial_Port_ID) != 0) return -1;
+			continue;
+		}
+		if (Byte == FLASHER_BOOTLOADER_COMMAND_WRITE_BLOCK) return 0;
+		if (Byte != FLASHER_BOOTLOADER_ERROR_BAD_CRC)
+		{
+			printf("[%s] Error : the bootloader failed to write the block %d (error code 0x%02X).\n", String_Serial_Port, Block, Byte);
+			return -1;
+		}
+	}
+	
+	printf("[%s] Error : the block %d could not be transferred.\n", String_Serial_Port, Block);
+	return -1;
+}
+
+/** Update a clock firmware.
+ * @param String_Serial_Port The serial port the clock is connected to.
+ * @return 0 if the clock was successfully updated,
+ * @return -1 if an error occurred.
+ */
+static int FlasherUpdateClock(char *String_Serial_Port)
+{
+	TSerialPortID Serial_Port_ID;
+	unsigned short Clock_Blocks_CRC[FLASHER_APPLICATION_BLOCKS_COUNT], First_Block_Words[FLASHER_BLOCK_SIZE_WORDS];
+	int Is_Block_Changed[FLASHER_APPLICATION_BLOCKS_COUNT], Used_Blocks_Count = 0, Changed_Blocks_Count = 0, Result = -1, i;
+	long Start_Time;
+	unsigned char Byte;
+	
+	if (SerialPortOpen(String_Serial_Port, 19200, &Serial_Port_ID) != 0)
+	{
+		printf("[%s] Error : failed to open the serial port.\n", String_Serial_Port);
+		return -1;
+	}
+	Start_Time = FlasherGetTime();
+	
+	if (FlasherStartBootloader(String_Serial_Port, Serial_Port_ID) != 0) goto Exit;
+	
+	// Find the blocks that need to be written
+	if (FlasherGetBlocksCRC(Serial_Port_ID, Clock_Blocks_CRC) != 0)
+	{
+		printf("[%s] Error : failed to get the programmed blocks CRC.\n", String_Serial_Port);
+		goto Exit;
+	}
+	for (i = 0; i < FLASHER_APPLICATION_BLOCKS_COUNT; i++)
+	{
+		if (Flasher_Is_Block_Used[i]) Used_Blocks_Count++;
+		Is_Block_Changed[i] = Flasher_Is_Block_Used[i] && (Clock_Blocks_CRC[i] != Flasher_Blocks_CRC[i]);
+		if (Is_Block_Changed[i]) Changed_Blocks_Count++;
+	}
+	
+	if (Changed_Blocks_Count > 0)
+	{
+		printf("[%s] Writing %d blocks...\n", String_Serial_Port, Changed_Blocks_Count);
+		
+		// Erase the application entry point first, so the bootloader will wait for the host if the update is interrupted
+		memcpy(First_Block_Words, Flasher_Firmware_Words, sizeof(First_Block_Words));
+		for (i = 0; i < FLASHER_RELOCATED_WORDS_COUNT; i++) First_Block_Words[i] = FLASHER_ERASED_WORD;
+		if (FlasherWriteBlock(String_Serial_Port, Serial_Port_ID, 0, First_Block_Words) != 0) goto Exit;
+		
+		for (i = 1; i < FLASHER_APPLICATION_BLOCKS_COUNT; i++)
+		{
+			if (!Is_Block_Changed[i]) continue;
+			if (FlasherWriteBlock(String_Serial_Port, Serial_Port_ID, i, &Flasher_Firmware_Words[i * FLASHER_BLOCK_SIZE_WORDS]) != 0) goto Exit;
+		}
+		
+		// Restore the application entry point now that the whole firmware is written
+		if (FlasherWriteBlock(String_Serial_Port, Serial_Port_ID, 0, Flasher_Firmware_Words) != 0) goto Exit;
+	}
+	
+	// Start the new firmware
+	SerialPortWriteByte(Serial_Port_ID, FLASHER_BOOTLOADER_COMMAND_START_APPLICATION);
+	if ((FlasherReadByte(Serial_Port_ID, FLASHER_BOOTLOADER_ANSWER_TIMEOUT, &Byte) != 0) || (Byte != FLASHER_BOOTLOADER_COMMAND_START_APPLICATION))
+	{
+		printf("[%s] Error : the bootloader did not start the firmware.\n", String_Serial_Port);
+		goto Exit;
+	}
+	
+	printf("[%s] The firmware is successfully updated (%d blocks written, %d blocks already up to date, %.1f s).\n", String_Serial_Port, Changed_Blocks_Count, Used_Blocks_Count - Changed_Blocks_Count, (FlasherGetTime() - Start_Time) / 1000.0);
+	Result = 0;
+
+Exit:
+	SerialPortClose(Serial_Port_ID);
+	return Result;
+}
+
+/** Update a clock firmware from a dedicated thread.
+ * @param Pointer_Clock The clock to update.
+ * @return Always NULL.
+ */
+static void *FlasherThreadUpdateClock(void *Pointer_Clock)
+{
+	TFlasherClock *Pointer_Updated_Clock = Pointer_Clock;
+	
+	if (FlasherUpdateClock(Pointer_Updated_Clock->String_Serial_Port) == 0) Pointer_Updated_Clock->Is_Update_Successful = 1;
+	return NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int FlasherLoadFirmware(char *String_Hex_File)
+{
+	FILE *Pointer_File;
+	char String_Record[1024];
+	int Line = 0, Length, i, Bytes_Count, Record_Type, Checksum, Byte, Result = -1;
+	unsigned int Extended_Address = 0, Byte_Address, Word_Address;
+	unsigned char Record_Bytes[256 + 5];
+	
+	Pointer_File = fopen(String_Hex_File, "r");
+	if (Pointer_File == NULL)
+	{
+		printf("Error : failed to open the file '%s'.\n", String_Hex_File);
+		return -1;
+	}
+	
+	for (i = 0; i < FLASHER_APPLICATION_SIZE_WORDS; i++) Flasher_Firmware_Words[i] = FLASHER_ERASED_WORD;
+	memset(Flasher_Is_Block_Used, 0, sizeof(Flasher_Is_Block_Used));
+	
+	while (fgets(String_Record, sizeof(String_Record), Pointer_File) != NULL)
+	{
+		Line++;
+		
+		// Remove the end of line characters
+		Length = strlen(String_Record);
+		while ((Length > 0) && ((String_Record[Length - 1] == '\n') || (String_Record[Length - 1] == '\r'))) Length--;
+		if (Length == 0) continue;
+		
+		// Convert the record to binary and check its consistency
+		if ((String_Record[0] != ':') || (Length < 11) || ((Length & 1) == 0)) goto Bad_Record;
+		Bytes_Count = (Length - 1) / 2;
+		Checksum = 0;
+		for (i = 0; i < Bytes_Count; i++)
+		{
+			Byte = FlasherConvertHexadecimalDigits(&String_Record[1 + (i * 2)], 2);
+			if (Byte < 0) goto Bad_Record;
+			Record_Bytes[i] = (unsigned char) Byte;
+			Checksum += Byte;
+		}
+		if ((Record_Bytes[0] != Bytes_Count - 5) || ((Checksum & 0xFF) != 0)) goto Bad_Record;
+		Record_Type = Record_Bytes[3];
+		
+		// End of file
+		if (Record_Type == 1) break;
+		// Extended linear address
+		if (Record_Type == 4)
+		{
+			if (Record_Bytes[0] != 2) goto Bad_Record;
+			Extended_Address = (Record_Bytes[4] << 24) | (Record_Bytes[5] << 16);
+			continue;
+		}
+		// Ignore the other records (they do not contain data)
+		if (Record_Type != 0) continue;
+		
+		// Store the data words (they are stored little endian, 2 bytes per word)
+		Byte_Address = Extended_Address | (Record_Bytes[1] << 8) | Record_Bytes[2];
+		for (i = 0; i < Record_Bytes[0]; i++)
+		{
+			Word_Address = (Byte_Address + i) / 2;
+			
+			// The configuration word and the EEPROM data can't be written by the bootloader, the configuration word is set when programming the bootloader
+			if (Word_Address >= FLASHER_CONFIGURATION_WORD_ADDRESS) continue;
+			if (Word_Address >= FLASHER_APPLICATION_SIZE_WORDS)
+			{
+				printf("Error : the firmware overlaps the bootloader area at address 0x%04X (line %d).\n", Word_Address, Line);
+				goto Exit;
+			}
+			
+			if ((Byte_Address + i) & 1) Flasher_Firmware_Words[Word_Address] = (Flasher_Firmware_Words[Word_Address] & 0x00FF) | (Record_Bytes[4 + i] << 8);
+			else Flasher_Firmware_Words[Word_Address] = (Flasher_Firmware_Words[Word_Address] & 0xFF00) | Record_Bytes[4 + i];
+			Flasher_Is_Block_Used[Word_Address / FLASHER_BLOCK_SIZE_WORDS] = 1;
+		}
+	}
+	
+	// Make sure the firmware contains valid instructions
+	for (i = 0; i < FLASHER_APPLICATION_SIZE_WORDS; i++)
+	{
+		if (Flasher_Firmware_Words[i] > 0x3FFF)
+		{
+			printf("Error : the word at address 0x%04X is not a valid instruction.\n", i);
+			goto Exit;
+		}
+	}
+	if (!Flasher_Is_Block_Used[0])
+	{
+		printf("Error : the firmware has no reset vector.\n");
+		goto Exit;
+	}
+	
+	// Compute the CRC of each block, so they can be compared with the clock ones
+	for (i = 0; i < FLASHER_APPLICATION_SIZE_WORDS; i++)
+	{
+		if ((i % FLASHER_BLOCK_SIZE_WORDS) == 0) Flasher_Blocks_CRC[i / FLASHER_BLOCK_SIZE_WORDS] = 0xFFFF;
+		Flasher_Blocks_CRC[i / FLASHER_BLOCK_SIZE_WORDS] = FlasherUpdateCRC(Flasher_Blocks_CRC[i / FLASHER_BLOCK_SIZE_WORDS], (unsigned char) (Flasher_Firmware_Words[i] >> 8));
+		Flasher_Blocks_CRC[i / FLASHER_BLOCK_SIZE_WORDS] = FlasherUpdateCRC(Flasher_Blocks_CRC[i / FLASHER_BLOCK_SIZE_WORDS], (unsigned char) Flasher_Firmware_Words[i]);
+	}
+	
+	Result = 0;
+	goto Exit;
+
+Bad_Record:
+	printf("Error : bad Intel HEX record at line %d.\n", Line);
+
+Exit:
+	fclose(Pointer_File);
+	return Result;
+}
+
+int FlasherFlash(char *String_Serial_Ports[], int Serial_Ports_Count)
+{
+	TFlasherClock *Pointer_Clocks;
+	int i, Failed_Clocks_Count = 0;
+	
+	Pointer_Clocks = calloc(Serial_Ports_Count, sizeof(TFlasherClock));
+	if (Pointer_Clocks == NULL)
+	{
+		printf("Error : not enough memory.\n");
+		return Serial_Ports_Count;
+	}
+	
+	// Update all clocks at the same time, the serial link and the program memory writes are the bottlenecks
+	for (i = 0; i < Serial_Ports_Count; i++)
+	{
+		Pointer_Clocks[i].String_Serial_Port = String_Serial_Ports[i];
+		if (pthread_create(&Pointer_Clocks[i].Thread_ID, NULL, FlasherThreadUpdateClock, &Pointer_Clocks[i]) != 0)
+		{
+			printf("[%s] Error : failed to create the update thread.\n", String_Serial_Ports[i]);
+			Pointer_Clocks[i].String_Serial_Port = NULL; // Do not wait for this thread
+		}
+	}
+	
+	for (i = 0; i < Serial_Ports_Count; i++)
+	{
+		if (Pointer_Clocks[i].String_Serial_Port != NULL) pthread_join(Pointer_Clocks[i].Thread_ID, NULL);
+		if (!Pointer_Clocks[i].Is_Update_Successful) Failed_Clocks_Count++;
+	}
+	
+	free(Pointer_Clocks);
+	return Failed_Clocks_Count;
+}
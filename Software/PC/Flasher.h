@@ -0,0 +1,25 @@
+/** @file Flasher.h
+ * Update the clock firmware through the serial bootloader. Several clocks can be updated in parallel, each one on its own serial port.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_FLASHER_H
+#define H_FLASHER_H
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Load the firmware to flash from an Intel HEX file, as generated by the microcontroller compiler.
+ * @param String_Hex_File The file to load.
+ * @return 0 if the firmware was successfully loaded,
+ * @return -1 if an error occurred (an error message is displayed).
+ */
+int FlasherLoadFirmware(char *String_Hex_File);
+
+/** Flash the loaded firmware to one or more clocks at the same time. Only the blocks that differ from the clock ones are written.
+ * @param String_Serial_Ports The serial ports the clocks are connected to.
+ * @param Serial_Ports_Count How many serial ports are provided.
+ * @return How many clocks could not be updated.
+ */
+int FlasherFlash(char *String_Serial_Ports[], int Serial_Ports_Count);
+
+#endif
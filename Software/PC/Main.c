@@ -3,23 +3,45 @@
  * @author Adrien RICCIARDI
  */
 #include <errno.h>
+#include "Daemon.h"
+#include "Flasher.h"
+#include "Protocol.h"
+#include "Recorder.h"
 #include <Serial_Port.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 //-------------------------------------------------------------------------------------------------
 // Private constants
 //-------------------------------------------------------------------------------------------------
-/** The UART protocol magic number. */
-#define MAIN_UART_PROTOCOL_MAGIC_NUMBER 0xA5
+/** How long to wait for an addressed clock to answer, in milliseconds. */
+#define MAIN_ANSWER_TIMEOUT 1000
+/** How long to wait for each address to answer during a scan, in milliseconds (an answer takes about 2ms at 19200 bit/s). */
+#define MAIN_SCAN_ANSWER_TIMEOUT 50
+/** How long the clock must stay silent for its transmission to be considered finished when monitoring it, in milliseconds. */
+#define MAIN_MONITOR_BURST_END_TIMEOUT 20
+
+/** How often the clock telemetry is recorded, in milliseconds. */
+#define MAIN_RECORD_PERIOD 1000
+/** How many consecutive recording periods the clock status sequence number can stay unchanged before the telemetry is considered stale. A single unchanged value happens when the clock tick drifts across the request time. */
+#define MAIN_RECORD_MAXIMUM_UNCHANGED_SEQUENCE_NUMBERS 2
+
+/** How many ringtones the clock can play. */
+#define MAIN_RINGTONES_COUNT 3
 
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
 /** The serial port identifier. */
 static TSerialPortID Main_Serial_Port_ID;
+/** Set to 1 when the clock is reached through the daemon rather than by opening its serial port. */
+static int Main_Is_Daemon_Used = 0;
+
+/** The address of the clock the commands are sent to, PROTOCOL_BROADCAST_ADDRESS to send them to all clocks, or PROTOCOL_NO_UNIT_ADDRESS when the clock is alone on its line. */
+static int Main_Unit_Address = PROTOCOL_NO_UNIT_ADDRESS;
 
 //-------------------------------------------------------------------------------------------------
 // Private functions
@@ -30,25 +52,644 @@ static void MainExitCloseSerialPort(void)
 	SerialPortClose(Main_Serial_Port_ID);
 }
 
-/** Convert a 2-digit binary number to Binary Coded Decimal.
- * @param Number The number to convert.
- * @return the corresponding BCD value.
+/** Close the daemon connection on program termination. */
+static void MainExitDisconnectDaemon(void)
+{
+	DaemonDisconnect();
+}
+
+/** Display the program usage.
+ * @param String_Program_Name The program name.
+ */
+static void MainDisplayUsage(char *String_Program_Name)
+{
+	printf("Usage : %s Serial_Port [unit Unit_Address|all] Alarm_Hour Alarm_Minutes (set the time and the date from the computer clock, and the alarm)\n"
+		"  or    %s Serial_Port alarm Alarm_Hour Alarm_Minutes (set only the alarm, the clock time is not modified)\n"
+		"  or    %s Serial_Port time (set only the time from the computer clock)\n"
+		"  or    %s Serial_Port date (set only the date from the computer clock)\n"
+		"  or    %s Serial_Port update Field_Mask [Alarm_Hour Alarm_Minutes] (set the selected fields, the date and time ones from the computer clock ; the hexadecimal mask bits 0 to 6 select the seconds, minutes, hours, day of week, day, month and year, bit 7 selects the alarm)\n"
+		"  or    %s Serial_Port ringtone Ringtone_Index (select the alarm melody, index is in range [0;%d])\n"
+		"  or    %s Serial_Port crystal Turnover_Temperature Curvature Offset (set the RTC crystal curve the clock compensates its drift with : the frequency error in ppb is Offset - Curvature * (Temperature - Turnover_Temperature)^2, a typical crystal has a 25 degrees turnover temperature and a 34 ppb/degree^2 curvature)\n"
+		"  or    %s Serial_Port profile (display the firmware main loop profiler statistics)\n"
+		"  or    %s Serial_Port trace (display the firmware interrupt trace)\n"
+		"  or    %s Serial_Port flash Hex_File [Other_Serial_Port...] (update the firmware of one or more clocks through the bootloader, each clock must be alone on its line and have no address, or be power-cycled while flashing)\n"
+		"  or    %s Serial_Port address Unit_Address (set the address of a clock alone on its line, in range [1;%d], 0 removes the address ; a clock having an address ignores the frames without address, so use 'unit' to change its address)\n"
+		"  or    %s Serial_Port scan (display the addresses of all clocks sharing the line)\n"
+		"  or    %s Serial_Port daemon Socket_Path [Other_Serial_Port Other_Socket_Path...] (share the serial ports with other programs, give the socket path instead of the serial port to any other command)\n"
+		"  or    %s Socket_Path monitor (display all bytes sent by the clock served by a daemon)\n"
+		"  or    %s Serial_Port record Log_Directory (record the clock time offset, temperature and alarm state every second until the program is stopped)\n"
+		"  or    %s Log_Directory export Start End csv|json (write the recorded samples from Start to End excluded, the times are local and formatted as YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS)\n"
+		"  or    %s Log_Directory statistics Start End (display the lowest, highest and average temperature and the clock offset range from Start to End excluded)\n"
+		"All commands but flash and scan can be sent to a single clock of a shared line by inserting 'unit Unit_Address' after the serial port, or to all clocks with 'unit all' (the clocks do not answer).\n"
+		"Example : %s /dev/ttyUSB0 7 30\n"
+		"          %s /dev/ttyUSB0 unit all time\n"
+		"          %s Clock_Log statistics 2020-06-15 2020-06-22\n", String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name, MAIN_RINGTONES_COUNT - 1,
+		String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name, PROTOCOL_MAXIMUM_UNIT_ADDRESS, String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name,
+		String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name, String_Program_Name);
+}
+
+/** Open the serial port and close it automatically on program termination. The program exits if the port can't be opened.
+ * @param String_Serial_Port The serial port device, or the socket of the daemon serving the clock serial port. The program waits for the other daemon clients to terminate their commands.
+ */
+static void MainOpenSerialPort(char *String_Serial_Port)
+{
+	if (DaemonIsSocket(String_Serial_Port))
+	{
+		if (DaemonConnect(String_Serial_Port, 0) != 0) exit(EXIT_FAILURE);
+		Main_Is_Daemon_Used = 1;
+		atexit(MainExitDisconnectDaemon);
+		return;
+	}
+	
+	if (SerialPortOpen(String_Serial_Port, 19200, &Main_Serial_Port_ID) != 0)
+	{
+		printf("Error : failed to open the serial port '%s'.\n", String_Serial_Port);
+		exit(EXIT_FAILURE);
+	}
+	atexit(MainExitCloseSerialPort);
+}
+
+/** Block until a byte is received from the clock.
+ * @return The received byte.
+ */
+static unsigned char MainReceiveByte(void)
+{
+	if (Main_Is_Daemon_Used) return DaemonReadByte();
+	return SerialPortReadByte(Main_Serial_Port_ID);
+}
+
+/** Send a byte to the clock.
+ * @param Byte The byte to send.
+ */
+static void MainTransmitByte(unsigned char Byte)
+{
+	if (Main_Is_Daemon_Used) DaemonWriteByte(Byte);
+	else SerialPortWriteByte(Main_Serial_Port_ID, Byte);
+}
+
+/** Tell if a byte has been received from the clock or not.
+ * @return 1 if a byte is available to read,
+ * @return 0 if no byte was received.
+ */
+static int MainIsByteAvailable(void)
+{
+	if (Main_Is_Daemon_Used) return DaemonIsByteAvailable();
+	return SerialPortIsByteAvailable(Main_Serial_Port_ID);
+}
+
+/** Get the current time in milliseconds.
+ * @return The time.
+ */
+static long MainGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (Time.tv_sec * 1000) + (Time.tv_nsec / 1000000);
+}
+
+/** Wait for a byte from the clock.
+ * @param Timeout How many milliseconds to wait for the byte.
+ * @param Pointer_Byte On output, contain the received byte.
+ * @return 0 if a byte was received,
+ * @return -1 if the timeout expired.
+ */
+static int MainReadByte(int Timeout, unsigned char *Pointer_Byte)
+{
+	long Deadline;
+	
+	Deadline = MainGetTime() + Timeout;
+	while (!MainIsByteAvailable())
+	{
+		if (MainGetTime() >= Deadline) return -1;
+		usleep(1000);
+	}
+	*Pointer_Byte = MainReceiveByte();
+	return 0;
+}
+
+/** Send an encoded frame to the clock. The program exits if the frame could not be encoded.
+ * @param Pointer_Frame The frame.
+ * @param Size The frame size in bytes, a negative value tells that the encoding failed.
+ */
+static void MainTransmitFrame(unsigned char *Pointer_Frame, int Size)
+{
+	int i;
+	
+	if (Size < 0)
+	{
+		printf("Error : failed to encode the frame.\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < Size; i++) MainTransmitByte(Pointer_Frame[i]);
+}
+
+/** Send a command to the selected clock, prefixing it with the clock address if the line is shared.
+ * @param Command The command (or the magic number) to send.
+ */
+static void MainSendCommand(unsigned char Command)
+{
+	unsigned char Frame[PROTOCOL_MAXIMUM_FRAME_SIZE];
+	
+	MainTransmitFrame(Frame, ProtocolEncodeCommand(Main_Unit_Address, Command, Frame, sizeof(Frame)));
+}
+
+/** Send a command followed by its parameter to the selected clock.
+ * @param Command The command to send.
+ * @param Parameter The command parameter.
+ */
+static void MainSendParameterCommand(unsigned char Command, unsigned char Parameter)
+{
+	unsigned char Frame[PROTOCOL_MAXIMUM_FRAME_SIZE];
+	
+	MainTransmitFrame(Frame, ProtocolEncodeParameterCommand(Main_Unit_Address, Command, Parameter, Frame, sizeof(Frame)));
+}
+
+/** Wait for the clock to acknowledge a command. The program exits if an addressed clock does not answer. */
+static void MainWaitAcknowledge(void)
+{
+	unsigned char Byte;
+	
+	// Only a clock without address answers an unaddressed frame, it may be plugged later, so wait for it
+	if (Main_Unit_Address == PROTOCOL_NO_UNIT_ADDRESS)
+	{
+		while (MainReceiveByte() != PROTOCOL_MAGIC_NUMBER);
+		return;
+	}
+	
+	// No clock answers a broadcast frame
+	if (Main_Unit_Address == PROTOCOL_BROADCAST_ADDRESS) return;
+	
+	do
+	{
+		if (MainReadByte(MAIN_ANSWER_TIMEOUT, &Byte) != 0)
+		{
+			printf("Error : the clock %d did not answer.\n", Main_Unit_Address);
+			exit(EXIT_FAILURE);
+		}
+	} while (Byte != PROTOCOL_MAGIC_NUMBER);
+}
+
+/** Parse the alarm hour and minutes. The program exits if they are invalid.
+ * @param String_Hour The alarm hour string.
+ * @param String_Minutes The alarm minutes string.
+ * @param Pointer_Hour On output, contain the alarm hour.
+ * @param Pointer_Minutes On output, contain the alarm minutes.
+ */
+static void MainParseAlarm(char *String_Hour, char *String_Minutes, int *Pointer_Hour, int *Pointer_Minutes)
+{
+	int Result;
+	
+	// Alarm hour
+	Result = sscanf(String_Hour, "%d", Pointer_Hour);
+	if ((Result != 1) || !ProtocolIsFieldValid(PROTOCOL_FIELD_ALARM_HOUR, *Pointer_Hour))
+	{
+		printf("Error : the alarm hour must be in range [0;23].\n");
+		exit(EXIT_FAILURE);
+	}
+	// Alarm minutes
+	Result = sscanf(String_Minutes, "%d", Pointer_Minutes);
+	if ((Result != 1) || !ProtocolIsFieldValid(PROTOCOL_FIELD_ALARM_MINUTES, *Pointer_Minutes))
+	{
+		printf("Error : the alarm minutes must be in range [0;59].\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** Fill a configuration with the computer clock date and time and with the alarm.
+ * @param Pointer_Configuration On output, contain all configuration fields.
+ * @param Alarm_Hour The alarm hour.
+ * @param Alarm_Minutes The alarm minutes.
+ */
+static void MainGetConfiguration(TProtocolConfiguration *Pointer_Configuration, int Alarm_Hour, int Alarm_Minutes)
+{
+	time_t Time;
+	struct tm *Pointer_Converted_Time;
+	
+	// Get the current date and time now that all blocking operations are done (for a better accuracy)
+	Time = time(NULL);
+	Pointer_Converted_Time = localtime(&Time);
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_SECONDS] = Pointer_Converted_Time->tm_sec;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_MINUTES] = Pointer_Converted_Time->tm_min;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_HOURS] = Pointer_Converted_Time->tm_hour;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_DAY_OF_WEEK] = Pointer_Converted_Time->tm_wday + 1; // The day of the week starts from 1 on the RTC
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_DAY] = Pointer_Converted_Time->tm_mday;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_MONTH] = Pointer_Converted_Time->tm_mon + 1; // The month starts from 1 on the RTC
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_YEAR] = Pointer_Converted_Time->tm_year + 1900;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_ALARM_HOUR] = Alarm_Hour;
+	Pointer_Configuration->Fields[PROTOCOL_FIELD_ALARM_MINUTES] = Alarm_Minutes;
+}
+
+/** Update some configuration fields without stopping the clock.
+ * @param Command The configuration command to send.
+ * @param Field_Mask The fields the command updates.
+ * @param Alarm_Hour The alarm hour, it is used only if the alarm is selected.
+ * @param Alarm_Minutes The alarm minutes, they are used only if the alarm is selected.
+ * @return EXIT_SUCCESS.
+ */
+static int MainUpdateConfigurationFields(unsigned char Command, unsigned char Field_Mask, int Alarm_Hour, int Alarm_Minutes)
+{
+	TProtocolConfiguration Configuration;
+	unsigned char Frame[PROTOCOL_MAXIMUM_FRAME_SIZE];
+	
+	// The whole frame is sent at once, the clock does not acknowledge the command before the fields
+	MainGetConfiguration(&Configuration, Alarm_Hour, Alarm_Minutes);
+	MainTransmitFrame(Frame, ProtocolEncodeConfigurationFrame(Main_Unit_Address, Command, Field_Mask, &Configuration, Frame, sizeof(Frame)));
+	
+	// Wait for the clock answer
+	MainWaitAcknowledge();
+	printf("The clock is successfully updated.\n");
+	
+	return EXIT_SUCCESS;
+}
+
+/** Receive a 16-bit value sent most significant byte first by the clock.
+ * @return The received value.
+ */
+static unsigned int MainReceiveWord(void)
+{
+	unsigned int Word;
+	
+	Word = MainReceiveByte() << 8;
+	Word |= MainReceiveByte();
+	return Word;
+}
+
+/** Retrieve the main loop profiler statistics from the clock and display them. The clock firmware must be built with the profiler enabled.
+ * @return EXIT_SUCCESS.
+ */
+static int MainDisplayProfilerStatistics(void)
+{
+	static char *String_Phase_Names[] =
+	{
+		"UART configuration",
+		"RTC read",
+		"Display",
+		"Temperature",
+		"Alarm",
+		"RTC write"
+	};
+	int Phases_Count, i;
+	unsigned int Last, Minimum, Maximum;
+	
+	MainSendCommand(PROTOCOL_COMMAND_GET_PROFILER_STATISTICS);
+	
+	// The phases count is sent first, so the program can still display something if the firmware adds more phases
+	Phases_Count = MainReceiveByte();
+	printf("%-20s %10s %10s %10s (time base increments, 1 us at 4MHz, 0.4 us at 20MHz)\n", "Phase", "Last", "Minimum", "Maximum");
+	for (i = 0; i < Phases_Count; i++)
+	{
+		Last = MainReceiveWord();
+		Minimum = MainReceiveWord();
+		Maximum = MainReceiveWord();
+		if (i < (int) (sizeof(String_Phase_Names) / sizeof(String_Phase_Names[0]))) printf("%-20s ", String_Phase_Names[i]);
+		else printf("Phase %-14d ", i);
+		printf("%10u %10u %10u\n", Last, Minimum, Maximum);
+	}
+	printf("Overrun main loop iterations : %u\n", MainReceiveWord());
+	
+	return EXIT_SUCCESS;
+}
+
+/** Receive an interrupt trace entry and display it. */
+static void MainDisplayInterruptTraceEntry(void)
+{
+	static char *String_Source_Names[] =
+	{
+		"system tick",
+		"temperature sensor",
+		"UART"
+	};
+	int Sources, Served_Sources, Served_Sources_Count, Source, Entry_Time, Duration, i;
+	
+	Sources = MainReceiveByte();
+	Served_Sources = MainReceiveWord();
+	Entry_Time = MainReceiveWord();
+	Duration = MainReceiveWord();
+	
+	printf("entry time %5d, duration %5d, pending :", Entry_Time, Duration);
+	for (i = 0; i < 3; i++)
+	{
+		if (Sources & (1 << i)) printf(" %s", String_Source_Names[i]);
+	}
+	printf(", served :");
+	Served_Sources_Count = Sources >> 5;
+	for (i = 0; i < Served_Sources_Count; i++)
+	{
+		Source = (Served_Sources >> (i * 3)) & 0x07;
+		if (Source < 3) printf(" %s", String_Source_Names[Source]);
+		else printf(" unknown");
+	}
+	putchar('\n');
+}
+
+/** Retrieve the interrupt trace from the clock and display it. The clock firmware must be built with the interrupt trace enabled.
+ * @return EXIT_SUCCESS.
+ */
+static int MainDisplayInterruptTrace(void)
+{
+	int Entries_Count, i;
+	
+	MainSendCommand(PROTOCOL_COMMAND_GET_INTERRUPT_TRACE);
+	
+	// Display the trace from the oldest entry
+	Entries_Count = MainReceiveByte();
+	printf("Last %d interrupts (times in time base increments, 1 us at 4MHz, 0.4 us at 20MHz) :\n", Entries_Count);
+	for (i = 0; i < Entries_Count; i++)
+	{
+		printf("%2d : ", i);
+		MainDisplayInterruptTraceEntry();
+	}
+	
+	// Display worst cases
+	printf("Longest interrupt : ");
+	MainDisplayInterruptTraceEntry();
+	printf("Worst system tick interrupt entry latency : %u\n", MainReceiveWord());
+	
+	return EXIT_SUCCESS;
+}
+
+/** Select the melody the clock will play when the alarm rings.
+ * @param Ringtone The ringtone index.
+ * @return EXIT_SUCCESS.
+ */
+static int MainSetRingtone(int Ringtone)
+{
+	MainSendParameterCommand(PROTOCOL_COMMAND_SET_RINGTONE, (unsigned char) Ringtone);
+	
+	// Wait for the clock answer
+	MainWaitAcknowledge();
+	printf("The ringtone is successfully set.\n");
+	
+	return EXIT_SUCCESS;
+}
+
+/** Set the RTC crystal frequency curve, the clock uses it to compensate the drift caused by the temperature.
+ * @param Turnover_Temperature The temperature the crystal runs the fastest at, in centigrade degrees.
+ * @param Curvature How fast the crystal slows down away from its turnover temperature, in ppb per squared centigrade degree.
+ * @param Offset The crystal frequency error at its turnover temperature in ppb.
+ * @return EXIT_SUCCESS.
  */
-static unsigned char MainConvertBinaryNumberToBCD(int Number)
+static int MainSetCrystalCurve(int Turnover_Temperature, int Curvature, int Offset)
 {
-	int Tens, Units;
+	unsigned char Frame[PROTOCOL_MAXIMUM_FRAME_SIZE];
 	
-	// Make sure the number can be represented on 1-byte BCD
-	if ((Number < 0) || (Number > 99))
+	MainTransmitFrame(Frame, ProtocolEncodeCrystalCurve(Main_Unit_Address, Turnover_Temperature, Curvature, Offset, Frame, sizeof(Frame)));
+	
+	// Wait for the clock answer
+	MainWaitAcknowledge();
+	printf("The crystal curve is successfully set.\n");
+	
+	return EXIT_SUCCESS;
+}
+
+/** Set the address the clock answers to on a shared line. The clock must have no address and be alone on its line, or be addressed by its current address.
+ * @param Unit_Address The new address.
+ * @return EXIT_SUCCESS.
+ */
+static int MainSetUnitAddress(int Unit_Address)
+{
+	MainSendParameterCommand(PROTOCOL_COMMAND_SET_UNIT_ADDRESS, (unsigned char) Unit_Address);
+	
+	// Wait for the clock answer
+	MainWaitAcknowledge();
+	printf("The unit address is successfully set.\n");
+	
+	return EXIT_SUCCESS;
+}
+
+/** Display all bytes sent by the clock, whatever program the clock answers to.
+ * @param String_Socket_Path The socket of the daemon serving the clock serial port.
+ * @return EXIT_FAILURE if the daemon can't be reached, the function never returns otherwise.
+ */
+static int MainMonitor(char *String_Socket_Path)
+{
+	unsigned char Byte;
+	
+	if (DaemonConnect(String_Socket_Path, 1) != 0) return EXIT_FAILURE;
+	Main_Is_Daemon_Used = 1;
+	
+	// Display a line per burst of bytes, so each clock answer is easy to spot
+	while (1)
 	{
-		printf("[%s] Error : the number %d can't be converted to 1-byte BCD.\n", __func__, Number);
+		printf("%02X", MainReceiveByte());
+		while (MainReadByte(MAIN_MONITOR_BURST_END_TIMEOUT, &Byte) == 0) printf(" %02X", Byte);
+		putchar('\n');
+		fflush(stdout);
+	}
+}
+
+/** Find all clocks sharing the line by asking each address in turn, so the clocks never answer at the same time.
+ * @return EXIT_SUCCESS if at least one clock was found,
+ * @return EXIT_FAILURE if no clock answered.
+ */
+static int MainScanUnits(void)
+{
+	int Unit_Address, Units_Count = 0;
+	unsigned char Byte;
+	
+	for (Unit_Address = 1; Unit_Address <= PROTOCOL_MAXIMUM_UNIT_ADDRESS; Unit_Address++)
+	{
+		Main_Unit_Address = Unit_Address;
+		MainSendCommand(PROTOCOL_COMMAND_GET_UNIT_ADDRESS);
+		
+		// A clock answers with its address
+		if ((MainReadByte(MAIN_SCAN_ANSWER_TIMEOUT, &Byte) == 0) && (Byte == Unit_Address))
+		{
+			printf("Clock found at address %d.\n", Unit_Address);
+			Units_Count++;
+		}
+	}
+	
+	printf("%d clock(s) found.\n", Units_Count);
+	if (Units_Count == 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/** Convert the date and time reported by the clock to a computer time.
+ * @param Pointer_Configuration The clock date and time fields, they are the computer local time.
+ * @return The time in seconds since the Unix epoch.
+ */
+static time_t MainConvertClockTime(TProtocolConfiguration *Pointer_Configuration)
+{
+	struct tm Time;
+	
+	memset(&Time, 0, sizeof(Time));
+	Time.tm_sec = Pointer_Configuration->Fields[PROTOCOL_FIELD_SECONDS];
+	Time.tm_min = Pointer_Configuration->Fields[PROTOCOL_FIELD_MINUTES];
+	Time.tm_hour = Pointer_Configuration->Fields[PROTOCOL_FIELD_HOURS];
+	Time.tm_mday = Pointer_Configuration->Fields[PROTOCOL_FIELD_DAY];
+	Time.tm_mon = Pointer_Configuration->Fields[PROTOCOL_FIELD_MONTH] - 1;
+	Time.tm_year = Pointer_Configuration->Fields[PROTOCOL_FIELD_YEAR] - 1900;
+	Time.tm_isdst = -1; // Let the C library tell whether daylight saving time applies
+	return mktime(&Time);
+}
+
+/** Ask the clock its telemetry every second and append it to a log, until the program is stopped. When the clock is served by a daemon, the line is only owned during each request so the other programs can use the clock in between.
+ * @param String_Serial_Port The serial port device, or the socket of the daemon serving the clock serial port.
+ * @param String_Directory The log directory.
+ * @return EXIT_FAILURE if the log can't be written or the daemon can't be reached, the function never returns otherwise.
+ */
+static int MainRecord(char *String_Serial_Port, char *String_Directory)
+{
+	int Is_Daemon_Socket, Size, Errors_Count = 0, Previous_Sequence_Number = -1, Unchanged_Sequence_Numbers_Count = 0;
+	unsigned char Answer[PROTOCOL_TELEMETRY_SIZE];
+	struct timespec Time;
+	TProtocolTelemetry Telemetry;
+	TRecorderSample Sample;
+	long long Offset;
+	
+	if (RecorderOpen(String_Directory) != 0) return EXIT_FAILURE;
+	Is_Daemon_Socket = DaemonIsSocket(String_Serial_Port);
+	if (!Is_Daemon_Socket) MainOpenSerialPort(String_Serial_Port);
+	printf("Recording the clock telemetry to '%s', stop the program to end the recording.\n", String_Directory);
+	fflush(stdout);
+	
+	while (1)
+	{
+		// Ask the clock right after a computer second starts, so the clock offset computed from whole seconds is accurate
+		clock_gettime(CLOCK_REALTIME, &Time);
+		usleep((MAIN_RECORD_PERIOD * 1000) - (Time.tv_nsec / 1000));
+		
+		if (Is_Daemon_Socket)
+		{
+			if (DaemonConnect(String_Serial_Port, 0) != 0) return EXIT_FAILURE;
+			Main_Is_Daemon_Used = 1;
+		}
+		
+		// Drop a late answer to a previous request
+		while (MainIsByteAvailable()) MainReceiveByte();
+		
+		clock_gettime(CLOCK_REALTIME, &Time);
+		MainSendCommand(PROTOCOL_COMMAND_GET_TELEMETRY);
+		for (Size = 0; Size < PROTOCOL_TELEMETRY_SIZE; Size++)
+		{
+			if (MainReadByte(MAIN_ANSWER_TIMEOUT, &Answer[Size]) != 0) break;
+		}
+		
+		if (Is_Daemon_Socket)
+		{
+			DaemonDisconnect();
+			Main_Is_Daemon_Used = 0;
+		}
+		
+		// Keep recording when the clock is unplugged for a while
+		if (ProtocolDecodeTelemetry(Answer, Size, &Telemetry) <= 0)
+		{
+			Errors_Count++;
+			printf("Warning : no valid telemetry received (%d error(s) since the recording started).\n", Errors_Count);
+			fflush(stdout);
+			continue;
+		}
+		
+		// The clock publishes its status on each tick, a status that is not updated anymore holds an old time and must not be recorded
+		if (Telemetry.Sequence_Number == Previous_Sequence_Number) Unchanged_Sequence_Numbers_Count++;
+		else Unchanged_Sequence_Numbers_Count = 0;
+		Previous_Sequence_Number = Telemetry.Sequence_Number;
+		if (Unchanged_Sequence_Numbers_Count >= MAIN_RECORD_MAXIMUM_UNCHANGED_SEQUENCE_NUMBERS)
+		{
+			Errors_Count++;
+			printf("Warning : the clock telemetry is stale, the clock did not tick for %d seconds (%d error(s) since the recording started).\n", Unchanged_Sequence_Numbers_Count, Errors_Count);
+			fflush(stdout);
+			continue;
+		}
+		
+		Sample.Time = ((long long) Time.tv_sec * 1000) + (Time.tv_nsec / 1000000);
+		// The clock tells when it received the request within its second, so the offset can be rounded to the nearest second instead of being truncated
+		Offset = (long long) (MainConvertClockTime(&Telemetry.Clock) - Time.tv_sec) * 1000;
+		if (Telemetry.Request_Timestamp != PROTOCOL_NO_TIMESTAMP) Offset += Telemetry.Request_Timestamp - (Time.tv_nsec / 1000000) + 500;
+		if (Offset < 0) Offset -= 999; // Round toward minus infinity
+		Sample.Clock_Offset = (int) (Offset / 1000);
+		Sample.Temperature = Telemetry.Temperature;
+		Sample.Flags = Telemetry.Flags;
+		if (RecorderAppend(&Sample) < 0) return EXIT_FAILURE;
+	}
+}
+
+/** Parse a local time given on the command line. The program exits if it is invalid.
+ * @param String_Time The time, formatted as YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS.
+ * @return The time in milliseconds since the Unix epoch.
+ */
+static long long MainParseLogTime(char *String_Time)
+{
+	struct tm Time;
+	int Result;
+	char Character;
+	time_t Seconds;
+	
+	memset(&Time, 0, sizeof(Time));
+	Result = sscanf(String_Time, "%d-%d-%d%c%d:%d:%d", &Time.tm_year, &Time.tm_mon, &Time.tm_mday, &Character, &Time.tm_hour, &Time.tm_min, &Time.tm_sec);
+	if (((Result != 3) && ((Result != 7) || (Character != 'T'))) || (Time.tm_mon < 1) || (Time.tm_mon > 12) || (Time.tm_mday < 1) || (Time.tm_mday > 31) || (Time.tm_hour > 23) || (Time.tm_min > 59) || (Time.tm_sec > 59))
+	{
+		printf("Error : '%s' is not a valid time, it must be formatted as YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS.\n", String_Time);
 		exit(EXIT_FAILURE);
 	}
 	
-	Tens = Number / 10;
-	Units = Number - (Tens * 10);
+	Time.tm_year -= 1900;
+	Time.tm_mon--;
+	Time.tm_isdst = -1;
+	Seconds = mktime(&Time);
+	return (long long) Seconds * 1000;
+}
+
+/** Write the recorded samples of a time range to the standard output.
+ * @param String_Directory The log directory.
+ * @param String_Start_Time The range start.
+ * @param String_End_Time The range end.
+ * @param String_Format The output format, "csv" or "json".
+ * @return EXIT_SUCCESS if the samples were exported,
+ * @return EXIT_FAILURE if an error occurred.
+ */
+static int MainExportLog(char *String_Directory, char *String_Start_Time, char *String_End_Time, char *String_Format)
+{
+	TRecorderFormat Format;
+	long long Start_Time, End_Time;
 	
-	return (unsigned char) ((Tens << 4) | Units);
+	if (strcmp(String_Format, "csv") == 0) Format = RECORDER_FORMAT_CSV;
+	else if (strcmp(String_Format, "json") == 0) Format = RECORDER_FORMAT_JSON;
+	else
+	{
+		printf("Error : the export format must be 'csv' or 'json'.\n");
+		return EXIT_FAILURE;
+	}
+	Start_Time = MainParseLogTime(String_Start_Time);
+	End_Time = MainParseLogTime(String_End_Time);
+	
+	if (RecorderExport(String_Directory, Start_Time, End_Time, Format, stdout) < 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/** Display the statistics of the recorded samples of a time range.
+ * @param String_Directory The log directory.
+ * @param String_Start_Time The range start.
+ * @param String_End_Time The range end.
+ * @return EXIT_SUCCESS if the statistics were displayed,
+ * @return EXIT_FAILURE if an error occurred or if there is no sample in the range.
+ */
+static int MainDisplayLogStatistics(char *String_Directory, char *String_Start_Time, char *String_End_Time)
+{
+	TRecorderStatistics Statistics;
+	char String_Time[64];
+	time_t Seconds;
+	
+	if (RecorderComputeStatistics(String_Directory, MainParseLogTime(String_Start_Time), MainParseLogTime(String_End_Time), &Statistics) != 0) return EXIT_FAILURE;
+	if (Statistics.Samples_Count == 0)
+	{
+		printf("No sample was recorded in this range.\n");
+		return EXIT_FAILURE;
+	}
+	
+	printf("Samples : %lld\n", Statistics.Samples_Count);
+	Seconds = (time_t) (Statistics.Minimum_Temperature_Sample.Time / 1000);
+	strftime(String_Time, sizeof(String_Time), "%Y-%m-%d %H:%M:%S", localtime(&Seconds));
+	printf("Lowest temperature : %d degrees (%s)\n", Statistics.Minimum_Temperature_Sample.Temperature, String_Time);
+	Seconds = (time_t) (Statistics.Maximum_Temperature_Sample.Time / 1000);
+	strftime(String_Time, sizeof(String_Time), "%Y-%m-%d %H:%M:%S", localtime(&Seconds));
+	printf("Highest temperature : %d degrees (%s)\n", Statistics.Maximum_Temperature_Sample.Temperature, String_Time);
+	printf("Average temperature : %.1f degrees\n", Statistics.Average_Temperature);
+	printf("Clock offset : from %ds to %ds\n", Statistics.Minimum_Clock_Offset, Statistics.Maximum_Clock_Offset);
+	
+	return EXIT_SUCCESS;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -56,82 +697,241 @@ static unsigned char MainConvertBinaryNumberToBCD(int Number)
 //-------------------------------------------------------------------------------------------------
 int main(int argc, char *argv[])
 {
-	char *String_Serial_Port;
-	int Result, Alarm_Hour, Alarm_Minutes;
-	time_t Time;
-	struct tm *Pointer_Converted_Time;
+	char *String_Serial_Port, **String_Socket_Paths;
+	int Result, Alarm_Hour = 0, Alarm_Minutes = 0, Ringtone, Unit_Address, Turnover_Temperature, Curvature, Offset, i;
+	unsigned int Field_Mask;
+	TProtocolConfiguration Configuration;
+	unsigned char Frame[PROTOCOL_MAXIMUM_FRAME_SIZE];
 	
 	// Check parameters
-	if (argc != 4)
+	if (argc < 3)
 	{
-		printf("Error : bad arguments.\n"
-			"Usage : %s Serial_Port Alarm_Hour Alarm_Minutes\n"
-			"Example : %s /dev/ttyUSB0 7 30\n", argv[0], argv[0]);
+		printf("Error : bad arguments.\n");
+		MainDisplayUsage(argv[0]);
 		return EXIT_FAILURE;
 	}
 	
 	// Extract parameters
 	// Serial port
 	String_Serial_Port = argv[1];
-	// Alarm hour
-	Result = sscanf(argv[2], "%d", &Alarm_Hour);
-	if ((Result != 1) || (Alarm_Hour < 0) || (Alarm_Hour > 23))
+	
+	// Serve the clocks to the other programs
+	if ((argc >= 4) && ((argc % 2) == 0) && (strcmp(argv[2], "daemon") == 0))
 	{
-		printf("Error : the alarm hour must be in range [0;23].\n");
+		String_Socket_Paths = malloc(((argc - 2) / 2) * sizeof(char *));
+		if (String_Socket_Paths == NULL)
+		{
+			printf("Error : not enough memory.\n");
+			return EXIT_FAILURE;
+		}
+		
+		// Gather all serial ports and sockets
+		argv[2] = String_Serial_Port;
+		for (i = 0; i < (argc - 2) / 2; i++)
+		{
+			argv[2 + i] = argv[2 + (2 * i)];
+			String_Socket_Paths[i] = argv[3 + (2 * i)];
+		}
+		DaemonServe(&argv[2], String_Socket_Paths, (argc - 2) / 2);
 		return EXIT_FAILURE;
 	}
-	// Alarm minutes
-	Result = sscanf(argv[3], "%d", &Alarm_Minutes);
-	if ((Result != 1) || (Alarm_Minutes < 0) || (Alarm_Minutes > 59))
+	if ((argc == 3) && (strcmp(argv[2], "monitor") == 0))
 	{
-		printf("Error : the alarm minutes must be in range [0;59].\n");
+		if (!DaemonIsSocket(String_Serial_Port))
+		{
+			printf("Error : '%s' is not a daemon socket.\n", String_Serial_Port);
+			return EXIT_FAILURE;
+		}
+		return MainMonitor(String_Serial_Port);
+	}
+	
+	// Read the recorded samples, the clock is not needed
+	if ((argc == 6) && (strcmp(argv[2], "export") == 0)) return MainExportLog(argv[1], argv[3], argv[4], argv[5]);
+	if ((argc == 5) && (strcmp(argv[2], "statistics") == 0)) return MainDisplayLogStatistics(argv[1], argv[3], argv[4]);
+	
+	// Select a clock of a shared line, the following arguments are handled as if the clock was alone on its line
+	if ((argc >= 5) && (strcmp(argv[2], "unit") == 0))
+	{
+		if (strcmp(argv[3], "all") == 0) Main_Unit_Address = PROTOCOL_BROADCAST_ADDRESS;
+		else
+		{
+			Result = sscanf(argv[3], "%d", &Main_Unit_Address);
+			if ((Result != 1) || (Main_Unit_Address < 1) || (Main_Unit_Address > PROTOCOL_MAXIMUM_UNIT_ADDRESS))
+			{
+				printf("Error : the unit address must be in range [1;%d], or 'all'.\n", PROTOCOL_MAXIMUM_UNIT_ADDRESS);
+				return EXIT_FAILURE;
+			}
+		}
+		
+		argv[2] = argv[0];
+		argv[3] = String_Serial_Port;
+		argv += 2;
+		argc -= 2;
+	}
+	
+	// Handle the shared line commands
+	if ((argc == 3) && (strcmp(argv[2], "scan") == 0) && (Main_Unit_Address == PROTOCOL_NO_UNIT_ADDRESS))
+	{
+		MainOpenSerialPort(String_Serial_Port);
+		return MainScanUnits();
+	}
+	if ((argc == 4) && (strcmp(argv[2], "address") == 0))
+	{
+		Result = sscanf(argv[3], "%d", &Unit_Address);
+		if ((Result != 1) || (Unit_Address < 0) || (Unit_Address > PROTOCOL_MAXIMUM_UNIT_ADDRESS))
+		{
+			printf("Error : the unit address must be in range [0;%d].\n", PROTOCOL_MAXIMUM_UNIT_ADDRESS);
+			return EXIT_FAILURE;
+		}
+		
+		MainOpenSerialPort(String_Serial_Port);
+		return MainSetUnitAddress(Unit_Address);
+	}
+	
+	// Commands receiving data can't be broadcast, as all clocks would answer at the same time
+	if ((Main_Unit_Address == PROTOCOL_BROADCAST_ADDRESS) && ((strcmp(argv[2], "profile") == 0) || (strcmp(argv[2], "trace") == 0) || (strcmp(argv[2], "record") == 0)))
+	{
+		printf("Error : this command must be sent to a single clock.\n");
 		return EXIT_FAILURE;
 	}
 	
-	// Try to open the serial port
-	if (SerialPortOpen(String_Serial_Port, 19200, &Main_Serial_Port_ID) != 0)
+	// Handle the commands that do not configure the time
+	if ((argc == 3) && (strcmp(argv[2], "profile") == 0))
 	{
-		printf("Error : failed to open the serial port '%s'.\n", String_Serial_Port);
+		MainOpenSerialPort(String_Serial_Port);
+		return MainDisplayProfilerStatistics();
+	}
+	if ((argc == 3) && (strcmp(argv[2], "trace") == 0))
+	{
+		MainOpenSerialPort(String_Serial_Port);
+		return MainDisplayInterruptTrace();
+	}
+	if ((argc == 4) && (strcmp(argv[2], "record") == 0)) return MainRecord(String_Serial_Port, argv[3]);
+	if ((argc >= 4) && (strcmp(argv[2], "flash") == 0) && (Main_Unit_Address == PROTOCOL_NO_UNIT_ADDRESS))
+	{
+		if (FlasherLoadFirmware(argv[3]) != 0) return EXIT_FAILURE;
+		
+		// Gather all serial ports, the bootloader timings do not allow sharing them through the daemon
+		argv[3] = String_Serial_Port;
+		for (i = 3; i < argc; i++)
+		{
+			if (DaemonIsSocket(argv[i]))
+			{
+				printf("Error : the firmware can't be updated through the daemon, stop it to flash the clock served on '%s'.\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		if (FlasherFlash(&argv[3], argc - 3) != 0) return EXIT_FAILURE;
+		return EXIT_SUCCESS;
+	}
+	if ((argc == 4) && (strcmp(argv[2], "ringtone") == 0))
+	{
+		Result = sscanf(argv[3], "%d", &Ringtone);
+		if ((Result != 1) || (Ringtone < 0) || (Ringtone >= MAIN_RINGTONES_COUNT))
+		{
+			printf("Error : the ringtone index must be in range [0;%d].\n", MAIN_RINGTONES_COUNT - 1);
+			return EXIT_FAILURE;
+		}
+		
+		MainOpenSerialPort(String_Serial_Port);
+		return MainSetRingtone(Ringtone);
+	}
+	
+	if ((argc == 6) && (strcmp(argv[2], "crystal") == 0))
+	{
+		Result = sscanf(argv[3], "%d", &Turnover_Temperature);
+		if ((Result != 1) || (Turnover_Temperature < 0) || (Turnover_Temperature > PROTOCOL_MAXIMUM_CRYSTAL_TURNOVER_TEMPERATURE))
+		{
+			printf("Error : the turnover temperature must be in range [0;%d].\n", PROTOCOL_MAXIMUM_CRYSTAL_TURNOVER_TEMPERATURE);
+			return EXIT_FAILURE;
+		}
+		Result = sscanf(argv[4], "%d", &Curvature);
+		if ((Result != 1) || (Curvature < 0) || (Curvature > PROTOCOL_MAXIMUM_CRYSTAL_CURVATURE))
+		{
+			printf("Error : the curvature must be in range [0;%d].\n", PROTOCOL_MAXIMUM_CRYSTAL_CURVATURE);
+			return EXIT_FAILURE;
+		}
+		Result = sscanf(argv[5], "%d", &Offset);
+		if ((Result != 1) || (Offset < -PROTOCOL_MAXIMUM_CRYSTAL_OFFSET) || (Offset > PROTOCOL_MAXIMUM_CRYSTAL_OFFSET))
+		{
+			printf("Error : the offset must be in range [%d;%d].\n", -PROTOCOL_MAXIMUM_CRYSTAL_OFFSET, PROTOCOL_MAXIMUM_CRYSTAL_OFFSET);
+			return EXIT_FAILURE;
+		}
+		
+		MainOpenSerialPort(String_Serial_Port);
+		return MainSetCrystalCurve(Turnover_Temperature, Curvature, Offset);
+	}
+	
+	// Handle the partial updates, they do not stop the clock
+	if ((argc == 5) && (strcmp(argv[2], "alarm") == 0))
+	{
+		MainParseAlarm(argv[3], argv[4], &Alarm_Hour, &Alarm_Minutes);
+		MainOpenSerialPort(String_Serial_Port);
+		return MainUpdateConfigurationFields(PROTOCOL_COMMAND_SET_ALARM, PROTOCOL_FIELD_MASK_ALARM, Alarm_Hour, Alarm_Minutes);
+	}
+	if ((argc == 3) && (strcmp(argv[2], "time") == 0))
+	{
+		MainOpenSerialPort(String_Serial_Port);
+		return MainUpdateConfigurationFields(PROTOCOL_COMMAND_SET_TIME, PROTOCOL_FIELD_MASK_TIME, 0, 0);
+	}
+	if ((argc == 3) && (strcmp(argv[2], "date") == 0))
+	{
+		MainOpenSerialPort(String_Serial_Port);
+		return MainUpdateConfigurationFields(PROTOCOL_COMMAND_SET_DATE, PROTOCOL_FIELD_MASK_DATE, 0, 0);
+	}
+	if (((argc == 4) || (argc == 6)) && (strcmp(argv[2], "update") == 0))
+	{
+		Result = sscanf(argv[3], "%x", &Field_Mask);
+		if ((Result != 1) || (Field_Mask > 0xFF))
+		{
+			printf("Error : the field mask must be an hexadecimal number in range [0;FF].\n");
+			return EXIT_FAILURE;
+		}
+		
+		// The alarm must be provided if it is selected
+		if (Field_Mask & PROTOCOL_FIELD_MASK_ALARM)
+		{
+			if (argc != 6)
+			{
+				printf("Error : the alarm hour and minutes must be provided when the alarm field is selected.\n");
+				return EXIT_FAILURE;
+			}
+			MainParseAlarm(argv[4], argv[5], &Alarm_Hour, &Alarm_Minutes);
+		}
+		
+		MainOpenSerialPort(String_Serial_Port);
+		return MainUpdateConfigurationFields(PROTOCOL_COMMAND_SET_FIELDS, (unsigned char) Field_Mask, Alarm_Hour, Alarm_Minutes);
+	}
+	
+	// Configure the time, date and alarm
+	if (argc != 4)
+	{
+		printf("Error : bad arguments.\n");
+		MainDisplayUsage(argv[0]);
 		return EXIT_FAILURE;
 	}
-	atexit(MainExitCloseSerialPort);
+	
+	MainParseAlarm(argv[2], argv[3], &Alarm_Hour, &Alarm_Minutes);
+	
+	// Try to open the serial port
+	MainOpenSerialPort(String_Serial_Port);
 	
 	// Connect to the clock
 	// Send the magic number to tell the clock that data will be sent
 	printf("Connecting to the clock...");
 	fflush(stdout);
-	SerialPortWriteByte(Main_Serial_Port_ID, MAIN_UART_PROTOCOL_MAGIC_NUMBER);
+	MainSendCommand(PROTOCOL_MAGIC_NUMBER);
 	// Wait for the answer
-	while (SerialPortReadByte(Main_Serial_Port_ID) != MAIN_UART_PROTOCOL_MAGIC_NUMBER);
+	MainWaitAcknowledge();
 	printf(" connected.\n");
 	
-	// Get the current date and time now that all blocking operations are done (for a better accuracy)
-	Time = time(NULL);
-	Pointer_Converted_Time = localtime(&Time);
-	
 	printf("Sending data...");
 	fflush(stdout);
-	// Send seconds
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_sec));
-	// Send minutes
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_min));
-	// Send hours
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_hour));
-	// Send the day of the week (starting from 1 on the RTC)
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_wday + 1));
-	// Send the day of the month
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_mday));
-	// Send the month (starting from 1 on the RTC)
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_mon + 1));
-	// Send the year (starting from 2000 on the RTC)
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Pointer_Converted_Time->tm_year - 100));
-	// Send alarm hour
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Alarm_Hour));
-	// Send alarm minutes
-	SerialPortWriteByte(Main_Serial_Port_ID, MainConvertBinaryNumberToBCD(Alarm_Minutes));
+	MainGetConfiguration(&Configuration, Alarm_Hour, Alarm_Minutes);
+	MainTransmitFrame(Frame, ProtocolEncodeConfigurationFields(PROTOCOL_FIELD_MASK_TIME | PROTOCOL_FIELD_MASK_DATE | PROTOCOL_FIELD_MASK_ALARM, &Configuration, Frame, sizeof(Frame)));
 	
 	// Wait for the clock answer
-	while (SerialPortReadByte(Main_Serial_Port_ID) != MAIN_UART_PROTOCOL_MAGIC_NUMBER);
+	MainWaitAcknowledge();
 	printf(" done.\nThe clock is successfully configured. You can unplug the cable.\n");
 	
 	return EXIT_SUCCESS;
@@ -0,0 +1,504 @@
+/** @file Recorder.c
+ * @see Recorder.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include "Protocol.h"
+#include "Recorder.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Identify a segment file. */
+#define RECORDER_SEGMENT_MAGIC_NUMBER "CLKT"
+/** The segment format version, increment it when the header or the record layout change. */
+#define RECORDER_SEGMENT_FORMAT_VERSION 1
+
+/** How long a segment lasts, in milliseconds. */
+#define RECORDER_SEGMENT_DURATION (24LL * 3600 * 1000)
+
+/** The size of a formatted sample time buffer in bytes, it is large enough for any date. */
+#define RECORDER_TIME_STRING_SIZE 64
+
+/** The biggest segment file name size in bytes, including the terminating zero. */
+#define RECORDER_FILE_NAME_MAXIMUM_SIZE 4096
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** The segment file header. */
+typedef struct
+{
+	char Magic_Number[4]; //!< Always RECORDER_SEGMENT_MAGIC_NUMBER, without terminating zero.
+	uint8_t Format_Version; //!< Always RECORDER_SEGMENT_FORMAT_VERSION.
+	uint8_t Record_Size; //!< The size of a record in bytes, so a reader can check it understands the records.
+	uint16_t Reserved; //!< Keep the start time aligned, always 0.
+	int64_t Start_Time; //!< The segment start in milliseconds since the Unix epoch, a UTC day start.
+} TRecorderSegmentHeader;
+
+/** A sample as it is stored in a segment. */
+typedef struct
+{
+	uint32_t Time_Delta; //!< The sample time minus the segment start time, in milliseconds.
+	int16_t Clock_Offset; //!< The clock time minus the computer local time, in seconds.
+	int8_t Temperature; //!< The temperature in centigrade degrees.
+	uint8_t Flags; //!< The PROTOCOL_TELEMETRY_FLAG_xxx values OR'ed.
+} TRecorderRecord;
+
+/** A segment mapped in memory for reading. */
+typedef struct
+{
+	void *Pointer_Mapping; //!< The whole file mapping, NULL if the segment does not exist.
+	size_t Mapping_Size; //!< The file size in bytes.
+	long long Start_Time; //!< The segment start time.
+	TRecorderRecord *Pointer_Records; //!< The first record.
+	long long Records_Count; //!< How many whole records the segment contains.
+} TRecorderMappedSegment;
+
+/** Called for each sample of a time range, in chronological order.
+ * @param Pointer_Sample The sample.
+ * @param Pointer_Context The data the handler works with.
+ */
+typedef void (*TRecorderSampleHandler)(TRecorderSample *Pointer_Sample, void *Pointer_Context);
+
+/** The data the export handlers work with. */
+typedef struct
+{
+	FILE *Pointer_File; //!< The output file.
+	long long Samples_Count; //!< How many samples were written.
+} TRecorderExportContext;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The log directory samples are recorded to. */
+static char *Recorder_String_Directory;
+/** The segment samples are appended to, -1 when no segment is opened. */
+static int Recorder_Segment_File_Descriptor = -1;
+/** The start time of the opened segment. */
+static long long Recorder_Segment_Start_Time;
+/** The time of the last recorded sample, -1 if the opened segment is empty. */
+static long long Recorder_Last_Sample_Time = -1;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the start of the segment a time belongs to.
+ * @param Time The time in milliseconds since the Unix epoch.
+ * @return The segment start time.
+ */
+static long long RecorderGetSegmentStartTime(long long Time)
+{
+	long long Start_Time;
+	
+	// Round toward minus infinity, the division rounds toward zero
+	Start_Time = (Time / RECORDER_SEGMENT_DURATION) * RECORDER_SEGMENT_DURATION;
+	if (Start_Time > Time) Start_Time -= RECORDER_SEGMENT_DURATION;
+	return Start_Time;
+}
+
+/** Build a segment file name.
+ * @param String_Directory The log directory.
+ * @param Start_Time The segment start time.
+ * @param String_File_Name On output, contain the file name. The buffer must be RECORDER_FILE_NAME_MAXIMUM_SIZE bytes large.
+ * @return 0 on success,
+ * @return -1 if the name is too long (an error message is displayed).
+ */
+static int RecorderGetSegmentFileName(char *String_Directory, long long Start_Time, char *String_File_Name)
+{
+	time_t Seconds;
+	struct tm Day;
+	int Size;
+	
+	Seconds = (time_t) (Start_Time / 1000);
+	gmtime_r(&Seconds, &Day);
+	Size = snprintf(String_File_Name, RECORDER_FILE_NAME_MAXIMUM_SIZE, "%s/%04d-%02d-%02d.seg", String_Directory, Day.tm_year + 1900, Day.tm_mon + 1, Day.tm_mday);
+	if ((Size < 0) || (Size >= RECORDER_FILE_NAME_MAXIMUM_SIZE))
+	{
+		printf("Error : the log directory name is too long.\n");
+		return -1;
+	}
+	return 0;
+}
+
+/** Check a segment header.
+ * @param Pointer_Header The header read from the segment.
+ * @param Start_Time The expected segment start time.
+ * @param String_File_Name The segment file name, used in the error message.
+ * @return 0 if the header is valid,
+ * @return -1 if it is not (an error message is displayed).
+ */
+static int RecorderCheckSegmentHeader(TRecorderSegmentHeader *Pointer_Header, long long Start_Time, char *String_File_Name)
+{
+	if ((memcmp(Pointer_Header->Magic_Number, RECORDER_SEGMENT_MAGIC_NUMBER, sizeof(Pointer_Header->Magic_Number)) != 0) || (Pointer_Header->Format_Version != RECORDER_SEGMENT_FORMAT_VERSION) || (Pointer_Header->Record_Size != sizeof(TRecorderRecord))
+		|| (Pointer_Header->Start_Time != Start_Time))
+	{
+		printf("Error : '%s' is not a valid segment.\n", String_File_Name);
+		return -1;
+	}
+	return 0;
+}
+
+/** Open the segment samples are appended to, creating it if needed. A record partially written when the program was stopped is removed.
+ * @param Start_Time The segment start time.
+ * @return 0 on success,
+ * @return -1 if an error occurred (an error message is displayed).
+ */
+static int RecorderOpenSegment(long long Start_Time)
+{
+	char String_File_Name[RECORDER_FILE_NAME_MAXIMUM_SIZE];
+	int File_Descriptor;
+	struct stat Status;
+	TRecorderSegmentHeader Header;
+	TRecorderRecord Record;
+	long long Records_Count;
+	
+	if (RecorderGetSegmentFileName(Recorder_String_Directory, Start_Time, String_File_Name) != 0) return -1;
+	File_Descriptor = open(String_File_Name, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if ((File_Descriptor == -1) || (fstat(File_Descriptor, &Status) != 0))
+	{
+		printf("Error : failed to open the segment '%s' (%s).\n", String_File_Name, strerror(errno));
+		if (File_Descriptor != -1) close(File_Descriptor);
+		return -1;
+	}
+	
+	// Start a new segment with its header
+	if (Status.st_size == 0)
+	{
+		memset(&Header, 0, sizeof(Header));
+		memcpy(Header.Magic_Number, RECORDER_SEGMENT_MAGIC_NUMBER, sizeof(Header.Magic_Number));
+		Header.Format_Version = RECORDER_SEGMENT_FORMAT_VERSION;
+		Header.Record_Size = sizeof(TRecorderRecord);
+		Header.Start_Time = Start_Time;
+		if (write(File_Descriptor, &Header, sizeof(Header)) != sizeof(Header))
+		{
+			printf("Error : failed to write the segment '%s' header.\n", String_File_Name);
+			close(File_Descriptor);
+			return -1;
+		}
+		Recorder_Last_Sample_Time = -1;
+	}
+	// Continue an existing segment
+	else
+	{
+		if ((pread(File_Descriptor, &Header, sizeof(Header), 0) != sizeof(Header)) || (RecorderCheckSegmentHeader(&Header, Start_Time, String_File_Name) != 0))
+		{
+			close(File_Descriptor);
+			return -1;
+		}
+		
+		// Drop a record partially written when the program was stopped, so the file keeps a whole number of records
+		Records_Count = (Status.st_size - sizeof(Header)) / sizeof(Record);
+		if (ftruncate(File_Descriptor, sizeof(Header) + (Records_Count * sizeof(Record))) != 0)
+		{
+			printf("Error : failed to repair the segment '%s' (%s).\n", String_File_Name, strerror(errno));
+			close(File_Descriptor);
+			return -1;
+		}
+		
+		// Get the last sample time so the samples stay in chronological order
+		if (Records_Count == 0) Recorder_Last_Sample_Time = -1;
+		else
+		{
+			if (pread(File_Descriptor, &Record, sizeof(Record), sizeof(Header) + ((Records_Count - 1) * sizeof(Record))) != sizeof(Record))
+			{
+				printf("Error : failed to read the segment '%s' last record.\n", String_File_Name);
+				close(File_Descriptor);
+				return -1;
+			}
+			Recorder_Last_Sample_Time = Start_Time + Record.Time_Delta;
+		}
+	}
+	
+	Recorder_Segment_File_Descriptor = File_Descriptor;
+	Recorder_Segment_Start_Time = Start_Time;
+	return 0;
+}
+
+/** Map a segment in memory for reading.
+ * @param String_Directory The log directory.
+ * @param Start_Time The segment start time.
+ * @param Pointer_Segment On output, contain the mapped segment. A missing segment is returned as an empty segment.
+ * @return 0 on success,
+ * @return -1 if the segment can't be read or is corrupted (an error message is displayed).
+ */
+static int RecorderMapSegment(char *String_Directory, long long Start_Time, TRecorderMappedSegment *Pointer_Segment)
+{
+	char String_File_Name[RECORDER_FILE_NAME_MAXIMUM_SIZE];
+	int File_Descriptor;
+	struct stat Status;
+	
+	memset(Pointer_Segment, 0, sizeof(TRecorderMappedSegment));
+	Pointer_Segment->Start_Time = Start_Time;
+	if (RecorderGetSegmentFileName(String_Directory, Start_Time, String_File_Name) != 0) return -1;
+	
+	// No sample was recorded this day
+	File_Descriptor = open(String_File_Name, O_RDONLY);
+	if ((File_Descriptor == -1) && (errno == ENOENT)) return 0;
+	if ((File_Descriptor == -1) || (fstat(File_Descriptor, &Status) != 0))
+	{
+		printf("Error : failed to open the segment '%s' (%s).\n", String_File_Name, strerror(errno));
+		if (File_Descriptor != -1) close(File_Descriptor);
+		return -1;
+	}
+	if (Status.st_size < (off_t) sizeof(TRecorderSegmentHeader))
+	{
+		close(File_Descriptor);
+		if (Status.st_size == 0) return 0; // The recorder was stopped right after creating the file
+		printf("Error : '%s' is not a valid segment.\n", String_File_Name);
+		return -1;
+	}
+	
+	// The mapping stays valid once the file is closed
+	Pointer_Segment->Pointer_Mapping = mmap(NULL, Status.st_size, PROT_READ, MAP_SHARED, File_Descriptor, 0);
+	close(File_Descriptor);
+	if (Pointer_Segment->Pointer_Mapping == MAP_FAILED)
+	{
+		printf("Error : failed to map the segment '%s' (%s).\n", String_File_Name, strerror(errno));
+		Pointer_Segment->Pointer_Mapping = NULL;
+		return -1;
+	}
+	Pointer_Segment->Mapping_Size = Status.st_size;
+	
+	if (RecorderCheckSegmentHeader(Pointer_Segment->Pointer_Mapping, Start_Time, String_File_Name) != 0)
+	{
+		munmap(Pointer_Segment->Pointer_Mapping, Pointer_Segment->Mapping_Size);
+		Pointer_Segment->Pointer_Mapping = NULL;
+		return -1;
+	}
+	
+	// A record being written by the recorder is ignored
+	Pointer_Segment->Pointer_Records = (TRecorderRecord *) ((unsigned char *) Pointer_Segment->Pointer_Mapping + sizeof(TRecorderSegmentHeader));
+	Pointer_Segment->Records_Count = (Status.st_size - sizeof(TRecorderSegmentHeader)) / sizeof(TRecorderRecord);
+	return 0;
+}
+
+/** Release a segment mapped by RecorderMapSegment().
+ * @param Pointer_Segment The segment.
+ */
+static void RecorderUnmapSegment(TRecorderMappedSegment *Pointer_Segment)
+{
+	if (Pointer_Segment->Pointer_Mapping != NULL) munmap(Pointer_Segment->Pointer_Mapping, Pointer_Segment->Mapping_Size);
+}
+
+/** Find the first record of a segment that is not older than a time.
+ * @param Pointer_Segment The segment.
+ * @param Time The time.
+ * @return The record index, Records_Count if all records are older.
+ */
+static long long RecorderFindRecord(TRecorderMappedSegment *Pointer_Segment, long long Time)
+{
+	long long Lowest_Index = 0, Highest_Index, Middle_Index;
+	
+	// The records are in chronological order, and the time of a record does not depend on the previous ones
+	Highest_Index = Pointer_Segment->Records_Count;
+	while (Lowest_Index < Highest_Index)
+	{
+		Middle_Index = Lowest_Index + ((Highest_Index - Lowest_Index) / 2);
+		if (Pointer_Segment->Start_Time + Pointer_Segment->Pointer_Records[Middle_Index].Time_Delta < Time) Lowest_Index = Middle_Index + 1;
+		else Highest_Index = Middle_Index;
+	}
+	return Lowest_Index;
+}
+
+/** Call a handler for each sample of a time range, in chronological order.
+ * @param String_Directory The log directory.
+ * @param Start_Time The range start, it is included.
+ * @param End_Time The range end, it is excluded.
+ * @param Handler The handler to call.
+ * @param Pointer_Context The data given to the handler.
+ * @return 0 on success,
+ * @return -1 if a segment can't be read or is corrupted (an error message is displayed).
+ */
+static int RecorderReadRange(char *String_Directory, long long Start_Time, long long End_Time, TRecorderSampleHandler Handler, void *Pointer_Context)
+{
+	long long Segment_Start_Time, i;
+	TRecorderMappedSegment Segment;
+	TRecorderRecord *Pointer_Record;
+	TRecorderSample Sample;
+	
+	for (Segment_Start_Time = RecorderGetSegmentStartTime(Start_Time); Segment_Start_Time < End_Time; Segment_Start_Time += RECORDER_SEGMENT_DURATION)
+	{
+		if (RecorderMapSegment(String_Directory, Segment_Start_Time, &Segment) != 0) return -1;
+		
+		for (i = RecorderFindRecord(&Segment, Start_Time); i < Segment.Records_Count; i++)
+		{
+			Pointer_Record = &Segment.Pointer_Records[i];
+			Sample.Time = Segment_Start_Time + Pointer_Record->Time_Delta;
+			if (Sample.Time >= End_Time) break;
+			
+			Sample.Clock_Offset = Pointer_Record->Clock_Offset;
+			Sample.Temperature = Pointer_Record->Temperature;
+			Sample.Flags = Pointer_Record->Flags;
+			Handler(&Sample, Pointer_Context);
+		}
+		
+		RecorderUnmapSegment(&Segment);
+	}
+	return 0;
+}
+
+/** Format a sample time as an ISO 8601 UTC date and time with milliseconds.
+ * @param Time The time in milliseconds since the Unix epoch.
+ * @param String_Time On output, contain the formatted time. The buffer must be RECORDER_TIME_STRING_SIZE bytes large.
+ */
+static void RecorderFormatTime(long long Time, char *String_Time)
+{
+	time_t Seconds;
+	struct tm Date;
+	int Milliseconds;
+	
+	Milliseconds = (int) (Time % 1000);
+	if (Milliseconds < 0) Milliseconds += 1000;
+	Seconds = (time_t) ((Time - Milliseconds) / 1000);
+	gmtime_r(&Seconds, &Date);
+	snprintf(String_Time, RECORDER_TIME_STRING_SIZE, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", Date.tm_year + 1900, Date.tm_mon + 1, Date.tm_mday, Date.tm_hour, Date.tm_min, Date.tm_sec, Milliseconds);
+}
+
+/** Write a sample as a CSV line, see TRecorderSampleHandler. */
+static void RecorderExportCSVSample(TRecorderSample *Pointer_Sample, void *Pointer_Context)
+{
+	TRecorderExportContext *Pointer_Export_Context = Pointer_Context;
+	char String_Time[RECORDER_TIME_STRING_SIZE];
+	
+	RecorderFormatTime(Pointer_Sample->Time, String_Time);
+	fprintf(Pointer_Export_Context->Pointer_File, "%s,%d,%d,%d,%d\n", String_Time, Pointer_Sample->Clock_Offset, Pointer_Sample->Temperature, (Pointer_Sample->Flags & PROTOCOL_TELEMETRY_FLAG_ALARM_ENABLED) != 0,
+		(Pointer_Sample->Flags & PROTOCOL_TELEMETRY_FLAG_RINGING) != 0);
+	Pointer_Export_Context->Samples_Count++;
+}
+
+/** Write a sample as a JSON array element, see TRecorderSampleHandler. */
+static void RecorderExportJSONSample(TRecorderSample *Pointer_Sample, void *Pointer_Context)
+{
+	TRecorderExportContext *Pointer_Export_Context = Pointer_Context;
+	char String_Time[RECORDER_TIME_STRING_SIZE];
+	
+	// Separate the elements
+	if (Pointer_Export_Context->Samples_Count > 0) fputs(",\n", Pointer_Export_Context->Pointer_File);
+	
+	RecorderFormatTime(Pointer_Sample->Time, String_Time);
+	fprintf(Pointer_Export_Context->Pointer_File, "  {\"time\": \"%s\", \"clock_offset\": %d, \"temperature\": %d, \"alarm_enabled\": %s, \"ringing\": %s}", String_Time, Pointer_Sample->Clock_Offset, Pointer_Sample->Temperature,
+		(Pointer_Sample->Flags & PROTOCOL_TELEMETRY_FLAG_ALARM_ENABLED) ? "true" : "false", (Pointer_Sample->Flags & PROTOCOL_TELEMETRY_FLAG_RINGING) ? "true" : "false");
+	Pointer_Export_Context->Samples_Count++;
+}
+
+/** Accumulate a sample into the statistics, see TRecorderSampleHandler. */
+static void RecorderAccumulateStatistics(TRecorderSample *Pointer_Sample, void *Pointer_Context)
+{
+	TRecorderStatistics *Pointer_Statistics = Pointer_Context;
+	
+	if ((Pointer_Statistics->Samples_Count == 0) || (Pointer_Sample->Temperature < Pointer_Statistics->Minimum_Temperature_Sample.Temperature)) Pointer_Statistics->Minimum_Temperature_Sample = *Pointer_Sample;
+	if ((Pointer_Statistics->Samples_Count == 0) || (Pointer_Sample->Temperature > Pointer_Statistics->Maximum_Temperature_Sample.Temperature)) Pointer_Statistics->Maximum_Temperature_Sample = *Pointer_Sample;
+	if ((Pointer_Statistics->Samples_Count == 0) || (Pointer_Sample->Clock_Offset < Pointer_Statistics->Minimum_Clock_Offset)) Pointer_Statistics->Minimum_Clock_Offset = Pointer_Sample->Clock_Offset;
+	if ((Pointer_Statistics->Samples_Count == 0) || (Pointer_Sample->Clock_Offset > Pointer_Statistics->Maximum_Clock_Offset)) Pointer_Statistics->Maximum_Clock_Offset = Pointer_Sample->Clock_Offset;
+	
+	// Keep the temperatures sum until all samples are read
+	Pointer_Statistics->Average_Temperature += Pointer_Sample->Temperature;
+	Pointer_Statistics->Samples_Count++;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int RecorderOpen(char *String_Directory)
+{
+	if ((mkdir(String_Directory, 0755) != 0) && (errno != EEXIST))
+	{
+		printf("Error : failed to create the log directory '%s' (%s).\n", String_Directory, strerror(errno));
+		return -1;
+	}
+	
+	// The segment is opened with the first sample
+	Recorder_String_Directory = String_Directory;
+	Recorder_Segment_File_Descriptor = -1;
+	Recorder_Last_Sample_Time = -1;
+	return 0;
+}
+
+int RecorderAppend(TRecorderSample *Pointer_Sample)
+{
+	long long Segment_Start_Time;
+	TRecorderRecord Record;
+	
+	// Samples older than the recorded ones would break the segment order
+	if (Pointer_Sample->Time <= Recorder_Last_Sample_Time) return 1;
+	
+	// Switch to the sample day segment
+	Segment_Start_Time = RecorderGetSegmentStartTime(Pointer_Sample->Time);
+	if ((Recorder_Segment_File_Descriptor == -1) || (Segment_Start_Time != Recorder_Segment_Start_Time))
+	{
+		RecorderClose();
+		if (RecorderOpenSegment(Segment_Start_Time) != 0) return -1;
+		if (Pointer_Sample->Time <= Recorder_Last_Sample_Time) return 1; // The existing segment may already hold more recent samples
+	}
+	
+	// Saturate the values that do not fit in a record
+	memset(&Record, 0, sizeof(Record));
+	Record.Time_Delta = (uint32_t) (Pointer_Sample->Time - Segment_Start_Time);
+	if (Pointer_Sample->Clock_Offset < INT16_MIN) Record.Clock_Offset = INT16_MIN;
+	else if (Pointer_Sample->Clock_Offset > INT16_MAX) Record.Clock_Offset = INT16_MAX;
+	else Record.Clock_Offset = (int16_t) Pointer_Sample->Clock_Offset;
+	if (Pointer_Sample->Temperature < INT8_MIN) Record.Temperature = INT8_MIN;
+	else if (Pointer_Sample->Temperature > INT8_MAX) Record.Temperature = INT8_MAX;
+	else Record.Temperature = (int8_t) Pointer_Sample->Temperature;
+	Record.Flags = (uint8_t) Pointer_Sample->Flags;
+	
+	// A single write appends the whole record
+	if (write(Recorder_Segment_File_Descriptor, &Record, sizeof(Record)) != sizeof(Record))
+	{
+		printf("Error : failed to write the sample (%s).\n", strerror(errno));
+		return -1;
+	}
+	Recorder_Last_Sample_Time = Pointer_Sample->Time;
+	return 0;
+}
+
+void RecorderClose(void)
+{
+	if (Recorder_Segment_File_Descriptor == -1) return;
+	close(Recorder_Segment_File_Descriptor);
+	Recorder_Segment_File_Descriptor = -1;
+}
+
+long long RecorderExport(char *String_Directory, long long Start_Time, long long End_Time, TRecorderFormat Format, FILE *Pointer_File)
+{
+	TRecorderExportContext Context;
+	int Result;
+	
+	Context.Pointer_File = Pointer_File;
+	Context.Samples_Count = 0;
+	
+	if (Format == RECORDER_FORMAT_CSV)
+	{
+		fputs("time,clock_offset,temperature,alarm_enabled,ringing\n", Pointer_File);
+		Result = RecorderReadRange(String_Directory, Start_Time, End_Time, RecorderExportCSVSample, &Context);
+	}
+	else
+	{
+		fputs("[\n", Pointer_File);
+		Result = RecorderReadRange(String_Directory, Start_Time, End_Time, RecorderExportJSONSample, &Context);
+		if (Context.Samples_Count > 0) fputc('\n', Pointer_File);
+		fputs("]\n", Pointer_File);
+	}
+	
+	if (Result != 0) return -1;
+	return Context.Samples_Count;
+}
+
+int RecorderComputeStatistics(char *String_Directory, long long Start_Time, long long End_Time, TRecorderStatistics *Pointer_Statistics)
+{
+	memset(Pointer_Statistics, 0, sizeof(TRecorderStatistics));
+	if (RecorderReadRange(String_Directory, Start_Time, End_Time, RecorderAccumulateStatistics, Pointer_Statistics) != 0) return -1;
+	
+	if (Pointer_Statistics->Samples_Count > 0) Pointer_Statistics->Average_Temperature /= Pointer_Statistics->Samples_Count;
+	return 0;
+}
@@ -0,0 +1,84 @@
+/** @file Recorder.h
+ * Store the clock telemetry in a compact append-only binary log, and read a time range back without parsing the whole log.
+ * The log is a directory holding a segment file per UTC day, named after the day (YYYY-MM-DD.seg). A segment starts with a header telling the day start time, followed by fixed-size records in chronological order. Each record stores its time as a delta from the segment start, so the segment can be mapped in memory and any time located by a binary search.
+ * All values are stored in the computer byte order.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_RECORDER_H
+#define H_RECORDER_H
+
+#include <stdio.h>
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** A telemetry sample. */
+typedef struct
+{
+	long long Time; //!< When the sample was taken, in milliseconds since the Unix epoch (UTC).
+	int Clock_Offset; //!< The clock time minus the computer local time, in seconds. It is saturated to the range [-32768;32767].
+	int Temperature; //!< The temperature in centigrade degrees, in range [-128;127].
+	int Flags; //!< The PROTOCOL_TELEMETRY_FLAG_xxx values OR'ed.
+} TRecorderSample;
+
+/** The statistics of a time range. */
+typedef struct
+{
+	long long Samples_Count; //!< How many samples are in the range, the other fields are meaningful only if there is at least one sample.
+	TRecorderSample Minimum_Temperature_Sample; //!< The first sample with the lowest temperature.
+	TRecorderSample Maximum_Temperature_Sample; //!< The first sample with the highest temperature.
+	double Average_Temperature; //!< The average temperature.
+	int Minimum_Clock_Offset; //!< The lowest clock offset.
+	int Maximum_Clock_Offset; //!< The highest clock offset.
+} TRecorderStatistics;
+
+/** All export formats. */
+typedef enum
+{
+	RECORDER_FORMAT_CSV, //!< A header line followed by a line per sample.
+	RECORDER_FORMAT_JSON //!< An array with an object per sample.
+} TRecorderFormat;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Start recording to a log directory, it is created if it does not exist. The samples are appended to the existing segments.
+ * @param String_Directory The log directory.
+ * @return 0 on success,
+ * @return -1 if the directory can't be used (an error message is displayed).
+ */
+int RecorderOpen(char *String_Directory);
+
+/** Append a sample to the log, switching to a new segment when the day changes. The sample is written at once, so stopping the program never loses the previous samples.
+ * @param Pointer_Sample The sample, it must be more recent than the previous one.
+ * @return 0 on success,
+ * @return 1 if the sample was ignored because it is not more recent than the last recorded one (the computer clock went backward),
+ * @return -1 if the sample could not be written (an error message is displayed).
+ */
+int RecorderAppend(TRecorderSample *Pointer_Sample);
+
+/** Stop recording. */
+void RecorderClose(void);
+
+/** Write the samples of a time range to a file.
+ * @param String_Directory The log directory.
+ * @param Start_Time The range start in milliseconds since the Unix epoch, it is included.
+ * @param End_Time The range end in milliseconds since the Unix epoch, it is excluded.
+ * @param Format The output format.
+ * @param Pointer_File The output file.
+ * @return How many samples were written,
+ * @return -1 if a segment is corrupted or can't be read (an error message is displayed).
+ */
+long long RecorderExport(char *String_Directory, long long Start_Time, long long End_Time, TRecorderFormat Format, FILE *Pointer_File);
+
+/** Compute the statistics of a time range.
+ * @param String_Directory The log directory.
+ * @param Start_Time The range start in milliseconds since the Unix epoch, it is included.
+ * @param End_Time The range end in milliseconds since the Unix epoch, it is excluded.
+ * @param Pointer_Statistics On output, contain the statistics.
+ * @return 0 on success,
+ * @return -1 if a segment is corrupted or can't be read (an error message is displayed).
+ */
+int RecorderComputeStatistics(char *String_Directory, long long Start_Time, long long End_Time, TRecorderStatistics *Pointer_Statistics);
+
+#endif
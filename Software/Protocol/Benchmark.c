@@ -0,0 +1,168 @@
+/** @file Benchmark.c
+ * Measure the protocol codec throughput, so a protocol change can be checked to perform the same on every host. Each encoded frame is decoded back and compared, so the benchmark also checks the codec.
+ * @author Adrien RICCIARDI
+ */
+#include "Protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many frames are encoded and decoded by default. */
+#define BENCHMARK_DEFAULT_FRAMES_COUNT 10000000
+
+/** How many different frames are cycled through, so the benchmark does not always encode the same values. */
+#define BENCHMARK_FRAMES_VARIANTS_COUNT 256
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A frame to encode. */
+typedef struct
+{
+	int Unit_Address; //!< The destination address.
+	unsigned char Command; //!< The configuration command.
+	unsigned char Field_Mask; //!< The fields to send with PROTOCOL_COMMAND_SET_FIELDS.
+	TProtocolConfiguration Configuration; //!< The fields values.
+} TBenchmarkFrame;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The frames to encode. */
+static TBenchmarkFrame Benchmark_Frames[BENCHMARK_FRAMES_VARIANTS_COUNT];
+/** The encoded frames. */
+static unsigned char Benchmark_Encoded_Frames[BENCHMARK_FRAMES_VARIANTS_COUNT][PROTOCOL_MAXIMUM_FRAME_SIZE];
+/** The encoded frames sizes. */
+static int Benchmark_Encoded_Frames_Sizes[BENCHMARK_FRAMES_VARIANTS_COUNT];
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the current time in seconds.
+ * @return The time.
+ */
+static double BenchmarkGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec + (Time.tv_nsec / 1e9);
+}
+
+/** Create frames covering all configuration commands, addressed and unaddressed. */
+static void BenchmarkGenerateFrames(void)
+{
+	static const unsigned char Commands[] = {PROTOCOL_COMMAND_SET_ALARM, PROTOCOL_COMMAND_SET_TIME, PROTOCOL_COMMAND_SET_DATE, PROTOCOL_COMMAND_SET_FIELDS};
+	TBenchmarkFrame *Pointer_Frame;
+	int i;
+	
+	srand(1);
+	for (i = 0; i < BENCHMARK_FRAMES_VARIANTS_COUNT; i++)
+	{
+		Pointer_Frame = &Benchmark_Frames[i];
+		if (i & 1) Pointer_Frame->Unit_Address = PROTOCOL_NO_UNIT_ADDRESS;
+		else Pointer_Frame->Unit_Address = (rand() % PROTOCOL_MAXIMUM_UNIT_ADDRESS) + 1;
+		Pointer_Frame->Command = Commands[(i >> 1) % sizeof(Commands)];
+		Pointer_Frame->Field_Mask = (unsigned char) rand();
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_SECONDS] = rand() % 60;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_MINUTES] = rand() % 60;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_HOURS] = rand() % 24;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_DAY_OF_WEEK] = (rand() % 7) + 1;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_DAY] = (rand() % 31) + 1;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_MONTH] = (rand() % 12) + 1;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_YEAR] = 2000 + (rand() % 100);
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_ALARM_HOUR] = rand() % 24;
+		Pointer_Frame->Configuration.Fields[PROTOCOL_FIELD_ALARM_MINUTES] = rand() % 60;
+	}
+}
+
+/** Check that a decoded frame matches the encoded one.
+ * @param Pointer_Frame The encoded frame.
+ * @param Unit_Address The decoded address.
+ * @param Command The decoded command.
+ * @param Field_Mask The decoded field mask.
+ * @param Pointer_Configuration The decoded fields.
+ * @return 0 if the frames match,
+ * @return -1 otherwise.
+ */
+static int BenchmarkCompareFrames(TBenchmarkFrame *Pointer_Frame, int Unit_Address, unsigned char Command, unsigned char Field_Mask, TProtocolConfiguration *Pointer_Configuration)
+{
+	int Field;
+	
+	if ((Unit_Address != Pointer_Frame->Unit_Address) || (Command != Pointer_Frame->Command)) return -1;
+	if ((Command == PROTOCOL_COMMAND_SET_FIELDS) && (Field_Mask != Pointer_Frame->Field_Mask)) return -1;
+	for (Field = 0; Field < PROTOCOL_FIELDS_COUNT; Field++)
+	{
+		if (!(Field_Mask & ((Field >= PROTOCOL_FIELD_ALARM_HOUR) ? PROTOCOL_FIELD_MASK_ALARM : (1 << Field)))) continue;
+		if (Pointer_Configuration->Fields[Field] != Pointer_Frame->Configuration.Fields[Field]) return -1;
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	long Frames_Count = BENCHMARK_DEFAULT_FRAMES_COUNT, i, Bytes_Count = 0;
+	int Index, Size, Unit_Address;
+	unsigned char Command, Field_Mask;
+	TBenchmarkFrame *Pointer_Frame;
+	TProtocolConfiguration Configuration;
+	double Start_Time, Encoding_Duration, Decoding_Duration;
+	
+	if (argc > 2)
+	{
+		printf("Usage : %s [Frames_Count]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if ((argc == 2) && ((sscanf(argv[1], "%ld", &Frames_Count) != 1) || (Frames_Count <= 0)))
+	{
+		printf("Error : the frames count must be a positive number.\n");
+		return EXIT_FAILURE;
+	}
+	
+	BenchmarkGenerateFrames();
+	
+	// Encode
+	Start_Time = BenchmarkGetTime();
+	for (i = 0; i < Frames_Count; i++)
+	{
+		Index = i % BENCHMARK_FRAMES_VARIANTS_COUNT;
+		Pointer_Frame = &Benchmark_Frames[Index];
+		Size = ProtocolEncodeConfigurationFrame(Pointer_Frame->Unit_Address, Pointer_Frame->Command, Pointer_Frame->Field_Mask, &Pointer_Frame->Configuration, Benchmark_Encoded_Frames[Index], sizeof(Benchmark_Encoded_Frames[Index]));
+		if (Size < 0)
+		{
+			printf("Error : failed to encode frame %d.\n", Index);
+			return EXIT_FAILURE;
+		}
+		Benchmark_Encoded_Frames_Sizes[Index] = Size;
+		Bytes_Count += Size;
+	}
+	Encoding_Duration = BenchmarkGetTime() - Start_Time;
+	
+	// Decode and check
+	memset(&Configuration, 0, sizeof(Configuration));
+	Start_Time = BenchmarkGetTime();
+	for (i = 0; i < Frames_Count; i++)
+	{
+		Index = i % BENCHMARK_FRAMES_VARIANTS_COUNT;
+		Size = ProtocolDecodeConfigurationFrame(Benchmark_Encoded_Frames[Index], Benchmark_Encoded_Frames_Sizes[Index], &Unit_Address, &Command, &Field_Mask, &Configuration);
+		if ((Size != Benchmark_Encoded_Frames_Sizes[Index]) || (BenchmarkCompareFrames(&Benchmark_Frames[Index], Unit_Address, Command, Field_Mask, &Configuration) != 0))
+		{
+			printf("Error : frame %d is not decoded as it was encoded.\n", Index);
+			return EXIT_FAILURE;
+		}
+	}
+	Decoding_Duration = BenchmarkGetTime() - Start_Time;
+	
+	printf("%ld frames (%ld bytes) :\n", Frames_Count, Bytes_Count);
+	printf("Encoding : %.1f ns per frame, %.1f Mframes/s, %.1f MB/s\n", (Encoding_Duration * 1e9) / Frames_Count, Frames_Count / (Encoding_Duration * 1e6), Bytes_Count / (Encoding_Duration * 1e6));
+	printf("Decoding : %.1f ns per frame, %.1f Mframes/s, %.1f MB/s (including the check)\n", (Decoding_Duration * 1e9) / Frames_Count, Frames_Count / (Decoding_Duration * 1e6), Bytes_Count / (Decoding_Duration * 1e6));
+	
+	return EXIT_SUCCESS;
+}
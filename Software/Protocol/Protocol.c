@@ -0,0 +1,303 @@
+/** @file Protocol.c
+ * @see Protocol.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "Protocol.h"
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** All fields of a whole configuration frame. */
+#define PROTOCOL_FIELD_MASK_ALL 0xFF
+
+/** The RTC year starts from 2000. */
+#define PROTOCOL_YEAR_BASE 2000
+
+/** The clock dates its events relative to the RTC 1Hz signal rising edge, which comes this many milliseconds after the beginning of a second. */
+#define PROTOCOL_TICK_EDGE_TIME 500
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The lowest value of each configuration field. */
+static const int Protocol_Field_Minimum_Values[PROTOCOL_FIELDS_COUNT] = {0, 0, 0, 1, 1, 1, PROTOCOL_YEAR_BASE, 0, 0};
+/** The highest value of each configuration field. */
+static const int Protocol_Field_Maximum_Values[PROTOCOL_FIELDS_COUNT] = {59, 59, 23, 7, 31, 12, PROTOCOL_YEAR_BASE + 99, 23, 59};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the field mask bit selecting a field.
+ * @param Field The field.
+ * @return The field mask bit, the alarm hour and minutes are selected by the same bit.
+ */
+static unsigned char ProtocolGetFieldBit(int Field)
+{
+	if (Field >= PROTOCOL_FIELD_ALARM_HOUR) return PROTOCOL_FIELD_MASK_ALARM;
+	return 1 << Field;
+}
+
+/** Get the field mask implied by a configuration command.
+ * @param Command The command.
+ * @return The field mask,
+ * @return 0 if the command is not a configuration command or if it carries its own field mask.
+ */
+static unsigned char ProtocolGetCommandFieldMask(unsigned char Command)
+{
+	switch (Command)
+	{
+		case PROTOCOL_MAGIC_NUMBER:
+			return PROTOCOL_FIELD_MASK_ALL;
+		case PROTOCOL_COMMAND_SET_ALARM:
+			return PROTOCOL_FIELD_MASK_ALARM;
+		case PROTOCOL_COMMAND_SET_TIME:
+			return PROTOCOL_FIELD_MASK_TIME;
+		case PROTOCOL_COMMAND_SET_DATE:
+			return PROTOCOL_FIELD_MASK_DATE;
+		default:
+			return 0;
+	}
+}
+
+/** Convert a 2-digit binary number to Binary Coded Decimal.
+ * @param Number The number in range [0;99].
+ * @return The BCD value.
+ */
+static unsigned char ProtocolConvertBinaryToBCD(int Number)
+{
+	int Tens;
+	
+	Tens = Number / 10;
+	return (unsigned char) ((Tens << 4) | (Number - (Tens * 10)));
+}
+
+/** Convert a telemetry timestamp to milliseconds.
+ * @param Pointer_Bytes The timestamp bytes, most significant byte first. The timestamp is the signed time elapsed since the RTC 1Hz signal edge, in the clock timer units.
+ * @param Tick_Period The RTC 1Hz signal period measured by the clock.
+ * @return The milliseconds elapsed since the beginning of the reported second,
+ * @return PROTOCOL_NO_TIMESTAMP if the clock did not date the event.
+ */
+static int ProtocolDecodeTimestamp(unsigned char *Pointer_Bytes, int Tick_Period)
+{
+	int Timestamp, Numerator;
+	
+	Timestamp = (Pointer_Bytes[0] << 8) | Pointer_Bytes[1];
+	if (Timestamp >= 32768) Timestamp -= 65536;
+	if ((Timestamp == PROTOCOL_NO_TIMESTAMP) || (Tick_Period == 0)) return PROTOCOL_NO_TIMESTAMP;
+	
+	// Round to the nearest millisecond
+	Numerator = Timestamp * 1000;
+	if (Numerator >= 0) Numerator += Tick_Period / 2;
+	else Numerator -= Tick_Period / 2;
+	return PROTOCOL_TICK_EDGE_TIME + (Numerator / Tick_Period);
+}
+
+/** Convert a 1-byte Binary Coded Decimal value to binary.
+ * @param BCD The BCD value.
+ * @return The binary number,
+ * @return -1 if the value is not a valid BCD number.
+ */
+static int ProtocolConvertBCDToBinary(unsigned char BCD)
+{
+	if (((BCD >> 4) > 9) || ((BCD & 0x0F) > 9)) return -1;
+	return ((BCD >> 4) * 10) + (BCD & 0x0F);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int ProtocolIsFieldValid(TProtocolField Field, int Value)
+{
+	if ((Field < 0) || (Field >= PROTOCOL_FIELDS_COUNT)) return 0;
+	return (Value >= Protocol_Field_Minimum_Values[Field]) && (Value <= Protocol_Field_Maximum_Values[Field]);
+}
+
+int ProtocolEncodeCommand(int Unit_Address, unsigned char Command, unsigned char *Pointer_Buffer, int Buffer_Size)
+{
+	int Size = 0;
+	
+	// Prefix the command with the destination address on a shared line
+	if (Unit_Address != PROTOCOL_NO_UNIT_ADDRESS)
+	{
+		if (((Unit_Address < 1) || (Unit_Address > PROTOCOL_MAXIMUM_UNIT_ADDRESS)) && (Unit_Address != PROTOCOL_BROADCAST_ADDRESS)) return -1;
+		if (Buffer_Size < 2) return -1;
+		Pointer_Buffer[0] = PROTOCOL_COMMAND_ADDRESSED_FRAME;
+		Pointer_Buffer[1] = (unsigned char) Unit_Address;
+		Size = 2;
+	}
+	
+	if (Size >= Buffer_Size) return -1;
+	Pointer_Buffer[Size] = Command;
+	return Size + 1;
+}
+
+int ProtocolEncodeParameterCommand(int Unit_Address, unsigned char Command, unsigned char Parameter, unsigned char *Pointer_Buffer, int Buffer_Size)
+{
+	int Size;
+	
+	Size = ProtocolEncodeCommand(Unit_Address, Command, Pointer_Buffer, Buffer_Size);
+	if ((Size < 0) || (Size >= Buffer_Size)) return -1;
+	
+	Pointer_Buffer[Size] = Parameter;
+	return Size + 1;
+}
+
+int ProtocolEncodeCrystalCurve(int Unit_Address, int Turnover_Temperature, int Curvature, int Offset, unsigned char *Pointer_Buffer, int Buffer_Size)
+{
+	int Size;
+	
+	if ((Turnover_Temperature < 0) || (Turnover_Temperature > PROTOCOL_MAXIMUM_CRYSTAL_TURNOVER_TEMPERATURE)) return -1;
+	if ((Curvature < 0) || (Curvature > PROTOCOL_MAXIMUM_CRYSTAL_CURVATURE)) return -1;
+	if ((Offset < -PROTOCOL_MAXIMUM_CRYSTAL_OFFSET) || (Offset > PROTOCOL_MAXIMUM_CRYSTAL_OFFSET)) return -1;
+	
+	Size = ProtocolEncodeCommand(Unit_Address, PROTOCOL_COMMAND_SET_CRYSTAL_CURVE, Pointer_Buffer, Buffer_Size);
+	if ((Size < 0) || (Size + 4 > Buffer_Size)) return -1;
+	
+	// The values are sent in binary, the offset most significant byte first
+	Pointer_Buffer[Size] = (unsigned char) Turnover_Temperature;
+	Pointer_Buffer[Size + 1] = (unsigned char) Curvature;
+	Pointer_Buffer[Size + 2] = (unsigned char) ((Offset >> 8) & 0xFF);
+	Pointer_Buffer[Size + 3] = (unsigned char) (Offset & 0xFF);
+	return Size + 4;
+}
+
+int ProtocolEncodeConfigurationFields(unsigned char Field_Mask, TProtocolConfiguration *Pointer_Configuration, unsigned char *Pointer_Buffer, int Buffer_Size)
+{
+	int Size = 0, Field, Value;
+	
+	// The fields are sent in the RTC registers order, followed by the alarm
+	for (Field = 0; Field < PROTOCOL_FIELDS_COUNT; Field++)
+	{
+		if (!(Field_Mask & ProtocolGetFieldBit(Field))) continue;
+		
+		Value = Pointer_Configuration->Fields[Field];
+		if (!ProtocolIsFieldValid(Field, Value) || (Size >= Buffer_Size)) return -1;
+		if (Field == PROTOCOL_FIELD_YEAR) Value -= PROTOCOL_YEAR_BASE;
+		Pointer_Buffer[Size] = ProtocolConvertBinaryToBCD(Value);
+		Size++;
+	}
+	return Size;
+}
+
+int ProtocolEncodeConfigurationFrame(int Unit_Address, unsigned char Command, unsigned char Field_Mask, TProtocolConfiguration *Pointer_Configuration, unsigned char *Pointer_Buffer, int Buffer_Size)
+{
+	int Size, Fields_Size;
+	
+	// A whole configuration frame needs the clock acknowledge before the fields are sent, so it can't be encoded at once
+	if (Command == PROTOCOL_COMMAND_SET_FIELDS)
+	{
+		Size = ProtocolEncodeParameterCommand(Unit_Address, Command, Field_Mask, Pointer_Buffer, Buffer_Size);
+	}
+	else
+	{
+		Field_Mask = ProtocolGetCommandFieldMask(Command);
+		if ((Field_Mask == 0) || (Field_Mask == PROTOCOL_FIELD_MASK_ALL)) return -1;
+		Size = ProtocolEncodeCommand(Unit_Address, Command, Pointer_Buffer, Buffer_Size);
+	}
+	if (Size < 0) return -1;
+	
+	Fields_Size = ProtocolEncodeConfigurationFields(Field_Mask, Pointer_Configuration, &Pointer_Buffer[Size], Buffer_Size - Size);
+	if (Fields_Size < 0) return -1;
+	return Size + Fields_Size;
+}
+
+int ProtocolDecodeConfigurationFrame(unsigned char *Pointer_Buffer, int Buffer_Size, int *Pointer_Unit_Address, unsigned char *Pointer_Command, unsigned char *Pointer_Field_Mask, TProtocolConfiguration *Pointer_Configuration)
+{
+	int Size = 0, Frame_Size, Field, Value, Values[PROTOCOL_FIELDS_COUNT];
+	unsigned char Field_Mask;
+	
+	// Destination address
+	if (Buffer_Size < 1) return 0;
+	if (Pointer_Buffer[0] == PROTOCOL_COMMAND_ADDRESSED_FRAME)
+	{
+		if (Buffer_Size < 2) return 0;
+		*Pointer_Unit_Address = Pointer_Buffer[1];
+		Size = 2;
+	}
+	else *Pointer_Unit_Address = PROTOCOL_NO_UNIT_ADDRESS;
+	
+	// Command
+	if (Size >= Buffer_Size) return 0;
+	*Pointer_Command = Pointer_Buffer[Size];
+	Size++;
+	if (*Pointer_Command == PROTOCOL_COMMAND_SET_FIELDS)
+	{
+		if (Size >= Buffer_Size) return 0;
+		Field_Mask = Pointer_Buffer[Size];
+		Size++;
+	}
+	else
+	{
+		Field_Mask = ProtocolGetCommandFieldMask(*Pointer_Command);
+		if (Field_Mask == 0) return -1;
+	}
+	*Pointer_Field_Mask = Field_Mask;
+	
+	// Fields, all of them must be received and valid before the configuration is updated
+	Frame_Size = Size;
+	for (Field = 0; Field < PROTOCOL_FIELDS_COUNT; Field++)
+	{
+		if (Field_Mask & ProtocolGetFieldBit(Field)) Frame_Size++;
+	}
+	if (Frame_Size > Buffer_Size) return 0;
+	
+	for (Field = 0; Field < PROTOCOL_FIELDS_COUNT; Field++)
+	{
+		if (!(Field_Mask & ProtocolGetFieldBit(Field))) continue;
+		
+		Value = ProtocolConvertBCDToBinary(Pointer_Buffer[Size]);
+		if ((Value >= 0) && (Field == PROTOCOL_FIELD_YEAR)) Value += PROTOCOL_YEAR_BASE;
+		if (!ProtocolIsFieldValid(Field, Value)) return -1;
+		Values[Field] = Value;
+		Size++;
+	}
+	
+	for (Field = 0; Field < PROTOCOL_FIELDS_COUNT; Field++)
+	{
+		if (Field_Mask & ProtocolGetFieldBit(Field)) Pointer_Configuration->Fields[Field] = Values[Field];
+	}
+	return Frame_Size;
+}
+
+int ProtocolDecodeTelemetry(unsigned char *Pointer_Buffer, int Buffer_Size, TProtocolTelemetry *Pointer_Telemetry)
+{
+	int Field, Value;
+	
+	if (Buffer_Size < PROTOCOL_TELEMETRY_SIZE) return 0;
+	
+	Pointer_Telemetry->Sequence_Number = Pointer_Buffer[0];
+	Pointer_Buffer++;
+	
+	// The date and time fields follow in the RTC registers order
+	for (Field = 0; Field < PROTOCOL_FIELD_ALARM_HOUR; Field++)
+	{
+		Value = ProtocolConvertBCDToBinary(Pointer_Buffer[Field]);
+		if ((Value >= 0) && (Field == PROTOCOL_FIELD_YEAR)) Value += PROTOCOL_YEAR_BASE;
+		if (!ProtocolIsFieldValid(Field, Value)) return -1;
+		Pointer_Telemetry->Clock.Fields[Field] = Value;
+	}
+	Pointer_Telemetry->Temperature = Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR];
+	
+	// The alarm comes from the RTC RAM, which is random until the alarm is set, so it does not invalidate the other data
+	Pointer_Telemetry->Clock.Fields[PROTOCOL_FIELD_ALARM_HOUR] = ProtocolConvertBCDToBinary(Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR + 1]);
+	Pointer_Telemetry->Clock.Fields[PROTOCOL_FIELD_ALARM_MINUTES] = ProtocolConvertBCDToBinary(Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR + 2]);
+	if (!ProtocolIsFieldValid(PROTOCOL_FIELD_ALARM_HOUR, Pointer_Telemetry->Clock.Fields[PROTOCOL_FIELD_ALARM_HOUR]) || !ProtocolIsFieldValid(PROTOCOL_FIELD_ALARM_MINUTES, Pointer_Telemetry->Clock.Fields[PROTOCOL_FIELD_ALARM_MINUTES]))
+	{
+		Pointer_Telemetry->Clock.Fields[PROTOCOL_FIELD_ALARM_HOUR] = -1;
+		Pointer_Telemetry->Clock.Fields[PROTOCOL_FIELD_ALARM_MINUTES] = -1;
+	}
+	
+	Pointer_Telemetry->Flags = Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR + 3];
+	Pointer_Telemetry->UART_Overrun_Errors_Count = Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR + 4];
+	Pointer_Telemetry->UART_Framing_Errors_Count = Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR + 5];
+	Pointer_Telemetry->Button_Bounces_Count = Pointer_Buffer[PROTOCOL_FIELD_ALARM_HOUR + 6];
+	
+	// The timestamps are converted with the period the clock measured, so the clock timer frequency error cancels out
+	Pointer_Buffer += PROTOCOL_FIELD_ALARM_HOUR + 7;
+	Pointer_Telemetry->Tick_Period = (Pointer_Buffer[0] << 8) | Pointer_Buffer[1];
+	Pointer_Telemetry->Request_Timestamp = ProtocolDecodeTimestamp(&Pointer_Buffer[2], Pointer_Telemetry->Tick_Period);
+	Pointer_Telemetry->UART_Frame_Timestamp = ProtocolDecodeTimestamp(&Pointer_Buffer[4], Pointer_Telemetry->Tick_Period);
+	Pointer_Telemetry->Button_Press_Timestamp = ProtocolDecodeTimestamp(&Pointer_Buffer[6], Pointer_Telemetry->Tick_Period);
+	Pointer_Telemetry->Temperature_Sample_Timestamp = ProtocolDecodeTimestamp(&Pointer_Buffer[8], Pointer_Telemetry->Tick_Period);
+	return PROTOCOL_TELEMETRY_SIZE;
+}
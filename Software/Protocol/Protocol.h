@@ -0,0 +1,204 @@
+/** @file Protocol.h
+ * Encode and decode the frames exchanged with the clock through its serial port. The codec never allocates memory : frames are built into and read from caller-provided buffers, so the same code runs on every host (the PC program links it directly, the Android application calls it through JNI).
+ * The firmware side of the protocol is the UART.c state machine, the constants below must follow it.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_PROTOCOL_H
+#define H_PROTOCOL_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** The UART protocol magic number (a value that could hardly be randomly generated on the bus). It starts a whole configuration frame and acknowledges all commands. */
+#define PROTOCOL_MAGIC_NUMBER 0xA5
+/** Get the main loop profiler statistics. */
+#define PROTOCOL_COMMAND_GET_PROFILER_STATISTICS 0xB0
+/** Get the interrupt trace. */
+#define PROTOCOL_COMMAND_GET_INTERRUPT_TRACE 0xB1
+/** Select the alarm ringtone. */
+#define PROTOCOL_COMMAND_SET_RINGTONE 0xB2
+/** Start the bootloader. */
+#define PROTOCOL_COMMAND_ENTER_BOOTLOADER 0xB3
+/** Set only the alarm, the clock keeps running. */
+#define PROTOCOL_COMMAND_SET_ALARM 0xB4
+/** Set only the time. */
+#define PROTOCOL_COMMAND_SET_TIME 0xB5
+/** Set only the date. */
+#define PROTOCOL_COMMAND_SET_DATE 0xB6
+/** Set the configuration fields selected by a field mask. */
+#define PROTOCOL_COMMAND_SET_FIELDS 0xB7
+/** Send the following command to a single clock of a shared line. */
+#define PROTOCOL_COMMAND_ADDRESSED_FRAME 0xB8
+/** Ask the clock its unit address. */
+#define PROTOCOL_COMMAND_GET_UNIT_ADDRESS 0xB9
+/** Set the clock unit address. */
+#define PROTOCOL_COMMAND_SET_UNIT_ADDRESS 0xBA
+/** Ask the clock its telemetry : the status snapshot the clock published on its last tick. */
+#define PROTOCOL_COMMAND_GET_TELEMETRY 0xBB
+/** Set the RTC crystal frequency curve the clock compensates its drift with. */
+#define PROTOCOL_COMMAND_SET_CRYSTAL_CURVE 0xBC
+
+/** The address all clocks of a shared line answer to, broadcast frames are never answered. */
+#define PROTOCOL_BROADCAST_ADDRESS 0xFF
+/** Tell that a frame is not addressed, it is only executed and answered by a clock having no address. */
+#define PROTOCOL_NO_UNIT_ADDRESS -1
+/** The highest unit address. */
+#define PROTOCOL_MAXIMUM_UNIT_ADDRESS 254
+
+/** The seconds, minutes and hours configuration fields. The date and time fields bits follow the RTC registers order. */
+#define PROTOCOL_FIELD_MASK_TIME 0x07
+/** The day of week, day, month and year configuration fields. */
+#define PROTOCOL_FIELD_MASK_DATE 0x78
+/** The alarm hour and minutes configuration fields. */
+#define PROTOCOL_FIELD_MASK_ALARM 0x80
+
+/** The telemetry answer size in bytes : the sequence number, the date and time fields in the RTC registers order (BCD), the filtered temperature in centigrade degrees (binary), the alarm hour and minutes (BCD), the flags, the UART overruns count, the UART framing errors count, the buttons bounces count, then 16-bit values sent most significant byte first : the RTC 1Hz signal period, the request, last configuration frame, last button press and last temperature sample timestamps. */
+#define PROTOCOL_TELEMETRY_SIZE 25
+/** The telemetry flag telling that the alarm switch is on. */
+#define PROTOCOL_TELEMETRY_FLAG_ALARM_ENABLED 0x01
+/** The telemetry flag telling that the alarm is ringing. */
+#define PROTOCOL_TELEMETRY_FLAG_RINGING 0x02
+/** The telemetry timestamp of an event that did not happen in the last two seconds, or that the clock could not date (its RTC was set less than a second ago). */
+#define PROTOCOL_NO_TIMESTAMP -32768
+
+/** The highest crystal turnover temperature in centigrade degrees, the lowest is 0. */
+#define PROTOCOL_MAXIMUM_CRYSTAL_TURNOVER_TEMPERATURE 100
+/** The highest crystal curvature in ppb per squared centigrade degree, the lowest is 0. */
+#define PROTOCOL_MAXIMUM_CRYSTAL_CURVATURE 255
+/** The highest crystal frequency offset magnitude in ppb. */
+#define PROTOCOL_MAXIMUM_CRYSTAL_OFFSET 32767
+
+/** The biggest frame size in bytes : an addressed frame setting all fields. */
+#define PROTOCOL_MAXIMUM_FRAME_SIZE 13
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All configuration fields, the date and time ones follow the RTC registers order. */
+typedef enum
+{
+	PROTOCOL_FIELD_SECONDS, //!< Range [0;59].
+	PROTOCOL_FIELD_MINUTES, //!< Range [0;59].
+	PROTOCOL_FIELD_HOURS, //!< Range [0;23].
+	PROTOCOL_FIELD_DAY_OF_WEEK, //!< Range [1;7], 1 is sunday.
+	PROTOCOL_FIELD_DAY, //!< Range [1;31].
+	PROTOCOL_FIELD_MONTH, //!< Range [1;12].
+	PROTOCOL_FIELD_YEAR, //!< Range [2000;2099].
+	PROTOCOL_FIELD_ALARM_HOUR, //!< Range [0;23].
+	PROTOCOL_FIELD_ALARM_MINUTES, //!< Range [0;59].
+	PROTOCOL_FIELDS_COUNT
+} TProtocolField;
+
+/** The clock configuration, only the fields selected by a frame field mask are meaningful. */
+typedef struct
+{
+	int Fields[PROTOCOL_FIELDS_COUNT]; //!< The fields values, indexed by TProtocolField.
+} TProtocolConfiguration;
+
+/** The clock state reported by its telemetry. */
+typedef struct
+{
+	int Sequence_Number; //!< Incremented by the clock each time it publishes its status (once per second), an unchanged value tells that the telemetry is stale.
+	TProtocolConfiguration Clock; //!< The clock date and time and its alarm. The alarm fields are -1 if the clock alarm is invalid (it was never set).
+	int Temperature; //!< The filtered temperature in centigrade degrees.
+	int Flags; //!< The PROTOCOL_TELEMETRY_FLAG_xxx values OR'ed.
+	int UART_Overrun_Errors_Count; //!< How many UART overruns happened since the clock started, saturated to 255.
+	int UART_Framing_Errors_Count; //!< How many bytes the clock received with a framing error since it started, saturated to 255.
+	int Button_Bounces_Count; //!< How many bounces of the snooze button and alarm switch contacts the clock filtered out since it started, saturated to 255.
+	int Tick_Period; //!< The clock RTC 1Hz signal period measured with the clock timer, in the clock timestamp units.
+	int Request_Timestamp; //!< When the clock received the telemetry request, in milliseconds from the beginning of the reported second (the request comes after the status publication, so it can exceed 1000), or PROTOCOL_NO_TIMESTAMP.
+	int UART_Frame_Timestamp; //!< When the clock received its last configuration frame, in milliseconds from the beginning of the reported second (negative if it was received during a previous second), or PROTOCOL_NO_TIMESTAMP.
+	int Button_Press_Timestamp; //!< When the snooze button was last pressed, in milliseconds from the beginning of the reported second, or PROTOCOL_NO_TIMESTAMP.
+	int Temperature_Sample_Timestamp; //!< When the temperature was last sampled, in milliseconds from the beginning of the reported second, or PROTOCOL_NO_TIMESTAMP.
+} TProtocolTelemetry;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Tell whether a configuration field value can be sent to the clock.
+ * @param Field The field.
+ * @param Value The value to check.
+ * @return 1 if the value is in the field range,
+ * @return 0 otherwise.
+ */
+int ProtocolIsFieldValid(TProtocolField Field, int Value);
+
+/** Encode a command, prefixed by the destination address if the line is shared.
+ * @param Unit_Address The clock address, PROTOCOL_BROADCAST_ADDRESS to send the command to all clocks, or PROTOCOL_NO_UNIT_ADDRESS when the clock is alone on its line.
+ * @param Command The command or the magic number.
+ * @param Pointer_Buffer On output, contain the frame.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return The frame size in bytes,
+ * @return -1 if the address is invalid or the buffer is too small.
+ */
+int ProtocolEncodeCommand(int Unit_Address, unsigned char Command, unsigned char *Pointer_Buffer, int Buffer_Size);
+
+/** Encode a command followed by a one-byte parameter, like the ringtone or the unit address ones.
+ * @param Unit_Address The clock address, see ProtocolEncodeCommand().
+ * @param Command The command.
+ * @param Parameter The command parameter.
+ * @param Pointer_Buffer On output, contain the frame.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return The frame size in bytes,
+ * @return -1 if the address is invalid or the buffer is too small.
+ */
+int ProtocolEncodeParameterCommand(int Unit_Address, unsigned char Command, unsigned char Parameter, unsigned char *Pointer_Buffer, int Buffer_Size);
+
+/** Encode the crystal curve command. The crystal frequency error in ppb is Offset - Curvature * (Temperature - Turnover_Temperature)².
+ * @param Unit_Address The clock address, see ProtocolEncodeCommand().
+ * @param Turnover_Temperature The temperature the crystal runs the fastest at, in range [0;PROTOCOL_MAXIMUM_CRYSTAL_TURNOVER_TEMPERATURE] centigrade degrees.
+ * @param Curvature How fast the crystal slows down away from its turnover temperature, in range [0;PROTOCOL_MAXIMUM_CRYSTAL_CURVATURE] ppb per squared centigrade degree.
+ * @param Offset The crystal frequency error at its turnover temperature, in range [-PROTOCOL_MAXIMUM_CRYSTAL_OFFSET;PROTOCOL_MAXIMUM_CRYSTAL_OFFSET] ppb (positive when the crystal runs fast).
+ * @param Pointer_Buffer On output, contain the frame.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return The frame size in bytes,
+ * @return -1 if a parameter is invalid or the buffer is too small.
+ */
+int ProtocolEncodeCrystalCurve(int Unit_Address, int Turnover_Temperature, int Curvature, int Offset, unsigned char *Pointer_Buffer, int Buffer_Size);
+
+/** Encode the selected configuration fields in Binary Coded Decimal, as they follow a configuration command.
+ * @param Field_Mask The fields to encode (PROTOCOL_FIELD_MASK_xxx bits, the date and time bits select the fields in the RTC registers order).
+ * @param Pointer_Configuration The fields values.
+ * @param Pointer_Buffer On output, contain the encoded fields.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return The encoded fields size in bytes,
+ * @return -1 if a selected field is out of range or the buffer is too small.
+ */
+int ProtocolEncodeConfigurationFields(unsigned char Field_Mask, TProtocolConfiguration *Pointer_Configuration, unsigned char *Pointer_Buffer, int Buffer_Size);
+
+/** Encode a whole partial configuration frame, the clock executes it without any intermediate acknowledge.
+ * @param Unit_Address The clock address, see ProtocolEncodeCommand().
+ * @param Command PROTOCOL_COMMAND_SET_ALARM, PROTOCOL_COMMAND_SET_TIME, PROTOCOL_COMMAND_SET_DATE or PROTOCOL_COMMAND_SET_FIELDS.
+ * @param Field_Mask The fields to send with PROTOCOL_COMMAND_SET_FIELDS, it is ignored by the other commands.
+ * @param Pointer_Configuration The fields values.
+ * @param Pointer_Buffer On output, contain the frame.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return The frame size in bytes,
+ * @return -1 if a parameter is invalid or the buffer is too small.
+ */
+int ProtocolEncodeConfigurationFrame(int Unit_Address, unsigned char Command, unsigned char Field_Mask, TProtocolConfiguration *Pointer_Configuration, unsigned char *Pointer_Buffer, int Buffer_Size);
+
+/** Decode a configuration frame the way the clock does, including whole configuration frames starting with the magic number.
+ * @param Pointer_Buffer The received bytes.
+ * @param Buffer_Size How many bytes are available.
+ * @param Pointer_Unit_Address On output, contain the frame destination address or PROTOCOL_NO_UNIT_ADDRESS.
+ * @param Pointer_Command On output, contain the command or the magic number.
+ * @param Pointer_Field_Mask On output, contain the received fields mask.
+ * @param Pointer_Configuration On output, the received fields are updated, the other ones are left unmodified.
+ * @return The frame size in bytes when a whole frame was decoded,
+ * @return 0 if more bytes are needed,
+ * @return -1 if the bytes are not a valid configuration frame.
+ */
+int ProtocolDecodeConfigurationFrame(unsigned char *Pointer_Buffer, int Buffer_Size, int *Pointer_Unit_Address, unsigned char *Pointer_Command, unsigned char *Pointer_Field_Mask, TProtocolConfiguration *Pointer_Configuration);
+
+/** Decode the clock answer to a telemetry command.
+ * @param Pointer_Buffer The received bytes.
+ * @param Buffer_Size How many bytes are available.
+ * @param Pointer_Telemetry On output, contain the decoded telemetry.
+ * @return PROTOCOL_TELEMETRY_SIZE when the whole answer was decoded,
+ * @return 0 if more bytes are needed,
+ * @return -1 if the date and time are invalid.
+ */
+int ProtocolDecodeTelemetry(unsigned char *Pointer_Buffer, int Buffer_Size, TProtocolTelemetry *Pointer_Telemetry);
+
+#endif
@@ -0,0 +1,267 @@
+/** @file DS1307.c
+ * @see DS1307.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "DS1307.h"
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+// Clock registers addresses
+#define DS1307_REGISTER_SECONDS 0
+#define DS1307_REGISTER_MINUTES 1
+#define DS1307_REGISTER_HOURS 2
+#define DS1307_REGISTER_DAY 3
+#define DS1307_REGISTER_DATE 4
+#define DS1307_REGISTER_MONTH 5
+#define DS1307_REGISTER_YEAR 6
+#define DS1307_REGISTER_CONTROL 7
+
+/** How many registers hold the date and time. */
+#define DS1307_CLOCK_REGISTERS_COUNT 7
+
+/** The Clock Halt bit of the seconds register. */
+#define DS1307_SECONDS_CLOCK_HALT_BIT 0x80
+
+/** The control register OUT bit, it gives the pin level when the square wave is disabled. */
+#define DS1307_CONTROL_OUT_BIT 0x80
+/** The control register SQWE bit. */
+#define DS1307_CONTROL_SQUARE_WAVE_ENABLE_BIT 0x10
+/** The control register RS1 and RS0 bits. */
+#define DS1307_CONTROL_RATE_SELECT_MASK 0x03
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** The I2C slave interface states. */
+typedef enum
+{
+	DS1307_I2C_STATE_IDLE, //!< The DS1307 is not addressed.
+	DS1307_I2C_STATE_RECEIVE_ADDRESS, //!< A Start condition was received, the next byte is the slave address.
+	DS1307_I2C_STATE_RECEIVE_REGISTER_POINTER, //!< The DS1307 was addressed for writing, the next byte is the register pointer.
+	DS1307_I2C_STATE_RECEIVE_DATA, //!< All following bytes are written to the memory.
+	DS1307_I2C_STATE_TRANSMIT_DATA //!< The DS1307 was addressed for reading.
+} TDS1307I2CState;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The clock registers and the RAM. */
+static unsigned char DS1307_Memory[DS1307_MEMORY_SIZE];
+
+/** The clock registers copy the I2C reads are served from, it is updated on each Start condition so a read transaction is never torn by a seconds increment. */
+static unsigned char DS1307_Clock_Registers_Buffer[DS1307_CLOCK_REGISTERS_COUNT];
+
+/** The 1Hz signal level coming from the oscillator. */
+static unsigned char DS1307_Oscillator_Level;
+/** Set when the seconds register was written, which resets the oscillator divider chain. */
+static unsigned char DS1307_Is_Divider_Reset;
+
+/** The I2C interface state. */
+static TDS1307I2CState DS1307_I2C_State;
+/** The next memory address to access. */
+static unsigned char DS1307_Register_Pointer;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Convert a BCD byte to binary.
+ * @param BCD_Number The number to convert.
+ * @return The binary value.
+ */
+static int DS1307ConvertBCDToBinary(unsigned char BCD_Number)
+{
+	return ((BCD_Number >> 4) * 10) + (BCD_Number & 0x0F);
+}
+
+/** Convert a binary number in range [0; 99] to BCD.
+ * @param Number The number to convert.
+ * @return The BCD value.
+ */
+static unsigned char DS1307ConvertBinaryToBCD(int Number)
+{
+	return (unsigned char) (((Number / 10) << 4) | (Number % 10));
+}
+
+/** Increment a BCD clock register.
+ * @param Address The register address.
+ * @param Mask The register bits holding the value.
+ * @param Minimum The value following the maximum one.
+ * @param Maximum The last valid value.
+ * @return 1 if the register wrapped around and the next register must be incremented,
+ * @return 0 otherwise.
+ */
+static int DS1307IncrementRegister(int Address, unsigned char Mask, int Minimum, int Maximum)
+{
+	int Value, Has_Wrapped_Around = 0;
+	
+	Value = DS1307ConvertBCDToBinary(DS1307_Memory[Address] & Mask);
+	if (Value >= Maximum)
+	{
+		Value = Minimum;
+		Has_Wrapped_Around = 1;
+	}
+	else Value++;
+	
+	DS1307_Memory[Address] = (DS1307_Memory[Address] & ~Mask) | DS1307ConvertBinaryToBCD(Value);
+	return Has_Wrapped_Around;
+}
+
+/** Get the month length, taking leap years into account the same way the DS1307 does (every year divisible by 4, which is right until 2100).
+ * @return How many days are in the current month.
+ */
+static int DS1307GetMonthDaysCount(void)
+{
+	static const int Days_Count[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	int Month, Year;
+	
+	Month = DS1307ConvertBCDToBinary(DS1307_Memory[DS1307_REGISTER_MONTH] & 0x1F);
+	Year = DS1307ConvertBCDToBinary(DS1307_Memory[DS1307_REGISTER_YEAR]);
+	
+	if ((Month < 1) || (Month > 12)) return 31; // The real chip does not check the registers content either
+	if ((Month == 2) && ((Year % 4) == 0)) return 29;
+	return Days_Count[Month - 1];
+}
+
+/** Increment the time and date by one second. */
+static void DS1307IncrementSeconds(void)
+{
+	if (!DS1307IncrementRegister(DS1307_REGISTER_SECONDS, 0x7F, 0, 59)) return;
+	if (!DS1307IncrementRegister(DS1307_REGISTER_MINUTES, 0x7F, 0, 59)) return;
+	if (!DS1307IncrementRegister(DS1307_REGISTER_HOURS, 0x3F, 0, 23)) return; // Only the 24-hour mode used by the firmware is simulated
+	
+	// A new day begins
+	DS1307IncrementRegister(DS1307_REGISTER_DAY, 0x07, 1, 7);
+	if (!DS1307IncrementRegister(DS1307_REGISTER_DATE, 0x3F, 1, DS1307GetMonthDaysCount())) return;
+	if (!DS1307IncrementRegister(DS1307_REGISTER_MONTH, 0x1F, 1, 12)) return;
+	DS1307IncrementRegister(DS1307_REGISTER_YEAR, 0xFF, 0, 99);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void DS1307Initialize(void)
+{
+	int i;
+	
+	for (i = 0; i < DS1307_MEMORY_SIZE; i++) DS1307_Memory[i] = 0;
+	DS1307SetDateAndTime(2000, 1, 1, 7, 0, 0, 0);
+	
+	DS1307_Oscillator_Level = 1;
+	DS1307_Is_Divider_Reset = 0;
+	DS1307_I2C_State = DS1307_I2C_STATE_IDLE;
+	DS1307_Register_Pointer = 0;
+}
+
+void DS1307SetDateAndTime(int Year, int Month, int Day, int Day_Of_Week, int Hours, int Minutes, int Seconds)
+{
+	DS1307_Memory[DS1307_REGISTER_SECONDS] = DS1307ConvertBinaryToBCD(Seconds); // Also clear the Clock Halt bit
+	DS1307_Memory[DS1307_REGISTER_MINUTES] = DS1307ConvertBinaryToBCD(Minutes);
+	DS1307_Memory[DS1307_REGISTER_HOURS] = DS1307ConvertBinaryToBCD(Hours);
+	DS1307_Memory[DS1307_REGISTER_DAY] = (unsigned char) Day_Of_Week;
+	DS1307_Memory[DS1307_REGISTER_DATE] = DS1307ConvertBinaryToBCD(Day);
+	DS1307_Memory[DS1307_REGISTER_MONTH] = DS1307ConvertBinaryToBCD(Month);
+	DS1307_Memory[DS1307_REGISTER_YEAR] = DS1307ConvertBinaryToBCD(Year - 2000);
+}
+
+unsigned char DS1307ReadMemory(unsigned char Address)
+{
+	return DS1307_Memory[Address % DS1307_MEMORY_SIZE];
+}
+
+void DS1307WriteMemory(unsigned char Address, unsigned char Byte)
+{
+	DS1307_Memory[Address % DS1307_MEMORY_SIZE] = Byte;
+}
+
+void DS1307HalfSecondElapsed(void)
+{
+	// The oscillator is stopped while the Clock Halt bit is set
+	if (DS1307_Memory[DS1307_REGISTER_SECONDS] & DS1307_SECONDS_CLOCK_HALT_BIT) return;
+	
+	DS1307_Oscillator_Level = !DS1307_Oscillator_Level;
+	if (!DS1307_Oscillator_Level) DS1307IncrementSeconds();
+}
+
+unsigned char DS1307IsDividerReset(void)
+{
+	unsigned char Is_Divider_Reset;
+	
+	Is_Divider_Reset = DS1307_Is_Divider_Reset;
+	DS1307_Is_Divider_Reset = 0;
+	return Is_Divider_Reset;
+}
+
+unsigned char DS1307GetSquareWaveLevel(void)
+{
+	unsigned char Control;
+	
+	Control = DS1307_Memory[DS1307_REGISTER_CONTROL];
+	
+	// Only the 1Hz rate used by the firmware is simulated, other rates keep the pin at its OUT level
+	if ((Control & DS1307_CONTROL_SQUARE_WAVE_ENABLE_BIT) && ((Control & DS1307_CONTROL_RATE_SELECT_MASK) == 0)) return DS1307_Oscillator_Level;
+	if (Control & DS1307_CONTROL_OUT_BIT) return 1;
+	return 0;
+}
+
+void DS1307I2CStart(void)
+{
+	int i;
+	
+	for (i = 0; i < DS1307_CLOCK_REGISTERS_COUNT; i++) DS1307_Clock_Registers_Buffer[i] = DS1307_Memory[i];
+	DS1307_I2C_State = DS1307_I2C_STATE_RECEIVE_ADDRESS;
+}
+
+void DS1307I2CStop(void)
+{
+	DS1307_I2C_State = DS1307_I2C_STATE_IDLE;
+}
+
+unsigned char DS1307I2CWriteByte(unsigned char Byte)
+{
+	switch (DS1307_I2C_State)
+	{
+		case DS1307_I2C_STATE_RECEIVE_ADDRESS:
+			if ((Byte & 0xFE) != DS1307_I2C_ADDRESS)
+			{
+				DS1307_I2C_State = DS1307_I2C_STATE_IDLE;
+				return 0;
+			}
+			if (Byte & 0x01) DS1307_I2C_State = DS1307_I2C_STATE_TRANSMIT_DATA;
+			else DS1307_I2C_State = DS1307_I2C_STATE_RECEIVE_REGISTER_POINTER;
+			return 1;
+		
+		case DS1307_I2C_STATE_RECEIVE_REGISTER_POINTER:
+			DS1307_Register_Pointer = Byte % DS1307_MEMORY_SIZE;
+			DS1307_I2C_State = DS1307_I2C_STATE_RECEIVE_DATA;
+			return 1;
+		
+		case DS1307_I2C_STATE_RECEIVE_DATA:
+			DS1307_Memory[DS1307_Register_Pointer] = Byte;
+		
+			// Writing the seconds restarts a whole second, the square wave output goes low until the next half second
+			if (DS1307_Register_Pointer == DS1307_REGISTER_SECONDS)
+			{
+				DS1307_Oscillator_Level = 0;
+				DS1307_Is_Divider_Reset = 1;
+			}
+			DS1307_Register_Pointer = (DS1307_Register_Pointer + 1) % DS1307_MEMORY_SIZE;
+			return 1;
+		
+		default:
+			return 0;
+	}
+}
+
+unsigned char DS1307I2CReadByte(void)
+{
+	unsigned char Byte;
+	
+	if (DS1307_I2C_State != DS1307_I2C_STATE_TRANSMIT_DATA) return 0xFF; // The bus is pulled up when nobody drives it
+	
+	if (DS1307_Register_Pointer < DS1307_CLOCK_REGISTERS_COUNT) Byte = DS1307_Clock_Registers_Buffer[DS1307_Register_Pointer];
+	else Byte = DS1307_Memory[DS1307_Register_Pointer];
+	DS1307_Register_Pointer = (DS1307_Register_Pointer + 1) % DS1307_MEMORY_SIZE;
+	
+	return Byte;
+}
@@ -0,0 +1,79 @@
+/** @file DS1307.h
+ * Simulate the DS1307 Real-Time Clock : the 64-byte memory, the calendar, the 1Hz square wave output and the I2C slave interface.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_DS1307_H
+#define H_DS1307_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** The DS1307 memory size in bytes (clock registers and RAM). */
+#define DS1307_MEMORY_SIZE 64
+
+/** The DS1307 I2C address ready to be sent on the bus (the R/#W bit is not included). */
+#define DS1307_I2C_ADDRESS 0xD0
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Start the clock on saturday 2000/01/01 00:00:00 with a cleared RAM, as if its battery was just installed and the time was set to the DS1307 epoch. */
+void DS1307Initialize(void);
+
+/** Directly set the clock registers, without going through the I2C bus.
+ * @param Year The year in range [2000; 2099].
+ * @param Month The month in range [1; 12].
+ * @param Day The day of the month in range [1; 31].
+ * @param Day_Of_Week The day of the week in range [1; 7], 1 is sunday.
+ * @param Hours The hours in range [0; 23].
+ * @param Minutes The minutes in range [0; 59].
+ * @param Seconds The seconds in range [0; 59].
+ */
+void DS1307SetDateAndTime(int Year, int Month, int Day, int Day_Of_Week, int Hours, int Minutes, int Seconds);
+
+/** Directly read a memory byte, without going through the I2C bus.
+ * @param Address The byte address, in range [0; DS1307_MEMORY_SIZE - 1].
+ * @return The byte value.
+ */
+unsigned char DS1307ReadMemory(unsigned char Address);
+
+/** Directly write a memory byte, without going through the I2C bus.
+ * @param Address The byte address, in range [0; DS1307_MEMORY_SIZE - 1].
+ * @param Byte The byte value.
+ */
+void DS1307WriteMemory(unsigned char Address, unsigned char Byte);
+
+/** Must be called every 500ms of simulated time. The seconds register is incremented when the square wave output goes low. */
+void DS1307HalfSecondElapsed(void);
+
+/** Tell whether the seconds register was written since the last call, in this case the next half second must be counted from now.
+ * @return 0 if the oscillator divider chain kept running,
+ * @return 1 if the divider chain was reset.
+ */
+unsigned char DS1307IsDividerReset(void);
+
+/** Get the SQW/OUT pin level.
+ * @return 0 if the pin is low,
+ * @return 1 if the pin is high.
+ */
+unsigned char DS1307GetSquareWaveLevel(void);
+
+/** An I2C Start condition has been sent on the bus. */
+void DS1307I2CStart(void);
+
+/** An I2C Stop condition has been sent on the bus. */
+void DS1307I2CStop(void);
+
+/** The master sent a byte.
+ * @param Byte The byte.
+ * @return 1 if the DS1307 acknowledged the byte,
+ * @return 0 if the byte was not acknowledged.
+ */
+unsigned char DS1307I2CWriteByte(unsigned char Byte);
+
+/** The master read a byte.
+ * @return The byte sent by the DS1307, or 0xFF if it was not addressed for reading.
+ */
+unsigned char DS1307I2CReadByte(void);
+
+#endif
@@ -0,0 +1,812 @@
+/** @file Hardware.c
+ * @see Hardware.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "DS1307.h"
+#include "Hardware.h"
+#include "LCD.h"
+#include "Scenario.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <system.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Build the mask of a register bit.
+ * @param Bit The bit number.
+ */
+#define HARDWARE_BIT(Bit) (1 << (Bit))
+
+/** The UART reception FIFO size. */
+#define HARDWARE_UART_RECEPTION_FIFO_SIZE 2
+/** How many bytes can wait to be sent to the UART. */
+#define HARDWARE_UART_PENDING_BYTES_MAXIMUM_COUNT 256
+/** How many UART transmission events (and thus transmitted bytes) can be stored until the scenario retrieves them. */
+#define HARDWARE_UART_EVENTS_MAXIMUM_COUNT 256
+
+/** How long the main loop runs after an interrupt was served before it can be considered idle again, it gives it the time to process the posted events. */
+#define HARDWARE_MAIN_LOOP_ITERATION_DURATION 20
+
+/** How many times in a row the interrupt handler can be entered without the simulated time advancing, more means that an interrupt flag is never cleared. */
+#define HARDWARE_MAXIMUM_CONSECUTIVE_INTERRUPTS_COUNT 100
+
+/** How long the snooze button contact bounces after being pressed or released, like a worn switch does. */
+#define HARDWARE_SNOOZE_BUTTON_BOUNCE_DURATION ((50 * HARDWARE_TIME_UNITS_PER_SECOND) / 1000)
+/** How long the snooze button contact stays in the same state while it bounces. */
+#define HARDWARE_SNOOZE_BUTTON_BOUNCE_PERIOD ((7 * HARDWARE_TIME_UNITS_PER_SECOND) / 1000)
+
+/** The DS1307 crystal turnover temperature in centigrade degrees, it runs at its nominal frequency at this temperature. */
+#define HARDWARE_CRYSTAL_TURNOVER_TEMPERATURE 25
+/** How much slower the DS1307 crystal runs away from its turnover temperature, in ppb per squared centigrade degree (a typical 32.768KHz tuning fork crystal value). */
+#define HARDWARE_CRYSTAL_CURVATURE 34
+
+/** Tell that no event is scheduled. */
+#define HARDWARE_NO_EVENT_TIME ((unsigned long long) -1)
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All special function registers. The peripherals registers that are computed on access are not stored here. */
+static unsigned char Hardware_Registers[SIMULATOR_REGISTERS_COUNT];
+
+/** The simulated time elapsed since power on. */
+static unsigned long long Hardware_Time;
+/** When the next DS1307 oscillator half period ends. */
+static unsigned long long Hardware_RTC_Half_Second_Time;
+/** The DS1307 oscillator delay that is still too small to be simulated, in billionths of time unit. */
+static unsigned long long Hardware_RTC_Drift_Remainder;
+/** When the scenario must be executed again. */
+static unsigned long long Hardware_Scenario_Time;
+
+/** When timer 1 was at zero, timer 1 value is computed from this time while it is running. */
+static unsigned long long Hardware_Timer_1_Origin_Time;
+/** The next CCP1 compare match, or HARDWARE_NO_EVENT_TIME. */
+static unsigned long long Hardware_Timer_1_Match_Time;
+
+/** When the ADC conversion in progress ends, or HARDWARE_NO_EVENT_TIME. */
+static unsigned long long Hardware_ADC_Conversion_End_Time;
+/** The LM35DZ temperature in centigrade degrees. */
+static int Hardware_Temperature;
+
+/** The alarm switch position. */
+static int Hardware_Is_Alarm_Switch_Enabled;
+/** When the snooze button was last pressed, or HARDWARE_NO_EVENT_TIME if it was never pressed. */
+static unsigned long long Hardware_Snooze_Button_Press_Time;
+/** When the snooze button was or will be released. */
+static unsigned long long Hardware_Snooze_Button_Release_Time;
+
+/** The bytes waiting to be sent to the UART. */
+static unsigned char Hardware_UART_Pending_Bytes[HARDWARE_UART_PENDING_BYTES_MAXIMUM_COUNT];
+/** How many bytes are waiting to be sent to the UART. */
+static int Hardware_UART_Pending_Bytes_Count;
+/** When the next byte will be fully received, or HARDWARE_NO_EVENT_TIME. */
+static unsigned long long Hardware_UART_Reception_Time;
+/** The UART reception FIFO. */
+static unsigned char Hardware_UART_Reception_FIFO[HARDWARE_UART_RECEPTION_FIFO_SIZE];
+/** How many bytes are in the reception FIFO. */
+static int Hardware_UART_Reception_FIFO_Count;
+/** The transmitter events, including the bytes transmitted by the firmware. */
+static THardwareUARTEvent Hardware_UART_Events[HARDWARE_UART_EVENTS_MAXIMUM_COUNT];
+/** How many transmitter events were stored. */
+static int Hardware_UART_Events_Count;
+/** Set to 1 when some transmitter events could not be stored. */
+static int Hardware_Is_UART_Events_Overflow;
+
+/** Set to 1 while the firmware interrupt handler is running. */
+static int Hardware_Is_Interrupt_Handler_Running;
+/** Set to 1 when an interrupt has been served since the main loop last polled the RTC 1Hz signal. */
+static int Hardware_Has_Interrupt_Been_Served;
+
+/** Where the firmware is started again when the microcontroller is reset. */
+static jmp_buf Hardware_Reset_Context;
+/** Set to 1 when the scenario requested a reset. */
+static int Hardware_Is_Reset_Requested;
+/** The requested reset cause. */
+static THardwareResetType Hardware_Reset_Type;
+/** When the firmware started booting the last time. */
+static unsigned long long Hardware_Boot_Start_Time;
+/** How long the last boot lasted, or HARDWARE_BOOT_IN_PROGRESS. */
+static unsigned long long Hardware_Boot_Duration;
+
+//-------------------------------------------------------------------------------------------------
+// Firmware functions
+//-------------------------------------------------------------------------------------------------
+/** The firmware entry point (its main() function, renamed when it is translated). */
+void FirmwareMain(void);
+
+/** The firmware interrupt handler. */
+void interrupt(void);
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Stop the simulation because the firmware did something that can't be simulated.
+ * @param String_Message The reason.
+ */
+static void HardwareAbort(char *String_Message)
+{
+	printf("Error : %s (simulated time %.3f s).\n", String_Message, (double) Hardware_Time / HARDWARE_TIME_UNITS_PER_SECOND);
+	exit(EXIT_FAILURE);
+}
+
+/** Get the timer 1 prescaler value.
+ * @return The prescaler value.
+ */
+static unsigned long long HardwareGetTimer1Prescaler(void)
+{
+	return 1ULL << ((Hardware_Registers[SIMULATOR_REGISTER_T1CON] >> 4) & 0x03);
+}
+
+/** Tell whether the CCP1 module resets timer 1 on a compare match (special event trigger mode).
+ * @return 1 if timer 1 is reset by the CCP1 module, 0 otherwise.
+ */
+static int HardwareIsTimer1ResetByCCP1(void)
+{
+	return (Hardware_Registers[SIMULATOR_REGISTER_CCP1CON] & 0x0F) == 0x0B;
+}
+
+/** Get the timer 1 value.
+ * @return The 16-bit timer value.
+ */
+static unsigned int HardwareGetTimer1Value(void)
+{
+	unsigned long long Increments, Period;
+	
+	if (!(Hardware_Registers[SIMULATOR_REGISTER_T1CON] & HARDWARE_BIT(TMR1ON))) return (Hardware_Registers[SIMULATOR_REGISTER_TMR1H] << 8) | Hardware_Registers[SIMULATOR_REGISTER_TMR1L];
+	
+	Increments = (Hardware_Time - Hardware_Timer_1_Origin_Time) / HardwareGetTimer1Prescaler();
+	if (HardwareIsTimer1ResetByCCP1())
+	{
+		Period = ((Hardware_Registers[SIMULATOR_REGISTER_CCPR1H] << 8) | Hardware_Registers[SIMULATOR_REGISTER_CCPR1L]) + 1;
+		return (unsigned int) (Increments % Period);
+	}
+	return (unsigned int) (Increments & 0xFFFF);
+}
+
+/** Compute when the next CCP1 compare match will happen. Must be called each time timer 1 or the CCP1 module configuration changes. */
+static void HardwareScheduleTimer1Match(void)
+{
+	unsigned long long Period;
+	
+	if (!(Hardware_Registers[SIMULATOR_REGISTER_T1CON] & HARDWARE_BIT(TMR1ON)) || !HardwareIsTimer1ResetByCCP1())
+	{
+		Hardware_Timer_1_Match_Time = HARDWARE_NO_EVENT_TIME;
+		return;
+	}
+	
+	// The compare match sets the interrupt flag and resets the timer once per period
+	Period = (((Hardware_Registers[SIMULATOR_REGISTER_CCPR1H] << 8) | Hardware_Registers[SIMULATOR_REGISTER_CCPR1L]) + 1) * HardwareGetTimer1Prescaler();
+	Hardware_Timer_1_Match_Time = Hardware_Timer_1_Origin_Time + (((Hardware_Time - Hardware_Timer_1_Origin_Time) / Period) + 1) * Period;
+}
+
+/** Set timer 1 value, keeping it counting if it is running.
+ * @param Value The new value.
+ */
+static void HardwareSetTimer1Value(unsigned int Value)
+{
+	Hardware_Registers[SIMULATOR_REGISTER_TMR1H] = (unsigned char) (Value >> 8);
+	Hardware_Registers[SIMULATOR_REGISTER_TMR1L] = (unsigned char) Value;
+	Hardware_Timer_1_Origin_Time = Hardware_Time - (Value * HardwareGetTimer1Prescaler());
+	HardwareScheduleTimer1Match();
+}
+
+/** Update the UART reception interrupt flag from the reception FIFO content. */
+static void HardwareUpdateUARTReceptionFlag(void)
+{
+	if (Hardware_UART_Reception_FIFO_Count > 0) Hardware_Registers[SIMULATOR_REGISTER_PIR1] |= HARDWARE_BIT(RCIF);
+	else Hardware_Registers[SIMULATOR_REGISTER_PIR1] &= ~HARDWARE_BIT(RCIF);
+}
+
+/** Pop a byte from the UART reception FIFO.
+ * @return The oldest received byte.
+ */
+static unsigned char HardwareReadUARTByte(void)
+{
+	unsigned char Byte;
+	int i;
+	
+	if (Hardware_UART_Reception_FIFO_Count == 0) return Hardware_Registers[SIMULATOR_REGISTER_RCREG];
+	
+	Byte = Hardware_UART_Reception_FIFO[0];
+	for (i = 1; i < Hardware_UART_Reception_FIFO_Count; i++) Hardware_UART_Reception_FIFO[i - 1] = Hardware_UART_Reception_FIFO[i];
+	Hardware_UART_Reception_FIFO_Count--;
+	Hardware_Registers[SIMULATOR_REGISTER_RCREG] = Byte;
+	
+	HardwareUpdateUARTReceptionFlag();
+	return Byte;
+}
+
+/** Store a UART transmitter event.
+ * @param Type The event type.
+ * @param Byte The written byte, if any.
+ */
+static void HardwareAddUARTEvent(THardwareUARTEventType Type, unsigned char Byte)
+{
+	if (Hardware_UART_Events_Count == HARDWARE_UART_EVENTS_MAXIMUM_COUNT)
+	{
+		Hardware_Is_UART_Events_Overflow = 1;
+		return;
+	}
+	
+	Hardware_UART_Events[Hardware_UART_Events_Count].Time = Hardware_Time;
+	Hardware_UART_Events[Hardware_UART_Events_Count].Type = Type;
+	Hardware_UART_Events[Hardware_UART_Events_Count].Byte = Byte;
+	Hardware_UART_Events_Count++;
+}
+
+/** Receive the next pending UART byte. */
+static void HardwareReceiveUARTByte(void)
+{
+	int i;
+	
+	// Bytes are lost when the receiver is disabled or when the FIFO is full
+	if ((Hardware_Registers[SIMULATOR_REGISTER_RCSTA] & 0x90) != 0x90) printf("Warning : the byte 0x%02X was sent while the UART receiver is disabled, it is lost.\n", Hardware_UART_Pending_Bytes[0]);
+	else if (Hardware_UART_Reception_FIFO_Count == HARDWARE_UART_RECEPTION_FIFO_SIZE)
+	{
+		Hardware_Registers[SIMULATOR_REGISTER_RCSTA] |= HARDWARE_BIT(OERR);
+		printf("Warning : UART overrun, the byte 0x%02X is lost.\n", Hardware_UART_Pending_Bytes[0]);
+	}
+	else
+	{
+		Hardware_UART_Reception_FIFO[Hardware_UART_Reception_FIFO_Count] = Hardware_UART_Pending_Bytes[0];
+		Hardware_UART_Reception_FIFO_Count++;
+		HardwareUpdateUARTReceptionFlag();
+	}
+	
+	// Start receiving the next byte
+	for (i = 1; i < Hardware_UART_Pending_Bytes_Count; i++) Hardware_UART_Pending_Bytes[i - 1] = Hardware_UART_Pending_Bytes[i];
+	Hardware_UART_Pending_Bytes_Count--;
+	if (Hardware_UART_Pending_Bytes_Count > 0) Hardware_UART_Reception_Time = Hardware_Time + HARDWARE_UART_BYTE_DURATION;
+	else Hardware_UART_Reception_Time = HARDWARE_NO_EVENT_TIME;
+}
+
+/** Store the conversion result of the LM35DZ output voltage (10mV per centigrade degree, the ADC reference is the 5V supply). */
+static void HardwareEndADCConversion(void)
+{
+	unsigned int Result;
+	
+	Result = (unsigned int) (((Hardware_Temperature * 1023 * 10) + 2500) / 5000);
+	if (Hardware_Registers[SIMULATOR_REGISTER_ADCON1] & 0x80) // Right justified
+	{
+		Hardware_Registers[SIMULATOR_REGISTER_ADRESH] = (unsigned char) (Result >> 8);
+		Hardware_Registers[SIMULATOR_REGISTER_ADRESL] = (unsigned char) Result;
+	}
+	else
+	{
+		Hardware_Registers[SIMULATOR_REGISTER_ADRESH] = (unsigned char) (Result >> 2);
+		Hardware_Registers[SIMULATOR_REGISTER_ADRESL] = (unsigned char) (Result << 6);
+	}
+	
+	Hardware_Registers[SIMULATOR_REGISTER_ADCON0] &= ~HARDWARE_BIT(GO);
+	Hardware_Registers[SIMULATOR_REGISTER_PIR1] |= HARDWARE_BIT(ADIF);
+	Hardware_ADC_Conversion_End_Time = HARDWARE_NO_EVENT_TIME;
+}
+
+/** Start an ADC conversion, it lasts 12 TAD. */
+static void HardwareStartADCConversion(void)
+{
+	static const unsigned long long Oscillator_Periods_Per_TAD[] = { 2, 8, 32, 16 }; // The RC oscillator TAD is typically 4us, which is 16 oscillator periods at 4MHz
+	
+	if (!(Hardware_Registers[SIMULATOR_REGISTER_ADCON0] & HARDWARE_BIT(ADON))) return;
+	Hardware_ADC_Conversion_End_Time = Hardware_Time + (12 * Oscillator_Periods_Per_TAD[Hardware_Registers[SIMULATOR_REGISTER_ADCON0] >> 6]) / 4 + 1;
+}
+
+/** Execute the operation requested to the MSSP module by setting a SSPCON2 bit. The bus is so fast compared to the simulated events that the operation is considered instantaneous. */
+static void HardwareExecuteI2COperation(void)
+{
+	unsigned char Control;
+	
+	Control = Hardware_Registers[SIMULATOR_REGISTER_SSPCON2];
+	if (Control & HARDWARE_BIT(SEN)) DS1307I2CStart();
+	else if (Control & HARDWARE_BIT(PEN)) DS1307I2CStop();
+	else if (Control & HARDWARE_BIT(RCEN)) Hardware_Registers[SIMULATOR_REGISTER_SSPBUF] = DS1307I2CReadByte();
+	else if (!(Control & HARDWARE_BIT(ACKEN))) return; // Only the acknowledge data bit was modified, it does not start an operation
+	
+	// The hardware clears the operation bit when it is done
+	Hardware_Registers[SIMULATOR_REGISTER_SSPCON2] &= ~(HARDWARE_BIT(SEN) | HARDWARE_BIT(PEN) | HARDWARE_BIT(RCEN) | HARDWARE_BIT(ACKEN));
+	Hardware_Registers[SIMULATOR_REGISTER_PIR1] |= HARDWARE_BIT(SSPIF);
+}
+
+/** Tell whether an enabled interrupt is pending.
+ * @return 1 if the interrupt handler must be called, 0 otherwise.
+ */
+static int HardwareIsInterruptPending(void)
+{
+	unsigned char Interrupt_Control;
+	
+	Interrupt_Control = Hardware_Registers[SIMULATOR_REGISTER_INTCON];
+	if ((Interrupt_Control & HARDWARE_BIT(INTF)) && (Interrupt_Control & HARDWARE_BIT(INTE))) return 1;
+	if ((Interrupt_Control & HARDWARE_BIT(PEIE)) && (Hardware_Registers[SIMULATOR_REGISTER_PIR1] & Hardware_Registers[SIMULATOR_REGISTER_PIE1])) return 1;
+	if ((Interrupt_Control & HARDWARE_BIT(PEIE)) && (Hardware_Registers[SIMULATOR_REGISTER_PIR2] & Hardware_Registers[SIMULATOR_REGISTER_PIE2])) return 1;
+	return 0;
+}
+
+/** Call the firmware interrupt handler as long as an enabled interrupt is pending, the same way the core would do it. */
+static void HardwareServeInterrupts(void)
+{
+	int Consecutive_Interrupts_Count = 0;
+	
+	// The handler can't be interrupted
+	if (Hardware_Is_Interrupt_Handler_Running) return;
+	
+	while ((Hardware_Registers[SIMULATOR_REGISTER_INTCON] & HARDWARE_BIT(GIE)) && HardwareIsInterruptPending())
+	{
+		Consecutive_Interrupts_Count++;
+		if (Consecutive_Interrupts_Count > HARDWARE_MAXIMUM_CONSECUTIVE_INTERRUPTS_COUNT) HardwareAbort("an interrupt flag is never cleared by the interrupt handler");
+		
+		Hardware_Is_Interrupt_Handler_Running = 1;
+		Hardware_Registers[SIMULATOR_REGISTER_INTCON] &= ~HARDWARE_BIT(GIE);
+		interrupt();
+		Hardware_Registers[SIMULATOR_REGISTER_INTCON] |= HARDWARE_BIT(GIE); // RETFIE
+		Hardware_Is_Interrupt_Handler_Running = 0;
+		
+		Hardware_Has_Interrupt_Been_Served = 1;
+	}
+}
+
+/** Get the next scheduled event time.
+ * @return The earliest event time.
+ */
+static unsigned long long HardwareGetNextEventTime(void)
+{
+	unsigned long long Time;
+	
+	Time = Hardware_RTC_Half_Second_Time;
+	if (Hardware_Timer_1_Match_Time < Time) Time = Hardware_Timer_1_Match_Time;
+	if (Hardware_ADC_Conversion_End_Time < Time) Time = Hardware_ADC_Conversion_End_Time;
+	if (Hardware_UART_Reception_Time < Time) Time = Hardware_UART_Reception_Time;
+	if (Hardware_Scenario_Time < Time) Time = Hardware_Scenario_Time;
+	return Time;
+}
+
+/** Set the registers values the microcontroller gets on a reset. */
+static void HardwareResetRegisters(void)
+{
+	int i;
+	
+	for (i = 0; i < SIMULATOR_REGISTERS_COUNT; i++) Hardware_Registers[i] = 0;
+	Hardware_Registers[SIMULATOR_REGISTER_TRISA] = 0x3F;
+	Hardware_Registers[SIMULATOR_REGISTER_TRISB] = 0xFF;
+	Hardware_Registers[SIMULATOR_REGISTER_TRISC] = 0xFF;
+	Hardware_Registers[SIMULATOR_REGISTER_OPTION_REG] = 0xFF;
+	Hardware_Registers[SIMULATOR_REGISTER_STATUS] = 0x18;
+	Hardware_Registers[SIMULATOR_REGISTER_PR2] = 0xFF;
+	Hardware_Registers[SIMULATOR_REGISTER_TXSTA] = HARDWARE_BIT(TRMT);
+	Hardware_Registers[SIMULATOR_REGISTER_PIR1] = HARDWARE_BIT(TXIF); // Transmission is instantaneous, so the transmit buffer is always empty
+}
+
+/** Reset the microcontroller as requested by the scenario, then start the firmware again. */
+static void HardwareApplyReset(void)
+{
+	unsigned char Ports[3], Power_Control;
+	int i;
+	
+	// The ports output latches and the POR bit are kept by a brown-out reset
+	for (i = 0; i < 3; i++) Ports[i] = Hardware_Registers[SIMULATOR_REGISTER_PORTA + i];
+	Power_Control = Hardware_Registers[SIMULATOR_REGISTER_PCON] & HARDWARE_BIT(NOT_POR);
+	HardwareResetRegisters();
+	if (Hardware_Reset_Type == HARDWARE_RESET_TYPE_BROWN_OUT)
+	{
+		for (i = 0; i < 3; i++) Hardware_Registers[SIMULATOR_REGISTER_PORTA + i] = Ports[i];
+		Hardware_Registers[SIMULATOR_REGISTER_PCON] = Power_Control;
+	}
+	else LCDInitialize(); // The display lost its power too
+	
+	// Stop the peripherals
+	Hardware_Timer_1_Origin_Time = Hardware_Time;
+	Hardware_Timer_1_Match_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_ADC_Conversion_End_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_UART_Reception_FIFO_Count = 0;
+	Hardware_Is_Interrupt_Handler_Running = 0;
+	Hardware_Has_Interrupt_Been_Served = 0;
+	
+	Hardware_Is_Reset_Requested = 0;
+	Hardware_Boot_Start_Time = Hardware_Time;
+	Hardware_Boot_Duration = HARDWARE_BOOT_IN_PROGRESS;
+	longjmp(Hardware_Reset_Context, 1);
+}
+
+/** Compute the DS1307 oscillator half period at the current temperature, the crystal running slower away from its turnover temperature.
+ * @return The half period in HARDWARE_TIME_UNITS_PER_SECOND units.
+ */
+static unsigned long long HardwareGetRTCHalfPeriod(void)
+{
+	unsigned long long Delay;
+	int Difference;
+	
+	// Accumulate the delay caused by the frequency error until it reaches a whole time unit
+	Difference = Hardware_Temperature - HARDWARE_CRYSTAL_TURNOVER_TEMPERATURE;
+	Hardware_RTC_Drift_Remainder += (HARDWARE_TIME_UNITS_PER_SECOND / 2) * HARDWARE_CRYSTAL_CURVATURE * (unsigned long long) (Difference * Difference);
+	Delay = Hardware_RTC_Drift_Remainder / 1000000000;
+	Hardware_RTC_Drift_Remainder %= 1000000000;
+	
+	return (HARDWARE_TIME_UNITS_PER_SECOND / 2) + Delay;
+}
+
+/** Process all events scheduled at the current time. */
+static void HardwareProcessEvents(void)
+{
+	if (Hardware_Time == Hardware_RTC_Half_Second_Time)
+	{
+		DS1307HalfSecondElapsed();
+		Hardware_RTC_Half_Second_Time += HardwareGetRTCHalfPeriod();
+	}
+	
+	if (Hardware_Time == Hardware_Timer_1_Match_Time)
+	{
+		Hardware_Registers[SIMULATOR_REGISTER_PIR1] |= HARDWARE_BIT(CCP1IF);
+		HardwareScheduleTimer1Match();
+	}
+	
+	if (Hardware_Time == Hardware_ADC_Conversion_End_Time) HardwareEndADCConversion();
+	if (Hardware_Time == Hardware_UART_Reception_Time) HardwareReceiveUARTByte();
+	
+	if (Hardware_Time == Hardware_Scenario_Time)
+	{
+		Hardware_Scenario_Time = ScenarioExecute();
+		if (Hardware_Is_Reset_Requested) HardwareApplyReset();
+	}
+}
+
+/** Let the simulated time pass, serving the interrupts as the events happen.
+ * @param Time The time to reach.
+ */
+static void HardwareRunUntil(unsigned long long Time)
+{
+	unsigned long long Next_Event_Time;
+	
+	while (1)
+	{
+		Next_Event_Time = HardwareGetNextEventTime();
+		if (Next_Event_Time > Time) break;
+		
+		Hardware_Time = Next_Event_Time;
+		HardwareProcessEvents();
+		HardwareServeInterrupts();
+	}
+	Hardware_Time = Time;
+}
+
+/** Called each time the firmware polls the RTC 1Hz signal. When no interrupt was served since the previous poll the main loop has nothing to do, so jump to the next event. */
+static void HardwareWaitInMainLoop(void)
+{
+	if (Hardware_Is_Interrupt_Handler_Running) return;
+	
+	// The first poll tells that the firmware has finished booting
+	if (Hardware_Boot_Duration == HARDWARE_BOOT_IN_PROGRESS) Hardware_Boot_Duration = Hardware_Time - Hardware_Boot_Start_Time;
+	
+	if (Hardware_Has_Interrupt_Been_Served)
+	{
+		Hardware_Has_Interrupt_Been_Served = 0;
+		HardwareRunUntil(Hardware_Time + HARDWARE_MAIN_LOOP_ITERATION_DURATION);
+	}
+	else HardwareRunUntil(HardwareGetNextEventTime());
+}
+
+/** Get the snooze button contact level. The contact alternately opens and closes for a while after the button is pressed or released.
+ * @return 1 if the contact is closed (RB0 is high), 0 otherwise.
+ */
+static int HardwareGetSnoozeButtonLevel(void)
+{
+	unsigned long long Edge_Time;
+	int Level;
+	
+	if ((Hardware_Snooze_Button_Press_Time == HARDWARE_NO_EVENT_TIME) || (Hardware_Time < Hardware_Snooze_Button_Press_Time)) return 0;
+	
+	if (Hardware_Time < Hardware_Snooze_Button_Release_Time)
+	{
+		Edge_Time = Hardware_Snooze_Button_Press_Time;
+		Level = 1;
+	}
+	else
+	{
+		Edge_Time = Hardware_Snooze_Button_Release_Time;
+		Level = 0;
+	}
+	
+	// The contact takes the new level first, then bounces back to the previous one every other bounce period
+	if ((Hardware_Time - Edge_Time < HARDWARE_SNOOZE_BUTTON_BOUNCE_DURATION) && (((Hardware_Time - Edge_Time) / HARDWARE_SNOOZE_BUTTON_BOUNCE_PERIOD) & 1)) Level = !Level;
+	return Level;
+}
+
+/** Get a register value as the core reads it, without any side effect.
+ * @param Register The register.
+ * @return The register value.
+ */
+static unsigned char HardwareGetRegisterValue(TSimulatorRegister Register)
+{
+	unsigned char Value;
+	
+	switch (Register)
+	{
+		// RA1 is connected to the DS1307 SQW/OUT pin
+		case SIMULATOR_REGISTER_PORTA:
+			Value = Hardware_Registers[SIMULATOR_REGISTER_PORTA] & ~HARDWARE_BIT(1);
+			if (DS1307GetSquareWaveLevel()) Value |= HARDWARE_BIT(1);
+			return Value;
+		
+		// RB0 is connected to the snooze button
+		case SIMULATOR_REGISTER_PORTB:
+			Value = Hardware_Registers[SIMULATOR_REGISTER_PORTB] & ~HARDWARE_BIT(0);
+			if (HardwareGetSnoozeButtonLevel()) Value |= HARDWARE_BIT(0);
+			return Value;
+		
+		// RC2 is connected to the alarm switch
+		case SIMULATOR_REGISTER_PORTC:
+			Value = Hardware_Registers[SIMULATOR_REGISTER_PORTC] & ~HARDWARE_BIT(2);
+			if (Hardware_Is_Alarm_Switch_Enabled) Value |= HARDWARE_BIT(2);
+			return Value;
+		
+		case SIMULATOR_REGISTER_TMR1L:
+			return (unsigned char) HardwareGetTimer1Value();
+		
+		case SIMULATOR_REGISTER_TMR1H:
+			return (unsigned char) (HardwareGetTimer1Value() >> 8);
+		
+		default:
+			return Hardware_Registers[Register];
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void HardwareInitialize(void)
+{
+	// Set the registers power-on values
+	HardwareResetRegisters();
+	
+	Hardware_Time = 0;
+	Hardware_RTC_Half_Second_Time = HARDWARE_TIME_UNITS_PER_SECOND / 2;
+	Hardware_RTC_Drift_Remainder = 0;
+	Hardware_Scenario_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_Timer_1_Origin_Time = 0;
+	Hardware_Timer_1_Match_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_ADC_Conversion_End_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_UART_Reception_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_UART_Pending_Bytes_Count = 0;
+	Hardware_UART_Reception_FIFO_Count = 0;
+	Hardware_UART_Events_Count = 0;
+	Hardware_Is_UART_Events_Overflow = 0;
+	Hardware_Is_Interrupt_Handler_Running = 0;
+	Hardware_Has_Interrupt_Been_Served = 0;
+	Hardware_Is_Reset_Requested = 0;
+	Hardware_Boot_Start_Time = 0;
+	Hardware_Boot_Duration = HARDWARE_BOOT_IN_PROGRESS;
+	
+	// Set the board default state
+	Hardware_Temperature = 20;
+	Hardware_Is_Alarm_Switch_Enabled = 0;
+	Hardware_Snooze_Button_Press_Time = HARDWARE_NO_EVENT_TIME;
+	Hardware_Snooze_Button_Release_Time = HARDWARE_NO_EVENT_TIME;
+	
+	DS1307Initialize();
+	LCDInitialize();
+}
+
+void HardwareRunFirmware(unsigned long long Scenario_Time)
+{
+	Hardware_Scenario_Time = Scenario_Time;
+	
+	// A reset starts the firmware again from here
+	setjmp(Hardware_Reset_Context);
+	FirmwareMain();
+	HardwareAbort("the firmware main() function returned");
+}
+
+void HardwareReset(THardwareResetType Type)
+{
+	Hardware_Is_Reset_Requested = 1;
+	Hardware_Reset_Type = Type;
+}
+
+unsigned long long HardwareGetBootDuration(void)
+{
+	return Hardware_Boot_Duration;
+}
+
+unsigned long long HardwareGetTime(void)
+{
+	return Hardware_Time;
+}
+
+void HardwareSetAlarmSwitch(int Is_Enabled)
+{
+	Hardware_Is_Alarm_Switch_Enabled = Is_Enabled;
+}
+
+void HardwarePressSnoozeButton(unsigned long long Duration)
+{
+	// The RB0/INT edge interrupt is not enabled by the firmware, which samples the pin instead
+	Hardware_Snooze_Button_Press_Time = Hardware_Time;
+	Hardware_Snooze_Button_Release_Time = Hardware_Time + Duration;
+}
+
+void HardwareSetTemperature(int Temperature)
+{
+	Hardware_Temperature = Temperature;
+}
+
+void HardwareSendUARTByte(unsigned char Byte)
+{
+	if (Hardware_UART_Pending_Bytes_Count == HARDWARE_UART_PENDING_BYTES_MAXIMUM_COUNT) HardwareAbort("too many bytes are waiting to be sent to the UART");
+	
+	Hardware_UART_Pending_Bytes[Hardware_UART_Pending_Bytes_Count] = Byte;
+	Hardware_UART_Pending_Bytes_Count++;
+	if (Hardware_UART_Reception_Time == HARDWARE_NO_EVENT_TIME) Hardware_UART_Reception_Time = Hardware_Time + HARDWARE_UART_BYTE_DURATION;
+}
+
+int HardwareGetUARTTransmittedBytes(unsigned char *Pointer_Buffer, int Buffer_Size)
+{
+	int i, Count = 0;
+	
+	for (i = 0; (i < Hardware_UART_Events_Count) && (Count < Buffer_Size); i++)
+	{
+		if (Hardware_UART_Events[i].Type != HARDWARE_UART_EVENT_TYPE_BYTE_WRITTEN) continue;
+		Pointer_Buffer[Count] = Hardware_UART_Events[i].Byte;
+		Count++;
+	}
+	
+	Hardware_UART_Events_Count = 0;
+	Hardware_Is_UART_Events_Overflow = 0;
+	return Count;
+}
+
+int HardwareGetUARTEvents(THardwareUARTEvent *Pointer_Events, int Maximum_Events_Count)
+{
+	int i;
+	
+	if (Hardware_Is_UART_Events_Overflow || (Hardware_UART_Events_Count > Maximum_Events_Count)) HardwareAbort("too many UART events happened during a single run command");
+	for (i = 0; i < Hardware_UART_Events_Count; i++) Pointer_Events[i] = Hardware_UART_Events[i];
+	
+	Hardware_UART_Events_Count = 0;
+	return i;
+}
+
+int HardwareIsRinging(void)
+{
+	return (Hardware_Registers[SIMULATOR_REGISTER_T2CON] & HARDWARE_BIT(TMR2ON)) != 0;
+}
+
+int HardwareGetBuzzerFrequency(void)
+{
+	static const int Prescalers[] = { 1, 4, 16, 16 };
+	
+	// The buzzer sounds only when the CCP2 module outputs the PWM signal
+	if (!HardwareIsRinging() || ((Hardware_Registers[SIMULATOR_REGISTER_CCP2CON] & 0x0C) != 0x0C)) return 0;
+	return (int) (HARDWARE_TIME_UNITS_PER_SECOND / (Prescalers[Hardware_Registers[SIMULATOR_REGISTER_T2CON] & 0x03] * (Hardware_Registers[SIMULATOR_REGISTER_PR2] + 1)));
+}
+
+int HardwareIsBacklightOn(void)
+{
+	return (Hardware_Registers[SIMULATOR_REGISTER_PORTC] >> 5) & 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Firmware interface (see system.h)
+//-------------------------------------------------------------------------------------------------
+unsigned char SimulatorReadRegister(TSimulatorRegister Register)
+{
+	// RA1 is connected to the DS1307 SQW/OUT pin, the main loop polls it when it has nothing else to do
+	if (Register == SIMULATOR_REGISTER_PORTA) HardwareWaitInMainLoop();
+	// Reading the received byte pops it from the FIFO
+	else if (Register == SIMULATOR_REGISTER_RCREG) return HardwareReadUARTByte();
+	
+	return HardwareGetRegisterValue(Register);
+}
+
+void SimulatorWriteRegister(TSimulatorRegister Register, unsigned char Value)
+{
+	unsigned char Previous_Value;
+	unsigned int Timer_Value;
+	
+	Previous_Value = Hardware_Registers[Register];
+	Hardware_Registers[Register] = Value;
+	
+	switch (Register)
+	{
+		// The firmware jumps to the reset vector to start the bootloader
+		case SIMULATOR_REGISTER_PCL:
+			HardwareAbort("the firmware jumped to the bootloader, which is not simulated");
+			break;
+		
+		// The display signals are connected to port B, data is latched on the E signal falling edge
+		case SIMULATOR_REGISTER_PORTB:
+			if ((Previous_Value & HARDWARE_BIT(3)) && !(Value & HARDWARE_BIT(3))) LCDLatchNibble((Value >> 2) & 1, Value >> 4);
+			break;
+		
+		case SIMULATOR_REGISTER_INTCON:
+		case SIMULATOR_REGISTER_PIE1:
+		case SIMULATOR_REGISTER_PIE2:
+			HardwareServeInterrupts();
+			break;
+		
+		case SIMULATOR_REGISTER_PIR1:
+			// TXIF and RCIF are read-only
+			Hardware_Registers[SIMULATOR_REGISTER_PIR1] = (Value & ~(HARDWARE_BIT(TXIF) | HARDWARE_BIT(RCIF))) | (Previous_Value & (HARDWARE_BIT(TXIF) | HARDWARE_BIT(RCIF)));
+			HardwareServeInterrupts();
+			break;
+		
+		// Only the written byte of the running timer is changed
+		case SIMULATOR_REGISTER_TMR1L:
+		case SIMULATOR_REGISTER_TMR1H:
+			Hardware_Registers[Register] = Previous_Value;
+			Timer_Value = HardwareGetTimer1Value();
+			if (Register == SIMULATOR_REGISTER_TMR1L) Timer_Value = (Timer_Value & 0xFF00) | Value;
+			else Timer_Value = (Value << 8) | (Timer_Value & 0x00FF);
+			HardwareSetTimer1Value(Timer_Value);
+			break;
+		
+		// Keep the timer value when it is started, stopped or when its prescaler changes
+		case SIMULATOR_REGISTER_T1CON:
+			Hardware_Registers[SIMULATOR_REGISTER_T1CON] = Previous_Value;
+			Timer_Value = HardwareGetTimer1Value();
+			Hardware_Registers[SIMULATOR_REGISTER_T1CON] = Value;
+			HardwareSetTimer1Value(Timer_Value);
+			break;
+		
+		case SIMULATOR_REGISTER_CCPR1L:
+		case SIMULATOR_REGISTER_CCPR1H:
+		case SIMULATOR_REGISTER_CCP1CON:
+			HardwareScheduleTimer1Match();
+			break;
+		
+		case SIMULATOR_REGISTER_ADCON0:
+			if (!(Previous_Value & HARDWARE_BIT(GO)) && (Value & HARDWARE_BIT(GO))) HardwareStartADCConversion();
+			break;
+		
+		case SIMULATOR_REGISTER_SSPBUF:
+			if (DS1307I2CWriteByte(Value)) Hardware_Registers[SIMULATOR_REGISTER_SSPCON2] &= ~HARDWARE_BIT(ACKSTAT);
+			else Hardware_Registers[SIMULATOR_REGISTER_SSPCON2] |= HARDWARE_BIT(ACKSTAT);
+			Hardware_Registers[SIMULATOR_REGISTER_PIR1] |= HARDWARE_BIT(SSPIF);
+			if (DS1307IsDividerReset()) Hardware_RTC_Half_Second_Time = Hardware_Time + (HARDWARE_TIME_UNITS_PER_SECOND / 2);
+			break;
+		
+		case SIMULATOR_REGISTER_SSPCON2:
+			HardwareExecuteI2COperation();
+			break;
+		
+		case SIMULATOR_REGISTER_TXREG:
+			if (!(Hardware_Registers[SIMULATOR_REGISTER_TXSTA] & HARDWARE_BIT(TXEN))) HardwareAbort("a byte was written to the UART while the transmitter is disabled");
+			HardwareAddUARTEvent(HARDWARE_UART_EVENT_TYPE_BYTE_WRITTEN, Value);
+			break;
+		
+		// The transmission pin is driven only while the transmitter is enabled. Transmission is instantaneous, so the transmit shift register is always empty
+		case SIMULATOR_REGISTER_TXSTA:
+			Hardware_Registers[SIMULATOR_REGISTER_TXSTA] |= HARDWARE_BIT(TRMT);
+			if (!(Previous_Value & HARDWARE_BIT(TXEN)) && (Value & HARDWARE_BIT(TXEN))) HardwareAddUARTEvent(HARDWARE_UART_EVENT_TYPE_TRANSMITTER_ENABLED, 0);
+			else if ((Previous_Value & HARDWARE_BIT(TXEN)) && !(Value & HARDWARE_BIT(TXEN))) HardwareAddUARTEvent(HARDWARE_UART_EVENT_TYPE_TRANSMITTER_DISABLED, 0);
+			break;
+		
+		case SIMULATOR_REGISTER_RCSTA:
+			// Clearing CREN clears the overrun error
+			if (!(Value & HARDWARE_BIT(CREN))) Hardware_Registers[SIMULATOR_REGISTER_RCSTA] &= ~HARDWARE_BIT(OERR);
+			break;
+		
+		default:
+			break;
+	}
+}
+
+void SimulatorWriteRegisterBit(TSimulatorRegister Register, unsigned char Bit, unsigned char Value)
+{
+	unsigned char Register_Value;
+	
+	// Bit instructions read the whole register, modify the bit and write the register back
+	Register_Value = HardwareGetRegisterValue(Register);
+	if (Value) Register_Value |= HARDWARE_BIT(Bit);
+	else Register_Value &= ~HARDWARE_BIT(Bit);
+	SimulatorWriteRegister(Register, Register_Value);
+}
+
+void delay_ms(unsigned char Milliseconds)
+{
+	HardwareRunUntil(Hardware_Time + (Milliseconds * HARDWARE_TIME_UNITS_PER_SECOND) / 1000);
+}
+
+void delay_us(unsigned char Microseconds)
+{
+	HardwareRunUntil(Hardware_Time + (Microseconds * HARDWARE_TIME_UNITS_PER_SECOND) / 1000000);
+}
@@ -0,0 +1,130 @@
+/** @file Hardware.h
+ * Simulate the PIC16F876 peripherals used by the firmware and the clock board around them (buttons, LM35DZ temperature sensor, buzzer and display backlight).
+ * The simulated time only advances when the firmware waits (delays, or the main loop polling the RTC 1Hz signal while it has nothing to do), so days of clock operation are simulated in seconds.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_HARDWARE_H
+#define H_HARDWARE_H
+
+#include "Configuration.h"
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** How many simulated time units are in a second, the time unit is the firmware instruction cycle. */
+#define HARDWARE_TIME_UNITS_PER_SECOND ((unsigned long long) CONFIGURATION_INSTRUCTION_FREQUENCY)
+
+/** The UART baud rate used by the firmware. */
+#define HARDWARE_UART_BAUD_RATE 19200
+/** How long a byte takes to be transferred by the UART (start bit, 8 data bits and stop bit). */
+#define HARDWARE_UART_BYTE_DURATION ((10 * HARDWARE_TIME_UNITS_PER_SECOND) / HARDWARE_UART_BAUD_RATE)
+
+/** Returned by HardwareGetBootDuration() while the firmware is booting. */
+#define HARDWARE_BOOT_IN_PROGRESS ((unsigned long long) -1)
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** What reset the microcontroller. */
+typedef enum
+{
+	HARDWARE_RESET_TYPE_POWER_ON, //!< The board was powered off then on again, the display lost its state. The battery-backed DS1307 keeps running.
+	HARDWARE_RESET_TYPE_BROWN_OUT //!< The supply voltage dropped for a short time, only the microcontroller was reset.
+} THardwareResetType;
+
+/** What happened on the UART transmission pin. */
+typedef enum
+{
+	HARDWARE_UART_EVENT_TYPE_TRANSMITTER_ENABLED, //!< The transmitter started driving the pin.
+	HARDWARE_UART_EVENT_TYPE_TRANSMITTER_DISABLED, //!< The transmitter released the pin.
+	HARDWARE_UART_EVENT_TYPE_BYTE_WRITTEN //!< A byte was written to the transmission register.
+} THardwareUARTEventType;
+
+/** A UART transmission pin event. */
+typedef struct
+{
+	unsigned long long Time; //!< When the event happened.
+	THardwareUARTEventType Type; //!< The event type.
+	unsigned char Byte; //!< The written byte, for a HARDWARE_UART_EVENT_TYPE_BYTE_WRITTEN event.
+} THardwareUARTEvent;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Power the board on : reset the microcontroller registers, the DS1307 and the display. */
+void HardwareInitialize(void);
+
+/** Run the firmware from its reset vector. This function never returns, the simulation ends when the scenario calls exit().
+ * @param Scenario_Time The simulated time when HardwareExecuteScenario() will be called for the first time.
+ */
+void HardwareRunFirmware(unsigned long long Scenario_Time);
+
+/** Reset the microcontroller once the scenario returns to the simulated hardware, then run the firmware again from its reset vector. The PCON register tells the firmware which reset happened.
+ * The firmware variables keep their values like the microcontroller RAM does, but the ones with an initializer are not initialized again by the C startup code as they would be on the real microcontroller.
+ * @param Type The reset cause.
+ */
+void HardwareReset(THardwareResetType Type);
+
+/** Get how long the firmware took to boot the last time, from its reset vector to the first time the main loop polls the RTC 1Hz signal. The power-up timer and the oscillator start-up delays are not included.
+ * @return The boot duration in HARDWARE_TIME_UNITS_PER_SECOND units,
+ * @return HARDWARE_BOOT_IN_PROGRESS if the firmware has not finished booting.
+ */
+unsigned long long HardwareGetBootDuration(void);
+
+/** Get the simulated time elapsed since the board was powered on.
+ * @return The time in HARDWARE_TIME_UNITS_PER_SECOND units.
+ */
+unsigned long long HardwareGetTime(void);
+
+/** Set the alarm switch position.
+ * @param Is_Enabled Set to 1 to enable the alarm, set to 0 to disable it.
+ */
+void HardwareSetAlarmSwitch(int Is_Enabled);
+
+/** Press the snooze button, then release it after a while. The button contact bounces when it is pressed and released.
+ * @param Duration How long the button is held, in HARDWARE_TIME_UNITS_PER_SECOND units.
+ */
+void HardwarePressSnoozeButton(unsigned long long Duration);
+
+/** Set the room temperature measured by the LM35DZ sensor.
+ * @param Temperature The temperature in centigrade degrees, in range [0; 100].
+ */
+void HardwareSetTemperature(int Temperature);
+
+/** Send a byte to the microcontroller UART. Bytes are received one after the other at the UART baud rate.
+ * @param Byte The byte to send.
+ */
+void HardwareSendUARTByte(unsigned char Byte);
+
+/** Retrieve the bytes transmitted by the microcontroller UART since the previous call (this also discards the pending UART events).
+ * @param Pointer_Buffer On output, contain the transmitted bytes.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return How many bytes were stored in the buffer.
+ */
+int HardwareGetUARTTransmittedBytes(unsigned char *Pointer_Buffer, int Buffer_Size);
+
+/** Retrieve the UART transmission pin events since the previous call, in chronological order. They tell when the microcontroller drives a line shared with other clocks.
+ * @param Pointer_Events On output, contain the events.
+ * @param Maximum_Events_Count How many events the buffer can contain.
+ * @return How many events were stored in the buffer, the program exits if some events did not fit.
+ */
+int HardwareGetUARTEvents(THardwareUARTEvent *Pointer_Events, int Maximum_Events_Count);
+
+/** Tell whether the alarm is ringing, i.e. the PWM time base is running (the buzzer is silent during the melody rests).
+ * @return 1 if the alarm is ringing,
+ * @return 0 if it is not.
+ */
+int HardwareIsRinging(void);
+
+/** Get the frequency the buzzer is playing.
+ * @return The frequency in Hz, or 0 if the buzzer is silent.
+ */
+int HardwareGetBuzzerFrequency(void);
+
+/** Tell whether the display backlight is lighted.
+ * @return 1 if the backlight is on,
+ * @return 0 if it is off.
+ */
+int HardwareIsBacklightOn(void);
+
+#endif
@@ -0,0 +1,165 @@
+/** @file LCD.c
+ * @see LCD.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "LCD.h"
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The display data RAM size, it holds two 40-character lines. */
+#define LCD_DISPLAY_DATA_RAM_SIZE 0x68
+/** The second line first address. */
+#define LCD_SECOND_LINE_ADDRESS 0x40
+/** How many characters a line holds in the display data RAM. */
+#define LCD_LINE_SIZE 40
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The display data RAM, only the first LCD_LINE_SIZE bytes of each line are used. */
+static unsigned char LCD_Display_Data_RAM[LCD_DISPLAY_DATA_RAM_SIZE];
+/** The address counter. */
+static unsigned char LCD_Address_Counter;
+
+/** Set to 1 when the controller talks through its 4-bit interface. */
+static int LCD_Is_4_Bit_Interface_Enabled;
+/** Set to 1 when the upper nibble of a byte has been received on the 4-bit interface. */
+static int LCD_Is_Upper_Nibble_Received;
+/** The last received upper nibble. */
+static unsigned char LCD_Upper_Nibble;
+
+/** Set to 1 when the address counter is incremented after each access, set to 0 when it is decremented. */
+static int LCD_Is_Address_Incremented;
+/** Set to 1 when the display is turned on. */
+static int LCD_Is_Display_Enabled;
+/** Set to 1 when data writes go to the character generator RAM, which is not simulated. */
+static int LCD_Is_Character_Generator_RAM_Selected;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Move the address counter to the next or previous display data RAM location, wrapping from a line to the other like the real controller. */
+static void LCDMoveAddressCounter(void)
+{
+	if (LCD_Is_Address_Incremented)
+	{
+		LCD_Address_Counter++;
+		if (LCD_Address_Counter == LCD_LINE_SIZE) LCD_Address_Counter = LCD_SECOND_LINE_ADDRESS;
+		else if (LCD_Address_Counter == LCD_SECOND_LINE_ADDRESS + LCD_LINE_SIZE) LCD_Address_Counter = 0;
+	}
+	else
+	{
+		if (LCD_Address_Counter == 0) LCD_Address_Counter = LCD_SECOND_LINE_ADDRESS + LCD_LINE_SIZE - 1;
+		else if (LCD_Address_Counter == LCD_SECOND_LINE_ADDRESS) LCD_Address_Counter = LCD_LINE_SIZE - 1;
+		else LCD_Address_Counter--;
+	}
+}
+
+/** Execute a command.
+ * @param Command The command byte.
+ */
+static void LCDExecuteCommand(unsigned char Command)
+{
+	int i;
+	
+	// Set DDRAM address
+	if (Command & 0x80)
+	{
+		LCD_Address_Counter = Command & 0x7F;
+		if (LCD_Address_Counter >= LCD_DISPLAY_DATA_RAM_SIZE) LCD_Address_Counter = 0;
+		LCD_Is_Character_Generator_RAM_Selected = 0;
+	}
+	// Set CGRAM address
+	else if (Command & 0x40) LCD_Is_Character_Generator_RAM_Selected = 1;
+	// Function set, the firmware sends a single-nibble function set at power-on and talks through the 4-bit interface afterwards
+	else if (Command & 0x20) LCD_Is_4_Bit_Interface_Enabled = 1;
+	// Cursor or display shift, it is not used by the firmware
+	else if (Command & 0x10) return;
+	// Display on/off control
+	else if (Command & 0x08) LCD_Is_Display_Enabled = (Command >> 2) & 1;
+	// Entry mode set
+	else if (Command & 0x04) LCD_Is_Address_Incremented = (Command >> 1) & 1;
+	// Return home
+	else if (Command & 0x02) LCD_Address_Counter = 0;
+	// Clear display
+	else if (Command & 0x01)
+	{
+		for (i = 0; i < LCD_DISPLAY_DATA_RAM_SIZE; i++) LCD_Display_Data_RAM[i] = ' ';
+		LCD_Address_Counter = 0;
+		LCD_Is_Address_Incremented = 1;
+		LCD_Is_Character_Generator_RAM_Selected = 0;
+	}
+}
+
+/** Execute a command or write a data byte.
+ * @param Is_Data Set to 1 if the byte is a data byte, set to 0 if it is a command.
+ * @param Byte The byte.
+ */
+static void LCDWriteByte(int Is_Data, unsigned char Byte)
+{
+	if (!Is_Data)
+	{
+		LCDExecuteCommand(Byte);
+		return;
+	}
+	
+	if (LCD_Is_Character_Generator_RAM_Selected) return;
+	LCD_Display_Data_RAM[LCD_Address_Counter] = Byte;
+	LCDMoveAddressCounter();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void LCDInitialize(void)
+{
+	int i;
+	
+	// The display data RAM content is random on power-on, fill it with a recognizable pattern
+	for (i = 0; i < LCD_DISPLAY_DATA_RAM_SIZE; i++) LCD_Display_Data_RAM[i] = 0xFF;
+	LCD_Address_Counter = 0;
+	
+	LCD_Is_4_Bit_Interface_Enabled = 0;
+	LCD_Is_Upper_Nibble_Received = 0;
+	LCD_Is_Address_Incremented = 1;
+	LCD_Is_Display_Enabled = 0;
+	LCD_Is_Character_Generator_RAM_Selected = 0;
+}
+
+void LCDLatchNibble(int Is_Data, unsigned char Nibble)
+{
+	Nibble &= 0x0F;
+	
+	// The lower data lines are not connected, so the 8-bit interface sees them low
+	if (!LCD_Is_4_Bit_Interface_Enabled)
+	{
+		LCDWriteByte(Is_Data, Nibble << 4);
+		return;
+	}
+	
+	if (!LCD_Is_Upper_Nibble_Received)
+	{
+		LCD_Upper_Nibble = Nibble;
+		LCD_Is_Upper_Nibble_Received = 1;
+		return;
+	}
+	LCD_Is_Upper_Nibble_Received = 0;
+	LCDWriteByte(Is_Data, (LCD_Upper_Nibble << 4) | Nibble);
+}
+
+void LCDGetLine(int Line, char *String_Line)
+{
+	int i;
+	unsigned char Character, Address;
+	
+	Address = Line ? LCD_SECOND_LINE_ADDRESS : 0;
+	for (i = 0; i < LCD_LINE_LENGTH; i++)
+	{
+		Character = LCD_Display_Data_RAM[Address + i];
+		if (!LCD_Is_Display_Enabled) String_Line[i] = ' ';
+		else if ((Character < 0x20) || (Character > 0x7D)) String_Line[i] = LCD_NON_ASCII_CHARACTER; // 0x7E and 0x7F are arrows in the character generator ROM
+		else String_Line[i] = (char) Character;
+	}
+	String_Line[LCD_LINE_LENGTH] = 0;
+}
@@ -0,0 +1,35 @@
+/** @file LCD.h
+ * Simulate the HD44780-compatible controller of the DEM16216SYH-LY 2x16 display, connected through its 4-bit interface.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_LCD_H
+#define H_LCD_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** How many characters are visible on a line. */
+#define LCD_LINE_LENGTH 16
+
+/** The character used to show a character that has no ASCII equivalent (like the degree sign). */
+#define LCD_NON_ASCII_CHARACTER '*'
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Put the controller in its power-on state. */
+void LCDInitialize(void);
+
+/** Must be called on each E signal falling edge.
+ * @param Is_Data Set to 1 if the R/S signal is high (data), set to 0 if it is low (command).
+ * @param Nibble The DB7 to DB4 signals level, in bits 3 to 0.
+ */
+void LCDLatchNibble(int Is_Data, unsigned char Nibble);
+
+/** Get the characters visible on a display line.
+ * @param Line The line, 0 is the top one.
+ * @param String_Line On output, contain the LCD_LINE_LENGTH visible characters and a terminating zero. All characters are spaces when the display is turned off.
+ */
+void LCDGetLine(int Line, char *String_Line);
+
+#endif
@@ -0,0 +1,32 @@
+/** @file Main.c
+ * Run the clock firmware on simulated hardware, with simulated time going much faster than real time, and check its behavior against a scenario.
+ * @author Adrien RICCIARDI
+ */
+#include "Hardware.h"
+#include "Scenario.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	unsigned long long First_Run_Time;
+	
+	// Check parameters
+	if (argc != 2)
+	{
+		printf("Usage : %s Scenario_File\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	ScenarioLoad(argv[1]);
+	HardwareInitialize();
+	
+	// Apply the commands preceding the first run command (setting the RTC time, the alarm switch...) before the firmware boots
+	First_Run_Time = ScenarioExecute();
+	
+	HardwareRunFirmware(First_Run_Time);
+	return EXIT_SUCCESS; // Never reached, the scenario ends the program
+}
@@ -0,0 +1,949 @@
+/** @file Scenario.c
+ * @see Scenario.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include "DS1307.h"
+#include "Hardware.h"
+#include "LCD.h"
+#include "Scenario.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many commands a scenario can contain. */
+#define SCENARIO_MAXIMUM_COMMANDS_COUNT 1024
+/** How many bytes a command can send or expect. */
+#define SCENARIO_MAXIMUM_BYTES_COUNT 32
+/** The longest allowed scenario line. */
+#define SCENARIO_MAXIMUM_LINE_LENGTH 256
+
+/** How many clocks can share the same line. */
+#define SCENARIO_MAXIMUM_UNITS_COUNT 8
+/** How many UART events a unit can report for a single run command. */
+#define SCENARIO_MAXIMUM_UNIT_EVENTS_COUNT 256
+/** How many bytes sent by the clocks on the shared line can be stored until they are checked. */
+#define SCENARIO_MAXIMUM_LINE_BYTES_COUNT 256
+
+/** The UART protocol magic number. */
+#define SCENARIO_UART_PROTOCOL_MAGIC_NUMBER 0xA5
+
+/** The unit address base address in the DS1307 RAM, the address is followed by its complement. */
+#define SCENARIO_UNIT_ADDRESS_BASE_ADDRESS 0x0B
+
+/** How long the snooze button is held when the scenario does not tell it. */
+#define SCENARIO_SNOOZE_DEFAULT_DURATION ((200 * HARDWARE_TIME_UNITS_PER_SECOND) / 1000)
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** All commands. */
+typedef enum
+{
+	SCENARIO_COMMAND_TYPE_RTC,
+	SCENARIO_COMMAND_TYPE_CONFIGURE,
+	SCENARIO_COMMAND_TYPE_SEND,
+	SCENARIO_COMMAND_TYPE_ALARM,
+	SCENARIO_COMMAND_TYPE_SNOOZE,
+	SCENARIO_COMMAND_TYPE_TEMPERATURE,
+	SCENARIO_COMMAND_TYPE_RUN,
+	SCENARIO_COMMAND_TYPE_EXPECT_LINE,
+	SCENARIO_COMMAND_TYPE_EXPECT_RINGING,
+	SCENARIO_COMMAND_TYPE_EXPECT_BACKLIGHT,
+	SCENARIO_COMMAND_TYPE_EXPECT_BOOT,
+	SCENARIO_COMMAND_TYPE_EXPECT_UART,
+	SCENARIO_COMMAND_TYPE_PRINT,
+	SCENARIO_COMMAND_TYPE_ADDRESS,
+	SCENARIO_COMMAND_TYPE_UNITS,
+	SCENARIO_COMMAND_TYPE_UNIT,
+	SCENARIO_COMMAND_TYPE_RESET
+} TScenarioCommandType;
+
+/** A parsed command. */
+typedef struct
+{
+	TScenarioCommandType Type; //!< What to do.
+	int Line_Number; //!< The command line in the scenario file, to report errors.
+	int Values[SCENARIO_MAXIMUM_BYTES_COUNT]; //!< The numerical parameters (date and time fields, switch state, bytes...).
+	int Values_Count; //!< How many numerical parameters are used.
+	unsigned long long Duration; //!< The run command duration, the longest expected boot duration or how long the snooze button is held, in simulated time units.
+	char String_Text[LCD_LINE_LENGTH + 1]; //!< The expected display line text.
+} TScenarioCommand;
+
+/** What a unit process must do. */
+typedef enum
+{
+	SCENARIO_UNIT_REQUEST_TYPE_EXECUTE_COMMAND, //!< Execute a command that does not let the time pass, then answer.
+	SCENARIO_UNIT_REQUEST_TYPE_RUN //!< Run the clock until the given time, then send the UART events.
+} TScenarioUnitRequestType;
+
+/** A request sent by the coordinator process to a unit process. */
+typedef struct
+{
+	TScenarioUnitRequestType Type; //!< What to do.
+	int Command_Index; //!< The command to execute.
+	unsigned long long Time; //!< The time to run until.
+} TScenarioUnitRequest;
+
+/** A UART event of a clock on the shared line. */
+typedef struct
+{
+	THardwareUARTEvent Event; //!< The event.
+	int Unit_Index; //!< The clock that generated the event.
+	int Order; //!< The event order in the clock events, to sort simultaneous events.
+} TScenarioLineEvent;
+
+/** A clock on the shared line, as seen by the coordinator process. */
+typedef struct
+{
+	pid_t Process_ID; //!< The process simulating the clock.
+	int Request_File_Descriptor; //!< The pipe the requests are written to.
+	int Answer_File_Descriptor; //!< The pipe the answers are read from.
+	int Is_Transmitter_Enabled; //!< Tell whether the clock drives the line.
+	unsigned long long Transmission_End_Time; //!< When the last byte sent by the clock will be fully transmitted.
+} TScenarioUnit;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The scenario file name, to report errors. */
+static char *Scenario_String_File_Name;
+
+/** All scenario commands. */
+static TScenarioCommand Scenario_Commands[SCENARIO_MAXIMUM_COMMANDS_COUNT];
+/** How many commands the scenario contains. */
+static int Scenario_Commands_Count;
+/** The next command to execute. */
+static int Scenario_Current_Command_Index = 0;
+
+/** Set to 1 when a run command has been parsed, so the firmware is running. */
+static int Scenario_Is_Run_Command_Found = 0;
+
+/** How many expectations were checked. */
+static int Scenario_Checked_Expectations_Count = 0;
+/** When the scenario began, to compute the simulation speed. */
+static time_t Scenario_Start_Time;
+
+/** How many clocks share the line, 0 if a single clock is simulated by this process. */
+static int Scenario_Units_Count = 0;
+/** In a unit process, the simulated clock number (starting from 1). It is 0 in the process playing the scenario. */
+static int Scenario_Unit_Number = 0;
+/** In a unit process, the pipe the requests are read from. */
+static int Scenario_Unit_Request_File_Descriptor;
+/** In a unit process, the pipe the answers are written to. */
+static int Scenario_Unit_Answer_File_Descriptor;
+
+/** All clocks sharing the line. */
+static TScenarioUnit Scenario_Units[SCENARIO_MAXIMUM_UNITS_COUNT];
+/** The clock the commands that are not related to the line apply to. */
+static int Scenario_Selected_Unit_Index = 0;
+/** The simulated time all clocks have reached. */
+static unsigned long long Scenario_Line_Time = 0;
+/** The bytes sent by the clocks on the shared line, in the order the PC receives them. */
+static unsigned char Scenario_Line_Bytes[SCENARIO_MAXIMUM_LINE_BYTES_COUNT];
+/** How many bytes were received from the shared line since the previous check. */
+static int Scenario_Line_Bytes_Count = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Display a scenario syntax error and exit.
+ * @param Line_Number The faulty line.
+ * @param String_Message The error description.
+ */
+static void ScenarioExitOnSyntaxError(int Line_Number, char *String_Message)
+{
+	printf("%s:%d : error : %s.\n", Scenario_String_File_Name, Line_Number, String_Message);
+	exit(EXIT_FAILURE);
+}
+
+/** Compute the day of the week of a date.
+ * @param Year The year.
+ * @param Month The month in range [1; 12].
+ * @param Day The day of the month.
+ * @return The day of the week in range [1; 7], 1 is sunday (the value the PC program sends).
+ */
+static int ScenarioComputeDayOfWeek(int Year, int Month, int Day)
+{
+	static const int Month_Offsets[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+	
+	if (Month < 3) Year--;
+	return ((Year + (Year / 4) - (Year / 100) + (Year / 400) + Month_Offsets[Month - 1] + Day) % 7) + 1;
+}
+
+/** Convert a binary number in range [0; 99] to BCD.
+ * @param Number The number to convert.
+ * @return The BCD value.
+ */
+static int ScenarioConvertBinaryToBCD(int Number)
+{
+	return ((Number / 10) << 4) | (Number % 10);
+}
+
+/** Parse a date and a time.
+ * @param Pointer_Command The command to store the date and time to, they are stored in the first 6 values (year, month, day, hours, minutes, seconds).
+ * @param String_Date The date string.
+ * @param String_Time The time string.
+ */
+static void ScenarioParseDateAndTime(TScenarioCommand *Pointer_Command, char *String_Date, char *String_Time)
+{
+	int *Pointer_Values;
+	
+	Pointer_Values = Pointer_Command->Values;
+	if ((String_Date == NULL) || (sscanf(String_Date, "%d/%d/%d", &Pointer_Values[0], &Pointer_Values[1], &Pointer_Values[2]) != 3)) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "bad date, use the YYYY/MM/DD format");
+	if ((Pointer_Values[0] < 2000) || (Pointer_Values[0] > 2099) || (Pointer_Values[1] < 1) || (Pointer_Values[1] > 12) || (Pointer_Values[2] < 1) || (Pointer_Values[2] > 31)) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "the date is out of the RTC range");
+	
+	if ((String_Time == NULL) || (sscanf(String_Time, "%d:%d:%d", &Pointer_Values[3], &Pointer_Values[4], &Pointer_Values[5]) != 3)) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "bad time, use the HH:MM:SS format");
+	if ((Pointer_Values[3] < 0) || (Pointer_Values[3] > 23) || (Pointer_Values[4] < 0) || (Pointer_Values[4] > 59) || (Pointer_Values[5] < 0) || (Pointer_Values[5] > 59)) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "the time is out of range");
+	
+	Pointer_Command->Values_Count = 6;
+}
+
+/** Parse an "on" or "off" word.
+ * @param Pointer_Command The command to store the value to.
+ * @param String_Word The word.
+ */
+static void ScenarioParseSwitch(TScenarioCommand *Pointer_Command, char *String_Word)
+{
+	if ((String_Word != NULL) && (strcmp(String_Word, "on") == 0)) Pointer_Command->Values[0] = 1;
+	else if ((String_Word != NULL) && (strcmp(String_Word, "off") == 0)) Pointer_Command->Values[0] = 0;
+	else ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "'on' or 'off' is expected");
+	Pointer_Command->Values_Count = 1;
+}
+
+/** Parse all remaining words of the line as hexadecimal bytes.
+ * @param Pointer_Command The command to store the bytes to.
+ */
+static void ScenarioParseBytes(TScenarioCommand *Pointer_Command)
+{
+	char *String_Word;
+	unsigned int Byte;
+	
+	Pointer_Command->Values_Count = 0;
+	while ((String_Word = strtok(NULL, " \t")) != NULL)
+	{
+		if (Pointer_Command->Values_Count == SCENARIO_MAXIMUM_BYTES_COUNT) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "too many bytes");
+		if ((sscanf(String_Word, "%x", &Byte) != 1) || (Byte > 0xFF)) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "bad hexadecimal byte");
+		Pointer_Command->Values[Pointer_Command->Values_Count] = (int) Byte;
+		Pointer_Command->Values_Count++;
+	}
+}
+
+/** Parse a duration.
+ * @param Pointer_Command The command to store the duration to.
+ * @param String_Duration The duration string, a number followed by a unit.
+ */
+static void ScenarioParseDuration(TScenarioCommand *Pointer_Command, char *String_Duration)
+{
+	unsigned long long Value;
+	char String_Unit[8];
+	
+	if ((String_Duration == NULL) || (sscanf(String_Duration, "%llu%7s", &Value, String_Unit) != 2)) ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "bad duration, use a number followed by ms, s, m, h or d");
+	
+	if (strcmp(String_Unit, "ms") == 0) Pointer_Command->Duration = (Value * HARDWARE_TIME_UNITS_PER_SECOND) / 1000;
+	else if (strcmp(String_Unit, "s") == 0) Pointer_Command->Duration = Value * HARDWARE_TIME_UNITS_PER_SECOND;
+	else if (strcmp(String_Unit, "m") == 0) Pointer_Command->Duration = Value * 60 * HARDWARE_TIME_UNITS_PER_SECOND;
+	else if (strcmp(String_Unit, "h") == 0) Pointer_Command->Duration = Value * 3600 * HARDWARE_TIME_UNITS_PER_SECOND;
+	else if (strcmp(String_Unit, "d") == 0) Pointer_Command->Duration = Value * 86400 * HARDWARE_TIME_UNITS_PER_SECOND;
+	else ScenarioExitOnSyntaxError(Pointer_Command->Line_Number, "unknown duration unit, use ms, s, m, h or d");
+}
+
+/** Parse a scenario line.
+ * @param Pointer_Command On output, contain the parsed command.
+ * @param String_Line The line, it is modified.
+ * @return 1 if the line contains a command,
+ * @return 0 if the line is empty or is a comment.
+ */
+static int ScenarioParseLine(TScenarioCommand *Pointer_Command, char *String_Line)
+{
+	char *String_Command, *String_Word, *String_Text_Beginning, *String_Text_End;
+	int Line_Number, Alarm_Hour, Alarm_Minutes;
+	
+	Line_Number = Pointer_Command->Line_Number;
+	
+	// Keep the quoted text apart, as it can contain spaces
+	String_Text_Beginning = strchr(String_Line, '"');
+	if (String_Text_Beginning != NULL)
+	{
+		String_Text_End = strrchr(String_Line, '"');
+		if (String_Text_End == String_Text_Beginning) ScenarioExitOnSyntaxError(Line_Number, "the text closing quote is missing");
+		*String_Text_Beginning = 0;
+		*String_Text_End = 0;
+		String_Text_Beginning++;
+		if (strlen(String_Text_Beginning) > LCD_LINE_LENGTH) ScenarioExitOnSyntaxError(Line_Number, "the text is longer than a display line");
+	}
+	
+	String_Command = strtok(String_Line, " \t\r\n");
+	if ((String_Command == NULL) || (String_Command[0] == '#')) return 0;
+	
+	if (strcmp(String_Command, "rtc") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_RTC;
+		String_Word = strtok(NULL, " \t\r\n");
+		ScenarioParseDateAndTime(Pointer_Command, String_Word, strtok(NULL, " \t\r\n"));
+		
+		// Use the real day of the week if none is provided
+		String_Word = strtok(NULL, " \t\r\n");
+		if (String_Word == NULL) Pointer_Command->Values[6] = ScenarioComputeDayOfWeek(Pointer_Command->Values[0], Pointer_Command->Values[1], Pointer_Command->Values[2]);
+		else if ((sscanf(String_Word, "%d", &Pointer_Command->Values[6]) != 1) || (Pointer_Command->Values[6] < 0) || (Pointer_Command->Values[6] > 7)) ScenarioExitOnSyntaxError(Line_Number, "the day of the week must be in range [0; 7]");
+		Pointer_Command->Values_Count = 7;
+	}
+	else if (strcmp(String_Command, "configure") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_CONFIGURE;
+		String_Word = strtok(NULL, " \t\r\n");
+		ScenarioParseDateAndTime(Pointer_Command, String_Word, strtok(NULL, " \t\r\n"));
+		
+		String_Word = strtok(NULL, " \t\r\n");
+		if ((String_Word == NULL) || (sscanf(String_Word, "%d:%d", &Alarm_Hour, &Alarm_Minutes) != 2) || (Alarm_Hour < 0) || (Alarm_Hour > 23) || (Alarm_Minutes < 0) || (Alarm_Minutes > 59)) ScenarioExitOnSyntaxError(Line_Number, "bad alarm time, use the HH:MM format");
+		Pointer_Command->Values[6] = Alarm_Hour;
+		Pointer_Command->Values[7] = Alarm_Minutes;
+		Pointer_Command->Values_Count = 8;
+	}
+	else if (strcmp(String_Command, "send") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_SEND;
+		ScenarioParseBytes(Pointer_Command);
+		if (Pointer_Command->Values_Count == 0) ScenarioExitOnSyntaxError(Line_Number, "no byte to send");
+	}
+	else if (strcmp(String_Command, "alarm") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_ALARM;
+		ScenarioParseSwitch(Pointer_Command, strtok(NULL, " \t\r\n"));
+	}
+	else if (strcmp(String_Command, "snooze") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_SNOOZE;
+		
+		// A short press is done when no duration is provided
+		String_Word = strtok(NULL, " \t\r\n");
+		if (String_Word == NULL) Pointer_Command->Duration = SCENARIO_SNOOZE_DEFAULT_DURATION;
+		else ScenarioParseDuration(Pointer_Command, String_Word);
+	}
+	else if (strcmp(String_Command, "temperature") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_TEMPERATURE;
+		String_Word = strtok(NULL, " \t\r\n");
+		if ((String_Word == NULL) || (sscanf(String_Word, "%d", &Pointer_Command->Values[0]) != 1) || (Pointer_Command->Values[0] < 0) || (Pointer_Command->Values[0] > 100)) ScenarioExitOnSyntaxError(Line_Number, "the LM35DZ temperature must be in range [0; 100]");
+		Pointer_Command->Values_Count = 1;
+	}
+	else if (strcmp(String_Command, "run") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_RUN;
+		ScenarioParseDuration(Pointer_Command, strtok(NULL, " \t\r\n"));
+	}
+	else if (strcmp(String_Command, "expect") == 0)
+	{
+		String_Word = strtok(NULL, " \t\r\n");
+		if (String_Word == NULL) ScenarioExitOnSyntaxError(Line_Number, "the expected property is missing");
+		
+		if ((strcmp(String_Word, "line1") == 0) || (strcmp(String_Word, "line2") == 0))
+		{
+			Pointer_Command->Type = SCENARIO_COMMAND_TYPE_EXPECT_LINE;
+			Pointer_Command->Values[0] = String_Word[4] - '1';
+			Pointer_Command->Values_Count = 1;
+			if (String_Text_Beginning == NULL) ScenarioExitOnSyntaxError(Line_Number, "the expected text must be quoted");
+			strcpy(Pointer_Command->String_Text, String_Text_Beginning);
+		}
+		else if (strcmp(String_Word, "ringing") == 0)
+		{
+			Pointer_Command->Type = SCENARIO_COMMAND_TYPE_EXPECT_RINGING;
+			ScenarioParseSwitch(Pointer_Command, strtok(NULL, " \t\r\n"));
+		}
+		else if (strcmp(String_Word, "backlight") == 0)
+		{
+			Pointer_Command->Type = SCENARIO_COMMAND_TYPE_EXPECT_BACKLIGHT;
+			ScenarioParseSwitch(Pointer_Command, strtok(NULL, " \t\r\n"));
+		}
+		else if (strcmp(String_Word, "boot") == 0)
+		{
+			Pointer_Command->Type = SCENARIO_COMMAND_TYPE_EXPECT_BOOT;
+			ScenarioParseDuration(Pointer_Command, strtok(NULL, " \t\r\n"));
+		}
+		else if (strcmp(String_Word, "uart") == 0)
+		{
+			Pointer_Command->Type = SCENARIO_COMMAND_TYPE_EXPECT_UART;
+			ScenarioParseBytes(Pointer_Command);
+		}
+		else ScenarioExitOnSyntaxError(Line_Number, "unknown expected property");
+	}
+	else if (strcmp(String_Command, "print") == 0) Pointer_Command->Type = SCENARIO_COMMAND_TYPE_PRINT;
+	else if (strcmp(String_Command, "address") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_ADDRESS;
+		String_Word = strtok(NULL, " \t\r\n");
+		if ((String_Word == NULL) || (sscanf(String_Word, "%d", &Pointer_Command->Values[0]) != 1) || (Pointer_Command->Values[0] < 0) || (Pointer_Command->Values[0] > 254)) ScenarioExitOnSyntaxError(Line_Number, "the unit address must be in range [0; 254]");
+		Pointer_Command->Values_Count = 1;
+	}
+	else if (strcmp(String_Command, "units") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_UNITS;
+		if (Scenario_Commands_Count != 0) ScenarioExitOnSyntaxError(Line_Number, "the units command must be the first command");
+		String_Word = strtok(NULL, " \t\r\n");
+		if ((String_Word == NULL) || (sscanf(String_Word, "%d", &Scenario_Units_Count) != 1) || (Scenario_Units_Count < 2) || (Scenario_Units_Count > SCENARIO_MAXIMUM_UNITS_COUNT)) ScenarioExitOnSyntaxError(Line_Number, "the clocks count must be in range [2; 8]");
+	}
+	else if (strcmp(String_Command, "unit") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_UNIT;
+		if (Scenario_Units_Count == 0) ScenarioExitOnSyntaxError(Line_Number, "the units command must tell how many clocks share the line first");
+		String_Word = strtok(NULL, " \t\r\n");
+		if ((String_Word == NULL) || (sscanf(String_Word, "%d", &Pointer_Command->Values[0]) != 1) || (Pointer_Command->Values[0] < 1) || (Pointer_Command->Values[0] > Scenario_Units_Count)) ScenarioExitOnSyntaxError(Line_Number, "there is no such clock on the line");
+		Pointer_Command->Values[0]--; // Convert the clock number to an index
+		Pointer_Command->Values_Count = 1;
+	}
+	else if (strcmp(String_Command, "reset") == 0)
+	{
+		Pointer_Command->Type = SCENARIO_COMMAND_TYPE_RESET;
+		if (Scenario_Units_Count != 0) ScenarioExitOnSyntaxError(Line_Number, "the reset command can't be used when several clocks share the line");
+		if (!Scenario_Is_Run_Command_Found) ScenarioExitOnSyntaxError(Line_Number, "the firmware must have been started by a run command before it can be reset");
+		String_Word = strtok(NULL, " \t\r\n");
+		if ((String_Word != NULL) && (strcmp(String_Word, "power") == 0)) Pointer_Command->Values[0] = HARDWARE_RESET_TYPE_POWER_ON;
+		else if ((String_Word != NULL) && (strcmp(String_Word, "brownout") == 0)) Pointer_Command->Values[0] = HARDWARE_RESET_TYPE_BROWN_OUT;
+		else ScenarioExitOnSyntaxError(Line_Number, "the reset cause must be \"power\" or \"brownout\"");
+		Pointer_Command->Values_Count = 1;
+	}
+	else ScenarioExitOnSyntaxError(Line_Number, "unknown command");
+	
+	if (Pointer_Command->Type == SCENARIO_COMMAND_TYPE_RUN) Scenario_Is_Run_Command_Found = 1;
+	return 1;
+}
+
+/** Display the simulated time, the RTC date and time, the display content, the outputs state and the last boot duration. */
+static void ScenarioPrintState(void)
+{
+	unsigned long long Time, Boot_Duration;
+	char String_Line[LCD_LINE_LENGTH + 1];
+	
+	Time = HardwareGetTime();
+	if (Scenario_Unit_Number != 0) printf("Clock %d, ", Scenario_Unit_Number);
+	printf("At %llud %02llu:%02llu:%02llu.%03llu (RTC 20%02X/%02X/%02X %02X:%02X:%02X) :\n", Time / (86400 * HARDWARE_TIME_UNITS_PER_SECOND), (Time / (3600 * HARDWARE_TIME_UNITS_PER_SECOND)) % 24, (Time / (60 * HARDWARE_TIME_UNITS_PER_SECOND)) % 60,
+		(Time / HARDWARE_TIME_UNITS_PER_SECOND) % 60, ((Time % HARDWARE_TIME_UNITS_PER_SECOND) * 1000) / HARDWARE_TIME_UNITS_PER_SECOND, DS1307ReadMemory(6), DS1307ReadMemory(5), DS1307ReadMemory(4), DS1307ReadMemory(2), DS1307ReadMemory(1), DS1307ReadMemory(0) & 0x7F);
+	LCDGetLine(0, String_Line);
+	printf("  |%s|\n", String_Line);
+	LCDGetLine(1, String_Line);
+	printf("  |%s|\n", String_Line);
+	printf("  Ringing : %s (buzzer %d Hz), backlight : %s\n", HardwareIsRinging() ? "on" : "off", HardwareGetBuzzerFrequency(), HardwareIsBacklightOn() ? "on" : "off");
+	Boot_Duration = HardwareGetBootDuration();
+	if (Boot_Duration == HARDWARE_BOOT_IN_PROGRESS) printf("  The firmware is booting\n");
+	else printf("  Last boot : %.3f ms\n", (double) (Boot_Duration * 1000) / HARDWARE_TIME_UNITS_PER_SECOND);
+}
+
+/** Display a failed expectation and exit.
+ * @param Pointer_Command The expectation.
+ * @param String_Message What was wrong.
+ */
+static void ScenarioExitOnFailedExpectation(TScenarioCommand *Pointer_Command, char *String_Message)
+{
+	printf("%s:%d : expectation failed : %s.\n", Scenario_String_File_Name, Pointer_Command->Line_Number, String_Message);
+	ScenarioPrintState();
+	exit(EXIT_FAILURE);
+}
+
+/** Check whether a display line begins with the expected text.
+ * @param Pointer_Command The expectation.
+ */
+static void ScenarioCheckLine(TScenarioCommand *Pointer_Command)
+{
+	char String_Line[LCD_LINE_LENGTH + 1], String_Message[128];
+	int i;
+	
+	LCDGetLine(Pointer_Command->Values[0], String_Line);
+	for (i = 0; Pointer_Command->String_Text[i] != 0; i++)
+	{
+		if ((Pointer_Command->String_Text[i] != '?') && (Pointer_Command->String_Text[i] != String_Line[i]))
+		{
+			snprintf(String_Message, sizeof(String_Message), "line %d is \"%s\" instead of \"%s\"", Pointer_Command->Values[0] + 1, String_Line, Pointer_Command->String_Text);
+			ScenarioExitOnFailedExpectation(Pointer_Command, String_Message);
+		}
+	}
+}
+
+/** Check the bytes sent by the clock.
+ * @param Pointer_Command The expectation.
+ * @param Bytes The bytes sent since the previous check.
+ * @param Bytes_Count How many bytes were sent.
+ */
+static void ScenarioCheckUART(TScenarioCommand *Pointer_Command, unsigned char *Bytes, int Bytes_Count)
+{
+	char String_Message[128];
+	int i;
+	
+	if (Bytes_Count != Pointer_Command->Values_Count)
+	{
+		snprintf(String_Message, sizeof(String_Message), "the clock sent %d byte(s) instead of %d", Bytes_Count, Pointer_Command->Values_Count);
+		ScenarioExitOnFailedExpectation(Pointer_Command, String_Message);
+	}
+	for (i = 0; i < Bytes_Count; i++)
+	{
+		if (Bytes[i] != Pointer_Command->Values[i])
+		{
+			snprintf(String_Message, sizeof(String_Message), "the byte %d sent by the clock is 0x%02X instead of 0x%02X", i, Bytes[i], Pointer_Command->Values[i]);
+			ScenarioExitOnFailedExpectation(Pointer_Command, String_Message);
+		}
+	}
+}
+
+/** Execute a command that does not let the simulated time pass.
+ * @param Pointer_Command The command.
+ */
+static void ScenarioExecuteCommand(TScenarioCommand *Pointer_Command)
+{
+	unsigned char Bytes[SCENARIO_MAXIMUM_BYTES_COUNT + 1];
+	int *Pointer_Values, Bytes_Count, i;
+	
+	Pointer_Values = Pointer_Command->Values;
+	switch (Pointer_Command->Type)
+	{
+		case SCENARIO_COMMAND_TYPE_RTC:
+			DS1307SetDateAndTime(Pointer_Values[0], Pointer_Values[1], Pointer_Values[2], Pointer_Values[6], Pointer_Values[3], Pointer_Values[4], Pointer_Values[5]);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_CONFIGURE:
+			HardwareSendUARTByte(SCENARIO_UART_PROTOCOL_MAGIC_NUMBER);
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[5]));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[4]));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[3]));
+			HardwareSendUARTByte(ScenarioComputeDayOfWeek(Pointer_Values[0], Pointer_Values[1], Pointer_Values[2]));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[2]));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[1]));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[0] - 2000));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[6]));
+			HardwareSendUARTByte(ScenarioConvertBinaryToBCD(Pointer_Values[7]));
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_SEND:
+			for (i = 0; i < Pointer_Command->Values_Count; i++) HardwareSendUARTByte((unsigned char) Pointer_Values[i]);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_ALARM:
+			HardwareSetAlarmSwitch(Pointer_Values[0]);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_SNOOZE:
+			HardwarePressSnoozeButton(Pointer_Command->Duration);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_TEMPERATURE:
+			HardwareSetTemperature(Pointer_Values[0]);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_EXPECT_LINE:
+			ScenarioCheckLine(Pointer_Command);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_EXPECT_RINGING:
+			if (HardwareIsRinging() != Pointer_Values[0]) ScenarioExitOnFailedExpectation(Pointer_Command, Pointer_Values[0] ? "the alarm is not ringing" : "the alarm is ringing");
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_EXPECT_BACKLIGHT:
+			if (HardwareIsBacklightOn() != Pointer_Values[0]) ScenarioExitOnFailedExpectation(Pointer_Command, Pointer_Values[0] ? "the backlight is off" : "the backlight is on");
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_EXPECT_BOOT:
+			if (HardwareGetBootDuration() == HARDWARE_BOOT_IN_PROGRESS) ScenarioExitOnFailedExpectation(Pointer_Command, "the firmware has not finished booting");
+			if (HardwareGetBootDuration() > Pointer_Command->Duration) ScenarioExitOnFailedExpectation(Pointer_Command, "the firmware took too long to boot");
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_EXPECT_UART:
+			Bytes_Count = HardwareGetUARTTransmittedBytes(Bytes, sizeof(Bytes));
+			ScenarioCheckUART(Pointer_Command, Bytes, Bytes_Count);
+			break;
+		
+		case SCENARIO_COMMAND_TYPE_PRINT:
+			ScenarioPrintState();
+			break;
+		
+		// Store the address the same way the firmware does, as if the clock was configured alone on its line before being connected to the shared line
+		case SCENARIO_COMMAND_TYPE_ADDRESS:
+			DS1307WriteMemory(SCENARIO_UNIT_ADDRESS_BASE_ADDRESS, (unsigned char) Pointer_Values[0]);
+			DS1307WriteMemory(SCENARIO_UNIT_ADDRESS_BASE_ADDRESS + 1, (unsigned char) ~Pointer_Values[0]);
+			break;
+		
+		default:
+			break;
+	}
+	
+	if ((Pointer_Command->Type >= SCENARIO_COMMAND_TYPE_EXPECT_LINE) && (Pointer_Command->Type <= SCENARIO_COMMAND_TYPE_EXPECT_UART)) Scenario_Checked_Expectations_Count++;
+}
+
+/** Write a whole buffer to a pipe. The program exits if the other process has terminated.
+ * @param File_Descriptor The pipe.
+ * @param Pointer_Buffer The data to write.
+ * @param Size The data size in bytes.
+ */
+static void ScenarioWritePipe(int File_Descriptor, void *Pointer_Buffer, size_t Size)
+{
+	ssize_t Written_Size;
+	
+	while (Size > 0)
+	{
+		Written_Size = write(File_Descriptor, Pointer_Buffer, Size);
+		if (Written_Size <= 0) exit(EXIT_FAILURE);
+		Pointer_Buffer = (char *) Pointer_Buffer + Written_Size;
+		Size -= (size_t) Written_Size;
+	}
+}
+
+/** Read a whole buffer from a pipe.
+ * @param File_Descriptor The pipe.
+ * @param Pointer_Buffer On output, contain the read data.
+ * @param Size The data size in bytes.
+ * @return 0 if the whole buffer was read,
+ * @return -1 if the other process has terminated.
+ */
+static int ScenarioReadPipe(int File_Descriptor, void *Pointer_Buffer, size_t Size)
+{
+	ssize_t Read_Size;
+	
+	while (Size > 0)
+	{
+		Read_Size = read(File_Descriptor, Pointer_Buffer, Size);
+		if (Read_Size <= 0) return -1;
+		Pointer_Buffer = (char *) Pointer_Buffer + Read_Size;
+		Size -= (size_t) Read_Size;
+	}
+	return 0;
+}
+
+/** Serve the coordinator process requests in a unit process, until the clock must run.
+ * @return The simulated time when this function must be called again.
+ */
+static unsigned long long ScenarioServeUnitRequests(void)
+{
+	TScenarioUnitRequest Request;
+	int Answer = 0;
+	
+	while (1)
+	{
+		// The coordinator closes the pipe when the scenario ends or fails
+		if (ScenarioReadPipe(Scenario_Unit_Request_File_Descriptor, &Request, sizeof(Request)) != 0) exit(EXIT_SUCCESS);
+		
+		if (Request.Type == SCENARIO_UNIT_REQUEST_TYPE_RUN) return Request.Time;
+		
+		// A failed expectation exits the process, which the coordinator notices
+		ScenarioExecuteCommand(&Scenario_Commands[Request.Command_Index]);
+		fflush(stdout);
+		ScenarioWritePipe(Scenario_Unit_Answer_File_Descriptor, &Answer, sizeof(Answer));
+	}
+}
+
+/** Send the UART events of the run that just ended to the coordinator process. */
+static void ScenarioSendUnitEvents(void)
+{
+	THardwareUARTEvent Events[SCENARIO_MAXIMUM_UNIT_EVENTS_COUNT];
+	int Events_Count;
+	
+	fflush(stdout); // Display the hardware warnings before the coordinator displays anything else
+	Events_Count = HardwareGetUARTEvents(Events, SCENARIO_MAXIMUM_UNIT_EVENTS_COUNT);
+	ScenarioWritePipe(Scenario_Unit_Answer_File_Descriptor, &Events_Count, sizeof(Events_Count));
+	ScenarioWritePipe(Scenario_Unit_Answer_File_Descriptor, Events, Events_Count * sizeof(THardwareUARTEvent));
+}
+
+/** Create a process for each clock sharing the line. The processes inherit the loaded scenario and the powered-on hardware. */
+static void ScenarioStartUnits(void)
+{
+	int Request_Pipe[2], Answer_Pipe[2], i, j;
+	pid_t Process_ID;
+	
+	// Each process output must appear in order
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	
+	for (i = 0; i < Scenario_Units_Count; i++)
+	{
+		if ((pipe(Request_Pipe) != 0) || (pipe(Answer_Pipe) != 0))
+		{
+			printf("Error : failed to create the clock %d pipes.\n", i + 1);
+			exit(EXIT_FAILURE);
+		}
+		
+		Process_ID = fork();
+		if (Process_ID < 0)
+		{
+			printf("Error : failed to create the clock %d process.\n", i + 1);
+			exit(EXIT_FAILURE);
+		}
+		
+		// Unit process
+		if (Process_ID == 0)
+		{
+			// Keep only this clock pipes, so the other clocks notice when the coordinator terminates
+			for (j = 0; j < i; j++)
+			{
+				close(Scenario_Units[j].Request_File_Descriptor);
+				close(Scenario_Units[j].Answer_File_Descriptor);
+			}
+			close(Request_Pipe[1]);
+			close(Answer_Pipe[0]);
+			Scenario_Unit_Request_File_Descriptor = Request_Pipe[0];
+			Scenario_Unit_Answer_File_Descriptor = Answer_Pipe[1];
+			Scenario_Unit_Number = i + 1;
+			return;
+		}
+		
+		// Coordinator process
+		close(Request_Pipe[0]);
+		close(Answer_Pipe[1]);
+		Scenario_Units[i].Process_ID = Process_ID;
+		Scenario_Units[i].Request_File_Descriptor = Request_Pipe[1];
+		Scenario_Units[i].Answer_File_Descriptor = Answer_Pipe[0];
+		Scenario_Units[i].Is_Transmitter_Enabled = 0; // The transmitter is disabled on power-on
+		Scenario_Units[i].Transmission_End_Time = 0;
+	}
+}
+
+/** Make a clock execute a command that does not let the time pass. The coordinator exits if the command failed.
+ * @param Unit_Index The clock.
+ * @param Command_Index The command.
+ */
+static void ScenarioExecuteUnitCommand(int Unit_Index, int Command_Index)
+{
+	TScenarioUnitRequest Request;
+	int Answer;
+	
+	Request.Type = SCENARIO_UNIT_REQUEST_TYPE_EXECUTE_COMMAND;
+	Request.Command_Index = Command_Index;
+	Request.Time = 0;
+	ScenarioWritePipe(Scenario_Units[Unit_Index].Request_File_Descriptor, &Request, sizeof(Request));
+	if (ScenarioReadPipe(Scenario_Units[Unit_Index].Answer_File_Descriptor, &Answer, sizeof(Answer)) != 0) exit(EXIT_FAILURE); // The clock process displayed the failure reason
+}
+
+/** Sort the line events chronologically, the events of a clock keep their order.
+ * @param Pointer_Event_1 The first event.
+ * @param Pointer_Event_2 The second event.
+ * @return A negative value if the first event comes first, a positive value otherwise.
+ */
+static int ScenarioCompareLineEvents(const void *Pointer_Event_1, const void *Pointer_Event_2)
+{
+	const TScenarioLineEvent *Pointer_Line_Event_1 = Pointer_Event_1, *Pointer_Line_Event_2 = Pointer_Event_2;
+	
+	if (Pointer_Line_Event_1->Event.Time != Pointer_Line_Event_2->Event.Time) return Pointer_Line_Event_1->Event.Time < Pointer_Line_Event_2->Event.Time ? -1 : 1;
+	if (Pointer_Line_Event_1->Unit_Index != Pointer_Line_Event_2->Unit_Index) return Pointer_Line_Event_1->Unit_Index - Pointer_Line_Event_2->Unit_Index;
+	return Pointer_Line_Event_1->Order - Pointer_Line_Event_2->Order;
+}
+
+/** Display a shared line error and exit.
+ * @param Pointer_Command The run command during which the error happened.
+ * @param Time When the error happened.
+ * @param String_Message The error description.
+ */
+static void ScenarioExitOnLineError(TScenarioCommand *Pointer_Command, unsigned long long Time, char *String_Message)
+{
+	printf("%s:%d : shared line error at %.6f s : %s.\n", Scenario_String_File_Name, Pointer_Command->Line_Number, (double) Time / HARDWARE_TIME_UNITS_PER_SECOND, String_Message);
+	exit(EXIT_FAILURE);
+}
+
+/** Run all clocks until the same time, then merge their transmissions the way the PC receives them. Only one clock can drive the line at a time.
+ * @param Pointer_Command The run command.
+ */
+static void ScenarioRunUnits(TScenarioCommand *Pointer_Command)
+{
+	static TScenarioLineEvent Line_Events[SCENARIO_MAXIMUM_UNITS_COUNT * SCENARIO_MAXIMUM_UNIT_EVENTS_COUNT];
+	THardwareUARTEvent Events[SCENARIO_MAXIMUM_UNIT_EVENTS_COUNT];
+	TScenarioUnitRequest Request;
+	TScenarioUnit *Pointer_Unit;
+	THardwareUARTEvent *Pointer_Event;
+	int Line_Events_Count = 0, Events_Count, i, j, Unit_Index;
+	unsigned long long Start_Time;
+	char String_Message[128];
+	
+	// Let all clocks run at the same time
+	Scenario_Line_Time += Pointer_Command->Duration;
+	Request.Type = SCENARIO_UNIT_REQUEST_TYPE_RUN;
+	Request.Command_Index = 0;
+	Request.Time = Scenario_Line_Time;
+	for (i = 0; i < Scenario_Units_Count; i++) ScenarioWritePipe(Scenario_Units[i].Request_File_Descriptor, &Request, sizeof(Request));
+	
+	// Gather their events
+	for (i = 0; i < Scenario_Units_Count; i++)
+	{
+		if ((ScenarioReadPipe(Scenario_Units[i].Answer_File_Descriptor, &Events_Count, sizeof(Events_Count)) != 0) || (ScenarioReadPipe(Scenario_Units[i].Answer_File_Descriptor, Events, Events_Count * sizeof(THardwareUARTEvent)) != 0)) exit(EXIT_FAILURE);
+		for (j = 0; j < Events_Count; j++)
+		{
+			Line_Events[Line_Events_Count].Event = Events[j];
+			Line_Events[Line_Events_Count].Unit_Index = i;
+			Line_Events[Line_Events_Count].Order = j;
+			Line_Events_Count++;
+		}
+	}
+	qsort(Line_Events, Line_Events_Count, sizeof(TScenarioLineEvent), ScenarioCompareLineEvents);
+	
+	// Replay the line activity
+	for (i = 0; i < Line_Events_Count; i++)
+	{
+		Unit_Index = Line_Events[i].Unit_Index;
+		Pointer_Unit = &Scenario_Units[Unit_Index];
+		Pointer_Event = &Line_Events[i].Event;
+		
+		switch (Pointer_Event->Type)
+		{
+			case HARDWARE_UART_EVENT_TYPE_TRANSMITTER_ENABLED:
+				for (j = 0; j < Scenario_Units_Count; j++)
+				{
+					if ((j != Unit_Index) && (Scenario_Units[j].Transmission_End_Time > Pointer_Event->Time))
+					{
+						snprintf(String_Message, sizeof(String_Message), "clock %d drives the line while clock %d is transmitting", Unit_Index + 1, j + 1);
+						ScenarioExitOnLineError(Pointer_Command, Pointer_Event->Time, String_Message);
+					}
+				}
+				Pointer_Unit->Is_Transmitter_Enabled = 1;
+				break;
+			
+			case HARDWARE_UART_EVENT_TYPE_TRANSMITTER_DISABLED:
+				if (Pointer_Unit->Transmission_End_Time > Pointer_Event->Time)
+				{
+					snprintf(String_Message, sizeof(String_Message), "clock %d released the line before its last byte was transmitted", Unit_Index + 1);
+					ScenarioExitOnLineError(Pointer_Command, Pointer_Event->Time, String_Message);
+				}
+				Pointer_Unit->Is_Transmitter_Enabled = 0;
+				break;
+			
+			case HARDWARE_UART_EVENT_TYPE_BYTE_WRITTEN:
+				// The byte is transmitted when the previous one has been shifted out
+				Start_Time = Pointer_Event->Time;
+				if (Pointer_Unit->Transmission_End_Time > Start_Time) Start_Time = Pointer_Unit->Transmission_End_Time;
+				Pointer_Unit->Transmission_End_Time = Start_Time + HARDWARE_UART_BYTE_DURATION;
+			
+				for (j = 0; j < Scenario_Units_Count; j++)
+				{
+					if ((j != Unit_Index) && Scenario_Units[j].Is_Transmitter_Enabled)
+					{
+						snprintf(String_Message, sizeof(String_Message), "clock %d transmits the byte 0x%02X while clock %d drives the line", Unit_Index + 1, Pointer_Event->Byte, j + 1);
+						ScenarioExitOnLineError(Pointer_Command, Start_Time, String_Message);
+					}
+				}
+			
+				if (Scenario_Line_Bytes_Count == SCENARIO_MAXIMUM_LINE_BYTES_COUNT) ScenarioExitOnLineError(Pointer_Command, Start_Time, "too many bytes were received without being checked");
+				Scenario_Line_Bytes[Scenario_Line_Bytes_Count] = Pointer_Event->Byte;
+				Scenario_Line_Bytes_Count++;
+				break;
+		}
+	}
+}
+
+/** Play the scenario on all clocks sharing the line. The PC transmissions reach all clocks, the clocks transmissions are merged on the PC reception. This function never returns. */
+static void ScenarioCoordinateUnits(void)
+{
+	TScenarioCommand *Pointer_Command;
+	int i, Status;
+	
+	while (Scenario_Current_Command_Index < Scenario_Commands_Count)
+	{
+		Pointer_Command = &Scenario_Commands[Scenario_Current_Command_Index];
+		
+		switch (Pointer_Command->Type)
+		{
+			case SCENARIO_COMMAND_TYPE_UNIT:
+				Scenario_Selected_Unit_Index = Pointer_Command->Values[0];
+				break;
+			
+			// The PC talks to all clocks
+			case SCENARIO_COMMAND_TYPE_CONFIGURE:
+			case SCENARIO_COMMAND_TYPE_SEND:
+				for (i = 0; i < Scenario_Units_Count; i++) ScenarioExecuteUnitCommand(i, Scenario_Current_Command_Index);
+				break;
+			
+			case SCENARIO_COMMAND_TYPE_RUN:
+				ScenarioRunUnits(Pointer_Command);
+				break;
+			
+			// The PC hears all clocks
+			case SCENARIO_COMMAND_TYPE_EXPECT_UART:
+				ScenarioCheckUART(Pointer_Command, Scenario_Line_Bytes, Scenario_Line_Bytes_Count);
+				Scenario_Line_Bytes_Count = 0;
+				Scenario_Checked_Expectations_Count++;
+				break;
+			
+			// Other commands apply to the selected clock
+			default:
+				ScenarioExecuteUnitCommand(Scenario_Selected_Unit_Index, Scenario_Current_Command_Index);
+				if ((Pointer_Command->Type >= SCENARIO_COMMAND_TYPE_EXPECT_LINE) && (Pointer_Command->Type <= SCENARIO_COMMAND_TYPE_EXPECT_BACKLIGHT)) Scenario_Checked_Expectations_Count++;
+				break;
+		}
+		Scenario_Current_Command_Index++;
+	}
+	
+	// Let the clocks processes terminate
+	for (i = 0; i < Scenario_Units_Count; i++) close(Scenario_Units[i].Request_File_Descriptor);
+	for (i = 0; i < Scenario_Units_Count; i++) waitpid(Scenario_Units[i].Process_ID, &Status, 0);
+	
+	printf("Scenario successful : %d expectations checked, %.1f days of operation of %d clocks simulated in %ld seconds.\n", Scenario_Checked_Expectations_Count, (double) Scenario_Line_Time / (86400 * HARDWARE_TIME_UNITS_PER_SECOND), Scenario_Units_Count, (long) (time(NULL) - Scenario_Start_Time));
+	exit(EXIT_SUCCESS);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void ScenarioLoad(char *String_File_Name)
+{
+	FILE *Pointer_File;
+	char String_Line[SCENARIO_MAXIMUM_LINE_LENGTH];
+	int Line_Number = 0;
+	
+	Scenario_String_File_Name = String_File_Name;
+	Pointer_File = fopen(String_File_Name, "r");
+	if (Pointer_File == NULL)
+	{
+		printf("Error : failed to open the scenario file '%s'.\n", String_File_Name);
+		exit(EXIT_FAILURE);
+	}
+	
+	Scenario_Commands_Count = 0;
+	while (fgets(String_Line, sizeof(String_Line), Pointer_File) != NULL)
+	{
+		Line_Number++;
+		if (Scenario_Commands_Count == SCENARIO_MAXIMUM_COMMANDS_COUNT) ScenarioExitOnSyntaxError(Line_Number, "too many commands");
+		
+		Scenario_Commands[Scenario_Commands_Count].Line_Number = Line_Number;
+		if (ScenarioParseLine(&Scenario_Commands[Scenario_Commands_Count], String_Line)) Scenario_Commands_Count++;
+	}
+	fclose(Pointer_File);
+	
+	Scenario_Start_Time = time(NULL);
+}
+
+unsigned long long ScenarioExecute(void)
+{
+	TScenarioCommand *Pointer_Command;
+	unsigned long long Time;
+	
+	// A clock sharing the line reports its transmissions at the end of each run, then waits for the next coordinator requests
+	if (Scenario_Unit_Number != 0)
+	{
+		ScenarioSendUnitEvents();
+		return ScenarioServeUnitRequests();
+	}
+	
+	while (Scenario_Current_Command_Index < Scenario_Commands_Count)
+	{
+		Pointer_Command = &Scenario_Commands[Scenario_Current_Command_Index];
+		Scenario_Current_Command_Index++;
+		
+		// Several clocks share the line, this process becomes the coordinator or one of the clocks
+		if (Pointer_Command->Type == SCENARIO_COMMAND_TYPE_UNITS)
+		{
+			ScenarioStartUnits();
+			if (Scenario_Unit_Number != 0) return ScenarioServeUnitRequests();
+			ScenarioCoordinateUnits();
+		}
+		
+		if (Pointer_Command->Type == SCENARIO_COMMAND_TYPE_RUN) return HardwareGetTime() + Pointer_Command->Duration;
+		
+		// The reset happens when the simulated hardware gets the control back, the next commands are executed as soon as the firmware waits for the first time
+		if (Pointer_Command->Type == SCENARIO_COMMAND_TYPE_RESET)
+		{
+			HardwareReset((THardwareResetType) Pointer_Command->Values[0]);
+			return HardwareGetTime();
+		}
+		ScenarioExecuteCommand(Pointer_Command);
+	}
+	
+	// The whole scenario has been played
+	Time = HardwareGetTime();
+	printf("Scenario successful : %d expectations checked, %.1f days of clock operation simulated in %ld seconds.\n", Scenario_Checked_Expectations_Count, (double) Time / (86400 * HARDWARE_TIME_UNITS_PER_SECOND), (long) (time(NULL) - Scenario_Start_Time));
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,41 @@
+/** @file Scenario.h
+ * Load a scenario file and play it against the simulated clock. A scenario is a text file with one command per line, empty lines and lines starting with '#' are ignored.
+ * Commands :
+ *   rtc YYYY/MM/DD HH:MM:SS [Day_Of_Week]  Directly set the DS1307 date and time, the day of the week (1 is sunday) is computed from the date when it is omitted.
+ *   configure YYYY/MM/DD HH:MM:SS HH:MM    Send the date, time and alarm through the UART, like the PC program does.
+ *   send XX [XX...]                         Send bytes (in hexadecimal) through the UART.
+ *   alarm on|off                            Set the alarm switch position.
+ *   snooze [Duration]                       Press the snooze button and hold it for the duration (200ms when omitted), the contact bounces on press and release.
+ *   temperature Degrees                     Set the room temperature.
+ *   run Duration                            Let the clock run for a duration like 500ms, 30s, 15m, 2h or 365d. The firmware starts running on the first run command.
+ *   expect line1|line2 "Text"               Check the beginning of a display line, a '?' matches any character and '*' is displayed for characters that have no ASCII equivalent.
+ *   expect ringing on|off                   Check whether the alarm is ringing.
+ *   expect backlight on|off                 Check whether the display backlight is lighted.
+ *   expect boot Duration                    Check that the firmware finished booting within the duration (see HardwareGetBootDuration()).
+ *   expect uart [XX...]                     Check the bytes sent by the clock since the previous check.
+ *   print                                   Display the simulated time, the display content, the buzzer and backlight state and the last boot duration.
+ *   address N                               Directly store the unit address (in range [0;254], 0 removes the address) in the DS1307 RAM, it is used on the next firmware boot.
+ *   units N                                 Simulate N clocks (in range [2;8]) sharing the same serial line, this must be the first command.
+ *   unit K                                  Select the clock (starting from 1) the following rtc, alarm, snooze, temperature, address, expect and print commands apply to.
+ *   reset power|brownout                    Reset the microcontroller, after a power cycle (the display is reset too) or a brown-out. It can't be used on a shared line.
+ * On a shared line, the send and configure commands reach all clocks, the run command makes all clocks run together, and expect uart checks the bytes received by the PC from all clocks. A clock driving the line while another one is transmitting is reported as an error.
+ * The simulation stops with an error message on the first failed expectation.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SCENARIO_H
+#define H_SCENARIO_H
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Load and check a scenario file. The program exits with an error message if the scenario is invalid.
+ * @param String_File_Name The scenario file.
+ */
+void ScenarioLoad(char *String_File_Name);
+
+/** Execute the scenario commands until the next run command. The program exits when the scenario end is reached or when an expectation fails.
+ * @return The simulated time when this function must be called again.
+ */
+unsigned long long ScenarioExecute(void);
+
+#endif
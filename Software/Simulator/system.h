@@ -0,0 +1,152 @@
+/** @file system.h
+ * Replace the BoostC system header when the firmware is built for the simulator. The firmware sources are preprocessed, then Translate.sed turns every special function register access into a call to the simulated microcontroller.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SYSTEM_H
+#define H_SYSTEM_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+// Register bits used by the firmware, the preprocessor replaces their names by their numbers before the register accesses are translated
+// INTCON
+#define INTF 1
+#define INTE 4
+#define PEIE 6
+#define GIE 7
+// OPTION_REG
+#define INTEDG 6
+// PCON
+#define NOT_BOR 0
+#define NOT_POR 1
+// PIR1 and PIE1
+#define TMR1IF 0
+#define TMR1IE 0
+#define TMR2IF 1
+#define TMR2IE 1
+#define CCP1IF 2
+#define CCP1IE 2
+#define SSPIF 3
+#define SSPIE 3
+#define TXIF 4
+#define TXIE 4
+#define RCIF 5
+#define RCIE 5
+#define ADIF 6
+#define ADIE 6
+// T1CON
+#define TMR1ON 0
+// T2CON
+#define TMR2ON 2
+// SSPCON2
+#define SEN 0
+#define RSEN 1
+#define PEN 2
+#define RCEN 3
+#define ACKEN 4
+#define ACKDT 5
+#define ACKSTAT 6
+// ADCON0
+#define ADON 0
+#define GO 2
+// TXSTA
+#define TRMT 1
+#define TXEN 5
+// RCSTA
+#define OERR 1
+#define FERR 2
+#define CREN 4
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All simulated special function registers. */
+typedef enum
+{
+	SIMULATOR_REGISTER_INDF,
+	SIMULATOR_REGISTER_TMR0,
+	SIMULATOR_REGISTER_PCL,
+	SIMULATOR_REGISTER_STATUS,
+	SIMULATOR_REGISTER_FSR,
+	SIMULATOR_REGISTER_PORTA,
+	SIMULATOR_REGISTER_PORTB,
+	SIMULATOR_REGISTER_PORTC,
+	SIMULATOR_REGISTER_PCLATH,
+	SIMULATOR_REGISTER_INTCON,
+	SIMULATOR_REGISTER_PIR1,
+	SIMULATOR_REGISTER_PIR2,
+	SIMULATOR_REGISTER_TMR1L,
+	SIMULATOR_REGISTER_TMR1H,
+	SIMULATOR_REGISTER_T1CON,
+	SIMULATOR_REGISTER_TMR2,
+	SIMULATOR_REGISTER_T2CON,
+	SIMULATOR_REGISTER_SSPBUF,
+	SIMULATOR_REGISTER_SSPCON,
+	SIMULATOR_REGISTER_CCPR1L,
+	SIMULATOR_REGISTER_CCPR1H,
+	SIMULATOR_REGISTER_CCP1CON,
+	SIMULATOR_REGISTER_RCSTA,
+	SIMULATOR_REGISTER_TXREG,
+	SIMULATOR_REGISTER_RCREG,
+	SIMULATOR_REGISTER_CCPR2L,
+	SIMULATOR_REGISTER_CCPR2H,
+	SIMULATOR_REGISTER_CCP2CON,
+	SIMULATOR_REGISTER_ADRESH,
+	SIMULATOR_REGISTER_ADCON0,
+	SIMULATOR_REGISTER_OPTION_REG,
+	SIMULATOR_REGISTER_TRISA,
+	SIMULATOR_REGISTER_TRISB,
+	SIMULATOR_REGISTER_TRISC,
+	SIMULATOR_REGISTER_PIE1,
+	SIMULATOR_REGISTER_PIE2,
+	SIMULATOR_REGISTER_PCON,
+	SIMULATOR_REGISTER_SSPCON2,
+	SIMULATOR_REGISTER_PR2,
+	SIMULATOR_REGISTER_SSPADD,
+	SIMULATOR_REGISTER_SSPSTAT,
+	SIMULATOR_REGISTER_TXSTA,
+	SIMULATOR_REGISTER_SPBRG,
+	SIMULATOR_REGISTER_ADRESL,
+	SIMULATOR_REGISTER_ADCON1,
+	SIMULATOR_REGISTER_EEDATA,
+	SIMULATOR_REGISTER_EEADR,
+	SIMULATOR_REGISTER_EEDATH,
+	SIMULATOR_REGISTER_EEADRH,
+	SIMULATOR_REGISTER_EECON1,
+	SIMULATOR_REGISTER_EECON2,
+	SIMULATOR_REGISTERS_COUNT
+} TSimulatorRegister;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Read a special function register, the peripherals react as the real ones would do.
+ * @param Register The register to read.
+ * @return The register value.
+ */
+unsigned char SimulatorReadRegister(TSimulatorRegister Register);
+
+/** Write a special function register, the peripherals react as the real ones would do.
+ * @param Register The register to write.
+ * @param Value The value to write.
+ */
+void SimulatorWriteRegister(TSimulatorRegister Register, unsigned char Value);
+
+/** Write a single bit of a special function register.
+ * @param Register The register to write.
+ * @param Bit The bit number, in range [0; 7].
+ * @param Value The bit value (any non-zero value sets the bit).
+ */
+void SimulatorWriteRegisterBit(TSimulatorRegister Register, unsigned char Bit, unsigned char Value);
+
+/** Let the simulated time pass for the requested amount of milliseconds.
+ * @param Milliseconds How many milliseconds to wait.
+ */
+void delay_ms(unsigned char Milliseconds);
+
+/** Let the simulated time pass for the requested amount of microseconds.
+ * @param Microseconds How many microseconds to wait.
+ */
+void delay_us(unsigned char Microseconds);
+
+#endif